@@ -26,6 +26,7 @@ limitations under the License.
 #include "backends/bmv2/pna_nic/version.h"
 #include "control-plane/p4RuntimeSerializer.h"
 #include "frontends/common/applyOptionsPragmas.h"
+#include "frontends/common/compileServer.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/p4/frontend.h"
 #include "fstream"
@@ -39,9 +40,7 @@ limitations under the License.
 
 using namespace P4;
 
-int main(int argc, char *const argv[]) {
-    setup_gc_logging();
-
+static int compile(int argc, char *const argv[]) {
     AutoCompileContext autoPnaNicContext(new BMV2::PnaNicContext);
     auto &options = BMV2::PnaNicContext::get().options();
     options.langVersion = CompilerOptions::FrontendVersion::P4_16;
@@ -132,3 +131,9 @@ int main(int argc, char *const argv[]) {
 
     return ::P4::errorCount() > 0;
 }
+
+int main(int argc, char *const argv[]) {
+    setup_gc_logging();
+
+    return P4::CompileServer::main(argc, argv, compile);
+}
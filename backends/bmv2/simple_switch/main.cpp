@@ -26,8 +26,10 @@ limitations under the License.
 #include "backends/bmv2/simple_switch/version.h"
 #include "control-plane/p4RuntimeSerializer.h"
 #include "frontends/common/applyOptionsPragmas.h"
+#include "frontends/common/compileServer.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/p4/frontend.h"
+#include "frontends/p4/metrics/metricsPassManager.h"
 #include "ir/ir.h"
 #include "ir/json_generator.h"
 #include "ir/json_loader.h"
@@ -41,10 +43,7 @@ limitations under the License.
 
 using namespace P4;
 
-int main(int argc, char *const argv[]) {
-    setup_gc_logging();
-    setup_signals();
-
+static int compile(int argc, char *const argv[]) {
     AutoCompileContext autoBMV2Context(new BMV2::SimpleSwitchContext);
     auto &options = BMV2::SimpleSwitchContext::get().options();
     options.langVersion = CompilerOptions::FrontendVersion::P4_16;
@@ -99,11 +98,16 @@ int main(int argc, char *const argv[]) {
     if (::P4::errorCount() > 0) return 1;
 
     BMV2::SimpleSwitchMidEnd midEnd(options);
+    P4::MetricsPassManager metricsPassManager(options, nullptr,
+                                              P4CContext::get().options().metrics);
     midEnd.addDebugHook(hook);
+    midEnd.addDebugHook(metricsPassManager.getSnapshotHook(), true);
+    midEnd.addDebugHook(metricsPassManager.getProfileHook(program), true);
     try {
         toplevel = midEnd.process(program);
         if (::P4::errorCount() > 1 || toplevel == nullptr || toplevel->getMain() == nullptr)
             return 1;
+        metricsPassManager.exportCompileProfile(program);
         if (!options.dumpJsonFile.empty() && !options.loadIRFromJson)
             JSONGenerator(*openFile(options.dumpJsonFile, true), true).emit(program);
     } catch (const std::exception &bug) {
@@ -135,3 +139,10 @@ int main(int argc, char *const argv[]) {
 
     return ::P4::errorCount() > 0;
 }
+
+int main(int argc, char *const argv[]) {
+    setup_gc_logging();
+    setup_signals();
+
+    return P4::CompileServer::main(argc, argv, compile);
+}
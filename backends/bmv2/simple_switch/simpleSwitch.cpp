@@ -25,6 +25,7 @@ limitations under the License.
 #include "backends/bmv2/simple_switch/options.h"
 #include "frontends/p4-14/fromv1.0/v1model.h"
 #include "frontends/p4/cloner.h"
+#include "frontends/p4/metrics/metricsPassManager.h"
 #include "lib/json.h"
 #include "midend/flattenLogMsg.h"
 
@@ -1195,8 +1196,13 @@ void SimpleSwitchBackend::convert(const IR::ToplevelBlock *tlb) {
 
     auto hook = options.getDebugHook();
     simplify.addDebugHook(hook);
+    P4::MetricsPassManager metricsPassManager(options, nullptr,
+                                              P4CContext::get().options().metrics);
+    simplify.addDebugHook(metricsPassManager.getSnapshotHook(), true);
+    simplify.addDebugHook(metricsPassManager.getProfileHook(program), true);
 
-    program->apply(simplify);
+    auto simplified = program->apply(simplify);
+    metricsPassManager.exportCompileProfile(simplified);
 
     // map IR node to compile-time allocated resource blocks.
     toplevel->apply(*new P4::BuildResourceMap(&structure->resourceMap));
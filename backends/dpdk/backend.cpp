@@ -25,6 +25,7 @@ limitations under the License.
 #include "dpdkHelpers.h"
 #include "dpdkMetadata.h"
 #include "dpdkProgram.h"
+#include "frontends/p4/metrics/metricsPassManager.h"
 #include "frontends/p4/moveDeclarations.h"
 #include "frontends/p4/typeChecking/typeChecker.h"
 #include "ir/dbprint.h"
@@ -127,11 +128,16 @@ void DpdkBackend::convert(const IR::ToplevelBlock *tlb) {
         // convert to assembly program
         convertToDpdk,
     };
+    P4::MetricsPassManager metricsPassManager(options, nullptr,
+                                              P4CContext::get().options().metrics);
     simplify.addDebugHook(hook, true);
+    simplify.addDebugHook(metricsPassManager.getSnapshotHook(), true);
+    simplify.addDebugHook(metricsPassManager.getProfileHook(program), true);
     program = program->apply(simplify);
     if (errorCount() > 0) {
         return;
     }
+    metricsPassManager.exportCompileProfile(program);
 
     dpdk_program = convertToDpdk->getDpdkProgram();
     if (dpdk_program == nullptr) {
@@ -163,10 +163,9 @@ void DpdkContextGenerator::CollectTablesAndSetAttributes() {
 }
 
 /// This functions insert a single key field in the match keys array.
-void DpdkContextGenerator::addKeyField(Util::JsonArray *keyJson, const cstring name,
+void DpdkContextGenerator::addKeyField(Util::JsonWriter &json, const cstring name,
                                        const cstring nameAnnotation, const IR::KeyElement *key,
                                        int position) {
-    auto *keyField = new Util::JsonObject();
     const auto *fieldNamePos = name.findlast('.');
     auto instanceName = name.replace(fieldNamePos, "");
     // FIXME: trim string_view
@@ -175,34 +174,33 @@ void DpdkContextGenerator::addKeyField(Util::JsonArray *keyJson, const cstring n
     // Replace header stack indices hdr[<index>] with hdr$<index>.
     std::regex hdrStackRegex(R"(\[([0-9]+)\])");
     keyName = std::regex_replace(keyName, hdrStackRegex, "$$$1");
-    keyField->emplace("name", keyName);
-    keyField->emplace("instance_name", instanceName);
-    keyField->emplace("field_name", fieldName);
+    json.beginObject();
+    json.member("name", keyName);
+    json.member("instance_name", instanceName);
+    json.member("field_name", fieldName);
     auto match_kind = toStr(key->matchType);
     if (match_kind == "optional" || match_kind == "range") match_kind = "ternary"_cs;
-    keyField->emplace("match_type", match_kind);
-    keyField->emplace("start_bit", 0);
-    keyField->emplace("bit_width", key->expression->type->width_bits());
-    keyField->emplace("bit_width_full", key->expression->type->width_bits());
-    keyField->emplace("position", position);
-    keyJson->append(keyField);
+    json.member("match_type", match_kind);
+    json.member("start_bit", 0);
+    json.member("bit_width", key->expression->type->width_bits());
+    json.member("bit_width_full", key->expression->type->width_bits());
+    json.member("position", position);
+    json.endObject();
 }
 
 /// This function sets the common table properties.
-Util::JsonObject *DpdkContextGenerator::initTableCommonJson(const cstring name,
-                                                            const struct TableAttributes &attr) {
-    auto *tableJson = new Util::JsonObject();
+void DpdkContextGenerator::initTableCommonJson(Util::JsonWriter &json, const cstring name,
+                                               const struct TableAttributes &attr) {
     cstring tableName = name;
-    tableJson->emplace("name", attr.externalName);
-    tableJson->emplace("target_name", tableName);
-    tableJson->emplace("direction", attr.direction);
-    tableJson->emplace("handle", attr.tableHandle);
-    tableJson->emplace("table_type", attr.tableType);
-    tableJson->emplace("size", attr.size);
-    tableJson->emplace("p4_hidden", attr.isHidden);
-    tableJson->emplace("add_on_miss", attr.is_add_on_miss);
-    tableJson->emplace("idle_timeout_with_auto_delete", attr.idle_timeout_with_auto_delete);
-    return tableJson;
+    json.member("name", attr.externalName);
+    json.member("target_name", tableName);
+    json.member("direction", attr.direction);
+    json.member("handle", attr.tableHandle);
+    json.member("table_type", attr.tableType);
+    json.member("size", attr.size);
+    json.member("p4_hidden", attr.isHidden);
+    json.member("add_on_miss", attr.is_add_on_miss);
+    json.member("idle_timeout_with_auto_delete", attr.idle_timeout_with_auto_delete);
 }
 
 void DpdkContextGenerator::collectHandleId() {
@@ -317,33 +315,32 @@ void DpdkContextGenerator::setDefaultActionHandle(const IR::P4Table *table) {
 }
 
 /// This functions creates JSON object for immediate fields (action parameters).
-void DpdkContextGenerator::addImmediateField(Util::JsonArray *paramJson, const cstring name,
+void DpdkContextGenerator::addImmediateField(Util::JsonWriter &json, const cstring name,
                                              int dest_start, int dest_width) {
-    auto *oneParam = new Util::JsonObject();
-    oneParam->emplace("param_name", name);
-    oneParam->emplace("dest_start", dest_start);
-    oneParam->emplace("dest_width", dest_width);
-    paramJson->append(oneParam);
+    json.beginObject();
+    json.member("param_name", name);
+    json.member("dest_start", dest_start);
+    json.member("dest_width", dest_width);
+    json.endObject();
 }
 
 /// This functions creates JSON object for match attributes of a table.
-Util::JsonObject *DpdkContextGenerator::addMatchAttributes(const IR::P4Table *table,
-                                                           const cstring ctrlName) {
-    auto tableAttr = ::P4::get(tableAttrmap, table->name.originalName);
-    auto *match_attributes = new Util::JsonObject();
-    auto *actFmtArray = new Util::JsonArray();
-    auto *stageTblArray = new Util::JsonArray();
-    auto *oneStageTbl = new Util::JsonObject();
+void DpdkContextGenerator::addMatchAttributes(Util::JsonWriter &json, const IR::P4Table *table,
+                                              const cstring ctrlName) {
+    json.beginObject();
+    json.key("stage_tables").beginArray();
+    json.beginObject();
+    json.key("action_format").beginArray();
     for (auto action : table->getActionList()->actionList) {
-        auto *oneAction = new Util::JsonObject();
+        json.beginObject();
         struct actionAttributes attr = ::P4::get(actionAttrMap, action->getName());
         auto name = action->externalName();
         if (name != "NoAction") {
             name = ctrlName + "." + name;
         }
-        oneAction->emplace("action_name", name);
-        oneAction->emplace("action_handle", attr.actionHandle);
-        auto *immFldArray = new Util::JsonArray();
+        json.member("action_name", name);
+        json.member("action_handle", attr.actionHandle);
+        json.key("immediate_fields").beginArray();
         if (attr.params) {
             int index = 0;
             int param_width = 8;  // Minimum width for dpdk action params
@@ -354,40 +351,40 @@ Util::JsonObject *DpdkContextGenerator::addMatchAttributes(const IR::P4Table *ta
                 } else if (!param->type->is<IR::Type_Boolean>()) {
                     BUG("Unsupported parameter type %1%", param->type);
                 }
-                addImmediateField(immFldArray, param->name.originalName, index / 8, param_width);
+                addImmediateField(json, param->name.originalName, index / 8, param_width);
                 index += param_width;
             }
         }
-        oneAction->emplace("immediate_fields"_cs, immFldArray);
-        actFmtArray->append(oneAction);
+        json.endArray();
+        json.endObject();
     }
-    oneStageTbl->emplace("action_format"_cs, actFmtArray);
-    stageTblArray->append(oneStageTbl);
-    match_attributes->emplace("stage_tables"_cs, stageTblArray);
-    return match_attributes;
+    json.endArray();
+    json.endObject();
+    json.endArray();
+    json.endObject();
 }
 
 /// This function adds a single parameter to the parameters array.
-void DpdkContextGenerator::addActionParam(Util::JsonArray *paramJson, const cstring name,
+void DpdkContextGenerator::addActionParam(Util::JsonWriter &json, const cstring name,
                                           int bitWidth, int position, int byte_array_index) {
-    auto *oneParam = new Util::JsonObject();
-    oneParam->emplace("name", name);
-    oneParam->emplace("start_bit", 0);
-    oneParam->emplace("bit_width", bitWidth);
-    oneParam->emplace("position", position);
-    oneParam->emplace("byte_array_index", byte_array_index);
-    paramJson->append(oneParam);
+    json.beginObject();
+    json.member("name", name);
+    json.member("start_bit", 0);
+    json.member("bit_width", bitWidth);
+    json.member("position", position);
+    json.member("byte_array_index", byte_array_index);
+    json.endObject();
 }
 
 /// This function creates JSON objects for  actions within a table.
-Util::JsonArray *DpdkContextGenerator::addActions(const IR::P4Table *table,
-                                                  const cstring controlName, bool isMatch) {
-    auto *actArray = new Util::JsonArray();
+void DpdkContextGenerator::addActions(Util::JsonWriter &json, const IR::P4Table *table,
+                                      const cstring controlName, bool isMatch) {
+    json.beginArray();
     for (auto action : table->getActionList()->actionList) {
         struct actionAttributes attr = ::P4::get(actionAttrMap, action->getName());
         // Printing compiler added actions is curently not required
         if (!attr.is_compiler_added_action) {
-            auto *act = new Util::JsonObject();
+            json.beginObject();
             auto actName = toStr(action->expression);
             auto name = action->externalName();
             if (name != "NoAction") {
@@ -395,16 +392,16 @@ Util::JsonArray *DpdkContextGenerator::addActions(const IR::P4Table *table,
             } else {
                 actName = name;
             }
-            act->emplace("name", attr.externalName);
-            act->emplace("target_name", actName);
-            act->emplace("handle", attr.actionHandle);
+            json.member("name", attr.externalName);
+            json.member("target_name", actName);
+            json.member("handle", attr.actionHandle);
             if (isMatch) {
-                act->emplace("constant_default_action", attr.constant_default_action);
-                act->emplace("is_compiler_added_action", attr.is_compiler_added_action);
-                act->emplace("allowed_as_hit_action", attr.allowed_as_hit_action);
-                act->emplace("allowed_as_default_action", attr.allowed_as_default_action);
+                json.member("constant_default_action", attr.constant_default_action);
+                json.member("is_compiler_added_action", attr.is_compiler_added_action);
+                json.member("allowed_as_hit_action", attr.allowed_as_hit_action);
+                json.member("allowed_as_default_action", attr.allowed_as_default_action);
             }
-            auto *paramJson = new Util::JsonArray();
+            json.key("p4_parameters").beginArray();
             if (attr.params) {
                 int index = 0;
                 int position = 0;
@@ -416,86 +413,88 @@ Util::JsonArray *DpdkContextGenerator::addActions(const IR::P4Table *table,
                     } else if (!param->type->is<IR::Type_Boolean>()) {
                         BUG("Unsupported parameter type %1%", param->type);
                     }
-                    addActionParam(paramJson, param->name.originalName, param_width, position,
+                    addActionParam(json, param->name.originalName, param_width, position,
                                    index / 8);
                     index += param_width;
                     position++;
                 }
             }
-            act->emplace("p4_parameters"_cs, paramJson);
-            actArray->append(act);
+            json.endArray();
+            json.endObject();
         }
     }
-    return actArray;
+    json.endArray();
 }
 
 /// This function adds the tables referred by this table.
-bool DpdkContextGenerator::addRefTables(const cstring tbl_name, const IR::P4Table **memberTable,
-                                        Util::JsonObject *tableJson) {
+bool DpdkContextGenerator::addRefTables(Util::JsonWriter &json, const cstring tbl_name,
+                                        const IR::P4Table **memberTable) {
     bool hasActionProfileSelector = false;
 
     // Below empty arrays are currently required by the control plane software.
     // May be removed in future.
-    tableJson->emplace("stateful_table_refs", new Util::JsonArray());
-    tableJson->emplace("statistics_table_refs", new Util::JsonArray());
-    tableJson->emplace("meter_table_refs", new Util::JsonArray());
+    json.key("stateful_table_refs").beginArray().endArray();
+    json.key("statistics_table_refs").beginArray().endArray();
+    json.key("meter_table_refs").beginArray().endArray();
 
     // Reference to compiler generated member table in case of action profile and action selector.
     if (structure->member_tables.count(tbl_name)) {
-        auto *actionDataJson = new Util::JsonArray();
         hasActionProfileSelector = true;
         *memberTable = structure->member_tables.at(tbl_name);
-        auto *actionDataField = new Util::JsonObject();
         auto tableAttr = ::P4::get(tableAttrmap, (*memberTable)->name.originalName);
         auto tableName = tableAttr.controlName + "." + (*memberTable)->name.originalName;
-        actionDataField->emplace("name", tableName);
-        actionDataField->emplace("handle", tableAttr.tableHandle);
-        actionDataJson->append(actionDataField);
-        tableJson->emplace("action_data_table_refs"_cs, actionDataJson);
+        json.key("action_data_table_refs").beginArray();
+        json.beginObject();
+        json.member("name", tableName);
+        json.member("handle", tableAttr.tableHandle);
+        json.endObject();
+        json.endArray();
     }
 
     // Reference to compiler generated group table in case of action selector
     if (structure->group_tables.count(tbl_name)) {
-        auto *selectionJson = new Util::JsonArray();
         hasActionProfileSelector = true;
         auto groupTable = structure->group_tables.at(tbl_name);
-        auto *selectField = new Util::JsonObject();
         auto tableAttr = ::P4::get(tableAttrmap, groupTable->name.originalName);
         auto tableName = tableAttr.controlName + "." + groupTable->name.originalName;
-        selectField->emplace("name", tableName);
-        selectField->emplace("handle", tableAttr.tableHandle);
-        selectionJson->append(selectField);
-        tableJson->emplace("selection_table_refs", selectionJson);
+        json.key("selection_table_refs").beginArray();
+        json.beginObject();
+        json.member("name", tableName);
+        json.member("handle", tableAttr.tableHandle);
+        json.endObject();
+        json.endArray();
     }
 
     if (hasActionProfileSelector) {
-        tableJson->emplace("action_profile", (*memberTable)->name.originalName);
+        json.member("action_profile", (*memberTable)->name.originalName);
     }
     return hasActionProfileSelector;
 }
 
 /// Add tables to the context json.
-void DpdkContextGenerator::addMatchTables(Util::JsonArray *tablesJson) {
+void DpdkContextGenerator::addMatchTables(Util::JsonWriter &json) {
+    json.beginArray();
     for (auto t : tables) {
         auto tbl = t->to<IR::P4Table>();
         auto tableAttr = ::P4::get(tableAttrmap, tbl->name.originalName);
-        auto *tableJson = initTableCommonJson(tbl->name.originalName, tableAttr);
+        json.beginObject();
+        initTableCommonJson(json, tbl->name.originalName, tableAttr);
         bool hasActionProfileSelector = false;
         bool isMatchTable = tableAttr.tableType == "match";
         const IR::P4Table *memberTable = nullptr;
         if (tableAttr.tableType != "selection") {
             if (isMatchTable) {
-                hasActionProfileSelector = addRefTables(tbl->name, &memberTable, tableJson);
+                hasActionProfileSelector = addRefTables(json, tbl->name, &memberTable);
                 auto match_keys = tbl->getKey();
                 if (match_keys) {
-                    auto *keyJson = new Util::JsonArray();
+                    json.key("match_key_fields").beginArray();
                     int position = 0;
                     for (auto matchKeyFromPrg : tableAttr.tableKeys) {
-                        addKeyField(keyJson, matchKeyFromPrg.first, matchKeyFromPrg.second,
+                        addKeyField(json, matchKeyFromPrg.first, matchKeyFromPrg.second,
                                     match_keys->keyElements.at(position), position);
                         position++;
                     }
-                    tableJson->emplace("match_key_fields"_cs, keyJson);
+                    json.endArray();
                 }
             }
             // If table implementation is action profile or action selector, all actions from member
@@ -511,68 +510,71 @@ void DpdkContextGenerator::addMatchTables(Util::JsonArray *tablesJson) {
             setDefaultActionHandle(table);
 
             tableAttr = ::P4::get(tableAttrmap, table->name.originalName);
-            tableJson->emplace("actions", addActions(table, tableAttr.controlName, isMatchTable));
+            json.key("actions");
+            addActions(json, table, tableAttr.controlName, isMatchTable);
             if (isMatchTable) {
-                tableJson->emplace("match_attributes",
-                                   addMatchAttributes(table, tableAttr.controlName));
+                json.key("match_attributes");
+                addMatchAttributes(json, table, tableAttr.controlName);
             }
-            tableJson->emplace("default_action_handle", tableAttr.default_action_handle);
+            json.member("default_action_handle", tableAttr.default_action_handle);
         } else {
             SelectionTable sel;
             sel.setAttributes(tbl, tableAttrmap);
-            tableJson->emplace("max_n_groups", sel.max_n_groups);
-            tableJson->emplace("max_n_members_per_group", sel.max_n_members_per_group);
-            tableJson->emplace("bound_to_action_data_table_handle",
-                               sel.bound_to_action_data_table_handle);
+            json.member("max_n_groups", sel.max_n_groups);
+            json.member("max_n_members_per_group", sel.max_n_members_per_group);
+            json.member("bound_to_action_data_table_handle",
+                        sel.bound_to_action_data_table_handle);
         }
-        tablesJson->append(tableJson);
+        json.endObject();
     }
+    json.endArray();
 }
 
 /// Add extern information to the context json.
-void DpdkContextGenerator::addExternInfo(Util::JsonArray *externsJson) {
+void DpdkContextGenerator::addExternInfo(Util::JsonWriter &json) {
+    json.beginArray();
     for (auto t : externs) {
         auto externAttr = ::P4::get(externAttrMap, t->name.name);
-        auto *externJson = new Util::JsonObject();
-        externJson->emplace("name", externAttr.externalName);
-        externJson->emplace("target_name", t->name.name);
-        externJson->emplace("type", externAttr.externType);
-        auto *attrJson = new Util::JsonObject();
+        json.beginObject();
+        json.member("name", externAttr.externalName);
+        json.member("target_name", t->name.name);
+        json.member("type", externAttr.externType);
+        json.key("attributes").beginObject();
         if (externAttr.externType == "Counter" || externAttr.externType == "DirectCounter") {
-            attrJson->emplace("type", externAttr.counterType);
+            json.member("type", externAttr.counterType);
         }
         if (externAttr.externType == "DirectCounter" || externAttr.externType == "DirectMeter") {
-            attrJson->emplace("table_id", externAttr.table_id);
+            json.member("table_id", externAttr.table_id);
         }
-        externJson->emplace("attributes", attrJson);
-        externsJson->append(externJson);
+        json.endObject();
+        json.endObject();
     }
+    json.endArray();
 }
 
-const Util::JsonObject *DpdkContextGenerator::genContextJsonObject() {
-    auto *json = new Util::JsonObject();
-    auto *tablesJson = new Util::JsonArray();
-    auto *externsJson = new Util::JsonArray();
+void DpdkContextGenerator::genContextJson(Util::JsonWriter &json) {
     struct TopLevelCtxt tlinfo;
     tlinfo.initTopLevelCtxt(options);
-    json->emplace("program_name", tlinfo.progName);
-    json->emplace("build_date", tlinfo.buildDate);
-    json->emplace("compile_command", tlinfo.compileCommand);
-    json->emplace("compiler_version", tlinfo.compilerVersion);
-    json->emplace("schema_version", "0.1");
-    json->emplace("target", "DPDK");
-    json->emplace("tables", tablesJson);
-    addMatchTables(tablesJson);
-    json->emplace("externs", externsJson);
-    addExternInfo(externsJson);
-    return json;
+    json.beginObject();
+    json.member("program_name", tlinfo.progName);
+    json.member("build_date", tlinfo.buildDate);
+    json.member("compile_command", tlinfo.compileCommand);
+    json.member("compiler_version", tlinfo.compilerVersion);
+    json.member("schema_version", "0.1");
+    json.member("target", "DPDK");
+    json.key("tables");
+    addMatchTables(json);
+    json.key("externs");
+    addExternInfo(json);
+    json.endObject();
 }
 
 void DpdkContextGenerator::serializeContextJson(std::ostream *destination) {
     collectHandleId();
     CollectTablesAndSetAttributes();
-    auto *json = genContextJsonObject();
-    json->serialize(*destination);
+    // The context is written as it is generated, without building a JsonObject tree first.
+    Util::JsonWriter json(*destination);
+    genContextJson(json);
     destination->flush();
 }
 
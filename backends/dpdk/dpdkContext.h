@@ -144,22 +144,26 @@ class DpdkContextGenerator : public Inspector {
         : refmap(refmap), structure(structure), p4info(p4info), options(options) {}
 
     void serializeContextJson(std::ostream *destination);
-    const Util::JsonObject *genContextJsonObject();
-    void addMatchTables(Util::JsonArray *tablesJson);
+    /// The methods below write their part of the context JSON to @p json.
+    void genContextJson(Util::JsonWriter &json);
+    void addMatchTables(Util::JsonWriter &json);
     size_t getHandleId(cstring name);
     void collectHandleId();
-    void addExternInfo(Util::JsonArray *externsJson);
-    Util::JsonObject *initTableCommonJson(const cstring name, const struct TableAttributes &attr);
-    void addKeyField(Util::JsonArray *keyJson, const cstring name, const cstring annon,
+    void addExternInfo(Util::JsonWriter &json);
+    void initTableCommonJson(Util::JsonWriter &json, const cstring name,
+                             const struct TableAttributes &attr);
+    void addKeyField(Util::JsonWriter &json, const cstring name, const cstring annon,
                      const IR::KeyElement *key, int position);
-    Util::JsonArray *addActions(const IR::P4Table *table, const cstring ctrlName, bool isMatch);
-    bool addRefTables(const cstring tbl_name, const IR::P4Table **memberTable,
-                      Util::JsonObject *tableJson);
-    void addImmediateField(Util::JsonArray *paramJson, const cstring name, int dest_start,
+    void addActions(Util::JsonWriter &json, const IR::P4Table *table, const cstring ctrlName,
+                    bool isMatch);
+    bool addRefTables(Util::JsonWriter &json, const cstring tbl_name,
+                      const IR::P4Table **memberTable);
+    void addImmediateField(Util::JsonWriter &json, const cstring name, int dest_start,
                            int dest_Width);
-    void addActionParam(Util::JsonArray *paramJson, const cstring name, int bitWidth, int position,
+    void addActionParam(Util::JsonWriter &json, const cstring name, int bitWidth, int position,
                         int byte_array_index);
-    Util::JsonObject *addMatchAttributes(const IR::P4Table *table, const cstring ctrlName);
+    void addMatchAttributes(Util::JsonWriter &json, const IR::P4Table *table,
+                            const cstring ctrlName);
     void setActionAttributes(const IR::P4Table *table);
     void setDefaultActionHandle(const IR::P4Table *table);
     void CollectTablesAndSetAttributes();
@@ -28,9 +28,11 @@ limitations under the License.
 #include "control-plane/bfruntime_ext.h"
 #include "control-plane/p4RuntimeSerializer.h"
 #include "frontends/common/applyOptionsPragmas.h"
+#include "frontends/common/compileServer.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/common/parser_options.h"
 #include "frontends/p4/frontend.h"
+#include "frontends/p4/metrics/metricsPassManager.h"
 #include "ir/ir.h"
 #include "ir/json_loader.h"
 #include "lib/error.h"
@@ -62,9 +64,7 @@ void generateTDIBfrtJson(bool isTDI, const IR::P4Program *program, DPDK::DpdkOpt
     p4rt->serializeBFRuntimeSchema(out);
 }
 
-int main(int argc, char *const argv[]) {
-    setup_gc_logging();
-
+static int compile(int argc, char *const argv[]) {
     AutoCompileContext autoDpdkContext(new DPDK::DpdkContext);
     auto &options = DPDK::DpdkContext::get().options();
     options.langVersion = CompilerOptions::FrontendVersion::P4_16;
@@ -129,11 +129,16 @@ int main(int argc, char *const argv[]) {
     if (::P4::errorCount() > 0) return 1;
     auto p4info = *P4::generateP4Runtime(program, options.arch).p4Info;
     DPDK::DpdkMidEnd midEnd(options);
+    P4::MetricsPassManager metricsPassManager(options, nullptr,
+                                              P4CContext::get().options().metrics);
     midEnd.addDebugHook(hook);
+    midEnd.addDebugHook(metricsPassManager.getSnapshotHook(), true);
+    midEnd.addDebugHook(metricsPassManager.getProfileHook(program), true);
     try {
         toplevel = midEnd.process(program);
         if (::P4::errorCount() > 1 || toplevel == nullptr || toplevel->getMain() == nullptr)
             return 1;
+        metricsPassManager.exportCompileProfile(program);
         if (!options.dumpJsonFile.empty())
             JSONGenerator(*openFile(options.dumpJsonFile, true), true).emit(program);
     } catch (const std::exception &bug) {
@@ -157,3 +162,9 @@ int main(int argc, char *const argv[]) {
 
     return ::P4::errorCount() > 0;
 }
+
+int main(int argc, char *const argv[]) {
+    setup_gc_logging();
+
+    return P4::CompileServer::main(argc, argv, compile);
+}
@@ -24,6 +24,7 @@ limitations under the License.
 #include "ebpfBackend.h"
 #include "ebpfOptions.h"
 #include "frontends/common/applyOptionsPragmas.h"
+#include "frontends/common/compileServer.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/p4/frontend.h"
 #include "fstream"
@@ -90,10 +91,7 @@ void compile(EbpfOptions &options) {
     EBPF::run_ebpf_backend(options, toplevel, &midend.refMap, &midend.typeMap);
 }
 
-int main(int argc, char *const argv[]) {
-    setup_gc_logging();
-    setup_signals();
-
+static int compileCommandLine(int argc, char *const argv[]) {
     AutoCompileContext autoEbpfContext(new EbpfContext);
     auto &options = EbpfContext::get().options();
     options.compilerVersion = cstring(P4C_EBPF_VERSION_STRING);
@@ -114,3 +112,10 @@ int main(int argc, char *const argv[]) {
     if (Log::verbose()) std::cerr << "Done." << std::endl;
     return ::P4::errorCount() > 0;
 }
+
+int main(int argc, char *const argv[]) {
+    setup_gc_logging();
+    setup_signals();
+
+    return P4::CompileServer::main(argc, argv, compileCommandLine);
+}
@@ -17,6 +17,7 @@ limitations under the License.
 #include "backends/graphs/version.h"
 #include "controls.h"
 #include "frontends/common/applyOptionsPragmas.h"
+#include "frontends/common/compileServer.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/p4/evaluator/evaluator.h"
 #include "frontends/p4/frontend.h"
@@ -124,10 +125,7 @@ using GraphsContext = P4CContextWithOptions<Options>;
 
 using namespace P4;
 
-int main(int argc, char *const argv[]) {
-    setup_gc_logging();
-    setup_signals();
-
+static int compile(int argc, char *const argv[]) {
     AutoCompileContext autoGraphsContext(new ::graphs::GraphsContext);
     auto &options = ::graphs::GraphsContext::get().options();
     options.langVersion = CompilerOptions::FrontendVersion::P4_16;
@@ -203,3 +201,10 @@ int main(int argc, char *const argv[]) {
 
     return ::P4::errorCount() > 0;
 }
+
+int main(int argc, char *const argv[]) {
+    setup_gc_logging();
+    setup_signals();
+
+    return P4::CompileServer::main(argc, argv, compile);
+}
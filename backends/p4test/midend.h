@@ -32,6 +32,7 @@ class MidEnd : public PassManager {
     P4::TypeMap typeMap;
     IR::ToplevelBlock *toplevel = nullptr;
 
+    /// The hooks are added recursively, they also see the passes of nested pass managers.
     void addDebugHook(DebugHook hook) { hooks.push_back(hook); }
     explicit MidEnd(P4TestOptions &options, std::ostream *outStream = nullptr);
     IR::ToplevelBlock *process(const IR::P4Program *&program) {
@@ -22,10 +22,16 @@ limitations under the License.
 #include "backends/p4test/version.h"
 #include "control-plane/p4RuntimeSerializer.h"
 #include "frontends/common/applyOptionsPragmas.h"
+#include "frontends/common/compileServer.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/p4/evaluator/evaluator.h"
 #include "frontends/p4/frontend.h"
+#include "frontends/p4/metrics/metricsBatch.h"
+#include "frontends/p4/metrics/metricsBinary.h"
+#include "frontends/p4/metrics/metricsPassManager.h"
 #include "frontends/p4/toP4/toP4.h"
+#include "ir/binary_ir_reader.h"
+#include "ir/binary_ir_writer.h"
 #include "ir/ir.h"
 #include "ir/json_loader.h"
 #include "ir/pass_utils.h"
@@ -70,6 +76,14 @@ P4TestOptions::P4TestOptions() {
             return true;
         },
         "read previously dumped json instead of P4 source code");
+    registerOption(
+        "--fromBinaryIR", "file",
+        [this](const char *arg) {
+            loadIRFromBinary = true;
+            file = arg;
+            return true;
+        },
+        "read previously dumped binary IR instead of P4 source code");
     registerOption(
         "--turn-off-logn", nullptr,
         [](const char *) {
@@ -137,17 +151,22 @@ static void log_dump(const IR::Node *node, const char *head) {
     }
 }
 
-int main(int argc, char *const argv[]) {
-    setup_gc_logging();
-    setup_signals();
-
+static int compile(int argc, char *const argv[]) {
     AutoCompileContext autoP4TestContext(new P4TestContext);
     auto &options = P4TestContext::get().options();
     options.langVersion = CompilerOptions::FrontendVersion::P4_16;
     options.compilerVersion = cstring(P4TEST_VERSION_STRING);
 
-    if (options.process(argc, argv) != nullptr) {
-        if (options.loadIRFromJson == false) options.setInputFile();
+    auto *remainingOptions = options.process(argc, argv);
+    if (remainingOptions != nullptr && options.metricsDiff) {
+        return P4::runMetricsDiff(*remainingOptions, options.metricsDiffThreshold);
+    }
+    if (remainingOptions != nullptr && options.metricsBatch) {
+        P4::MetricsBatch batch(options, *remainingOptions);
+        return batch.run() && ::P4::errorCount() == 0 ? 0 : 1;
+    }
+    if (remainingOptions != nullptr) {
+        if (!options.loadIRFromJson && !options.loadIRFromBinary) options.setInputFile();
     }
     if (::P4::errorCount() > 0) return 1;
     const IR::P4Program *program = nullptr;
@@ -163,6 +182,14 @@ int main(int argc, char *const argv[]) {
         } else {
             error(ErrorType::ERR_IO, "Can't open %s", options.file);
         }
+    } else if (options.loadIRFromBinary) {
+        BinaryIRReader reader;
+        if (reader.open(options.file.string())) {
+            const IR::Node *node = reader.root();
+            if (node && !(program = node->to<IR::P4Program>()))
+                error(ErrorType::ERR_INVALID, "%s is not a P4Program in binary IR format",
+                      options.file);
+        }
     } else {
         P4::DiagnosticCountInfo info;
         program = P4::parseP4File(options);
@@ -196,7 +223,11 @@ int main(int argc, char *const argv[]) {
 
         if (!options.parseOnly && !options.validateOnly) {
             P4Test::MidEnd midEnd(options);
+            P4::MetricsPassManager metricsPassManager(options, nullptr,
+                                                      P4CContext::get().options().metrics);
             midEnd.addDebugHook(hook);
+            midEnd.addDebugHook(metricsPassManager.getSnapshotHook());
+            midEnd.addDebugHook(metricsPassManager.getProfileHook(program));
 #if 0
             /* doing this breaks the output until we get dump/undump of srcInfo */
             if (options.debugJson) {
@@ -211,6 +242,7 @@ int main(int argc, char *const argv[]) {
             try {
                 top = midEnd.process(program);
                 // This can modify program!
+                metricsPassManager.exportCompileProfile(program);
                 log_dump(program, "After midend");
                 log_dump(top, "Top level block");
             } catch (const std::exception &bug) {
@@ -221,6 +253,8 @@ int main(int argc, char *const argv[]) {
         if (program) {
             if (!options.dumpJsonFile.empty())
                 JSONGenerator(*openFile(options.dumpJsonFile, true), true).emit(program);
+            if (!options.dumpBinaryIRFile.empty())
+                BinaryIRWriter(true).write(*openFile(options.dumpBinaryIRFile, true), program);
             if (options.debugJson) {
                 std::stringstream ss1, ss2;
                 JSONGenerator gen1(ss1), gen2(ss2);
@@ -247,3 +281,10 @@ int main(int argc, char *const argv[]) {
     if (Log::verbose()) std::cerr << "Done." << std::endl;
     return ::P4::errorCount() > 0;
 }
+
+int main(int argc, char *const argv[]) {
+    setup_gc_logging();
+    setup_signals();
+
+    return P4::CompileServer::main(argc, argv, compile);
+}
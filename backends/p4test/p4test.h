@@ -26,6 +26,7 @@ class P4TestOptions : public CompilerOptions {
     bool parseOnly = false;
     bool validateOnly = false;
     bool loadIRFromJson = false;
+    bool loadIRFromBinary = false;
     bool preferSwitch = false;
     P4TestOptions();
 };
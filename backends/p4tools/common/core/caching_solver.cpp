@@ -0,0 +1,291 @@
+#include "backends/p4tools/common/core/caching_solver.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "frontends/p4/optimizeExpressions.h"
+#include "ir/visitor.h"
+#include "lib/exceptions.h"
+#include "lib/timer.h"
+
+namespace P4::P4Tools {
+
+namespace {
+
+/// The number of answers kept before the cache starts afresh.
+constexpr size_t MAX_ENTRIES = 1 << 14;
+
+/// The number of most recent answers searched for counterexamples.
+constexpr size_t COUNTEREXAMPLE_WINDOW = 256;
+
+/// The number of cached models tried as the solution of a set.
+constexpr size_t MAX_MODEL_TRIES = 4;
+
+/// Collects the symbolic variables of an expression, in the order they are encountered.
+class CollectSymbolicVariables : public Inspector {
+    std::vector<const IR::SymbolicVariable *> &variables;
+
+ public:
+    explicit CollectSymbolicVariables(std::vector<const IR::SymbolicVariable *> &variables)
+        : variables(variables) {}
+
+    bool preorder(const IR::SymbolicVariable *var) override {
+        variables.push_back(var);
+        return false;
+    }
+};
+
+/// Replaces the symbolic variables of an expression with their values in a model. Expressions
+/// whose evaluation might report a diagnostic are marked as unsupported.
+class SubstituteModel : public Transform {
+    const SymbolicMapping &model;
+
+ public:
+    bool unsupported = false;
+
+    explicit SubstituteModel(const SymbolicMapping &model) : model(model) {}
+
+    const IR::Node *preorder(IR::SymbolicVariable *var) override {
+        prune();
+        auto it = model.find(var);
+        if (it == model.end()) {
+            unsupported = true;
+            return var;
+        }
+        return it->second;
+    }
+
+    const IR::Node *preorder(IR::Div *div) override {
+        unsupported = true;
+        prune();
+        return div;
+    }
+
+    const IR::Node *preorder(IR::Mod *mod) override {
+        unsupported = true;
+        prune();
+        return mod;
+    }
+};
+
+/// A union-find structure over the constraints of a query.
+class DisjointSets {
+    std::vector<size_t> parent;
+
+ public:
+    explicit DisjointSets(size_t size) : parent(size) {
+        std::iota(parent.begin(), parent.end(), 0);
+    }
+
+    size_t find(size_t element) {
+        while (parent[element] != element) {
+            parent[element] = parent[parent[element]];
+            element = parent[element];
+        }
+        return element;
+    }
+
+    /// Merges the sets of @param a and @param b. The smaller element becomes the representative.
+    void merge(size_t a, size_t b) {
+        a = find(a);
+        b = find(b);
+        if (a < b) {
+            parent[b] = a;
+        } else {
+            parent[a] = b;
+        }
+    }
+};
+
+}  // namespace
+
+CachingSolver::CachingSolver(AbstractSolver &solver) : solver(solver) {}
+
+void CachingSolver::comment(cstring comment) { solver.comment(comment); }
+
+void CachingSolver::seed(unsigned seed) { solver.seed(seed); }
+
+void CachingSolver::timeout(unsigned tm) { solver.timeout(tm); }
+
+std::vector<CachingSolver::Slice> CachingSolver::split(
+    const std::vector<const Constraint *> &asserts) {
+    // Merge the constraints which share a variable. Constraints without variables end up in
+    // the set of the first such constraint.
+    DisjointSets sets(asserts.size());
+    std::map<const IR::SymbolicVariable *, size_t, IR::SymbolicVariableLess> owners;
+    std::vector<std::vector<const IR::SymbolicVariable *>> variables(asserts.size());
+    std::optional<size_t> firstGround;
+    for (size_t i = 0; i < asserts.size(); i++) {
+        asserts[i]->apply(CollectSymbolicVariables(variables[i]));
+        if (variables[i].empty()) {
+            if (firstGround) {
+                sets.merge(*firstGround, i);
+            } else {
+                firstGround = i;
+            }
+        }
+        for (const auto *var : variables[i]) {
+            auto [it, inserted] = owners.emplace(var, i);
+            if (!inserted) {
+                sets.merge(it->second, i);
+            }
+        }
+    }
+
+    std::vector<Slice> slices;
+    std::map<size_t, size_t> sliceOfSet;
+    for (size_t i = 0; i < asserts.size(); i++) {
+        auto [it, inserted] = sliceOfSet.emplace(sets.find(i), slices.size());
+        if (inserted) {
+            slices.emplace_back();
+        }
+        auto &slice = slices[it->second];
+        slice.constraints.push_back(asserts[i]);
+        for (const auto *var : variables[i]) {
+            // Each variable is listed in the slice of the constraint which owns it.
+            if (owners.at(var) == i) {
+                slice.variables.push_back(var);
+            }
+        }
+    }
+    return slices;
+}
+
+CachingSolver::Key CachingSolver::makeKey(const std::vector<const Constraint *> &constraints) {
+    Key key(constraints);
+    std::sort(key.begin(), key.end());
+    key.erase(std::unique(key.begin(), key.end()), key.end());
+    return key;
+}
+
+bool CachingSolver::satisfies(const SymbolicMapping &model, const Slice &slice,
+                              const Key &known) {
+    for (const auto *var : slice.variables) {
+        if (model.find(var) == model.end()) {
+            return false;
+        }
+    }
+    for (const auto *constraint : slice.constraints) {
+        if (std::binary_search(known.begin(), known.end(), constraint)) {
+            continue;
+        }
+        SubstituteModel substitute(model);
+        const auto *substituted = constraint->apply(substitute);
+        if (substitute.unsupported) {
+            return false;
+        }
+        const auto *value = P4::optimizeExpression(substituted)->to<IR::BoolLiteral>();
+        if (value == nullptr || !value->value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const CachingSolver::Entry *CachingSolver::store(Entry entry) {
+    if (entries.size() >= MAX_ENTRIES) {
+        clearCache();
+    }
+    index.emplace(entry.key, entries.size());
+    entries.push_back(std::move(entry));
+    return &entries.back();
+}
+
+const CachingSolver::Entry *CachingSolver::lookup(const Slice &slice, const Key &key) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+        statistics.cacheHits++;
+        return &entries[it->second];
+    }
+
+    size_t modelTries = 0;
+    size_t end = entries.size() > COUNTEREXAMPLE_WINDOW ? entries.size() - COUNTEREXAMPLE_WINDOW
+                                                        : 0;
+    for (size_t i = entries.size(); i-- > end;) {
+        const auto &entry = entries[i];
+        bool isSubset = std::includes(key.begin(), key.end(), entry.key.begin(), entry.key.end());
+        // Adding constraints to unsatisfiable ones keeps them unsatisfiable.
+        if (isSubset && !entry.result) {
+            statistics.counterexampleHits++;
+            return store({key, false, nullptr});
+        }
+        if (!entry.result) {
+            continue;
+        }
+        // A solution of a superset is a solution of its subsets.
+        if (std::includes(entry.key.begin(), entry.key.end(), key.begin(), key.end())) {
+            statistics.counterexampleHits++;
+            return store({key, true, entry.model});
+        }
+        // The solution of a subset may happen to satisfy the remaining constraints as well.
+        if (isSubset && modelTries < MAX_MODEL_TRIES) {
+            modelTries++;
+            if (satisfies(*entry.model, slice, entry.key)) {
+                statistics.counterexampleHits++;
+                return store({key, true, entry.model});
+            }
+        }
+    }
+    return nullptr;
+}
+
+std::optional<bool> CachingSolver::checkSat(const std::vector<const Constraint *> &asserts) {
+    Util::ScopedTimer timer("caching_solver");
+    statistics.queries++;
+    model = nullptr;
+    auto *result = new SymbolicMapping();
+    bool timedOut = false;
+    for (const auto &slice : split(asserts)) {
+        statistics.sets++;
+        auto key = makeKey(slice.constraints);
+        const auto *entry = lookup(slice, key);
+        if (entry == nullptr) {
+            statistics.solverCalls++;
+            auto isSat = solver.checkSat(slice.constraints);
+            if (!isSat.has_value()) {
+                timedOut = true;
+                continue;
+            }
+            const SymbolicMapping *sliceModel = nullptr;
+            if (*isSat) {
+                sliceModel = new SymbolicMapping(solver.getSymbolicMapping());
+            }
+            entry = store({std::move(key), *isSat, sliceModel});
+        }
+        if (!entry->result) {
+            return false;
+        }
+        for (const auto &[var, value] : *entry->model) {
+            result->emplace(var, value);
+        }
+    }
+    if (timedOut) {
+        return std::nullopt;
+    }
+    model = result;
+    return true;
+}
+
+const SymbolicMapping &CachingSolver::getSymbolicMapping() const {
+    BUG_CHECK(model != nullptr, "CachingSolver: no model, the last query was not satisfiable.");
+    return *model;
+}
+
+void CachingSolver::toJSON(JSONGenerator &json) const { solver.toJSON(json); }
+
+bool CachingSolver::isInIncrementalMode() const { return solver.isInIncrementalMode(); }
+
+AbstractSolver &CachingSolver::getSolver() const { return solver; }
+
+const CachingSolver::Statistics &CachingSolver::getStatistics() const { return statistics; }
+
+void CachingSolver::clearCache() {
+    entries.clear();
+    index.clear();
+}
+
+}  // namespace P4::P4Tools
@@ -0,0 +1,134 @@
+#ifndef BACKENDS_P4TOOLS_COMMON_CORE_CACHING_SOLVER_H_
+#define BACKENDS_P4TOOLS_COMMON_CORE_CACHING_SOLVER_H_
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/json_generator.h"
+#include "ir/solver.h"
+#include "lib/cstring.h"
+#include "lib/rtti.h"
+
+namespace P4::P4Tools {
+
+/// An AbstractSolver which answers queries with as few calls to a backing solver as possible,
+/// in the manner of the solver chain of KLEE:
+///   - Independence: the constraints of a query are sliced into sets which do not share any
+///     symbolic variables. Each set is solved on its own, a query is satisfiable if all of its
+///     sets are, and its model is the union of their models.
+///   - Caching: the result and model of every set is cached, keyed by the constraints of the
+///     set. Consecutive queries of symbolic execution mostly differ in the set containing the
+///     newest constraint, all other sets are answered from the cache.
+///   - Counterexamples: a set which contains a cached unsatisfiable set is unsatisfiable. The
+///     cached models of subsets of a set are tried as its solution before the backing solver is
+///     called.
+///
+/// Results are deterministic for a given sequence of queries. Timeouts are not cached.
+class CachingSolver : public AbstractSolver {
+ public:
+    /// Counts how queries were answered.
+    struct Statistics {
+        /// Calls to checkSat.
+        size_t queries = 0;
+
+        /// Independent constraint sets checked.
+        size_t sets = 0;
+
+        /// Sets answered by a cached result.
+        size_t cacheHits = 0;
+
+        /// Sets answered by a cached unsatisfiable subset or a cached model.
+        size_t counterexampleHits = 0;
+
+        /// Sets passed on to the backing solver.
+        size_t solverCalls = 0;
+    };
+
+    /// Answers queries with @param solver, which must outlive this solver.
+    explicit CachingSolver(AbstractSolver &solver);
+
+    void comment(cstring comment) override;
+
+    void seed(unsigned seed) override;
+
+    void timeout(unsigned tm) override;
+
+    std::optional<bool> checkSat(const std::vector<const Constraint *> &asserts) override;
+
+    [[nodiscard]] const SymbolicMapping &getSymbolicMapping() const override;
+
+    void toJSON(JSONGenerator &json) const override;
+
+    [[nodiscard]] bool isInIncrementalMode() const override;
+
+    /// @returns the solver backing this cache.
+    [[nodiscard]] AbstractSolver &getSolver() const;
+
+    [[nodiscard]] const Statistics &getStatistics() const;
+
+    /// Drops all cached results.
+    void clearCache();
+
+ private:
+    /// The constraints of an independent set, ordered by address and without duplicates. The
+    /// order only serves lookups, it never decides which answer is used.
+    using Key = std::vector<const Constraint *>;
+
+    struct Entry {
+        Key key;
+
+        /// Whether the constraints are satisfiable.
+        bool result;
+
+        /// The model of satisfiable constraints, null otherwise.
+        const SymbolicMapping *model;
+    };
+
+    /// A set of constraints which shares no symbolic variables with other sets.
+    struct Slice {
+        std::vector<const Constraint *> constraints;
+        std::vector<const IR::SymbolicVariable *> variables;
+    };
+
+    /// Splits @param asserts into independent sets, in the order of their first constraint.
+    static std::vector<Slice> split(const std::vector<const Constraint *> &asserts);
+
+    /// @returns the key of @param constraints.
+    static Key makeKey(const std::vector<const Constraint *> &constraints);
+
+    /// Returns the cached answer for @param slice with @param key, or tries to derive one from
+    /// the cache. Returns null if the backing solver has to be asked.
+    const Entry *lookup(const Slice &slice, const Key &key);
+
+    /// @returns true if @param model binds all variables of @param slice and satisfies its
+    /// constraints. Constraints in @param known are satisfied by construction.
+    static bool satisfies(const SymbolicMapping &model, const Slice &slice, const Key &known);
+
+    /// Stores an answer, starting the cache afresh when it is full. The returned entry is valid
+    /// until the next answer is stored.
+    const Entry *store(Entry entry);
+
+    /// The solver which answers queries which are not in the cache.
+    AbstractSolver &solver;
+
+    /// The cached answers, in the order they were found. Counterexamples are searched from
+    /// the most recent answer backwards, which keeps the search deterministic.
+    std::vector<Entry> entries;
+
+    /// Maps the key of a set of constraints to its entry.
+    std::map<Key, size_t> index;
+
+    /// The model of the last satisfiable query.
+    const SymbolicMapping *model = nullptr;
+
+    Statistics statistics;
+
+    DECLARE_TYPEINFO(CachingSolver, AbstractSolver);
+};
+
+}  // namespace P4::P4Tools
+
+#endif /* BACKENDS_P4TOOLS_COMMON_CORE_CACHING_SOLVER_H_ */
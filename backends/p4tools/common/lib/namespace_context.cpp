@@ -1,5 +1,6 @@
 #include "backends/p4tools/common/lib/namespace_context.h"
 
+#include <mutex>
 #include <set>
 #include <vector>
 
@@ -92,6 +93,9 @@ const IR::IDeclaration *NamespaceContext::findDecl(const IR::Path *path) const {
 }
 
 const std::set<cstring> &NamespaceContext::getUsedNames() const {
+    // Namespace contexts are shared by the execution states of concurrent executors.
+    static std::recursive_mutex usedNamesMutex;
+    std::lock_guard<std::recursive_mutex> lock(usedNamesMutex);
     if (!usedNames) {
         if (this == Empty) {
             usedNames = *new std::set<cstring>();
@@ -4,14 +4,21 @@
 #include "backends/p4tools/common/lib/model.h"
 #include "ir/ir.h"
 #include "ir/node.h"
+#include "lib/persistent_map.h"
 
 namespace P4::P4Tools {
 
 /// A symbolic environment maps variables to their symbolic value. A symbolic value is just an
 /// expression on the program's initial state.
+///
+/// Copies of an environment share their unchanged entries, so copying an environment is O(1)
+/// and setting a variable is O(log n).
 class SymbolicEnv {
+ public:
+    using MapType = persistent_map<IR::StateVariable, const IR::Expression *>;
+
  private:
-    SymbolicMapType map;
+    MapType map;
 
  public:
     // Maybe coerce from Model for concrete execution?
@@ -31,7 +38,7 @@ class SymbolicEnv {
     const IR::Expression *subst(const IR::Expression *expr) const;
 
     /// @returns The immutable map that is internal to this symbolic environment.
-    [[nodiscard]] const SymbolicMapType &getInternalMap() const;
+    [[nodiscard]] const MapType &getInternalMap() const;
 
     /// Determines whether the given node represents a symbolic value. Symbolic values may be
     /// stored in the symbolic environment.
@@ -29,6 +29,8 @@ std::optional<uint32_t> Utils::currentSeed = std::nullopt;
 
 boost::random::mt19937 Utils::rng(0);
 
+thread_local boost::random::mt19937 *Utils::threadRng = nullptr;
+
 std::string Utils::getTimeStamp() {
     // get current time
     auto now = std::chrono::system_clock::now();
@@ -56,17 +58,25 @@ void Utils::setRandomSeed(int seed) {
 
 std::optional<uint32_t> Utils::getCurrentSeed() { return currentSeed; }
 
+boost::random::mt19937 &Utils::generator() { return threadRng ? *threadRng : rng; }
+
+Utils::RandomScope::RandomScope(boost::random::mt19937 &rng) : saved(threadRng) {
+    threadRng = &rng;
+}
+
+Utils::RandomScope::~RandomScope() { threadRng = saved; }
+
 uint64_t Utils::getRandInt(uint64_t max) {
     if (!currentSeed) {
         return 0;
     }
     boost::random::uniform_int_distribution<uint64_t> dist(0, max);
-    return dist(rng);
+    return dist(generator());
 }
 
 int64_t Utils::getRandInt(int64_t min, int64_t max) {
     boost::random::uniform_int_distribution<int64_t> distribution(min, max);
-    return distribution(rng);
+    return distribution(generator());
 }
 
 int64_t Utils::getRandInt(const std::vector<int64_t> &percent) {
@@ -92,7 +102,7 @@ big_int Utils::getRandBigInt(const big_int &max) {
         return 0;
     }
     boost::random::uniform_int_distribution<big_int> dist(0, max);
-    return dist(rng);
+    return dist(generator());
 }
 
 big_int Utils::getRandBigInt(const big_int &min, const big_int &max) {
@@ -100,7 +110,7 @@ big_int Utils::getRandBigInt(const big_int &min, const big_int &max) {
         return 0;
     }
     boost::random::uniform_int_distribution<big_int> dist(min, max);
-    return dist(rng);
+    return dist(generator());
 }
 
 const IR::Constant *Utils::getRandConstantForWidth(int bitWidth) {
@@ -27,6 +27,12 @@ class Utils {
     /// Stores the state of the PRNG.
     static std::optional<uint32_t> currentSeed;
 
+    /// The generator used by the current thread instead of @var rng, if any.
+    static thread_local boost::random::mt19937 *threadRng;
+
+    /// @returns the generator of the current thread.
+    static boost::random::mt19937 &generator();
+
  public:
     /// Return the current timestamp with millisecond accuracy.
     /// Format: year-month-day-hour:minute:second.millisecond
@@ -40,6 +46,18 @@ class Utils {
     /// @returns currentSeed.
     static std::optional<uint32_t> getCurrentSeed();
 
+    /// Makes the current thread draw random numbers from @param rng until the scope ends.
+    /// Concurrent workers use generators of their own to stay deterministic.
+    class RandomScope {
+        boost::random::mt19937 *saved;
+
+     public:
+        explicit RandomScope(boost::random::mt19937 &rng);
+        ~RandomScope();
+        RandomScope(const RandomScope &) = delete;
+        RandomScope &operator=(const RandomScope &) = delete;
+    };
+
     /// @returns a random integer in the range [0, @param max]. Always return 0 if no seed is set.
     static uint64_t getRandInt(uint64_t max);
 
@@ -77,7 +95,7 @@ class Utils {
     /// Shuffles the given iterable @param inp
     template <typename T>
     static void shuffle(T *inp) {
-        std::shuffle(inp->begin(), inp->end(), rng);
+        std::shuffle(inp->begin(), inp->end(), generator());
     }
 
     /// @returns a random element from the given range between @param start and @param end.
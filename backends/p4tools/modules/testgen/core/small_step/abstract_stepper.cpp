@@ -332,7 +332,7 @@ const IR::Literal *AbstractStepper::evaluateExpression(
     if (cond) {
         constraints.push_back(*cond);
     }
-    auto solverResult = solver.checkSat(constraints);
+    auto solverResult = solver.checkSat(constraints.toVector());
     // If the solver can find a solution under the given condition, get the model and return the
     // value.
     const IR::Literal *result = nullptr;
@@ -207,7 +207,7 @@ class CommandVisitor {
             // state.get().
             auto pathConstraints = state.get().getPathConstraint();
             pathConstraints.push_back(cond);
-            solverResult = self.get().solver.checkSat(pathConstraints);
+            solverResult = self.get().solver.checkSat(pathConstraints.toVector());
         }
 
         auto &nextState = state.get().clone();
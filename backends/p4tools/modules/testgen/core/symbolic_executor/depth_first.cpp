@@ -19,6 +19,10 @@ namespace P4::P4Tools::P4Testgen {
 DepthFirstSearch::DepthFirstSearch(AbstractSolver &solver, const ProgramInfo &programInfo)
     : SymbolicExecutor(solver, programInfo) {}
 
+SymbolicExecutor *DepthFirstSearch::cloneWorker(AbstractSolver &solver) const {
+    return new DepthFirstSearch(solver, programInfo);
+}
+
 std::optional<ExecutionStateReference> DepthFirstSearch::pickSuccessor(StepResult successors) {
     if (successors->empty()) {
         return std::nullopt;
@@ -24,6 +24,9 @@ class DepthFirstSearch : public SymbolicExecutor {
     /// Constructor for this strategy, considering inheritance
     DepthFirstSearch(AbstractSolver &solver, const ProgramInfo &programInfo);
 
+ protected:
+    SymbolicExecutor *cloneWorker(AbstractSolver &solver) const override;
+
  private:
     /// General unexplored branches.
     // Each element on this vector represents a set of alternative choices that could have been
@@ -21,27 +21,22 @@ namespace P4::P4Tools::P4Testgen {
 GreedyNodeSelection::GreedyNodeSelection(AbstractSolver &solver, const ProgramInfo &programInfo)
     : SymbolicExecutor(solver, programInfo) {}
 
+SymbolicExecutor *GreedyNodeSelection::cloneWorker(AbstractSolver &solver) const {
+    return new GreedyNodeSelection(solver, programInfo);
+}
+
 std::optional<SymbolicExecutor::Branch> GreedyNodeSelection::popPotentialBranch(
     const P4::Coverage::CoverageSet &coveredNodes,
     std::vector<SymbolicExecutor::Branch> &candidateBranches) {
     for (size_t idx = 0; idx < candidateBranches.size(); ++idx) {
         auto branch = candidateBranches.at(idx);
-        // First check all the potential set of nodes we can cover by looking ahead.
-        for (const auto &stmt : branch.potentialNodes) {
-            if (coveredNodes.count(stmt) == 0U) {
-                candidateBranches[idx] = candidateBranches.back();
-                candidateBranches.pop_back();
-                return branch;
-            }
-        }
-        // If we did not find anything, check whether this state covers any new nodes
-        // already.
-        for (const auto &stmt : branch.nextState.get().getVisited()) {
-            if (coveredNodes.count(stmt) == 0U) {
-                candidateBranches[idx] = candidateBranches.back();
-                candidateBranches.pop_back();
-                return branch;
-            }
+        // Check the potential set of nodes we can cover by looking ahead, and whether this
+        // state covers any new nodes already.
+        if (!coveredNodes.contains(branch.potentialNodes) ||
+            !coveredNodes.contains(branch.nextState.get().getVisited())) {
+            candidateBranches[idx] = candidateBranches.back();
+            candidateBranches.pop_back();
+            return branch;
         }
     }
     return std::nullopt;
@@ -31,6 +31,9 @@ class GreedyNodeSelection : public SymbolicExecutor {
     /// Constructor for this strategy, considering inheritance
     GreedyNodeSelection(AbstractSolver &solver, const ProgramInfo &programInfo);
 
+ protected:
+    SymbolicExecutor *cloneWorker(AbstractSolver &solver) const override;
+
  private:
     /// This variable keeps track of how many branch decisions we have made without producing a
     /// test. This is a safety guard in case the strategy gets stuck in parser loops because of its
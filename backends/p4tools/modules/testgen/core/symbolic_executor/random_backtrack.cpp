@@ -18,6 +18,10 @@ namespace P4::P4Tools::P4Testgen {
 RandomBacktrack::RandomBacktrack(AbstractSolver &solver, const ProgramInfo &programInfo)
     : SymbolicExecutor(solver, programInfo) {}
 
+SymbolicExecutor *RandomBacktrack::cloneWorker(AbstractSolver &solver) const {
+    return new RandomBacktrack(solver, programInfo);
+}
+
 std::optional<ExecutionStateReference> RandomBacktrack::pickSuccessor(StepResult successors) {
     if (successors->empty()) {
         return std::nullopt;
@@ -1,28 +1,90 @@
 #include "backends/p4tools/modules/testgen/core/symbolic_executor/symbolic_executor.h"
 
 #include <algorithm>
+#include <deque>
 #include <fstream>
 #include <iterator>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <random>
 #include <string>
 #include <vector>
 
+#include <boost/random/mersenne_twister.hpp>
+
 #include "backends/p4tools/common/lib/util.h"
 #include "ir/ir.h"
 #include "ir/solver.h"
 #include "lib/error.h"
 #include "lib/timer.h"
+#include "lib/work_stealing.h"
 #include "midend/coverage.h"
 
 #include "backends/p4tools/modules/testgen/core/program_info.h"
 #include "backends/p4tools/modules/testgen/core/small_step/small_step.h"
+#include "backends/p4tools/modules/testgen/lib/exceptions.h"
 #include "backends/p4tools/modules/testgen/lib/execution_state.h"
 #include "backends/p4tools/modules/testgen/lib/final_state.h"
 #include "backends/p4tools/modules/testgen/lib/logging.h"
+#include "backends/p4tools/modules/testgen/options.h"
 
 namespace P4::P4Tools::P4Testgen {
 
+/// The state shared by the executors taking part in a parallel run.
+struct SymbolicExecutor::ParallelRun {
+    unsigned threads;
+
+    /// The executor which started the run. The workers share its visited nodes.
+    SymbolicExecutor &owner;
+
+    /// Guards the visited nodes of the owner.
+    std::mutex coverageMutex;
+
+    /// Terminal states are passed to the callback one at a time. Random numbers drawn by the
+    /// callback come from this generator, as it runs on whichever worker found the state.
+    std::mutex commitMutex;
+    boost::random::mt19937 commitRng;
+
+    /// Set once the callback has asked to stop or a task has failed. Workers then stop
+    /// stepping and return from runImpl.
+    std::atomic<bool> stopped{false};
+
+    /// The states explored by the tasks, indexed by task.
+    std::mutex tasksMutex;
+    std::deque<ExecutionStateReference> states;
+
+    /// Tasks which have been added but not claimed by a worker yet.
+    std::atomic<size_t> unclaimed{0};
+
+    ParallelRun(unsigned threads, SymbolicExecutor &owner, uint32_t seed)
+        : threads(threads), owner(owner), commitRng(seed) {}
+
+    /// Whether branches should be handed to other workers.
+    bool wantsTasks() const { return !stopped && unclaimed < threads; }
+
+    /// Adds a task exploring @param state through @param spawn.
+    void addTask(ExecutionStateReference state, const Util::SpawnTask &spawn) {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        states.push_back(state);
+        unclaimed++;
+        size_t task = spawn();
+        BUG_CHECK(task == states.size() - 1, "Task %1% does not match its state.", task);
+    }
+
+    /// Claims @param task and returns the state it explores.
+    ExecutionStateReference claimTask(size_t task) {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        unclaimed--;
+        return states.at(task);
+    }
+};
+
 SymbolicExecutor::StepResult SymbolicExecutor::step(ExecutionState &state) {
+    // Once a parallel run has been stopped, its workers run out of states to explore.
+    if (parallelRun != nullptr && parallelRun->stopped) {
+        return new std::vector<Branch>();
+    }
     StepResult successors = nullptr;
     // Use a scope here to measure the time it takes for a step.
     {
@@ -34,18 +96,106 @@ SymbolicExecutor::StepResult SymbolicExecutor::step(ExecutionState &state) {
         std::remove_if(successors->begin(), successors->end(),
                        [this](const Branch &b) -> bool { return !evaluateBranch(b, solver); }),
         successors->end());
+    // Hand branches over to idle workers of a parallel run, the strategy picks among the rest.
+    if (spawnTask != nullptr) {
+        while (successors->size() > 1 && parallelRun->wantsTasks()) {
+            parallelRun->addTask(successors->back().nextState, *spawnTask);
+            successors->pop_back();
+        }
+    }
     return successors;
 }
 
 void SymbolicExecutor::run(const Callback &callBack) {
-    runImpl(callBack, ExecutionState::create(&programInfo.getP4Program()));
+    auto &initialState = ExecutionState::create(&programInfo.getP4Program());
+    if (threads > 1 && runParallel(callBack, initialState)) {
+        return;
+    }
+    runImpl(callBack, initialState);
+}
+
+void SymbolicExecutor::setThreads(unsigned threads, SolverFactory solverFactory) {
+    this->threads = threads;
+    this->solverFactory = std::move(solverFactory);
+}
+
+SymbolicExecutor *SymbolicExecutor::cloneWorker(AbstractSolver & /*solver*/) const {
+    return nullptr;
+}
+
+bool SymbolicExecutor::runParallel(const Callback &callBack,
+                                   ExecutionStateReference initialState) {
+    BUG_CHECK(solverFactory, "Parallel run without a solver factory.");
+    // Probe the strategy before doing any work on its behalf. The state of the reachability
+    // engine is not split between workers yet.
+    if (!TestgenOptions::get().pattern.empty() ||
+        std::unique_ptr<SymbolicExecutor>(cloneWorker(solver)) == nullptr) {
+        warning("The selected path selection policy does not support --threads, exploring "
+                "paths with a single worker.");
+        return false;
+    }
+
+    auto seed = Utils::getCurrentSeed().value_or(0);
+    ParallelRun run(threads, *this, seed);
+    run.states.push_back(initialState);
+    run.unclaimed = 1;
+    // Every worker explores its tasks with an executor and a solver of its own.
+    std::vector<std::unique_ptr<SymbolicExecutor>> workers;
+    for (unsigned worker = 0; worker < threads; worker++) {
+        workers.emplace_back(cloneWorker(solverFactory()));
+        workers.back()->parallelRun = &run;
+    }
+    parallelRun = &run;
+
+    // The callback of the workers, which is also where the shared coverage is updated.
+    auto commit = [&](const FinalState &finalState) {
+        std::lock_guard<std::mutex> lock(run.commitMutex);
+        if (run.stopped) {
+            return true;
+        }
+        Utils::RandomScope scope(run.commitRng);
+        if (callBack(finalState)) {
+            run.stopped = true;
+        }
+        return bool(run.stopped);
+    };
+    auto runTask = [&](size_t task, unsigned worker, const Util::SpawnTask &spawn) {
+        auto state = run.claimTask(task);
+        if (run.stopped) {
+            return;
+        }
+        std::seed_seq taskSeed{seed, static_cast<uint32_t>(task)};
+        boost::random::mt19937 rng(taskSeed);
+        Utils::RandomScope scope(rng);
+        auto &executor = *workers[worker];
+        executor.spawnTask = &spawn;
+        try {
+            executor.runImpl(commit, state);
+        } catch (...) {
+            run.stopped = true;
+            executor.spawnTask = nullptr;
+            throw;
+        }
+        executor.spawnTask = nullptr;
+    };
+    try {
+        Util::runWorkStealing(1, threads, runTask);
+    } catch (...) {
+        parallelRun = nullptr;
+        throw;
+    }
+    parallelRun = nullptr;
+    return true;
 }
 
 bool SymbolicExecutor::handleTerminalState(const Callback &callback,
                                            const ExecutionState &terminalState) {
+    if (parallelRun != nullptr && parallelRun->stopped) {
+        return true;
+    }
     // Check the solver for satisfiability. If it times out or reports non-satisfiability, issue
     // a warning and continue on a different path.
-    auto solverResult = solver.checkSat(terminalState.getPathConstraint());
+    auto solverResult = solver.checkSat(terminalState.getPathConstraint().toVector());
     if (!solverResult) {
         warning("Solver timed out");
         return false;
@@ -72,7 +222,7 @@ bool SymbolicExecutor::evaluateBranch(const SymbolicExecutor::Branch &branch,
     }
 
     // Check the consistency of the path constraints asserted so far.
-    auto solverResult = solver.checkSat(branch.nextState.get().getPathConstraint());
+    auto solverResult = solver.checkSat(branch.nextState.get().getPathConstraint().toVector());
     if (solverResult == std::nullopt) {
         warning("Solver timed out");
     }
@@ -92,6 +242,7 @@ SymbolicExecutor::SymbolicExecutor(AbstractSolver &solver, const ProgramInfo &pr
     : programInfo(programInfo),
       solver(solver),
       coverableNodes(programInfo.getCoverableNodes()),
+      visitedNodes(coverableNodes.getIndex()),
       evaluator(solver, programInfo) {
     // If there is no seed provided, do not randomize the solver.
     auto seed = Utils::getCurrentSeed();
@@ -101,14 +252,20 @@ SymbolicExecutor::SymbolicExecutor(AbstractSolver &solver, const ProgramInfo &pr
 }
 
 bool SymbolicExecutor::updateVisitedNodes(const P4::Coverage::CoverageSet &newNodes) {
-    auto hasUpdated = false;
-    for (const auto *newNode : newNodes) {
-        hasUpdated |= visitedNodes.insert(newNode).second;
+    if (parallelRun == nullptr) {
+        return visitedNodes.merge(newNodes);
     }
-    return hasUpdated;
+    std::lock_guard<std::mutex> lock(parallelRun->coverageMutex);
+    return parallelRun->owner.visitedNodes.merge(newNodes);
 }
 
-const P4::Coverage::CoverageSet &SymbolicExecutor::getVisitedNodes() { return visitedNodes; }
+P4::Coverage::CoverageSet SymbolicExecutor::getVisitedNodes() const {
+    if (parallelRun == nullptr) {
+        return visitedNodes;
+    }
+    std::lock_guard<std::mutex> lock(parallelRun->coverageMutex);
+    return parallelRun->owner.visitedNodes;
+}
 
 void SymbolicExecutor::printCurrentTraceAndBranches(std::ostream &out,
                                                     const ExecutionState &executionState) {
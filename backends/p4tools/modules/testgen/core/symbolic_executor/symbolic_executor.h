@@ -1,11 +1,13 @@
 #ifndef BACKENDS_P4TOOLS_MODULES_TESTGEN_CORE_SYMBOLIC_EXECUTOR_SYMBOLIC_EXECUTOR_H_
 #define BACKENDS_P4TOOLS_MODULES_TESTGEN_CORE_SYMBOLIC_EXECUTOR_SYMBOLIC_EXECUTOR_H_
 
+#include <atomic>
 #include <functional>
 #include <iosfwd>
 #include <vector>
 
 #include "ir/solver.h"
+#include "lib/work_stealing.h"
 #include "midend/coverage.h"
 
 #include "backends/p4tools/modules/testgen/core/program_info.h"
@@ -46,13 +48,22 @@ class SymbolicExecutor {
 
     virtual void runImpl(const Callback &callBack, ExecutionStateReference executionState) = 0;
 
+    /// Creates the solver of a worker of a parallel run. It is only called by run(), the
+    /// solver must outlive the run.
+    using SolverFactory = std::function<AbstractSolver &()>;
+
+    /// Explores the program with @param threads workers. Every worker gets a solver of its
+    /// own from @param solverFactory. See runParallel.
+    void setThreads(unsigned threads, SolverFactory solverFactory);
+
     explicit SymbolicExecutor(AbstractSolver &solver, const ProgramInfo &programInfo);
 
     /// Writes a list of the selected branches into @param out.
     void printCurrentTraceAndBranches(std::ostream &out, const ExecutionState &executionState);
 
-    /// Getter to access visitedNodes.
-    const P4::Coverage::CoverageSet &getVisitedNodes();
+    /// Returns a copy of the visited nodes. The workers of a parallel run share the visited
+    /// nodes of the executor which started it, which they may update concurrently.
+    [[nodiscard]] P4::Coverage::CoverageSet getVisitedNodes() const;
 
     /// Update the set of visited nodes. Returns true if there was an update.
     [[nodiscard]] bool updateVisitedNodes(const P4::Coverage::CoverageSet &newNodes);
@@ -67,7 +78,8 @@ class SymbolicExecutor {
     /// Set of all nodes, to be retrieved from programInfo.
     const P4::Coverage::CoverageSet &coverableNodes;
 
-    /// Set of all nodes executed in any testcase that has been outputted.
+    /// Set of all nodes executed in any testcase that has been outputted. Only used outside of
+    /// parallel runs, or by the executor which started one, see getVisitedNodes.
     P4::Coverage::CoverageSet visitedNodes;
 
     /// Handles processing at the end of a P4 program.
@@ -89,8 +101,36 @@ class SymbolicExecutor {
     static SymbolicExecutor::Branch popRandomBranch(
         std::vector<SymbolicExecutor::Branch> &candidateBranches);
 
+    /// Returns a new executor with the same strategy which uses @param solver, to explore a
+    /// part of the program in a parallel run. Strategies which return null, the default, are
+    /// always run sequentially.
+    virtual SymbolicExecutor *cloneWorker(AbstractSolver &solver) const;
+
  private:
     SmallStepEvaluator evaluator;
+
+    /// The number of workers of a run.
+    unsigned threads = 1;
+
+    /// Creates the solvers of the workers of a parallel run.
+    SolverFactory solverFactory;
+
+    /// The state shared by the executors taking part in a parallel run, null otherwise.
+    struct ParallelRun;
+    ParallelRun *parallelRun = nullptr;
+
+    /// Adds a task to the parallel run this worker is running a task of, null otherwise.
+    const Util::SpawnTask *spawnTask = nullptr;
+
+    /// Explores the program with multiple workers, each with an executor, a solver and a
+    /// random number generator of its own. A task explores a state with runImpl, starting
+    /// with @param initialState. While there are fewer unclaimed tasks than workers, the
+    /// branches of a step beyond the first become tasks of their own, which idle workers
+    /// steal. Terminal states are passed to @param callBack one at a time, and all workers
+    /// steer by the coverage of the tests generated so far. Which paths are explored, and
+    /// in which order, thus depends on the scheduling of the workers.
+    /// Returns false if the strategy does not support parallel runs.
+    bool runParallel(const Callback &callBack, ExecutionStateReference initialState);
 };
 
 }  // namespace P4::P4Tools::P4Testgen
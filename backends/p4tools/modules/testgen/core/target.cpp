@@ -82,7 +82,9 @@ CompilerResultOrError TestgenTarget::runCompilerImpl(const CompilerOptions &opti
     }
 
     /// Collect coverage information about the program.
-    auto coverage = P4::Coverage::CollectNodes(TestgenOptions::get().coverageOptions);
+    const auto &testgenOptions = TestgenOptions::get();
+    auto coverage =
+        P4::Coverage::CollectNodes(testgenOptions.coverageOptions, testgenOptions.threads);
     program->apply(coverage);
 
     return {
@@ -1,5 +1,6 @@
 #include "backends/p4tools/modules/testgen/lib/collect_coverable_nodes.h"
 
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -141,15 +142,21 @@ void CoverableNodesScanner::updateNodeCoverage(const IR::Node *node,
     CHECK_NULL(node);
 
     static NodeCache CACHED_NODES;
-    // If the node is already in the cache, return it.
-    auto it = CACHED_NODES.find(node);
-    if (it != CACHED_NODES.end()) {
-        nodes.insert(it->second.begin(), it->second.end());
-        return;
+    // The cache is shared by concurrent executors.
+    static std::mutex CACHED_NODES_MUTEX;
+    {
+        // If the node is already in the cache, return it.
+        std::lock_guard<std::mutex> lock(CACHED_NODES_MUTEX);
+        auto it = CACHED_NODES.find(node);
+        if (it != CACHED_NODES.end()) {
+            nodes.merge(it->second);
+            return;
+        }
     }
     node->apply(*this);
-    nodes.insert(coverableNodes.begin(), coverableNodes.end());
+    nodes.merge(coverableNodes);
     // Store the result in the cache.
+    std::lock_guard<std::mutex> lock(CACHED_NODES_MUTEX);
     CACHED_NODES.emplace(node, coverableNodes);
 }
 
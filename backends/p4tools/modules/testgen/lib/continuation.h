@@ -51,8 +51,9 @@ class Continuation {
     /// is a little clunky to use an maintain because we have to add new enum fields manually.
     /// TODO: Find a better implementation to print enums. Also use constexpr instead.
     friend std::ostream &operator<<(std::ostream &out, const Exception value) {
-        static std::map<Exception, std::string> strings;
-        if (strings.empty()) {
+        // Initialized once, so concurrent executors can print exceptions.
+        static const std::map<Exception, std::string> strings = [] {
+            std::map<Exception, std::string> strings;
 #define INSERT_ELEMENT(p) strings[p] = #p
             INSERT_ELEMENT(Exception::Exit);
             INSERT_ELEMENT(Exception::NoMatch);
@@ -60,9 +61,11 @@ class Continuation {
             INSERT_ELEMENT(Exception::Drop);
             INSERT_ELEMENT(Exception::Abort);
 #undef INSERT_ELEMENT
-        }
+            return strings;
+        }();
 
-        return out << strings[value];
+        auto it = strings.find(value);
+        return out << (it != strings.end() ? it->second : std::string());
     }
 
     /// Represents a command that invokes the topmost continuation on the continuation stack. If a
@@ -5,7 +5,6 @@
 #include <initializer_list>
 #include <list>
 #include <map>
-#include <stack>
 #include <string>
 #include <utility>
 #include <variant>
@@ -64,8 +63,7 @@ const NamespaceContext *ExecutionState::StackFrame::getNameSpaces() const { retu
 
 ExecutionState::ExecutionState(const IR::P4Program *program)
     : AbstractExecutionState(program),
-      body({program}),
-      stack(*(new std::stack<std::reference_wrapper<const StackFrame>>())) {
+      body({program}) {
     env.set(&PacketVars::INPUT_PACKET_LABEL, IR::Constant::get(IR::Type_Bits::get(0), 0));
     env.set(&PacketVars::PACKET_BUFFER_LABEL, IR::Constant::get(IR::Type_Bits::get(0), 0));
     // We also add the taint property and set it to false.
@@ -83,7 +81,7 @@ ExecutionState::ExecutionState(const IR::P4Program *program)
 }
 
 ExecutionState::ExecutionState(Continuation::Body body)
-    : body(std::move(body)), stack(*(new std::stack<std::reference_wrapper<const StackFrame>>())) {
+    : body(std::move(body)) {
     // We also add the taint property and set it to false.
     setProperty("inUndefinedState"_cs, false);
     // Drop is initialized to false, too.
@@ -106,11 +104,11 @@ ExecutionState &ExecutionState::clone() const { return *new ExecutionState(*this
 
 bool ExecutionState::isTerminal() const { return body.empty() && stack.empty(); }
 
-const std::vector<uint64_t> &ExecutionState::getSelectedBranches() const {
+const persistent_vector<uint64_t> &ExecutionState::getSelectedBranches() const {
     return selectedBranches;
 }
 
-const std::vector<const IR::Expression *> &ExecutionState::getPathConstraint() const {
+const persistent_vector<const IR::Expression *> &ExecutionState::getPathConstraint() const {
     return pathConstraint;
 }
 
@@ -173,7 +171,7 @@ void ExecutionState::markVisited(const IR::Node *node) {
     if (node->is<IR::P4Action>() && !coverageOptions.coverActions) {
         return;
     }
-    visitedNodes.emplace(node);
+    visitedNodes.insert(node);
 }
 
 const P4::Coverage::CoverageSet &ExecutionState::getVisited() const { return visitedNodes; }
@@ -213,13 +211,14 @@ void ExecutionState::set(const IR::StateVariable &var, const IR::Expression *val
     env.set(var, value);
 }
 
-const std::vector<std::reference_wrapper<const TraceEvent>> &ExecutionState::getTrace() const {
+const persistent_vector<std::reference_wrapper<const TraceEvent>> &ExecutionState::getTrace()
+    const {
     return trace;
 }
 
 const Continuation::Body &ExecutionState::getBody() const { return body; }
 
-const std::stack<std::reference_wrapper<const ExecutionState::StackFrame>> &
+const persistent_stack<std::reference_wrapper<const ExecutionState::StackFrame>> &
 ExecutionState::getStack() const {
     return stack;
 }
@@ -234,15 +233,18 @@ bool ExecutionState::hasProperty(cstring propertyName) const {
 
 void ExecutionState::addTestObject(cstring category, cstring objectLabel,
                                    const TestObject *object) {
-    testObjects[category][objectLabel] = object;
+    auto objects = getTestObjectCategory(category);
+    objects[objectLabel] = object;
+    testObjects.insert_or_assign(category, objects);
 }
 
 const TestObject *ExecutionState::getTestObject(cstring category, cstring objectLabel,
                                                 bool checked) const {
-    auto testObjectCategory = getTestObjectCategory(category);
-    auto it = testObjectCategory.find(objectLabel);
-    if (it != testObjectCategory.end()) {
-        return it->second;
+    if (const auto *testObjectCategory = testObjects.lookup(category)) {
+        auto it = testObjectCategory->find(objectLabel);
+        if (it != testObjectCategory->end()) {
+            return it->second;
+        }
     }
     if (checked) {
         BUG("Unable to find test object with the label %1% in the category %2%. ", objectLabel,
@@ -252,17 +254,17 @@ const TestObject *ExecutionState::getTestObject(cstring category, cstring object
 }
 
 TestObjectMap ExecutionState::getTestObjectCategory(cstring category) const {
-    auto it = testObjects.find(category);
-    if (it != testObjects.end()) {
-        return it->second;
+    if (const auto *testObjectCategory = testObjects.lookup(category)) {
+        return *testObjectCategory;
     }
     return {};
 }
 
 void ExecutionState::deleteTestObject(cstring category, cstring objectLabel) {
-    auto it = testObjects.find(category);
-    if (it != testObjects.end()) {
-        it->second.erase(objectLabel);
+    if (const auto *testObjectCategory = testObjects.lookup(category)) {
+        auto objects = *testObjectCategory;
+        objects.erase(objectLabel);
+        testObjects.insert_or_assign(category, objects);
     }
 }
 
@@ -7,7 +7,6 @@
 #include <iostream>
 #include <map>
 #include <optional>
-#include <stack>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -23,6 +22,9 @@
 #include "ir/solver.h"
 #include "lib/cstring.h"
 #include "lib/exceptions.h"
+#include "lib/persistent_map.h"
+#include "lib/persistent_stack.h"
+#include "lib/persistent_vector.h"
 #include "midend/coverage.h"
 
 #include "backends/p4tools/modules/testgen/lib/continuation.h"
@@ -31,6 +33,11 @@
 namespace P4::P4Tools::P4Testgen {
 
 /// Represents state of execution after having reached a program point.
+///
+/// A state is cloned at every branch of the symbolic execution. The symbolic environment, the
+/// trace, the path constraints, the test objects and the continuation stack are persistent
+/// containers, which the clones share until they are modified, so cloning a state does not copy
+/// them.
 class ExecutionState : public AbstractExecutionState {
     friend class Test::SmallStepTest;
 
@@ -73,7 +80,7 @@ class ExecutionState : public AbstractExecutionState {
 
  private:
     /// The program trace for the current program point (i.e., how we got to the current state).
-    std::vector<std::reference_wrapper<const TraceEvent>> trace;
+    persistent_vector<std::reference_wrapper<const TraceEvent>> trace;
 
     /// Set of visited nodes. Used for code coverage.
     P4::Coverage::CoverageSet visitedNodes;
@@ -90,7 +97,7 @@ class ExecutionState : public AbstractExecutionState {
     /// becomes the top of the stack.
     ///
     // Invariant: if the @body is empty, then so is this, and this state is terminal.
-    std::stack<std::reference_wrapper<const StackFrame>> stack;
+    persistent_stack<std::reference_wrapper<const StackFrame>> stack;
 
     /// State properties are bools, integers, or strings that can be set and propagated across
     /// execution state. They are used to influence execution along a particular continuation path.
@@ -106,7 +113,7 @@ class ExecutionState : public AbstractExecutionState {
     // which defines control plane match action entries. Once the interpreter has solved for the
     // variables used by these test objects and concretized the values, they can be used to generate
     // a test. Test objects are not constant because they may be manipulated by a target back end.
-    std::map<cstring, TestObjectMap> testObjects;
+    persistent_map<cstring, TestObjectMap> testObjects;
 
     /// The parserErrorLabel is set by the parser to indicate the variable corresponding to the
     /// parser error that is set by various built-in functions such as verify or extract.
@@ -120,10 +127,10 @@ class ExecutionState : public AbstractExecutionState {
 
     /// List of path constraints - expressions that must all evaluate to true to reach this
     /// execution state.
-    std::vector<const IR::Expression *> pathConstraint;
+    persistent_vector<const IR::Expression *> pathConstraint;
 
     /// List of branch decisions leading into this state.
-    std::vector<uint64_t> selectedBranches;
+    persistent_vector<uint64_t> selectedBranches;
 
     /// State that is needed to track reachability of nodes given a query.
     ReachabilityEngineState *reachabilityEngineState = nullptr;
@@ -145,11 +152,12 @@ class ExecutionState : public AbstractExecutionState {
     /// Determines whether this state represents the end of an execution.
     [[nodiscard]] bool isTerminal() const;
 
-    /// @returns list of paths constraints.
-    [[nodiscard]] const std::vector<const IR::Expression *> &getPathConstraint() const;
+    /// @returns list of paths constraints. Copies of the list share its structure, the
+    /// solver takes it as a vector through toVector().
+    [[nodiscard]] const persistent_vector<const IR::Expression *> &getPathConstraint() const;
 
     /// @returns list of branch decisions leading into this state.
-    [[nodiscard]] const std::vector<uint64_t> &getSelectedBranches() const;
+    [[nodiscard]] const persistent_vector<uint64_t> &getSelectedBranches() const;
 
     /// Adds path constraint.
     void pushPathConstraint(const IR::Expression *e);
@@ -177,13 +185,15 @@ class ExecutionState : public AbstractExecutionState {
     void set(const IR::StateVariable &var, const IR::Expression *value) override;
 
     /// @returns the current event trace.
-    [[nodiscard]] const std::vector<std::reference_wrapper<const TraceEvent>> &getTrace() const;
+    [[nodiscard]] const persistent_vector<std::reference_wrapper<const TraceEvent>> &getTrace()
+        const;
 
     /// @returns the current body.
     [[nodiscard]] const Continuation::Body &getBody() const;
 
     /// @returns the current stack.
-    [[nodiscard]] const std::stack<std::reference_wrapper<const StackFrame>> &getStack() const;
+    [[nodiscard]] const persistent_stack<std::reference_wrapper<const StackFrame>> &getStack()
+        const;
 
     /// Set the property with @arg propertyName to @arg property.
     void setProperty(cstring propertyName, Continuation::PropertyValue property);
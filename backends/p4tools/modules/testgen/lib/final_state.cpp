@@ -69,7 +69,7 @@ std::optional<std::reference_wrapper<const FinalState>> FinalState::computeConco
     if (resolvedConcolicVariables.empty()) {
         return *this;
     }
-    std::vector<const Constraint *> asserts = state.get().getPathConstraint();
+    std::vector<const Constraint *> asserts = state.get().getPathConstraint().toVector();
 
     for (const auto &resolvedConcolicVariable : resolvedConcolicVariables) {
         const auto &concolicVariable = resolvedConcolicVariable.first;
@@ -2,6 +2,7 @@
 
 #include <optional>
 
+#include "backends/p4tools/common/core/caching_solver.h"
 #include "backends/p4tools/common/core/z3_solver.h"
 #include "backends/p4tools/common/lib/format_int.h"
 #include "backends/p4tools/common/lib/model.h"
@@ -77,8 +78,11 @@ bool TestBackEnd::run(const FinalState &state) {
 
         // For long-running tests periodically reset the solver state to free up memory.
         if (testCount != 0 && testCount % RESET_THRESHOLD == 0) {
-            auto &solver = state.getSolver();
-            auto *z3Solver = solver.to<Z3Solver>();
+            auto *solver = &state.getSolver();
+            if (auto *cachingSolver = solver->to<CachingSolver>()) {
+                solver = &cachingSolver->getSolver();
+            }
+            auto *z3Solver = solver->to<Z3Solver>();
             CHECK_NULL(z3Solver);
             z3Solver->clearMemory();
         }
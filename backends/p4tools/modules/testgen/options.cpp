@@ -53,6 +53,29 @@ TestgenOptions::TestgenOptions()
         "Sets the maximum number of tests to be generated [default: 1]. Setting the value to 0 "
         "will generate tests until no more paths can be found.");
 
+    registerOption(
+        "--threads", "threads",
+        [this](const char *arg) {
+            try {
+                auto value = std::stoll(arg);
+                if (value < 1 || value > 1024) {
+                    throw std::invalid_argument("Invalid input.");
+                }
+                threads = static_cast<unsigned>(value);
+            } catch (std::exception &) {
+                error("Invalid input value %1% for --threads. Expected an integer from 1 to 1024.",
+                      arg);
+                return false;
+            }
+            return true;
+        },
+        "Explores paths with the given number of worker threads [default: 1]. Every worker uses "
+        "a solver of its own, idle workers take over unexplored branches of busy ones, and all "
+        "workers steer by the coverage of the tests generated so far. With more than one "
+        "thread, the generated tests depend on the scheduling of the threads, and can differ "
+        "between runs even with the same seed. Exploring all paths (--max-tests 0) still "
+        "generates a test for every path, in an order which depends on the scheduling.");
+
     registerOption(
         "--stop-metric", "stopMetric",
         [this](const char *arg) {
@@ -24,6 +24,9 @@ class TestgenOptions : public AbstractP4cToolOptions {
     /// Maximum number of tests to be generated. Defaults to 1.
     int64_t maxTests = 1;
 
+    /// Number of worker threads exploring paths. Defaults to 1.
+    unsigned threads = 1;
+
     /// Selects the path selection policy for test generation
     P4Testgen::PathSelectionPolicy pathSelectionPolicy = P4Testgen::PathSelectionPolicy::DepthFirst;
 
@@ -71,7 +71,9 @@ CompilerResultOrError Bmv2V1ModelTestgenTarget::runCompilerImpl(
         return std::nullopt;
     }
     /// Collect coverage information about the program.
-    auto coverage = P4::Coverage::CollectNodes(TestgenOptions::get().coverageOptions);
+    const auto &testgenOptions = TestgenOptions::get();
+    auto coverage =
+        P4::Coverage::CollectNodes(testgenOptions.coverageOptions, testgenOptions.threads);
     program->apply(coverage);
     if (errorCount() > 0) {
         return std::nullopt;
@@ -0,0 +1,125 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "test/gtest/helpers.h"
+
+#include "backends/p4tools/modules/testgen/options.h"
+#include "backends/p4tools/modules/testgen/targets/bmv2/test/gtest_utils.h"
+#include "backends/p4tools/modules/testgen/targets/bmv2/test_backend/protobuf_ir.h"
+#include "backends/p4tools/modules/testgen/testgen.h"
+
+namespace P4::P4Tools::Test {
+
+using namespace P4::literals;
+
+class P4TestgenParallelTest : public P4TestgenBmv2Test {
+ protected:
+    void TearDown() override { P4Testgen::TestgenOptions::get().threads = 1; }
+
+    /// Generates the tests of @param source with @param threads workers. The tests are sorted,
+    /// without the lines which differ between runs (the date and the coverage so far).
+    static std::vector<std::string> generate(const std::string &source, unsigned threads) {
+        auto &testgenOptions = P4Testgen::TestgenOptions::get();
+        testgenOptions.threads = threads;
+        auto testListOpt = P4Testgen::Testgen::generateTests(source, testgenOptions);
+        EXPECT_TRUE(testListOpt.has_value());
+        std::vector<std::string> tests;
+        if (testListOpt.has_value()) {
+            for (const auto *test : testListOpt.value()) {
+                std::stringstream formatted(
+                    test->checkedTo<P4Testgen::Bmv2::ProtobufIrTest>()->getFormattedTest());
+                std::string normalized;
+                for (std::string line; std::getline(formatted, line);) {
+                    if (line.find("Date generated:") != std::string::npos ||
+                        line.find("Current node coverage:") != std::string::npos) {
+                        continue;
+                    }
+                    normalized += line + "\n";
+                }
+                tests.push_back(normalized);
+            }
+        }
+        std::sort(tests.begin(), tests.end());
+        return tests;
+    }
+};
+
+TEST_F(P4TestgenParallelTest, GeneratesATestForEveryPathWithAnyNumberOfWorkers) {
+    std::stringstream streamTest;
+    streamTest << R"p4(
+header ethernet_t {
+    bit<48> dst_addr;
+    bit<48> src_addr;
+    bit<16> ether_type;
+}
+
+struct Headers {
+  ethernet_t eth_hdr;
+}
+
+struct Metadata {  }
+parser parse(packet_in pkt, out Headers hdr, inout Metadata m, inout standard_metadata_t sm) {
+  state start {
+      pkt.extract(hdr.eth_hdr);
+      transition accept;
+  }
+}
+control ingress(inout Headers hdr, inout Metadata meta, inout standard_metadata_t sm) {
+  apply {
+      if (hdr.eth_hdr.dst_addr == 1) {
+          sm.egress_spec = 1;
+      } else if (hdr.eth_hdr.dst_addr == 2) {
+          sm.egress_spec = 2;
+      }
+      if (hdr.eth_hdr.src_addr == 3) {
+          hdr.eth_hdr.ether_type = 3;
+      } else if (hdr.eth_hdr.src_addr == 4) {
+          hdr.eth_hdr.ether_type = 4;
+      }
+      if (hdr.eth_hdr.ether_type == 0xF00D) {
+          mark_to_drop(sm);
+      }
+  }
+}
+control egress(inout Headers hdr, inout Metadata meta, inout standard_metadata_t sm) {
+  apply {}
+}
+control deparse(packet_out pkt, in Headers hdr) {
+  apply {
+    pkt.emit(hdr.eth_hdr);
+  }
+}
+control verifyChecksum(inout Headers hdr, inout Metadata meta) {
+  apply {}
+}
+control computeChecksum(inout Headers hdr, inout Metadata meta) {
+  apply {}
+}
+V1Switch(parse(), verifyChecksum(), ingress(), egress(), computeChecksum(), deparse()) main;
+)p4";
+
+    auto source = P4_SOURCE(P4Headers::V1MODEL, streamTest.str().c_str());
+    auto &testgenOptions = P4Testgen::TestgenOptions::get();
+    testgenOptions.target = "bmv2"_cs;
+    testgenOptions.arch = "v1model"_cs;
+    testgenOptions.testBackend = "PROTOBUF_IR"_cs;
+    testgenOptions.testBaseName = "dummy"_cs;
+    testgenOptions.seed = 1;
+    testgenOptions.maxTests = 0;
+    testgenOptions.minPktSize = 112;
+    testgenOptions.maxPktSize = 112;
+
+    // All paths are explored, so every run generates the same tests, in the order in which
+    // the workers happen to find them.
+    auto sequential = generate(source, 1);
+    EXPECT_FALSE(sequential.empty());
+    EXPECT_EQ(generate(source, 2), sequential);
+    EXPECT_EQ(generate(source, 4), sequential);
+}
+
+}  // namespace P4::P4Tools::Test
@@ -0,0 +1,81 @@
+#include "backends/p4tools/common/core/caching_solver.h"
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <vector>
+
+#include "backends/p4tools/common/core/z3_solver.h"
+#include "backends/p4tools/common/lib/variables.h"
+#include "ir/ir.h"
+#include "lib/cstring.h"
+
+namespace P4::P4Tools::Test {
+
+using namespace P4::literals;
+
+class CachingSolverTest : public testing::Test {
+ protected:
+    Z3Solver z3Solver;
+    CachingSolver solver{z3Solver};
+
+    const IR::Type_Bits *type = IR::Type_Bits::get(8);
+    const IR::SymbolicVariable *fooVar = ToolsVariables::getSymbolicVariable(type, "foo"_cs);
+    const IR::SymbolicVariable *barVar = ToolsVariables::getSymbolicVariable(type, "bar"_cs);
+
+    const IR::Expression *equals(const IR::Expression *var, int value) const {
+        return new IR::Equ(var, IR::Constant::get(type, value));
+    }
+
+    /// @returns the value of @param var in the model of the last query.
+    int valueOf(const IR::SymbolicVariable *var) const {
+        const auto &model = solver.getSymbolicMapping();
+        auto it = model.find(var);
+        EXPECT_NE(it, model.end());
+        return it == model.end() ? -1 : it->second->checkedTo<IR::Constant>()->asInt();
+    }
+};
+
+TEST_F(CachingSolverTest, SolvesIndependentSetsSeparately) {
+    const auto *fooIsOne = equals(fooVar, 1);
+    const auto *barIsTwo = equals(barVar, 2);
+    EXPECT_EQ(solver.checkSat({fooIsOne, barIsTwo}), true);
+    EXPECT_EQ(solver.getStatistics().solverCalls, 2U);
+    EXPECT_EQ(valueOf(fooVar), 1);
+    EXPECT_EQ(valueOf(barVar), 2);
+
+    // Only the set with the new constraint is passed on.
+    const auto *barIsNotThree = new IR::Neq(barVar, IR::Constant::get(type, 3));
+    EXPECT_EQ(solver.checkSat({fooIsOne, barIsTwo, barIsNotThree}), true);
+    EXPECT_EQ(solver.getStatistics().cacheHits, 1U);
+    EXPECT_EQ(valueOf(fooVar), 1);
+    EXPECT_EQ(valueOf(barVar), 2);
+
+    // Constraints which share a variable end up in the same set.
+    const auto *fooIsBar = new IR::Equ(fooVar, barVar);
+    EXPECT_EQ(solver.checkSat({fooIsOne, barIsTwo, fooIsBar}), false);
+}
+
+TEST_F(CachingSolverTest, ReusesCachedAnswers) {
+    const auto *fooIsOne = equals(fooVar, 1);
+    const auto *fooIsTwo = equals(fooVar, 2);
+    EXPECT_EQ(solver.checkSat({fooIsOne, fooIsTwo}), false);
+    EXPECT_EQ(solver.getStatistics().solverCalls, 1U);
+    EXPECT_EQ(solver.checkSat({fooIsTwo, fooIsOne}), false);
+    EXPECT_EQ(solver.getStatistics().cacheHits, 1U);
+
+    // Supersets of unsatisfiable sets are unsatisfiable.
+    const auto *fooIsNotThree = new IR::Neq(fooVar, IR::Constant::get(type, 3));
+    EXPECT_EQ(solver.checkSat({fooIsOne, fooIsNotThree, fooIsTwo}), false);
+
+    // The model of {foo == 1} also satisfies foo != 3, and solves {foo != 3} as a superset.
+    EXPECT_EQ(solver.checkSat({fooIsOne}), true);
+    EXPECT_EQ(solver.checkSat({fooIsOne, fooIsNotThree}), true);
+    EXPECT_EQ(valueOf(fooVar), 1);
+    EXPECT_EQ(solver.checkSat({fooIsNotThree}), true);
+    EXPECT_EQ(valueOf(fooVar), 1);
+    EXPECT_EQ(solver.getStatistics().solverCalls, 2U);
+    EXPECT_EQ(solver.getStatistics().counterexampleHits, 3U);
+}
+
+}  // namespace P4::P4Tools::Test
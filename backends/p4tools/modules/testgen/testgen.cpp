@@ -3,11 +3,14 @@
 #include <cstdlib>
 #include <exception>
 #include <filesystem>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "backends/p4tools/common/compiler/compiler_target.h"
+#include "backends/p4tools/common/core/caching_solver.h"
 #include "backends/p4tools/common/core/z3_solver.h"
 #include "frontends/common/parser_options.h"
 #include "ir/solver.h"
@@ -80,8 +83,16 @@ std::optional<AbstractTestList> generateAndCollectAbstractTests(
                                                       testgenOptions.maxTests, std::nullopt,
                                                       testgenOptions.seed};
     // Need to declare the solver here to ensure its lifetime.
-    Z3Solver solver;
+    Z3Solver z3Solver;
+    CachingSolver solver(z3Solver);
     auto *symbolicExecutor = pickExecutionEngine(testgenOptions, programInfo, solver);
+    // The solvers of the workers of a parallel run, owned for the duration of the run.
+    std::vector<std::unique_ptr<Z3Solver>> workerZ3Solvers;
+    std::vector<std::unique_ptr<CachingSolver>> workerSolvers;
+    symbolicExecutor->setThreads(testgenOptions.threads, [&]() -> AbstractSolver & {
+        auto &workerZ3Solver = workerZ3Solvers.emplace_back(std::make_unique<Z3Solver>());
+        return *workerSolvers.emplace_back(std::make_unique<CachingSolver>(*workerZ3Solver));
+    });
 
     // Each test back end has a different run function.
     auto *testBackend =
@@ -128,8 +139,16 @@ int generateAndWriteAbstractTests(const TestgenOptions &testgenOptions,
         cstring(testPath.c_str()), testgenOptions.maxTests, testPath, testgenOptions.seed};
 
     // Need to declare the solver here to ensure its lifetime.
-    Z3Solver solver;
+    Z3Solver z3Solver;
+    CachingSolver solver(z3Solver);
     auto *symbolicExecutor = pickExecutionEngine(testgenOptions, programInfo, solver);
+    // The solvers of the workers of a parallel run, owned for the duration of the run.
+    std::vector<std::unique_ptr<Z3Solver>> workerZ3Solvers;
+    std::vector<std::unique_ptr<CachingSolver>> workerSolvers;
+    symbolicExecutor->setThreads(testgenOptions.threads, [&]() -> AbstractSolver & {
+        auto &workerZ3Solver = workerZ3Solvers.emplace_back(std::make_unique<Z3Solver>());
+        return *workerSolvers.emplace_back(std::make_unique<CachingSolver>(*workerZ3Solver));
+    });
 
     // Each test back end has a different run function.
     auto *testBackend =
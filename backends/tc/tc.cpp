@@ -17,6 +17,7 @@ and limitations under the License.
 #include "backend.h"
 #include "control-plane/p4RuntimeSerializer.h"
 #include "frontends/common/applyOptionsPragmas.h"
+#include "frontends/common/compileServer.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/p4/frontend.h"
 #include "ir/ir.h"
@@ -31,8 +32,7 @@ and limitations under the License.
 
 using namespace P4;
 
-int main(int argc, char *const argv[]) {
-    setup_gc_logging();
+static int compile(int argc, char *const argv[]) {
     AutoCompileContext autoTCContext(new TC::TCContext);
     auto &options = TC::TCContext::get().options();
     options.langVersion = TC::TCOptions::FrontendVersion::P4_16;
@@ -110,3 +110,9 @@ int main(int argc, char *const argv[]) {
     }
     return ::P4::errorCount() > 0;
 }
+
+int main(int argc, char *const argv[]) {
+    setup_gc_logging();
+
+    return P4::CompileServer::main(argc, argv, compile);
+}
@@ -18,6 +18,8 @@
 
 #include "unique_id.h"
 
+#include "ir/binary_ir_reader.h"
+#include "ir/binary_ir_writer.h"
 #include "ir/ir.h"
 #include "ir/json_generator.h"
 #include "ir/json_loader.h"
@@ -43,6 +45,18 @@ UniqueAttachedId UniqueAttachedId::fromJSON(P4::JSONLoader &json) {
     return uai;
 }
 
+void UniqueAttachedId::toBinary(P4::BinaryIRWriter &binary) const {
+    binary.emit(name);
+    binary.emit(type);
+}
+
+UniqueAttachedId UniqueAttachedId::fromBinary(P4::BinaryIRReader &binary) {
+    UniqueAttachedId uai;
+    binary.load(uai.name);
+    binary.load(uai.type);
+    return uai;
+}
+
 std::string UniqueAttachedId::build_name() const {
     std::string rv = "";
     if (type == INVALID) return rv;
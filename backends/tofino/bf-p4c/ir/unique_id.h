@@ -27,6 +27,8 @@
 namespace P4 {
 class JSONGenerator;
 class JSONLoader;
+class BinaryIRWriter;
+class BinaryIRReader;
 }  // namespace P4
 
 namespace P4 {
@@ -88,6 +90,8 @@ class UniqueAttachedId {
 
     void toJSON(P4::JSONGenerator &json) const;
     static UniqueAttachedId fromJSON(P4::JSONLoader &json);
+    void toBinary(P4::BinaryIRWriter &binary) const;
+    static UniqueAttachedId fromBinary(P4::BinaryIRReader &binary);
 
     bool has_meter_type() const {
         return type == METER || type == STATEFUL_ALU || type == SELECTOR;
@@ -18,6 +18,8 @@
 
 /* clang-format off */
 #include <exception>
+#include "ir/binary_ir_reader.h"
+#include "ir/binary_ir_writer.h"
 #include "ir/ir.h"
 #include "ir/json_loader.h"
 #include "lib/hex.h"
@@ -595,4 +597,30 @@ IR::MAU::HashFunction *IR::MAU::HashFunction::fromJSON(JSONLoader &json) {
     return rv;
 }
 
+void IR::MAU::HashFunction::toBinary(BinaryIRWriter &binary) const {
+    binary.emit(static_cast<int>(type));
+    binary.emit(size);
+    binary.emit(msb);
+    binary.emit(reverse);
+    binary.emit(poly);
+    binary.emit(init);
+    binary.emit(final_xor);
+    binary.emit(extend);
+}
+
+IR::MAU::HashFunction *IR::MAU::HashFunction::fromBinary(BinaryIRReader &binary) {
+    auto *rv = new HashFunction;
+    int type = 0;
+    binary.load(type);
+    rv->type = static_cast<decltype(rv->type)>(type);
+    binary.load(rv->size);
+    binary.load(rv->msb);
+    binary.load(rv->reverse);
+    binary.load(rv->poly);
+    binary.load(rv->init);
+    binary.load(rv->final_xor);
+    binary.load(rv->extend);
+    return rv;
+}
+
 /* clang-format on */
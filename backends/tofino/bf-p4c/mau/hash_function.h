@@ -43,6 +43,8 @@ struct HashFunction {
     bool operator!=(const HashFunction &a) const { return !(*this == a); }
     void toJSON(JSONGenerator &json) const;
     static HashFunction *fromJSON(JSONLoader &);
+    void toBinary(BinaryIRWriter &binary) const;
+    static HashFunction *fromBinary(BinaryIRReader &binary);
     bool setup(const IR::Expression *exp);
     bool convertPolynomialExtern(const IR::GlobalRef *);
     static HashFunction identity() {
@@ -76,6 +76,8 @@ struct TableResourceAlloc {
     }
     void toJSON(P4::JSONGenerator &json) const { json.emit(nullptr); }
     static TableResourceAlloc *fromJSON(P4::JSONLoader &) { return nullptr; }
+    void toBinary(P4::BinaryIRWriter &) const {}
+    static TableResourceAlloc *fromBinary(P4::BinaryIRReader &) { return nullptr; }
 
     void merge_instr(const TableResourceAlloc *);
     bool has_tind() const;
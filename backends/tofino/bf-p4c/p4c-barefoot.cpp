@@ -112,6 +112,7 @@
 #include "backends/tofino/bf-p4c/mau/table_flow_graph.h"
 #include "backends/tofino/bf-p4c/midend/type_checker.h"
 #include "backends/tofino/bf-p4c/parde/parser_header_sequences.h"
+#include "frontends/common/compileServer.h"
 #include "frontends/common/constantFolding.h"
 #include "frontends/p4-14/header_type.h"
 #include "frontends/p4-14/typecheck.h"
@@ -414,12 +415,7 @@ int handle_return(const int error_code, [[maybe_unused]] const BFN_Options &opti
     return error_code;
 }
 
-int main(int ac, char **av) {
-    setup_gc_logging();
-    setup_signals();
-    // initialize the Barefoot specific error types
-    BFN::ErrorType::getErrorTypes();
-
+static int compile(int ac, char *const av[]) {
     AutoCompileContext autoBFNContext(new BFNContext);
     auto &options = BackendOptions();
 
@@ -674,3 +670,12 @@ int main(int ac, char **av) {
     }
 #endif  // BFP4C_CATCH_EXCEPTIONS
 }
+
+int main(int ac, char **av) {
+    setup_gc_logging();
+    setup_signals();
+    // initialize the Barefoot specific error types
+    BFN::ErrorType::getErrorTypes();
+
+    return P4::CompileServer::main(ac, av, compile);
+}
@@ -23,6 +23,8 @@
 #include <sstream>
 
 #include "backends/tofino/bf-p4c/phv/phv_fields.h"
+#include "ir/binary_ir_reader.h"
+#include "ir/binary_ir_writer.h"
 #include "ir/ir.h"
 #include "ir/json_generator.h"
 #include "ir/json_loader.h"
@@ -209,6 +211,22 @@ Clot::Clot(JSONLoader &json) {
     json.load("stack_inc", stack_inc);
 }
 
+void Clot::toBinary(BinaryIRWriter &binary) const {
+    binary.emit(tag);
+    binary.emit(gress);
+    binary.emit(pov_bit);
+    binary.emit(stack_depth);
+    binary.emit(stack_inc);
+}
+
+Clot::Clot(BinaryIRReader &binary) {
+    binary.load(tag);
+    binary.load(gress);
+    binary.load(pov_bit);
+    binary.load(stack_depth);
+    binary.load(stack_inc);
+}
+
 std::ostream &operator<<(std::ostream &out, const Clot &clot) { return out << "CLOT " << clot.tag; }
 
 std::ostream &operator<<(std::ostream &out, const Clot *clot) {
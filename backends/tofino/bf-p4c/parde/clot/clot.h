@@ -48,6 +48,8 @@ namespace P4 {
 class cstring;
 class JSONGenerator;
 class JSONLoader;
+class BinaryIRWriter;
+class BinaryIRReader;
 }  // namespace P4
 
 class PhvInfo;
@@ -88,6 +90,11 @@ class Clot final : public LiftCompare<Clot> {
     explicit Clot(JSONLoader &json);
     static Clot *fromJSON(JSONLoader &json) { return new Clot(json); }
 
+    /// Binary IR serialization/deserialization.
+    void toBinary(BinaryIRWriter &binary) const;
+    explicit Clot(BinaryIRReader &binary);
+    static Clot *fromBinary(BinaryIRReader &binary) { return new Clot(binary); }
+
     /// Identifies the hardware CLOT associated with this object.
     unsigned tag;
 
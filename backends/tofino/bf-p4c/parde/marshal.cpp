@@ -18,6 +18,8 @@
 
 #include "marshal.h"
 
+#include "ir/binary_ir_reader.h"
+#include "ir/binary_ir_writer.h"
 #include "ir/ir.h"
 #include "ir/json_generator.h"
 #include "ir/json_loader.h"
@@ -42,3 +44,18 @@ MarshaledFrom MarshaledFrom::fromJSON(JSONLoader &json) {
     json.load("pre_padding", rv.pre_padding);
     return rv;
 }
+
+void MarshaledFrom::toBinary(BinaryIRWriter &binary) const {
+    binary.emit(gress);
+    binary.emit(field_name);
+    binary.emit(pre_padding);
+}
+
+/* static */
+MarshaledFrom MarshaledFrom::fromBinary(BinaryIRReader &binary) {
+    MarshaledFrom rv;
+    binary.load(rv.gress);
+    binary.load(rv.field_name);
+    binary.load(rv.pre_padding);
+    return rv;
+}
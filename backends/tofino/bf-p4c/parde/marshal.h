@@ -28,6 +28,8 @@ namespace P4 {
 
 class JSONGenerator;
 class JSONLoader;
+class BinaryIRWriter;
+class BinaryIRReader;
 
 struct MarshaledFrom {
     // use those two to uniquely identify a field.
@@ -51,6 +53,10 @@ struct MarshaledFrom {
     void toJSON(JSONGenerator &json) const;
     static MarshaledFrom fromJSON(JSONLoader &json);
 
+    /// Binary IR serialization/deserialization.
+    void toBinary(BinaryIRWriter &binary) const;
+    static MarshaledFrom fromBinary(BinaryIRReader &binary);
+
     friend std::ostream &operator<<(std::ostream &s, const MarshaledFrom &m);
     friend P4::JSONGenerator &operator<<(P4::JSONGenerator &out, const MarshaledFrom &c);
 
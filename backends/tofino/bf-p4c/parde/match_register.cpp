@@ -20,6 +20,8 @@
 
 #include <sstream>
 
+#include "ir/binary_ir_reader.h"
+#include "ir/binary_ir_writer.h"
 #include "ir/ir.h"
 #include "ir/json_generator.h"
 #include "ir/json_loader.h"
@@ -51,3 +53,12 @@ MatchRegister MatchRegister::fromJSON(JSONLoader &json) {
     BUG("Couldn't decode JSON value to parser match register");
     return MatchRegister();
 }
+
+void MatchRegister::toBinary(BinaryIRWriter &binary) const { binary.emit(toString()); }
+
+/* static */
+MatchRegister MatchRegister::fromBinary(BinaryIRReader &binary) {
+    cstring name;
+    binary.load(name);
+    return MatchRegister(name);
+}
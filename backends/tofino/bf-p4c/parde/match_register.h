@@ -27,6 +27,8 @@ namespace P4 {
 
 class JSONGenerator;
 class JSONLoader;
+class BinaryIRWriter;
+class BinaryIRReader;
 
 class MatchRegister {
  public:
@@ -41,6 +43,10 @@ class MatchRegister {
     void toJSON(JSONGenerator &json) const;
     static MatchRegister fromJSON(JSONLoader &json);
 
+    /// Binary IR serialization/deserialization.
+    void toBinary(BinaryIRWriter &binary) const;
+    static MatchRegister fromBinary(BinaryIRReader &binary);
+
     cstring name;
     size_t size;
     int id;
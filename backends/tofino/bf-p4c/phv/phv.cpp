@@ -22,6 +22,8 @@
 #include <iostream>
 #include <sstream>
 
+#include "ir/binary_ir_reader.h"
+#include "ir/binary_ir_writer.h"
 #include "ir/ir.h"
 #include "ir/json_loader.h"
 #include "lib/cstring.h"
@@ -167,6 +169,14 @@ void Container::toJSON(P4::JSONGenerator &json) const { json.emit(toString()); }
     return Container();
 }
 
+void Container::toBinary(P4::BinaryIRWriter &binary) const { binary.emit(toString()); }
+
+/* static */ Container Container::fromBinary(P4::BinaryIRReader &binary) {
+    cstring name;
+    binary.load(name);
+    return Container(name.c_str());
+}
+
 cstring FieldUse::toString(unsigned dark) const {
     if (use_ == 0) return ""_cs;
     std::stringstream ss;
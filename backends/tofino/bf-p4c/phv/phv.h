@@ -32,6 +32,8 @@ class bitvec;
 class cstring;
 class JSONGenerator;
 class JSONLoader;
+class BinaryIRWriter;
+class BinaryIRReader;
 }  // namespace P4
 
 using namespace P4;
@@ -238,6 +240,10 @@ class Container {
     void toJSON(P4::JSONGenerator &json) const;
     static Container fromJSON(P4::JSONLoader &json);
 
+    /// Binary IR serialization/deserialization.
+    void toBinary(P4::BinaryIRWriter &binary) const;
+    static Container fromBinary(P4::BinaryIRReader &binary);
+
     /// @return a string representation of this container.
     cstring toString() const;
 };
@@ -24,6 +24,7 @@ limitations under the License.
 #include "backends/ubpf/version.h"
 #include "control-plane/p4RuntimeSerializer.h"
 #include "frontends/common/applyOptionsPragmas.h"
+#include "frontends/common/compileServer.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/p4/frontend.h"
 #include "fstream"
@@ -66,10 +67,7 @@ void compile(EbpfOptions &options) {
     UBPF::run_ubpf_backend(options, toplevel, &midend.refMap, &midend.typeMap);
 }
 
-int main(int argc, char *const argv[]) {
-    setup_gc_logging();
-    setup_signals();
-
+static int compileCommandLine(int argc, char *const argv[]) {
     AutoCompileContext autoEbpfContext(new EbpfContext);
     auto &options = EbpfContext::get().options();
     options.compilerVersion = cstring(P4C_UBPF_VERSION_STRING);
@@ -91,3 +89,10 @@ int main(int argc, char *const argv[]) {
 
     return ::P4::errorCount() > 0;
 }
+
+int main(int argc, char *const argv[]) {
+    setup_gc_logging();
+    setup_signals();
+
+    return P4::CompileServer::main(argc, argv, compileCommandLine);
+}
@@ -0,0 +1,335 @@
+#include "frontends/common/architectureCache.h"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
+#include "ir/json_generator.h"
+#include "lib/error.h"
+#include "lib/exename.h"
+#include "lib/hash.h"
+#include "lib/log.h"
+
+namespace P4 {
+
+namespace {
+
+/// The first line of the cache entries, changed whenever their format changes.
+constexpr std::string_view ENTRY_HEADER = "p4c architecture cache 1";
+
+/// The input file, split into the standard includes at its start and the rest.
+struct SplitInput {
+    /// The lines up to the last #include of a standard include.
+    std::string prelude;
+
+    /// The remaining lines.
+    std::string rest;
+
+    /// The line number of the first remaining line.
+    unsigned restLine = 1;
+};
+
+/// Returns true if @p line can be part of the prelude: a blank line, a line comment, a
+/// single-line #define or an #include of a standard include. Sets @p isInclude for the latter.
+bool isPreludeLine(std::string_view line, bool &isInclude) {
+    line = absl::StripAsciiWhitespace(line);
+    isInclude = false;
+    if (line.empty() || absl::StartsWith(line, "//")) return true;
+    if (!absl::ConsumePrefix(&line, "#")) return false;
+    line = absl::StripLeadingAsciiWhitespace(line);
+    if (absl::ConsumePrefix(&line, "include")) {
+        line = absl::StripLeadingAsciiWhitespace(line);
+        isInclude = absl::StartsWith(line, "<") && absl::EndsWith(line, ">");
+        return isInclude;
+    }
+    return absl::StartsWith(line, "define") && !absl::EndsWith(line, "\\");
+}
+
+std::optional<SplitInput> splitInput(std::string_view contents) {
+    size_t preludeEnd = 0;
+    unsigned preludeLines = 0;
+    size_t pos = 0;
+    for (unsigned line = 1; pos < contents.size(); line++) {
+        auto end = contents.find('\n', pos);
+        end = end == std::string_view::npos ? contents.size() : end + 1;
+        bool isInclude = false;
+        if (!isPreludeLine(contents.substr(pos, end - pos), isInclude)) break;
+        pos = end;
+        if (isInclude) {
+            preludeEnd = pos;
+            preludeLines = line;
+        }
+    }
+    if (preludeEnd == 0) return std::nullopt;
+    return SplitInput{std::string(contents.substr(0, preludeEnd)),
+                      std::string(contents.substr(preludeEnd)), preludeLines + 1};
+}
+
+std::optional<std::string> readFile(const std::filesystem::path &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return std::nullopt;
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+std::string hashString(std::string_view data) {
+    return absl::StrFormat("%016x", Util::hash(data.data(), data.size()));
+}
+
+/// @returns the key of the entry for @p prelude.
+std::string entryKey(const ParserOptions &options, std::string_view prelude) {
+    std::error_code ec;
+    // Entries are not shared between builds of the compiler, which may differ in their IR.
+    std::string compiler = getExecutablePath().native();
+    auto modified = std::filesystem::last_write_time(compiler, ec);
+    if (!ec) absl::StrAppend(&compiler, " ", modified.time_since_epoch().count());
+    // Relative include paths are resolved from the current directory.
+    auto cwd = std::filesystem::current_path(ec);
+    return hashString(absl::StrCat(
+        ENTRY_HEADER, "\n", options.compilerVersion.string_view(), "\n", compiler, "\n",
+        cwd.native(), "\n", options.preprocessor_options.string_view(), "\n",
+        options.getIncludePath(), "\n", prelude));
+}
+
+/// Returns the files named by the line markers of the preprocessed @p text, other than
+/// @p excluded, with the hashes of their contents, one per line.
+std::optional<std::string> dependencies(std::string_view text,
+                                        const std::set<std::string, std::less<>> &excluded) {
+    std::set<std::string, std::less<>> files;
+    for (std::string_view line : absl::StrSplit(text, '\n')) {
+        if (!absl::ConsumePrefix(&line, "# ")) continue;
+        auto quote = line.find('"');
+        if (quote == std::string_view::npos) continue;
+        auto file = line.substr(quote + 1);
+        file = file.substr(0, file.find('"'));
+        if (file.empty() || file.front() == '<' || excluded.count(file) != 0) continue;
+        files.emplace(file);
+    }
+    std::string result;
+    for (const auto &file : files) {
+        auto contents = readFile(file);
+        if (!contents) return std::nullopt;
+        absl::StrAppend(&result, hashString(*contents), " ", file, "\n");
+    }
+    return result;
+}
+
+/// Returns true if the files listed by dependencies() still have the same hashes.
+bool unchanged(std::string_view dependencies) {
+    for (std::string_view line : absl::StrSplit(dependencies, '\n', absl::SkipEmpty())) {
+        auto space = line.find(' ');
+        if (space == std::string_view::npos) return false;
+        auto contents = readFile(line.substr(space + 1));
+        if (!contents || hashString(*contents) != line.substr(0, space)) return false;
+    }
+    return true;
+}
+
+/// Returns the #define and #undef directives in the output of the preprocessor. Predefined
+/// macros and macros defined on the command line are defined again anyway.
+std::string macroDirectives(std::string_view text) {
+    std::string result;
+    bool predefined = false;
+    for (std::string_view line : absl::StrSplit(text, '\n')) {
+        if (absl::StartsWith(line, "# ")) {
+            predefined = absl::StrContains(line, "\"<");
+        } else if (!predefined &&
+                   (absl::StartsWith(line, "#define ") || absl::StartsWith(line, "#undef "))) {
+            absl::StrAppend(&result, line, "\n");
+        }
+    }
+    return result;
+}
+
+/// Reads a section written as its size on a line, followed by its contents, from @p in, which
+/// holds @p fileSize bytes. Fails on sizes beyond the end of the file, which a truncated or
+/// corrupted entry could have.
+bool readSection(std::istream &in, uintmax_t fileSize, std::string &section) {
+    std::string line;
+    size_t size = 0;
+    if (!std::getline(in, line) || !absl::SimpleAtoi(line, &size)) return false;
+    auto pos = in.tellg();
+    if (pos < 0 || static_cast<uintmax_t>(pos) > fileSize ||
+        size > fileSize - static_cast<uintmax_t>(pos)) {
+        return false;
+    }
+    section.resize(size);
+    return static_cast<bool>(in.read(section.data(), static_cast<std::streamsize>(size)));
+}
+
+}  // namespace
+
+ArchitectureCache::ArchitectureCache(std::filesystem::path directory, bool shared)
+    : directory(std::move(directory)), shared(shared) {}
+
+std::filesystem::path ArchitectureCache::workDirectory() const {
+    if (!directory.empty()) return directory;
+    return std::filesystem::temp_directory_path();
+}
+
+bool ArchitectureCache::load(const std::filesystem::path &path,
+                             P4ParserDriver::Prelude &prelude) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    std::ifstream in(path, std::ios::binary);
+    std::string line;
+    if (!std::getline(in, line) || line != ENTRY_HEADER) return false;
+    std::string dependencies;
+    if (!readSection(in, size, dependencies) || !unchanged(dependencies)) return false;
+    return readSection(in, size, prelude.text) && readSection(in, size, prelude.symbols) &&
+           readSection(in, size, prelude.ir);
+}
+
+void ArchitectureCache::store(const std::filesystem::path &path, const std::string &dependencies,
+                              const P4ParserDriver::Prelude &prelude) {
+    // Entries are written to a temporary file and renamed, so that concurrent compilations
+    // never read a partial entry.
+    auto temporary = path;
+    temporary += absl::StrCat(".", getpid(), ".tmp");
+    std::error_code ec;
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        out << ENTRY_HEADER << '\n';
+        for (const auto *section : {&dependencies, &prelude.text, &prelude.symbols, &prelude.ir})
+            out << section->size() << '\n' << *section;
+        if (out) {
+            out.close();
+            std::filesystem::rename(temporary, path, ec);
+            if (!ec) return;
+        }
+    }
+    std::filesystem::remove(temporary, ec);
+    ::P4::warning(ErrorType::WARN_FAILED, "%1%: cannot write the architecture cache entry",
+                  path.string());
+}
+
+std::optional<std::string> ArchitectureCache::preprocess(const ParserOptions &options,
+                                                         std::string_view name,
+                                                         const std::string &source,
+                                                         std::string_view extraOptions) const {
+    auto path = workDirectory() / absl::StrCat(name, ".", getpid(), ".p4");
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << source;
+        if (!out) {
+            ::P4::error(ErrorType::ERR_IO, "%1%: cannot write the input of the preprocessor",
+                        path.string());
+            return std::nullopt;
+        }
+    }
+
+    auto cmd = options.getPreprocessorCommand(path, extraOptions);
+    if (Log::verbose()) std::cerr << "Invoking preprocessor " << std::endl << cmd << std::endl;
+    auto errors = ::P4::errorCount();
+    std::string text;
+    if (FILE *in = popen(cmd.c_str(), "r")) {
+        char buffer[4096];
+        while (size_t size = fread(buffer, 1, sizeof(buffer), in)) text.append(buffer, size);
+        ParserOptions::closeFile(in);
+    } else {
+        ::P4::error(ErrorType::ERR_IO, "Error invoking preprocessor");
+    }
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    if (::P4::errorCount() > errors) return std::nullopt;
+    return text;
+}
+
+P4ParserDriver::Prelude *ArchitectureCache::getPrelude(const ParserOptions &options,
+                                                       const std::string &key,
+                                                       std::string_view lines) const {
+    auto known = preludes.find(key);
+    if (known != preludes.end()) return &known->second;
+
+    auto entry = directory / (key + ".p4c");
+    P4ParserDriver::Prelude prelude;
+    if (!directory.empty() && load(entry, prelude)) {
+        LOG2("Using the parsed standard includes in " << entry);
+        return &preludes.emplace(key, std::move(prelude)).first->second;
+    }
+
+    // Keep the #define directives in the output, they are needed for the rest of the file.
+    auto source = absl::StrCat("#line 1 \"", absl::CEscape(options.file.native()), "\"\n", lines);
+    auto text = preprocess(options, key, source, "-dD");
+    if (!text) return nullptr;
+    prelude.text = std::move(*text);
+    std::istringstream empty;
+    if (P4ParserDriver::parse(prelude, empty, options.file.string()) == nullptr) return nullptr;
+
+    if (!directory.empty()) {
+        std::set<std::string, std::less<>> excluded = {options.file.string()};
+        excluded.emplace((workDirectory() / absl::StrCat(key, ".", getpid(), ".p4")).string());
+        if (auto deps = dependencies(prelude.text, excluded)) {
+            std::ostringstream ir;
+            JSONGenerator(ir).withSourcePositions().emit(prelude.program);
+            prelude.ir = ir.str();
+            store(entry, *deps, prelude);
+        }
+    }
+    return &preludes.emplace(key, std::move(prelude)).first->second;
+}
+
+std::optional<const IR::P4Program *> ArchitectureCache::parse(
+    const ParserOptions &options) const {
+    // Dependency output of the preprocessor needs to see the whole file.
+    if ((directory.empty() && !shared) || options.isv1() || options.file == "-" ||
+        options.doNotCompile ||
+        absl::StrContains(options.preprocessor_options.string_view(), " -M")) {
+        return std::nullopt;
+    }
+    auto contents = readFile(options.file);
+    if (!contents) return std::nullopt;
+    auto input = splitInput(*contents);
+    if (!input) return std::nullopt;
+    std::error_code ec;
+    if (!directory.empty()) std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        ::P4::warning(ErrorType::WARN_FAILED, "%1%: cannot create the architecture cache: %2%",
+                      directory.string(), ec.message());
+        return std::nullopt;
+    }
+
+    auto key = entryKey(options, input->prelude);
+    auto *prelude = getPrelude(options, key, input->prelude);
+    if (prelude == nullptr) return nullptr;
+
+    // Quoted includes of the rest are looked up relative to the input file.
+    auto inputDirectory = options.file.parent_path();
+    if (inputDirectory.empty()) inputDirectory = ".";
+    auto source = absl::StrCat(macroDirectives(prelude->text), "#line ", input->restLine, " \"",
+                               absl::CEscape(options.file.native()), "\"\n", input->rest);
+    auto rest = preprocess(options, key, source,
+                           absl::StrCat("-iquote ", absl::CEscape(inputDirectory.native())));
+    if (!rest) return nullptr;
+    std::istringstream restStream(*rest);
+    return P4ParserDriver::parse(*prelude, restStream, options.file.string());
+}
+
+void ArchitectureCache::preload(const ParserOptions &options) const {
+    if ((directory.empty() && !shared) || options.isv1()) return;
+    auto contents = readFile(options.file);
+    if (!contents) return;
+    auto input = splitInput(*contents);
+    if (!input) return;
+    std::error_code ec;
+    if (!directory.empty()) std::filesystem::create_directories(directory, ec);
+    getPrelude(options, entryKey(options, input->prelude), input->prelude);
+}
+
+}  // namespace P4
@@ -0,0 +1,82 @@
+#ifndef FRONTENDS_COMMON_ARCHITECTURECACHE_H_
+#define FRONTENDS_COMMON_ARCHITECTURECACHE_H_
+
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "frontends/common/parser_options.h"
+#include "frontends/parsers/parserDriver.h"
+
+namespace P4::IR {
+class P4Program;
+}  // namespace P4::IR
+
+namespace P4 {
+
+/// A cache of the parsed standard includes of P4-16 programs, shared by the compilations of
+/// many programs (see --arch-cache). Most programs start with a few lines such as
+///
+///     #define V1MODEL_VERSION 20200408
+///     #include <core.p4>
+///     #include <v1model.p4>
+///
+/// which every compilation preprocesses and parses again. The cache keeps the preprocessed
+/// text of these lines, the declarations parsed from it and the symbols the parser needs for
+/// the rest of the program. The rest of the program is preprocessed on its own, with the
+/// macros defined by the cached lines.
+///
+/// Entries are keyed by the cached lines, the preprocessor options, the include path and the
+/// compiler binary. An entry is only used if the files it includes still have the same hash.
+///
+/// The parsed declarations are also kept by the cache object, for the programs parsed through
+/// it later. A batch of programs uses one shared object, which parses the includes once even
+/// without a cache directory.
+class ArchitectureCache {
+ public:
+    /// Uses the entries in @p directory. With @p shared, the cache is used even if
+    /// @p directory is empty, and then only holds the includes parsed by this object.
+    explicit ArchitectureCache(std::filesystem::path directory, bool shared = false);
+
+    /// Parses the input file of @p options. Returns std::nullopt if the cache is disabled, the
+    /// file does not start with standard includes or the cache cannot be used, in which case
+    /// the file has to be parsed as usual. Otherwise returns the program, or null if parsing
+    /// failed.
+    std::optional<const IR::P4Program *> parse(const ParserOptions &options) const;
+
+    /// Parses the standard includes at the start of the input file of @p options, unless this
+    /// object already holds them, so that the programs parsed later share them.
+    void preload(const ParserOptions &options) const;
+
+ private:
+    /// Returns the parsed prelude of the input file of @p options, which starts with the
+    /// standard includes in @p lines, with the entry key @p key. Returns null on errors.
+    P4ParserDriver::Prelude *getPrelude(const ParserOptions &options, const std::string &key,
+                                        std::string_view lines) const;
+
+    /// Reads the entry in @p path into @p prelude. Returns false if there is no valid entry.
+    static bool load(const std::filesystem::path &path, P4ParserDriver::Prelude &prelude);
+
+    /// Writes @p prelude, which includes @p dependencies, to the entry in @p path.
+    static void store(const std::filesystem::path &path, const std::string &dependencies,
+                      const P4ParserDriver::Prelude &prelude);
+
+    /// Preprocesses @p source, writing it to a temporary file named after @p name first.
+    std::optional<std::string> preprocess(const ParserOptions &options, std::string_view name,
+                                          const std::string &source,
+                                          std::string_view extraOptions) const;
+
+    /// The directory of the temporary input files of the preprocessor.
+    std::filesystem::path workDirectory() const;
+
+    std::filesystem::path directory;
+    bool shared;
+    /// The preludes parsed or loaded by this object, by entry key.
+    mutable std::map<std::string, P4ParserDriver::Prelude> preludes;
+};
+
+}  // namespace P4
+
+#endif /* FRONTENDS_COMMON_ARCHITECTURECACHE_H_ */
@@ -0,0 +1,256 @@
+#include "frontends/common/compileServer.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include "frontends/common/options.h"
+#include "lib/compile_context.h"
+#include "lib/error.h"
+
+namespace P4 {
+
+namespace {
+
+/// The number of standard streams passed with a request.
+constexpr int STREAM_COUNT = 3;
+/// Requests larger than this are rejected.
+constexpr uint32_t MAX_REQUEST_SIZE = 16 << 20;
+
+bool readAll(int fd, char *data, size_t size) {
+    while (size > 0) {
+        auto count = ::read(fd, data, size);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool writeAll(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        auto count = ::write(fd, data, size);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+/// Receives the request header and the streams of the client. Returns false if the
+/// request is not valid, in which case no streams are left open.
+bool receiveHeader(int connection, CompileRequestHeader &header, int (&streams)[STREAM_COUNT]) {
+    iovec data{&header, sizeof(header)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(streams))];
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t count;
+    do {
+        count = recvmsg(connection, &message, 0);
+    } while (count < 0 && errno == EINTR);
+
+    int received = 0;
+    for (auto *cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+        size_t fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < fds; ++i) {
+            int fd;
+            std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            if (received < STREAM_COUNT)
+                streams[received++] = fd;
+            else
+                ::close(fd);
+        }
+    }
+
+    // The rest of a partially received header follows without the streams.
+    bool valid = count > 0 && received == STREAM_COUNT &&
+                 readAll(connection, reinterpret_cast<char *>(&header) + count,
+                         sizeof(header) - count) &&
+                 std::memcmp(header.magic, CompileRequestHeader::expectedMagic,
+                             sizeof(header.magic)) == 0 &&
+                 header.version == CompileRequestHeader::currentVersion &&
+                 header.size <= MAX_REQUEST_SIZE;
+    if (!valid) {
+        for (int i = 0; i < received; ++i) ::close(streams[i]);
+    }
+    return valid;
+}
+
+}  // namespace
+
+CompileServer::CompileServer(std::filesystem::path socketPath, CompileFn compile,
+                             std::string program)
+    : socketPath(std::move(socketPath)), compile(std::move(compile)), program(std::move(program)) {}
+
+int CompileServer::runRequest(const std::string &directory,
+                              const std::vector<std::string> &environment,
+                              std::vector<std::string> &arguments) const {
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Unable to start a compilation: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    if (pid == 0) {
+        // The request is compiled from scratch, like by a new process started in the
+        // directory and with the environment of the client.
+        if (chdir(directory.c_str()) != 0) {
+            std::cerr << "Unable to enter " << directory << ": " << std::strerror(errno)
+                      << std::endl;
+            _exit(1);
+        }
+        clearenv();
+        for (const auto &entry : environment) {
+            auto equals = entry.find('=');
+            setenv(entry.substr(0, equals).c_str(), entry.c_str() + equals + 1, 1);
+        }
+        std::vector<char *> argv;
+        for (auto &argument : arguments) argv.push_back(argument.data());
+        argv.push_back(nullptr);
+        int status = compile(static_cast<int>(arguments.size()), argv.data());
+        std::cout.flush();
+        std::cerr.flush();
+        _exit(status);
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return 1;
+    }
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return WEXITSTATUS(status);
+}
+
+void CompileServer::serve(int connection) const {
+    CompileRequestHeader header;
+    int streams[STREAM_COUNT];
+    if (!receiveHeader(connection, header, streams)) return;
+
+    // From here on, everything this process prints goes to the client.
+    for (int i = 0; i < STREAM_COUNT; ++i) {
+        dup2(streams[i], i);
+        ::close(streams[i]);
+    }
+
+    std::string request(header.size, '\0');
+    if (!readAll(connection, request.data(), request.size())) return;
+    // The working directory, the environment, then argv[0] and the arguments.
+    std::vector<std::string> strings;
+    for (size_t start = 0; start < request.size();) {
+        auto end = request.find('\0', start);
+        if (end == std::string::npos) end = request.size();
+        strings.push_back(request.substr(start, end - start));
+        start = end + 1;
+    }
+
+    int32_t status = 1;
+    size_t argv0 = 1 + size_t(header.environmentCount);
+    bool valid = strings.size() > argv0;
+    for (size_t i = 1; valid && i < argv0; ++i) {
+        auto equals = strings[i].find('=');
+        valid = equals != std::string::npos && equals > 0;
+    }
+    if (!valid) {
+        std::cerr << "Invalid compilation request" << std::endl;
+    } else if (std::filesystem::path(strings[argv0]).filename() != program) {
+        std::cerr << "The compilation server on " << socketPath.string() << " runs " << program
+                  << ", not " << std::filesystem::path(strings[argv0]).filename().string()
+                  << std::endl;
+    } else {
+        std::vector<std::string> environment(strings.begin() + 1, strings.begin() + argv0);
+        std::vector<std::string> arguments(strings.begin() + argv0, strings.end());
+        status = runRequest(strings[0], environment, arguments);
+    }
+    writeAll(connection, reinterpret_cast<const char *>(&status), sizeof(status));
+}
+
+bool CompileServer::run() const {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    const auto &path = socketPath.native();
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error(ErrorType::ERR_INVALID, "Invalid socket path %1%", path);
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        error(ErrorType::ERR_IO, "Unable to create a socket: %1%", std::strerror(errno));
+        return false;
+    }
+    // The compilers run by a request, like the preprocessor, do not inherit the socket.
+    fcntl(listener, F_SETFD, FD_CLOEXEC);
+    // A socket left behind by a server which is no longer running.
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) ::unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        error(ErrorType::ERR_IO, "Unable to listen on %1%: %2%", path, std::strerror(errno));
+        ::close(listener);
+        return false;
+    }
+
+    // Every connection is served by its own process, which is reaped automatically.
+    signal(SIGCHLD, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);
+    std::cout.flush();
+    std::cerr.flush();
+    while (true) {
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            error(ErrorType::ERR_IO, "Unable to accept a connection on %1%: %2%", path,
+                  std::strerror(errno));
+            ::close(listener);
+            return false;
+        }
+        fcntl(connection, F_SETFD, FD_CLOEXEC);
+        pid_t pid = fork();
+        if (pid == 0) {
+            ::close(listener);
+            // The compilation run by this process is waited for.
+            signal(SIGCHLD, SIG_DFL);
+            serve(connection);
+            _exit(0);
+        }
+        if (pid < 0) {
+            std::cerr << "Unable to serve a connection: " << std::strerror(errno) << std::endl;
+        }
+        ::close(connection);
+    }
+}
+
+int CompileServer::main(int argc, char *const argv[], CompileFn compile) {
+    if (argc < 3 || std::strcmp(argv[1], "--serve") != 0) return compile(argc, argv);
+
+    std::string program = std::filesystem::path(argv[0]).filename().string();
+    // The remaining arguments, if any, are a warm-up compilation.
+    if (argc > 3) {
+        std::vector<char *> warmUp{argv[0]};
+        warmUp.insert(warmUp.end(), argv + 3, argv + argc);
+        warmUp.push_back(nullptr);
+        compile(static_cast<int>(warmUp.size() - 1), warmUp.data());
+    }
+
+    AutoCompileContext serverContext(new P4CContextWithOptions<CompilerOptions>());
+    return CompileServer(argv[2], std::move(compile), program).run() ? 0 : 1;
+}
+
+}  // namespace P4
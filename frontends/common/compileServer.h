@@ -0,0 +1,82 @@
+/*
+Compilation server mode of the compilers (--serve <socket>). The compiler
+starts once, listens on a Unix socket and compiles the requests of clients
+(`p4c --server <socket>`), so a compilation does not pay for the process
+startup, the initialization of the garbage collector and the first reads of
+the standard includes again.
+
+Every request is compiled in a child forked from the server, which runs
+the command line of the request from scratch, in a fresh compilation
+context. The children inherit the warm state of the server: the interned
+cstring table, and the include files cached by --builtin-cpp. Arguments
+given after --serve <socket> are compiled once in the server itself before
+it starts listening, to warm up these caches; with --arch-cache, the parsed
+standard includes are then shared through the cache directory.
+
+A client connects and sends
+ - a CompileRequestHeader, together with its standard input, output and
+   error as SCM_RIGHTS;
+ - its working directory, its environment as NAME=value entries and its
+   command line, as NUL-terminated strings.
+The compilation runs in the working directory and with the environment of
+the client, and writes its output and diagnostics directly to the streams of
+the client. Once it is
+done, the server replies with the exit status of the compilation as an
+int32_t, 128 + the signal number if the compilation crashed.
+*/
+
+#ifndef FRONTENDS_COMMON_COMPILESERVER_H_
+#define FRONTENDS_COMMON_COMPILESERVER_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace P4 {
+
+struct CompileRequestHeader {
+    static constexpr char expectedMagic[4] = {'P', '4', 'C', 'S'};
+    static constexpr uint32_t currentVersion = 2;
+
+    char magic[4];
+    uint32_t version;
+    /// The size of the strings which follow the header.
+    uint32_t size;
+    /// The number of environment entries, which follow the working directory.
+    uint32_t environmentCount;
+};
+
+class CompileServer {
+ public:
+    /// Compiles the command line @p argv, like the main function of a compiler.
+    using CompileFn = std::function<int(int argc, char *const argv[])>;
+
+ private:
+    std::filesystem::path socketPath;
+    CompileFn compile;
+    std::string program;
+
+    /// Receives a request on @p connection, compiles it and sends the exit status.
+    void serve(int connection) const;
+    /// Runs a request in a child process, returns its exit status.
+    int runRequest(const std::string &directory, const std::vector<std::string> &environment,
+                   std::vector<std::string> &arguments) const;
+
+ public:
+    /// @p program is the name of the compiler, which must match argv[0] of the requests.
+    CompileServer(std::filesystem::path socketPath, CompileFn compile, std::string program);
+
+    /// Listens on the socket and serves requests until the process is terminated. Returns
+    /// false if the socket could not be created.
+    bool run() const;
+
+    /// The main function of a compiler which supports the server mode: runs a server if
+    /// --serve <socket> is the first option, and compile(argc, argv) otherwise.
+    static int main(int argc, char *const argv[], CompileFn compile);
+};
+
+}  // namespace P4
+
+#endif /* FRONTENDS_COMMON_COMPILESERVER_H_ */
@@ -59,6 +59,13 @@ CompilerOptions::CompilerOptions(std::string_view defaultMessage) : ParserOption
             return true;
         },
         "Dump the compiler IR after the midend as JSON in the specified file.");
+    registerOption(
+        "--toBinaryIR", "file",
+        [this](const char *arg) {
+            dumpBinaryIRFile = arg;
+            return true;
+        },
+        "Dump the compiler IR after the midend in the binary IR format in the specified file.");
     registerOption(
         "--ndebug", nullptr,
         [this](const char *) {
@@ -192,8 +199,14 @@ CompilerOptions::CompilerOptions(std::string_view defaultMessage) : ParserOption
             auto copy = strdup(arg);
             while (cstring metric = cstring(strsep(&copy, ","))) {
                 if (metric == "all") {
-                    CompilerOptions::selectedMetrics = validMetrics;
-                    return true;
+                    CompilerOptions::selectedMetrics.insert(validMetrics.begin(),
+                                                            validMetrics.end());
+                } else if (metric == "compile-profile") {
+                    // Not part of "all", the profile differs between compilations.
+                    CompilerOptions::selectedMetrics.insert(metric);
+                } else if (metric == "compile-profile-nodes") {
+                    CompilerOptions::selectedMetrics.insert("compile-profile"_cs);
+                    CompilerOptions::selectedMetrics.insert(metric);
                 } else if (validMetrics.find(metric) == validMetrics.end()) {
                     ::P4::error(ErrorType::ERR_INVALID, "Invalid metric: %s", metric);
                     return false;
@@ -206,7 +219,117 @@ CompilerOptions::CompilerOptions(std::string_view defaultMessage) : ParserOption
         "Select which code metrics will be collected.\n"
         "Valid options: all, loc, cyclomatic, halstead, unused-code, duplicit-code,\n"
         "nesting-depth, header-general, header-manipulation, header-modification,\n"
-        "match-action, parser, inlined, extern.");
+        "match-action, parser, inlined, extern, compile-profile (per-pass compile time and\n"
+        "allocations, not included in all), compile-profile-nodes (compile-profile with the\n"
+        "IR node counts of every pass, which is slower).");
+    registerOption(
+        "--metrics-cache", "dir",
+        [this](const char *arg) {
+            metricsCacheDir = arg;
+            return true;
+        },
+        "Reuse per-declaration code metric values (cyclomatic complexity, nesting depth,\n"
+        "header metrics) stored in the cache in the given directory, and store new ones.");
+    registerOption(
+        "--metrics-jobs", "N",
+        [this](const char *arg) {
+            char *end = nullptr;
+            auto jobs = strtoul(arg, &end, 10);
+            if (*end != 0 || jobs == 0) {
+                ::P4::error(ErrorType::ERR_INVALID, "Invalid number of metrics jobs: %1%", arg);
+                return false;
+            }
+            metricsJobs = jobs;
+            return true;
+        },
+        "Compute the per-block code metrics (cyclomatic complexity, nesting depth)\n"
+        "using N threads (default: 1).");
+    registerOption(
+        "--metrics-format", "json|txt|both",
+        [this](const char *arg) {
+            cstring format(arg);
+            if (format != "json" && format != "txt" && format != "both") {
+                ::P4::error(ErrorType::ERR_INVALID, "Invalid metrics format: %1%", arg);
+                return false;
+            }
+            metricsFormat = format;
+            return true;
+        },
+        "Select the files the code metrics are exported to (default: both).");
+    registerOption(
+        "--metrics-batch", "list|pattern",
+        [this](const char *arg) {
+            metricsBatch = cstring(arg);
+            return true;
+        },
+        "Collect the code metrics of many programs in one run. The argument is a glob\n"
+        "pattern, or a file listing one program (or pattern) per line. Programs given\n"
+        "on the command line are added to the batch. The programs are compiled by\n"
+        "--metrics-jobs worker processes.");
+    registerOption(
+        "--metrics-batch-output", "file",
+        [this](const char *arg) {
+            metricsBatchOutput = arg;
+            return true;
+        },
+        "JSON-lines file with the metrics of every program in the batch\n"
+        "(default: metrics.jsonl).");
+    registerOption(
+        "--metrics-parser-paths", "N",
+        [this](const char *arg) {
+            char *end = nullptr;
+            auto paths = strtoull(arg, &end, 10);
+            if (*end != 0 || paths == 0) {
+                ::P4::error(ErrorType::ERR_INVALID, "Invalid number of parser paths: %1%", arg);
+                return false;
+            }
+            metricsParserPaths = paths;
+            return true;
+        },
+        "Maximum number of parser paths enumerated per parser by the header manipulation\n"
+        "and modification metrics (default: 1000000). The metrics of parsers with more\n"
+        "paths are partial.");
+    registerOption(
+        "--metrics-after", "pass1[,pass2]",
+        [this](const char *arg) {
+            auto copy = strdup(arg);
+            while (auto pass = strsep(&copy, ",")) metricsAfterPasses.push_back(cstring(pass));
+            return true;
+        },
+        "Take a labeled snapshot of the selected code metrics after passes whose name\n"
+        "contains one of the given substrings, in every pipeline the compiler attaches\n"
+        "the metrics snapshot hook to (frontend, midend and backend passes). Snapshots are\n"
+        "exported into programName_metrics-NNNN-passName files.");
+    registerOption(
+        "--metrics-snapshot", nullptr,
+        [this](const char *) {
+            metricsSnapshot = true;
+            return true;
+        },
+        "Also export the code metrics into a compact binary snapshot\n"
+        "(programName_metrics.bin), which can be compared by --metrics-diff.");
+    registerOption(
+        "--metrics-diff", nullptr,
+        [this](const char *) {
+            metricsDiff = true;
+            return true;
+        },
+        "Compare the two metrics snapshots given instead of the program (old, new),\n"
+        "and report the blocks and tables whose metrics grew past the threshold.");
+    registerOption(
+        "--metrics-diff-threshold", "percent",
+        [this](const char *arg) {
+            char *end = nullptr;
+            double threshold = strtod(arg, &end);
+            if (*end != 0 || threshold < 0) {
+                ::P4::error(ErrorType::ERR_INVALID, "Invalid metrics diff threshold: %1%", arg);
+                return false;
+            }
+            metricsDiffThreshold = threshold;
+            return true;
+        },
+        "Growth of a metric value reported as a regression by --metrics-diff\n"
+        "(default: 10).");
 }
 
 bool CompilerOptions::enable_intrinsic_metadata_fix() { return true; }
@@ -57,6 +57,8 @@ class CompilerOptions : public ParserOptions {
     std::vector<cstring> passesToExcludeBackend;
     // Dump a JSON representation of the IR in the file.
     std::filesystem::path dumpJsonFile;
+    // Dump a binary representation of the IR in the file (see ir/binary_ir.h).
+    std::filesystem::path dumpBinaryIRFile;
     // Dump and undump the IR tree.
     bool debugJson = false;
     // if this flag is true, compile program in non-debug mode.
@@ -85,6 +87,26 @@ class CompilerOptions : public ParserOptions {
     cstring inputMetrics = nullptr;
     // Code metrics to be collected.
     std::set<cstring> selectedMetrics;
+    // Directory of the incremental code metrics cache, caching is disabled if empty.
+    std::filesystem::path metricsCacheDir;
+    // Number of threads computing the per-block code metrics.
+    unsigned metricsJobs = 1;
+    // Format of the exported code metrics: "json", "txt" or "both".
+    cstring metricsFormat = cstring::literal("both");
+    // Programs of the metrics batch mode, a glob pattern or a list file.
+    cstring metricsBatch = nullptr;
+    // Output of the metrics batch mode, with one JSON record per program.
+    std::filesystem::path metricsBatchOutput = "metrics.jsonl";
+    // Maximum number of parser paths expanded by the header packet metrics, per parser.
+    size_t metricsParserPaths = 1000000;
+    // Substrings of pass names after which labeled metric snapshots are taken.
+    std::vector<cstring> metricsAfterPasses;
+    // Also export the code metrics as a binary snapshot (programName_metrics.bin).
+    bool metricsSnapshot = false;
+    // Compare two metrics snapshots instead of compiling.
+    bool metricsDiff = false;
+    // Growth of a metric value, in percent, which is reported as a regression.
+    double metricsDiffThreshold = 10.0;
 
     // General optimization options -- can be interpreted by backends in various ways
     int optimizationLevel = 1;
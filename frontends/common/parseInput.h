@@ -17,8 +17,10 @@ limitations under the License.
 #ifndef FRONTENDS_COMMON_PARSEINPUT_H_
 #define FRONTENDS_COMMON_PARSEINPUT_H_
 
+#include "frontends/common/architectureCache.h"
 #include "frontends/common/options.h"
 #include "frontends/common/parser_options.h"
+#include "frontends/common/preprocessor.h"
 #include "frontends/p4-14/fromv1.0/converters.h"
 #include "frontends/parsers/parserDriver.h"
 #include "lib/error.h"
@@ -56,11 +58,15 @@ static const IR::P4Program *parseV1Program(Input stream, std::string_view source
  * by @options. If the language version is not P4-16, then the program is
  * converted to P4-16 before being returned.
  *
+ * The standard includes are parsed through @archCache if given, which allows
+ * several programs to share them, or through the cache selected by @options.
+ *
  * @return a P4-16 IR tree representing the contents of the given file, or null
  * on failure. If failure occurs, an error will also be reported.
  */
 template <typename C = P4V1::Converter>
-const IR::P4Program *parseP4File(const ParserOptions &options) {
+const IR::P4Program *parseP4File(const ParserOptions &options,
+                                 const ArchitectureCache *archCache = nullptr) {
     BUG_CHECK(&options == &P4CContext::get().options(),
               "Parsing using options that don't match the current "
               "compiler context");
@@ -76,6 +82,23 @@ const IR::P4Program *parseP4File(const ParserOptions &options) {
                                                             options.getDebugHook())
                                 : P4ParserDriver::parse(file, options.file.string());
         fclose(file);
+    } else if (auto cached = archCache != nullptr
+                                 ? archCache->parse(options)
+                                 : ArchitectureCache(options.archCacheDir).parse(options)) {
+        result = *cached;
+    } else if (auto preprocessor = Preprocessor::fromOptions(options)) {
+        auto text = preprocessor->preprocess(options.file);
+        if (::P4::errorCount() > 0 || !text.has_value()) {
+            return nullptr;
+        }
+        if (options.doNotCompile) {
+            std::cout << *text;
+            return nullptr;
+        }
+        StringInputStream in(*text);
+        result = options.isv1() ? parseV1Program<std::istream &, C>(in, options.file.string(), 1,
+                                                                   options.getDebugHook())
+                                : P4ParserDriver::parse(in, options.file.string());
     } else {
         auto preprocessorResult = options.preprocess();
         if (::P4::errorCount() > 0 || !preprocessorResult.has_value()) {
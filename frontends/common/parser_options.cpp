@@ -29,8 +29,10 @@ limitations under the License.
 #include <unordered_set>
 
 #include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "frontends/p4/toP4/toP4.h"
+#include "ir/visitor.h"
 #include "lib/exceptions.h"
 #include "lib/exename.h"
 #include "lib/log.h"
@@ -192,6 +194,22 @@ ParserOptions::ParserOptions(std::string_view defaultMessage) : Util::Options(de
             return true;
         },
         "Specify language version to compile.");
+    registerOption(
+        "--arch-cache", "dir",
+        [this](const char *arg) {
+            archCacheDir = arg;
+            return true;
+        },
+        "Cache the parsed standard includes of P4-16 programs in this directory, and\n"
+        "reuse them when compiling programs which include the same files.");
+    registerOption(
+        "--builtin-cpp", nullptr,
+        [this](const char *) {
+            builtinPreprocessor = true;
+            return true;
+        },
+        "Preprocess the input in the compiler process instead of invoking the\n"
+        "external preprocessor. Included files are cached by the process.");
     registerOption(
         "--nocpp", nullptr,
         [this](const char *) {
@@ -314,6 +332,23 @@ ParserOptions::ParserOptions(std::string_view defaultMessage) : Util::Options(de
             return true;
         },
         "[Compiler debugging] Folder where P4 programs are dumped\n");
+    registerOption(
+        "--node-arena", nullptr,
+        [this](const char *) {
+            nodeArena = true;
+            return true;
+        },
+        "[Compiler debugging] Allocate the IR nodes created by the frontend passes\n"
+        "in an arena, starting a new region for every pass.\n");
+    registerOption(
+        "--dense-visit-state", nullptr,
+        [](const char *) {
+            Visitor::setDenseVisitState(true);
+            return true;
+        },
+        "Track the nodes seen by each compiler pass in arrays indexed by node id\n"
+        "instead of hash maps. Faster, but uses memory proportional to the number\n"
+        "of IR nodes ever created.\n");
     registerOption(
         "--parser-inline-opt", nullptr,
         [this](const char *) {
@@ -405,20 +440,27 @@ const char *ParserOptions::getIncludePath() const {
     return path.c_str();
 }
 
+std::string ParserOptions::getPreprocessorCommand(const std::filesystem::path &input,
+                                                 std::string_view extraOptions) const {
+#ifdef __clang__
+    std::string cmd("cc -E -x c -Wno-comment");
+#else
+    std::string cmd("cpp");
+#endif
+
+    cmd += " -C -undef -nostdinc -x assembler-with-cpp " + preprocessor_options.string() +
+           getIncludePath() + " ";
+    if (!extraOptions.empty()) absl::StrAppend(&cmd, extraOptions, " ");
+    return cmd + absl::CEscape(input.native());
+}
+
 std::optional<ParserOptions::PreprocessorResult> ParserOptions::preprocess() const {
     FILE *in = nullptr;
 
     if (file == "-") {
         in = stdin;
     } else {
-#ifdef __clang__
-        std::string cmd("cc -E -x c -Wno-comment");
-#else
-        std::string cmd("cpp");
-#endif
-
-        cmd += " -C -undef -nostdinc -x assembler-with-cpp " + preprocessor_options.string() +
-               getIncludePath() + " " + absl::CEscape(file.native());
+        std::string cmd = getPreprocessorCommand(file);
 
         if (Log::verbose()) std::cerr << "Invoking preprocessor " << std::endl << cmd << std::endl;
         in = popen(cmd.c_str(), "r");
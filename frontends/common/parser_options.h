@@ -22,6 +22,8 @@ limitations under the License.
 #include <cstdio>
 #include <filesystem>
 #include <set>
+#include <string>
+#include <string_view>
 
 #include "../p4/metrics/metricsStructure.h"
 #include "ir/configuration.h"
@@ -87,18 +89,28 @@ class ParserOptions : public Util::Options {
     cstring compilerVersion;
     /// if true skip preprocess
     bool doNotPreprocess = false;
+    /// If true, preprocess in the compiler process instead of invoking the preprocessor.
+    bool builtinPreprocessor = false;
     /// substrings matched against pass names
     std::vector<cstring> top4;
     /// debugging dumps of programs written in this folder
     std::filesystem::path dumpFolder = ".";
     /// If false, optimization of callee parsers (subparsers) inlining is disabled.
     bool optimizeParserInlining = false;
+    /// If true, IR nodes created by the frontend passes are allocated in an Arena.
+    bool nodeArena = false;
+    /// Directory of the cache of parsed standard includes, disabled if empty.
+    std::filesystem::path archCacheDir;
     /// Expect that the only remaining argument is the input file.
     void setInputFile();
     /// Return target specific include path.
     const char *getIncludePath() const override;
     /// Returns the output of the preprocessor.
     std::optional<ParserOptions::PreprocessorResult> preprocess() const;
+    /// Returns the command which preprocesses @p input, passing @p extraOptions to the
+    /// preprocessor in addition to the preprocessor options.
+    std::string getPreprocessorCommand(const std::filesystem::path &input,
+                                       std::string_view extraOptions = {}) const;
     /// True if we are compiling a P4 v1.0 or v1.1 program
     bool isv1() const;
     /// Get a debug hook function suitable for insertion in the pass managers. The hook is
@@ -116,6 +128,8 @@ class ParserOptions : public Util::Options {
     bool noIncludes = false;
     /// Holds code metric values, makes them accessible during the entire compilation.
     Metrics metrics;
+    /// Number of labeled metric snapshots taken so far, used to number their files.
+    unsigned metricsSnapshotCount = 0;
 };
 
 /// A compilation context which exposes compiler options and a compiler
@@ -0,0 +1,1302 @@
+#include "frontends/common/preprocessor.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "frontends/common/parser_options.h"
+#include "lib/error.h"
+#include "lib/log.h"
+
+namespace P4 {
+
+namespace {
+
+/// The maximal depth of nested #include directives.
+constexpr unsigned MAX_INCLUDE_DEPTH = 200;
+
+/// Up to this many lines are skipped with blank lines rather than a line marker, as the
+/// external preprocessor does.
+constexpr unsigned MAX_BLANK_LINES = 8;
+
+/// The punctuators of more than one character, longest first.
+constexpr std::string_view PUNCTUATORS[] = {
+    "<<=", ">>=", "...", "##", "->", "++", "--", "<<", ">>", "<=", ">=", "==",
+    "!=",  "&&",  "||",  "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^="};
+
+/// Identifies the contents of a file, so that a changed file is mapped again.
+struct FileStamp {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    int64_t seconds = 0;
+    int64_t nanoseconds = 0;
+
+    explicit FileStamp(const struct stat &st)
+        : device(st.st_dev), inode(st.st_ino), size(st.st_size) {
+#ifdef __APPLE__
+        const auto &modified = st.st_mtimespec;
+#else
+        const auto &modified = st.st_mtim;
+#endif
+        seconds = modified.tv_sec;
+        nanoseconds = modified.tv_nsec;
+    }
+
+    bool operator==(const FileStamp &other) const {
+        return device == other.device && inode == other.inode && size == other.size &&
+               seconds == other.seconds && nanoseconds == other.nanoseconds;
+    }
+};
+
+/// A file mapped into memory.
+class MappedFile {
+    void *data;
+
+    MappedFile(void *data, FileStamp stamp) : data(data), stamp(stamp) {}
+
+ public:
+    /// The version of the file which is mapped.
+    const FileStamp stamp;
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() {
+        if (data != nullptr) munmap(data, stamp.size);
+    }
+
+    /// Maps the regular file @p path. Returns null if it cannot be read.
+    static std::shared_ptr<const MappedFile> map(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return nullptr;
+        struct stat st;
+        void *data = nullptr;
+        bool ok = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+        if (ok && st.st_size > 0) {
+            data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = data != MAP_FAILED;
+        }
+        close(fd);
+        if (!ok) return nullptr;
+        return std::shared_ptr<const MappedFile>(new MappedFile(data, FileStamp(st)));
+    }
+
+    std::string_view contents() const {
+        return {static_cast<const char *>(data), static_cast<size_t>(stamp.size)};
+    }
+};
+
+/// Returns the included file @p path, which is only mapped again if it changed since it was
+/// last included by any compilation of this process. Returns null if there is no such file.
+std::shared_ptr<const MappedFile> includedFile(const std::string &path) {
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<const MappedFile>> files;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return nullptr;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &file = files[path];
+    if (file == nullptr || !(file->stamp == FileStamp(st))) file = MappedFile::map(path);
+    return file;
+}
+
+enum class Kind { Identifier, Number, String, Punctuator, Comment, Placemarker };
+
+/// The names of the macros which are not expanded in a token, see "Prosser's algorithm".
+using HideSet = std::shared_ptr<const std::set<std::string, std::less<>>>;
+
+HideSet unite(const HideSet &a, const HideSet &b) {
+    if (a == nullptr || a == b) return b;
+    if (b == nullptr) return a;
+    auto result = std::make_shared<std::set<std::string, std::less<>>>(*a);
+    result->insert(b->begin(), b->end());
+    return result;
+}
+
+HideSet intersect(const HideSet &a, const HideSet &b) {
+    if (a == nullptr || b == nullptr) return nullptr;
+    auto result = std::make_shared<std::set<std::string, std::less<>>>();
+    std::set_intersection(a->begin(), a->end(), b->begin(), b->end(),
+                          std::inserter(*result, result->end()));
+    return result;
+}
+
+HideSet withName(const HideSet &set, const std::string &name) {
+    auto result = set == nullptr ? std::make_shared<std::set<std::string, std::less<>>>()
+                                 : std::make_shared<std::set<std::string, std::less<>>>(*set);
+    result->insert(name);
+    return result;
+}
+
+/// A preprocessing token.
+struct Token {
+    Kind kind = Kind::Punctuator;
+    std::string text;
+
+    /// The white space before the token.
+    std::string space;
+
+    HideSet hidden;
+
+    Token() = default;
+    Token(Kind kind, std::string text, std::string space = {})
+        : kind(kind), text(std::move(text)), space(std::move(space)) {}
+
+    bool is(std::string_view punctuator) const {
+        return kind == Kind::Punctuator && text == punctuator;
+    }
+
+    bool isHidden() const { return hidden != nullptr && hidden->count(text) != 0; }
+};
+
+using Tokens = std::vector<Token>;
+
+bool isIdentifierChar(char c) { return absl::ascii_isalnum(c) || c == '_' || c == '$'; }
+
+size_t punctuatorLength(std::string_view text) {
+    for (auto punctuator : PUNCTUATORS) {
+        if (absl::StartsWith(text, punctuator)) return punctuator.size();
+    }
+    return 1;
+}
+
+/// Splits the logical line @p text into tokens. Comments are white space, unless
+/// @p keepComments is set.
+Tokens tokenize(std::string_view text, bool keepComments) {
+    Tokens tokens;
+    size_t start = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        char next = i + 1 < text.size() ? text[i + 1] : '\0';
+        if (absl::ascii_isspace(c)) {
+            i++;
+            continue;
+        }
+        Token token;
+        token.space = std::string(text.substr(start, i - start));
+        size_t begin = i;
+        if (c == '/' && (next == '/' || next == '*')) {
+            auto end = next == '/' ? std::string_view::npos : text.find("*/", i + 2);
+            i = end == std::string_view::npos ? text.size() : end + 2;
+            if (!keepComments) continue;
+            token.kind = Kind::Comment;
+        } else if (absl::ascii_isalpha(c) || c == '_' || c == '$') {
+            while (i < text.size() && isIdentifierChar(text[i])) i++;
+            token.kind = Kind::Identifier;
+        } else if (absl::ascii_isdigit(c) || (c == '.' && absl::ascii_isdigit(next))) {
+            for (i++; i < text.size(); i++) {
+                char d = text[i];
+                bool exponentSign = (d == '+' || d == '-') && strchr("eEpP", text[i - 1]);
+                if (!exponentSign && !isIdentifierChar(d) && d != '.') break;
+            }
+            token.kind = Kind::Number;
+        } else if (c == '"') {
+            for (i++; i < text.size() && text[i] != '"'; i++) {
+                if (text[i] == '\\') i++;
+            }
+            i = std::min(i + 1, text.size());
+            token.kind = Kind::String;
+        } else {
+            i += punctuatorLength(text.substr(i));
+            token.kind = Kind::Punctuator;
+        }
+        token.text = std::string(text.substr(begin, i - begin));
+        tokens.push_back(std::move(token));
+        start = i;
+    }
+    return tokens;
+}
+
+/// Returns true if @p a and @p b would be read as a different token when written next to
+/// each other.
+bool wouldPaste(const Token &a, const Token &b) {
+    if (a.text.empty() || b.text.empty()) return false;
+    char last = a.text.back();
+    char first = b.text.front();
+    switch (a.kind) {
+        case Kind::Identifier:
+            return isIdentifierChar(first);
+        case Kind::Number:
+            return isIdentifierChar(first) || first == '.' ||
+                   ((first == '+' || first == '-') && strchr("eEpP", last));
+        case Kind::Punctuator:
+            if (last == '/' && (first == '/' || first == '*')) return true;
+            if (a.text == "." && absl::ascii_isdigit(first)) return true;
+            return punctuatorLength(a.text + b.text) > a.text.size();
+        default:
+            return false;
+    }
+}
+
+/// Returns @p text as a string literal.
+std::string quote(std::string_view text) {
+    std::string result = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') result += '\\';
+        result += c;
+    }
+    return result + "\"";
+}
+
+/// Returns the text of @p tokens, with their white space.
+std::string spell(const Tokens &tokens) {
+    std::string result;
+    for (const auto &token : tokens) {
+        if (!result.empty() && !token.space.empty()) result += ' ';
+        result += token.text;
+    }
+    return result;
+}
+
+/// Reads the logical lines of a file: physical lines are joined if they end with a backslash,
+/// or if a block comment continues on the next line.
+class LineReader {
+    std::string_view text;
+    size_t pos = 0;
+
+ public:
+    explicit LineReader(std::string_view text) : text(text) {}
+
+    /// Reads the next logical line into @p line. Returns the number of physical lines read,
+    /// zero at the end of the file.
+    unsigned next(std::string &line) {
+        line.clear();
+        if (pos >= text.size()) return 0;
+        unsigned lines = 1;
+        bool blockComment = false;
+        bool lineComment = false;
+        bool string = false;
+        while (pos < text.size()) {
+            char c = text[pos];
+            char next = pos + 1 < text.size() ? text[pos + 1] : '\0';
+            if (c == '\\' && (next == '\n' || (next == '\r' && pos + 2 < text.size() &&
+                                               text[pos + 2] == '\n'))) {
+                pos += next == '\n' ? 2 : 3;
+                lines++;
+                continue;
+            }
+            if (c == '\n') {
+                pos++;
+                if (!blockComment) break;
+                line += c;
+                lines++;
+                continue;
+            }
+            if (blockComment) {
+                blockComment = !(c == '*' && next == '/');
+                if (!blockComment) {
+                    line += c;
+                    pos++;
+                    c = next;
+                }
+            } else if (string) {
+                if (c == '\\' && next != '\0') {
+                    line += c;
+                    pos++;
+                    c = next;
+                } else {
+                    string = c != '"';
+                }
+            } else if (!lineComment) {
+                string = c == '"';
+                lineComment = c == '/' && next == '/';
+                blockComment = c == '/' && next == '*';
+                if (blockComment) {
+                    line += c;
+                    pos++;
+                    c = next;
+                }
+            }
+            line += c;
+            pos++;
+        }
+        return lines;
+    }
+};
+
+bool isDirective(std::string_view line) {
+    return absl::StartsWith(absl::StripLeadingAsciiWhitespace(line), "#");
+}
+
+/// A macro defined by #define.
+struct Macro {
+    bool functionLike = false;
+
+    /// Whether the last parameter takes the remaining arguments.
+    bool variadic = false;
+
+    std::vector<std::string> parameters;
+
+    /// The replacement list, with white space reduced to a single space.
+    Tokens body;
+
+    /// Returns the index of the parameter @p token, or -1.
+    int parameter(const Token &token) const {
+        if (!functionLike || token.kind != Kind::Identifier) return -1;
+        auto it = std::find(parameters.begin(), parameters.end(), token.text);
+        return it == parameters.end() ? -1 : static_cast<int>(it - parameters.begin());
+    }
+
+    bool operator==(const Macro &other) const {
+        if (functionLike != other.functionLike || variadic != other.variadic ||
+            parameters != other.parameters || body.size() != other.body.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < body.size(); i++) {
+            if (body[i].text != other.body[i].text || body[i].space != other.body[i].space)
+                return false;
+        }
+        return true;
+    }
+};
+
+/// Evaluates the controlling expression of #if and #elif, after macro expansion. As in C, values
+/// have the type intmax_t or uintmax_t, and an unsigned operand makes a binary operation unsigned.
+class ExpressionEvaluator {
+    const Tokens &tokens;
+    size_t pos = 0;
+
+    /// A value of the expression, with its bits stored as uintmax_t.
+    struct Value {
+        uint64_t bits = 0;
+        bool isUnsigned = false;
+
+        static Value of(bool value) { return {value ? 1U : 0U, false}; }
+        [[nodiscard]] int64_t asSigned() const { return static_cast<int64_t>(bits); }
+        [[nodiscard]] bool isTrue() const { return bits != 0; }
+    };
+
+ public:
+    /// The description of the first error.
+    std::optional<std::string> error;
+
+    explicit ExpressionEvaluator(const Tokens &tokens) : tokens(tokens) {}
+
+    std::optional<bool> evaluate() {
+        if (tokens.empty()) {
+            error = "#if with no expression";
+            return std::nullopt;
+        }
+        auto value = conditional(true);
+        if (!error && pos < tokens.size())
+            error = absl::StrCat("missing binary operator before token \"", tokens[pos].text, "\"");
+        if (error) return std::nullopt;
+        return value.isTrue();
+    }
+
+ private:
+    bool accept(std::string_view punctuator) {
+        if (pos >= tokens.size() || !tokens[pos].is(punctuator)) return false;
+        pos++;
+        return true;
+    }
+
+    void expect(std::string_view punctuator) {
+        if (!accept(punctuator) && !error) error = absl::StrCat("expected '", punctuator, "'");
+    }
+
+    static int precedence(std::string_view op) {
+        static const std::map<std::string_view, int> precedences = {
+            {"||", 1}, {"&&", 2}, {"|", 3},  {"^", 4},  {"&", 5},  {"==", 6}, {"!=", 6},
+            {"<", 7},  {">", 7},  {"<=", 7}, {">=", 7}, {"<<", 8}, {">>", 8}, {"+", 9},
+            {"-", 9},  {"*", 10}, {"/", 10}, {"%", 10}};
+        auto it = precedences.find(op);
+        return it == precedences.end() ? 0 : it->second;
+    }
+
+    /// Evaluates the expression at the current position. Operands which are not evaluated
+    /// because of short-circuiting may not report errors, they have @p evaluate unset.
+    Value conditional(bool evaluate) {
+        auto condition = binary(1, evaluate);
+        if (!accept("?")) return condition;
+        auto ifTrue = conditional(evaluate && condition.isTrue());
+        expect(":");
+        auto ifFalse = conditional(evaluate && !condition.isTrue());
+        auto result = condition.isTrue() ? ifTrue : ifFalse;
+        result.isUnsigned = ifTrue.isUnsigned || ifFalse.isUnsigned;
+        return result;
+    }
+
+    Value binary(int minPrecedence, bool evaluate) {
+        auto lhs = unary(evaluate);
+        while (pos < tokens.size() && tokens[pos].kind == Kind::Punctuator && !error) {
+            const auto &op = tokens[pos].text;
+            int prec = precedence(op);
+            if (prec < minPrecedence || prec == 0) break;
+            pos++;
+            bool evaluateRhs = evaluate;
+            if (op == "||") evaluateRhs = evaluate && !lhs.isTrue();
+            if (op == "&&") evaluateRhs = evaluate && lhs.isTrue();
+            auto rhs = binary(prec + 1, evaluateRhs);
+            lhs = apply(op, lhs, rhs, evaluateRhs);
+        }
+        return lhs;
+    }
+
+    Value apply(std::string_view op, Value lhs, Value rhs, bool evaluate) {
+        if (op == "||") return Value::of(lhs.isTrue() || rhs.isTrue());
+        if (op == "&&") return Value::of(lhs.isTrue() && rhs.isTrue());
+        // The type of a shift is the type of its left operand.
+        if (op == "<<" || op == ">>") {
+            auto count = rhs.asSigned();
+            if (rhs.isUnsigned && rhs.bits >= 64) count = 64;
+            // A negative count shifts the other way.
+            bool left = (op == "<<") == (count >= 0);
+            uint64_t amount = count < 0 ? -static_cast<uint64_t>(count) : count;
+            if (left) return {amount >= 64 ? 0 : lhs.bits << amount, lhs.isUnsigned};
+            if (lhs.isUnsigned) return {amount >= 64 ? 0 : lhs.bits >> amount, true};
+            auto value = lhs.asSigned();
+            return {static_cast<uint64_t>(amount >= 64 ? (value < 0 ? -1 : 0) : value >> amount),
+                    false};
+        }
+        // The usual arithmetic conversions. Arithmetic wraps around instead of invoking
+        // undefined behavior.
+        bool isUnsigned = lhs.isUnsigned || rhs.isUnsigned;
+        if (op == "==") return Value::of(lhs.bits == rhs.bits);
+        if (op == "!=") return Value::of(lhs.bits != rhs.bits);
+        if (op == "<" || op == ">" || op == "<=" || op == ">=") {
+            bool less = isUnsigned ? lhs.bits < rhs.bits : lhs.asSigned() < rhs.asSigned();
+            bool greater = isUnsigned ? lhs.bits > rhs.bits : lhs.asSigned() > rhs.asSigned();
+            if (op == "<") return Value::of(less);
+            if (op == ">") return Value::of(greater);
+            if (op == "<=") return Value::of(!greater);
+            return Value::of(!less);
+        }
+        if (op == "|") return {lhs.bits | rhs.bits, isUnsigned};
+        if (op == "^") return {lhs.bits ^ rhs.bits, isUnsigned};
+        if (op == "&") return {lhs.bits & rhs.bits, isUnsigned};
+        if (op == "+") return {lhs.bits + rhs.bits, isUnsigned};
+        if (op == "-") return {lhs.bits - rhs.bits, isUnsigned};
+        if (op == "*") return {lhs.bits * rhs.bits, isUnsigned};
+        if (rhs.bits == 0) {
+            if (evaluate && !error) error = "division by zero in #if";
+            return {0, isUnsigned};
+        }
+        if (isUnsigned) return {op == "/" ? lhs.bits / rhs.bits : lhs.bits % rhs.bits, true};
+        auto slhs = lhs.asSigned();
+        auto srhs = rhs.asSigned();
+        if (slhs == INT64_MIN && srhs == -1) return {op == "/" ? lhs.bits : 0, false};
+        return {static_cast<uint64_t>(op == "/" ? slhs / srhs : slhs % srhs), false};
+    }
+
+    Value unary(bool evaluate) {
+        if (error) return {};
+        if (pos >= tokens.size()) {
+            error = "#if with no expression";
+            return {};
+        }
+        const auto &token = tokens[pos++];
+        if (token.is("!")) return Value::of(!unary(evaluate).isTrue());
+        if (token.is("~")) {
+            auto value = unary(evaluate);
+            return {~value.bits, value.isUnsigned};
+        }
+        if (token.is("-")) {
+            auto value = unary(evaluate);
+            return {-value.bits, value.isUnsigned};
+        }
+        if (token.is("+")) return unary(evaluate);
+        if (token.is("(")) {
+            auto value = conditional(evaluate);
+            expect(")");
+            return value;
+        }
+        // Identifiers which are not macros evaluate to 0.
+        if (token.kind == Kind::Identifier) return {};
+        if (token.kind == Kind::Number) return number(token.text);
+        error = absl::StrCat("token \"", token.text, "\" is not valid in preprocessor expressions");
+        return {};
+    }
+
+    /// Constants with a u suffix are unsigned, and so are constants which do not fit in
+    /// intmax_t, as with cpp.
+    Value number(const std::string &text) {
+        auto digits = text;
+        bool isUnsigned = false;
+        while (!digits.empty() && strchr("uUlL", digits.back())) {
+            isUnsigned |= digits.back() == 'u' || digits.back() == 'U';
+            digits.pop_back();
+        }
+        int base = 0;
+        size_t start = 0;
+        if (absl::StartsWithIgnoreCase(digits, "0b")) {
+            base = 2;
+            start = 2;
+        }
+        char *end = nullptr;
+        errno = 0;
+        auto value = std::strtoull(digits.c_str() + start, &end, base);
+        if (digits.size() == start || *end != '\0' || errno != 0) {
+            error = absl::StrCat("invalid integer constant \"", text, "\" in #if");
+            return {};
+        }
+        return {value, isUnsigned || value > static_cast<uint64_t>(INT64_MAX)};
+    }
+};
+
+/// The state of a conditional directive.
+struct Conditional {
+    /// Whether the group of lines containing the conditional is processed.
+    bool parentActive;
+
+    /// Whether the current group of the conditional is processed.
+    bool active;
+
+    /// Whether a group of the conditional was processed already.
+    bool taken;
+
+    bool sawElse = false;
+};
+
+/// Detects files which are wrapped in `#ifndef X ... #endif`, which do not need to be read
+/// again while X is defined.
+struct IncludeGuard {
+    enum class State { Start, Inside, After, None };
+    State state = State::Start;
+    std::string macro;
+};
+
+/// A file being preprocessed.
+struct File {
+    /// The path the file was read from.
+    std::string path;
+
+    /// The name of the file in line markers and __FILE__, changed by #line.
+    std::string name;
+
+    /// The directory searched first by quoted #include directives.
+    std::filesystem::path directory;
+
+    /// The index in the include path of the directory containing the file, or -1.
+    int includeIndex;
+
+    LineReader reader;
+
+    /// The line of the current logical line, and of the next one.
+    unsigned line = 0;
+    unsigned nextLine = 1;
+
+    std::vector<Conditional> conditionals;
+    IncludeGuard guard;
+
+    File(std::string path, std::string name, std::filesystem::path directory, int includeIndex,
+         std::string_view text)
+        : path(std::move(path)),
+          name(std::move(name)),
+          directory(std::move(directory)),
+          includeIndex(includeIndex),
+          reader(text) {}
+
+    bool active() const { return conditionals.empty() || conditionals.back().active; }
+};
+
+/// Preprocesses one input file.
+class Preprocessing {
+    const std::vector<std::filesystem::path> &includePath;
+    std::map<std::string, Macro, std::less<>> macros;
+
+    std::string output;
+
+    /// The file and line of the next line of the output.
+    std::string outputFile;
+    unsigned outputLine = 0;
+
+    /// The file being read, and the number of files including it.
+    File *file = nullptr;
+    unsigned depth = 0;
+
+    std::string baseFile;
+    unsigned counter = 0;
+
+    /// The files which contain #pragma once, and the macros guarding files.
+    std::set<std::string> onceFiles;
+    std::map<std::string, std::string> guards;
+
+    /// Set by errors which stop preprocessing.
+    bool stopped = false;
+
+ public:
+    explicit Preprocessing(const std::vector<std::filesystem::path> &includePath)
+        : includePath(includePath) {}
+
+    /// Applies the -D and -U options in @p commandLine.
+    void commandLine(const std::vector<std::pair<bool, std::string>> &commandLine) {
+        File source({}, "<command-line>", {}, -1, {});
+        file = &source;
+        for (const auto &[isDefine, text] : commandLine) {
+            auto tokens = tokenize(text, false);
+            if (isDefine) {
+                define(tokens);
+            } else {
+                undefine(tokens);
+            }
+        }
+        file = nullptr;
+    }
+
+    /// Preprocesses @p text, the contents of the input file @p name.
+    std::optional<std::string> run(std::string_view text, const std::filesystem::path &name) {
+        auto errors = ::P4::errorCount();
+        baseFile = name.string();
+        process(text, baseFile, name.parent_path(), -1, "");
+        if (stopped || ::P4::errorCount() > errors) return std::nullopt;
+        return std::move(output);
+    }
+
+ private:
+    void error(std::string_view message) {
+        ::P4::error(ErrorType::ERR_INVALID, "%1%:%2%: %3%", file->name, file->line,
+                    std::string(message));
+    }
+
+    void warning(std::string_view message) {
+        ::P4::warning(ErrorType::WARN_INVALID, "%1%:%2%: %3%", file->name, file->line,
+                      std::string(message));
+    }
+
+    /// Writes a line marker which sets the line of the next output line.
+    void marker(unsigned line, std::string_view flags) {
+        absl::StrAppend(&output, "# ", line, " \"", file->name, "\"", flags, "\n");
+        outputFile = file->name;
+        outputLine = line;
+    }
+
+    /// Makes the next output line the line @p line of the current file.
+    void sync(unsigned line) {
+        if (outputFile == file->name && line >= outputLine &&
+            line - outputLine <= MAX_BLANK_LINES) {
+            output.append(line - outputLine, '\n');
+            outputLine = line;
+        } else {
+            marker(line, "");
+        }
+    }
+
+    void write(const Tokens &tokens) {
+        const Token *previous = nullptr;
+        for (const auto &token : tokens) {
+            if (!token.space.empty()) {
+                output += token.space;
+            } else if (previous != nullptr && wouldPaste(*previous, token)) {
+                output += ' ';
+            }
+            output += token.text;
+            outputLine += std::count(token.text.begin(), token.text.end(), '\n');
+            previous = &token;
+        }
+        output += '\n';
+        outputLine++;
+    }
+
+    void process(std::string_view text, const std::string &path, std::filesystem::path directory,
+                 int includeIndex, std::string_view flags) {
+        File current(path, path, std::move(directory), includeIndex, text);
+        File *parent = file;
+        file = &current;
+        marker(1, flags);
+        std::string line;
+        while (!stopped) {
+            unsigned lines = current.reader.next(line);
+            if (lines == 0) break;
+            current.line = current.nextLine;
+            current.nextLine += lines;
+            if (isDirective(line)) {
+                directive(line);
+            } else if (current.active()) {
+                textLine(line);
+            }
+        }
+        if (!current.conditionals.empty() && !stopped) error("unterminated conditional directive");
+        if (current.guard.state == IncludeGuard::State::After)
+            guards.emplace(current.path, current.guard.macro);
+        file = parent;
+        if (parent != nullptr) marker(parent->nextLine, " 2");
+    }
+
+    /// Notes a line which is not part of an include guard.
+    void unguarded() {
+        if (file->conditionals.empty()) file->guard.state = IncludeGuard::State::None;
+    }
+
+    void textLine(const std::string &line) {
+        auto tokens = tokenize(line, true);
+        if (std::any_of(tokens.begin(), tokens.end(),
+                        [](const Token &token) { return token.kind != Kind::Comment; })) {
+            unguarded();
+        }
+        if (tokens.empty()) return;
+        sync(file->line);
+        std::deque<Token> input(std::make_move_iterator(tokens.begin()),
+                                std::make_move_iterator(tokens.end()));
+        Tokens expanded;
+        expand(input, expanded, true);
+        write(expanded);
+    }
+
+    /// Appends the tokens of the next line to @p input, if it is not a directive.
+    bool readLine(std::deque<Token> &input) {
+        auto reader = file->reader;
+        std::string line;
+        unsigned lines = file->reader.next(line);
+        if (lines == 0 || isDirective(line)) {
+            file->reader = reader;
+            return false;
+        }
+        file->line = file->nextLine;
+        file->nextLine += lines;
+        auto tokens = tokenize(line, true);
+        if (!tokens.empty() && tokens.front().space.empty()) tokens.front().space = " ";
+        input.insert(input.end(), std::make_move_iterator(tokens.begin()),
+                     std::make_move_iterator(tokens.end()));
+        return true;
+    }
+
+    /// Returns the value of the predefined macro @p name.
+    std::optional<Token> predefined(const Token &name) {
+        Token result(Kind::Number, {}, name.space);
+        if (name.text == "__LINE__") {
+            result.text = std::to_string(file->line);
+        } else if (name.text == "__COUNTER__") {
+            result.text = std::to_string(counter++);
+        } else if (name.text == "__INCLUDE_LEVEL__") {
+            result.text = std::to_string(depth);
+        } else if (name.text == "__FILE__") {
+            result.kind = Kind::String;
+            result.text = quote(file->name);
+        } else if (name.text == "__BASE_FILE__") {
+            result.kind = Kind::String;
+            result.text = quote(baseFile);
+        } else {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    bool isDefined(std::string_view name) const {
+        return macros.count(name) != 0 || name == "__LINE__" || name == "__FILE__" ||
+               name == "__COUNTER__" || name == "__INCLUDE_LEVEL__" || name == "__BASE_FILE__";
+    }
+
+    /// Expands the macros in @p input into @p output. If @p more is set, the arguments of a
+    /// function-like macro may continue on the following lines.
+    void expand(std::deque<Token> &input, Tokens &output, bool more) {
+        while (!input.empty() && !stopped) {
+            Token token = std::move(input.front());
+            input.pop_front();
+            if (token.kind != Kind::Identifier || token.isHidden()) {
+                output.push_back(std::move(token));
+                continue;
+            }
+            auto it = macros.find(token.text);
+            if (it == macros.end()) {
+                auto value = predefined(token);
+                output.push_back(value ? std::move(*value) : std::move(token));
+                continue;
+            }
+            const Macro &macro = it->second;
+            Tokens replacement;
+            if (!macro.functionLike) {
+                replacement = substitute(macro, {}, withName(token.hidden, token.text));
+            } else if (!nextIsParenthesis(input, more)) {
+                // The name of a function-like macro is only expanded when it is called.
+                output.push_back(std::move(token));
+                continue;
+            } else {
+                std::vector<Tokens> arguments;
+                HideSet closing;
+                if (!collectArguments(token, input, more, arguments, closing)) return;
+                if (!checkArguments(macro, token, arguments)) continue;
+                replacement = substitute(macro, arguments,
+                                         withName(intersect(token.hidden, closing), token.text));
+            }
+            if (!replacement.empty()) replacement.front().space = token.space;
+            input.insert(input.begin(), std::make_move_iterator(replacement.begin()),
+                         std::make_move_iterator(replacement.end()));
+        }
+    }
+
+    bool nextIsParenthesis(std::deque<Token> &input, bool more) {
+        for (size_t i = 0;; i++) {
+            while (i == input.size()) {
+                if (!more || !readLine(input)) return false;
+            }
+            if (input[i].kind != Kind::Comment) return input[i].is("(");
+        }
+    }
+
+    bool collectArguments(const Token &name, std::deque<Token> &input, bool more,
+                          std::vector<Tokens> &arguments, HideSet &closing) {
+        while (!input.front().is("(")) input.pop_front();
+        input.pop_front();
+        arguments.emplace_back();
+        int nesting = 0;
+        while (true) {
+            if (input.empty()) {
+                if (more && readLine(input)) continue;
+                error(absl::StrCat("unterminated argument list invoking macro \"", name.text,
+                                   "\""));
+                return false;
+            }
+            Token token = std::move(input.front());
+            input.pop_front();
+            if (token.kind == Kind::Comment) continue;
+            if (token.is(")") && nesting == 0) {
+                closing = token.hidden;
+                return true;
+            }
+            if (token.is(",") && nesting == 0) {
+                arguments.emplace_back();
+                continue;
+            }
+            if (token.is("(")) nesting++;
+            if (token.is(")")) nesting--;
+            arguments.back().push_back(std::move(token));
+        }
+    }
+
+    bool checkArguments(const Macro &macro, const Token &name, std::vector<Tokens> &arguments) {
+        size_t parameters = macro.parameters.size();
+        if (parameters == 0 && arguments.size() == 1 && arguments.front().empty())
+            arguments.clear();
+        if (macro.variadic && arguments.size() == parameters - 1) arguments.emplace_back();
+        if (macro.variadic && arguments.size() > parameters) {
+            auto &rest = arguments[parameters - 1];
+            for (size_t i = parameters; i < arguments.size(); i++) {
+                rest.push_back(Token(Kind::Punctuator, ","));
+                rest.insert(rest.end(), arguments[i].begin(), arguments[i].end());
+            }
+            arguments.resize(parameters);
+        }
+        if (arguments.size() == parameters) return true;
+        error(absl::StrCat("macro \"", name.text, "\" passed ", arguments.size(),
+                           " arguments, but takes ", parameters));
+        return false;
+    }
+
+    static std::string stringize(const Tokens &argument) {
+        std::string text;
+        for (const auto &token : argument) {
+            if (!text.empty() && !token.space.empty()) text += ' ';
+            text += token.text;
+        }
+        return quote(text);
+    }
+
+    /// Pastes @p rhs to the end of @p lhs. Returns false if they do not form a single token,
+    /// which the external preprocessor accepts for assembler input.
+    static bool paste(Token &lhs, const Token &rhs) {
+        auto text = lhs.text + rhs.text;
+        auto tokens = tokenize(text, true);
+        if (tokens.size() != 1 || tokens.front().kind == Kind::Comment) return false;
+        lhs.kind = tokens.front().kind;
+        lhs.text = std::move(text);
+        return true;
+    }
+
+    /// Returns the replacement list of @p macro, with the parameters replaced by
+    /// @p arguments, and the tokens hidden by @p hidden.
+    Tokens substitute(const Macro &macro, const std::vector<Tokens> &arguments,
+                      const HideSet &hidden) {
+        const auto &body = macro.body;
+        std::vector<std::optional<Tokens>> expanded(arguments.size());
+        Tokens result;
+        for (size_t i = 0; i < body.size(); i++) {
+            const auto &token = body[i];
+            int parameter = macro.parameter(token);
+            int next = i + 1 < body.size() ? macro.parameter(body[i + 1]) : -1;
+            if (macro.functionLike && token.is("#") && next >= 0) {
+                result.push_back(Token(Kind::String, stringize(arguments[next]), token.space));
+                i++;
+            } else if (token.is("##")) {
+                const auto &operand = body[++i];
+                Tokens rhs = next >= 0 ? arguments[next] : Tokens{operand};
+                // `, ## __VA_ARGS__` drops the comma if there are no variable arguments.
+                if (rhs.empty() && macro.variadic &&
+                    next == static_cast<int>(arguments.size()) - 1 && !result.empty() &&
+                    result.back().is(",")) {
+                    result.pop_back();
+                    continue;
+                }
+                if (rhs.empty()) continue;
+                size_t first = 0;
+                if (!result.empty() && result.back().kind == Kind::Placemarker) {
+                    result.pop_back();
+                    rhs.front().space.clear();
+                } else if (!result.empty() && paste(result.back(), rhs.front())) {
+                    first = 1;
+                }
+                result.insert(result.end(), rhs.begin() + first, rhs.end());
+            } else if (parameter >= 0) {
+                bool beforePaste = i + 1 < body.size() && body[i + 1].is("##");
+                if (!beforePaste && !expanded[parameter]) {
+                    std::deque<Token> input(arguments[parameter].begin(),
+                                            arguments[parameter].end());
+                    expanded[parameter].emplace();
+                    expand(input, *expanded[parameter], false);
+                }
+                const auto &argument = beforePaste ? arguments[parameter] : *expanded[parameter];
+                if (argument.empty()) {
+                    if (beforePaste) result.push_back(Token(Kind::Placemarker, {}, token.space));
+                    continue;
+                }
+                size_t first = result.size();
+                result.insert(result.end(), argument.begin(), argument.end());
+                result[first].space = token.space;
+            } else {
+                result.push_back(token);
+            }
+        }
+        result.erase(std::remove_if(result.begin(), result.end(),
+                                    [](const Token &t) { return t.kind == Kind::Placemarker; }),
+                     result.end());
+        for (auto &token : result) token.hidden = unite(token.hidden, hidden);
+        return result;
+    }
+
+    void directive(const std::string &line) {
+        auto tokens = tokenize(line, false);
+        std::string name = tokens.size() > 1 && tokens[1].kind == Kind::Identifier
+                               ? tokens[1].text
+                               : std::string();
+        Tokens arguments(tokens.begin() + std::min<size_t>(tokens.size(), 2), tokens.end());
+        auto &conditionals = file->conditionals;
+        auto &guard = file->guard;
+
+        if (name == "if" || name == "ifdef" || name == "ifndef") {
+            bool active = file->active();
+            bool value = false;
+            if (active) value = name == "if" ? evaluate(arguments) : ifdef(name, arguments);
+            if (conditionals.empty()) {
+                bool isGuard = guard.state == IncludeGuard::State::Start && name == "ifndef" &&
+                               arguments.size() == 1;
+                guard.state = isGuard ? IncludeGuard::State::Inside : IncludeGuard::State::None;
+                if (isGuard) guard.macro = arguments.front().text;
+            }
+            conditionals.push_back(Conditional{active, active && value, active && value});
+        } else if (name == "elif" || name == "else") {
+            if (conditionals.empty()) return error(absl::StrCat("#", name, " without #if"));
+            auto &conditional = conditionals.back();
+            if (conditional.sawElse) return error(absl::StrCat("#", name, " after #else"));
+            if (conditionals.size() == 1) guard.state = IncludeGuard::State::None;
+            conditional.sawElse = name == "else";
+            bool value = !conditional.taken && conditional.parentActive &&
+                         (name == "else" || evaluate(arguments));
+            conditional.active = value;
+            conditional.taken = conditional.taken || value;
+        } else if (name == "endif") {
+            if (conditionals.empty()) return error("#endif without #if");
+            conditionals.pop_back();
+            if (conditionals.empty() && guard.state == IncludeGuard::State::Inside)
+                guard.state = IncludeGuard::State::After;
+        } else if (!file->active()) {
+            return;
+        } else if (name == "define") {
+            unguarded();
+            define(arguments);
+        } else if (name == "undef") {
+            unguarded();
+            undefine(arguments);
+        } else if (name == "include" || name == "include_next") {
+            unguarded();
+            include(arguments, name == "include_next");
+        } else if (name == "line") {
+            unguarded();
+            lineDirective(arguments);
+        } else if (name == "error") {
+            error(absl::StrCat("#error ", spell(arguments)));
+        } else if (name == "warning") {
+            warning(absl::StrCat("#warning ", spell(arguments)));
+        } else if (name == "pragma") {
+            if (arguments.size() == 1 && arguments[0].text == "once") onceFiles.emplace(file->path);
+        } else if (name == "ident" || name == "sccs" || tokens.size() == 1) {
+            return;
+        } else {
+            // Other lines starting with #, such as line markers, are passed through.
+            unguarded();
+            sync(file->line);
+            output += line;
+            output += '\n';
+            outputLine += 1 + std::count(line.begin(), line.end(), '\n');
+        }
+    }
+
+    bool ifdef(const std::string &name, const Tokens &arguments) {
+        if (arguments.empty() || arguments.front().kind != Kind::Identifier) {
+            error(absl::StrCat("no macro name given in #", name, " directive"));
+            return false;
+        }
+        return isDefined(arguments.front().text) == (name == "ifdef");
+    }
+
+    bool evaluate(const Tokens &arguments) {
+        Tokens replaced;
+        for (size_t i = 0; i < arguments.size(); i++) {
+            if (arguments[i].kind != Kind::Identifier || arguments[i].text != "defined") {
+                replaced.push_back(arguments[i]);
+                continue;
+            }
+            bool parenthesized = i + 1 < arguments.size() && arguments[i + 1].is("(");
+            size_t nameIndex = i + (parenthesized ? 2 : 1);
+            if (nameIndex >= arguments.size() || arguments[nameIndex].kind != Kind::Identifier ||
+                (parenthesized &&
+                 (nameIndex + 1 >= arguments.size() || !arguments[nameIndex + 1].is(")")))) {
+                error("operator \"defined\" requires an identifier");
+                return false;
+            }
+            replaced.push_back(Token(Kind::Number, isDefined(arguments[nameIndex].text) ? "1" : "0",
+                                     arguments[i].space));
+            i = nameIndex + (parenthesized ? 1 : 0);
+        }
+        std::deque<Token> input(replaced.begin(), replaced.end());
+        Tokens expanded;
+        expand(input, expanded, false);
+        ExpressionEvaluator evaluator(expanded);
+        auto value = evaluator.evaluate();
+        if (!value) {
+            error(*evaluator.error);
+            return false;
+        }
+        return *value;
+    }
+
+    void define(const Tokens &arguments) {
+        if (arguments.empty() || arguments.front().kind != Kind::Identifier)
+            return error("macro names must be identifiers");
+        const auto &name = arguments.front().text;
+        if (name == "defined") return error("\"defined\" cannot be used as a macro name");
+        Macro macro;
+        size_t i = 1;
+        if (i < arguments.size() && arguments[i].is("(") && arguments[i].space.empty()) {
+            macro.functionLike = true;
+            if (!parameters(arguments, ++i, macro)) return;
+        }
+        for (; i < arguments.size(); i++) {
+            macro.body.push_back(arguments[i]);
+            macro.body.back().space = macro.body.size() > 1 && !arguments[i].space.empty()
+                                          ? " "
+                                          : std::string();
+        }
+        if (!macro.body.empty() && (macro.body.front().is("##") || macro.body.back().is("##")))
+            return error("'##' cannot appear at either end of a macro expansion");
+        auto [it, inserted] = macros.emplace(name, macro);
+        if (!inserted && !(it->second == macro)) {
+            warning(absl::StrCat("\"", name, "\" redefined"));
+            it->second = std::move(macro);
+        }
+    }
+
+    /// Parses the parameters of a function-like macro, starting at @p i, after the opening
+    /// parenthesis.
+    bool parameters(const Tokens &arguments, size_t &i, Macro &macro) {
+        if (i < arguments.size() && arguments[i].is(")")) {
+            i++;
+            return true;
+        }
+        while (i < arguments.size()) {
+            const auto &token = arguments[i++];
+            if (token.is("...")) {
+                macro.variadic = true;
+                macro.parameters.emplace_back("__VA_ARGS__");
+            } else if (token.kind == Kind::Identifier) {
+                macro.parameters.push_back(token.text);
+                // GNU named variable arguments: `args...`.
+                if (i < arguments.size() && arguments[i].is("...")) {
+                    macro.variadic = true;
+                    i++;
+                }
+            } else {
+                break;
+            }
+            if (i < arguments.size() && arguments[i].is(")")) {
+                i++;
+                return true;
+            }
+            if (macro.variadic || i >= arguments.size() || !arguments[i++].is(",")) break;
+        }
+        error("invalid macro parameter list");
+        return false;
+    }
+
+    void undefine(const Tokens &arguments) {
+        if (arguments.empty() || arguments.front().kind != Kind::Identifier)
+            return error("macro names must be identifiers");
+        macros.erase(arguments.front().text);
+    }
+
+    void lineDirective(const Tokens &arguments) {
+        std::deque<Token> input(arguments.begin(), arguments.end());
+        Tokens expanded;
+        expand(input, expanded, false);
+        unsigned line = 0;
+        if (expanded.empty() || expanded.front().kind != Kind::Number ||
+            !absl::SimpleAtoi(expanded.front().text, &line)) {
+            return error("#line directive requires a line number");
+        }
+        if (expanded.size() > 1 && expanded[1].kind == Kind::String)
+            file->name = expanded[1].text.substr(1, expanded[1].text.size() - 2);
+        file->nextLine = line;
+    }
+
+    void include(const Tokens &arguments, bool next) {
+        Tokens tokens = arguments;
+        if (!tokens.empty() && tokens.front().kind == Kind::Identifier) {
+            std::deque<Token> input(arguments.begin(), arguments.end());
+            tokens.clear();
+            expand(input, tokens, false);
+        }
+        std::string name;
+        bool quoted = !tokens.empty() && tokens.front().kind == Kind::String;
+        if (quoted) {
+            name = tokens.front().text.substr(1, tokens.front().text.size() - 2);
+        } else if (!tokens.empty() && tokens.front().is("<")) {
+            auto end = std::find_if(tokens.begin(), tokens.end(),
+                                    [](const Token &token) { return token.is(">"); });
+            if (end != tokens.end()) name = spell(Tokens(tokens.begin() + 1, end));
+        }
+        if (name.empty()) return error("#include expects \"FILENAME\" or <FILENAME>");
+        if (depth >= MAX_INCLUDE_DEPTH) {
+            stopped = true;
+            return error("#include nested too deeply");
+        }
+
+        std::string path;
+        int index = -1;
+        std::shared_ptr<const MappedFile> contents;
+        if (std::filesystem::path(name).is_absolute()) {
+            path = name;
+            contents = includedFile(path);
+        } else {
+            if (quoted && !next) {
+                path = file->directory.empty() ? name : (file->directory / name).string();
+                contents = includedFile(path);
+            }
+            size_t start = next ? file->includeIndex + 1 : 0;
+            for (size_t i = start; contents == nullptr && i < includePath.size(); i++) {
+                path = (includePath[i] / name).string();
+                contents = includedFile(path);
+                index = static_cast<int>(i);
+            }
+        }
+        if (contents == nullptr) {
+            stopped = true;
+            ::P4::error(ErrorType::ERR_NOT_FOUND, "%1%:%2%: %3%: No such file or directory",
+                        file->name, file->line, name);
+            return;
+        }
+
+        if (onceFiles.count(path) != 0) return;
+        auto guard = guards.find(path);
+        if (guard != guards.end() && isDefined(guard->second)) return;
+        LOG2("Including " << path);
+        depth++;
+        process(contents->contents(), path, std::filesystem::path(path).parent_path(), index,
+                " 1");
+        depth--;
+    }
+};
+
+/// Splits @p options into arguments like a shell.
+std::vector<std::string> splitArguments(std::string_view options) {
+    std::vector<std::string> result;
+    std::optional<std::string> current;
+    char quote = '\0';
+    for (size_t i = 0; i < options.size(); i++) {
+        char c = options[i];
+        if (quote == '\0' && absl::ascii_isspace(c)) {
+            if (current) result.push_back(std::move(*current));
+            current.reset();
+            continue;
+        }
+        if (!current) current.emplace();
+        if (quote == '\0' && (c == '"' || c == '\'')) {
+            quote = c;
+        } else if (quote == c) {
+            quote = '\0';
+        } else if (c == '\\' && quote != '\'' && i + 1 < options.size()) {
+            *current += options[++i];
+        } else {
+            *current += c;
+        }
+    }
+    if (current) result.push_back(std::move(*current));
+    return result;
+}
+
+}  // namespace
+
+std::optional<Preprocessor> Preprocessor::fromOptions(const ParserOptions &options) {
+    if (!options.builtinPreprocessor || options.file == "-") return std::nullopt;
+    Preprocessor preprocessor;
+    auto arguments = splitArguments(
+        absl::StrCat(options.preprocessor_options.string_view(), options.getIncludePath()));
+    for (size_t i = 0; i < arguments.size(); i++) {
+        const auto &argument = arguments[i];
+        char option = argument.size() >= 2 && argument[0] == '-' ? argument[1] : '\0';
+        if (option != 'I' && option != 'D' && option != 'U') {
+            ::P4::warning(ErrorType::WARN_UNSUPPORTED,
+                          "--builtin-cpp does not support the preprocessor option %1%, "
+                          "invoking the external preprocessor",
+                          argument);
+            return std::nullopt;
+        }
+        auto value = argument.substr(2);
+        if (value.empty() && i + 1 < arguments.size()) value = arguments[++i];
+        if (option == 'I') preprocessor.addIncludeDirectory(value);
+        if (option == 'D') preprocessor.define(value);
+        if (option == 'U') preprocessor.undefine(value);
+    }
+    return preprocessor;
+}
+
+void Preprocessor::addIncludeDirectory(std::filesystem::path directory) {
+    includePath.push_back(std::move(directory));
+}
+
+void Preprocessor::define(std::string_view definition) {
+    auto equals = definition.find('=');
+    if (equals == std::string_view::npos) {
+        commandLine.emplace_back(true, absl::StrCat(definition, " 1"));
+    } else {
+        commandLine.emplace_back(
+            true, absl::StrCat(definition.substr(0, equals), " ", definition.substr(equals + 1)));
+    }
+}
+
+void Preprocessor::undefine(std::string_view name) {
+    commandLine.emplace_back(false, std::string(name));
+}
+
+std::optional<std::string> Preprocessor::preprocess(const std::filesystem::path &file) const {
+    auto contents = MappedFile::map(file.string());
+    if (contents == nullptr) {
+        ::P4::error(ErrorType::ERR_NOT_FOUND, "%1%: No such file or directory.", file);
+        return std::nullopt;
+    }
+    return preprocess(contents->contents(), file);
+}
+
+std::optional<std::string> Preprocessor::preprocess(std::string_view text,
+                                                    const std::filesystem::path &file) const {
+    Preprocessing preprocessing(includePath);
+    preprocessing.commandLine(commandLine);
+    return preprocessing.run(text, file);
+}
+
+}  // namespace P4
@@ -0,0 +1,69 @@
+#ifndef FRONTENDS_COMMON_PREPROCESSOR_H_
+#define FRONTENDS_COMMON_PREPROCESSOR_H_
+
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace P4 {
+
+class ParserOptions;
+
+/// A C preprocessor which runs in the compiler process (see --builtin-cpp), instead of the
+/// external preprocessor invoked by ParserOptions::preprocess. It implements what P4 programs
+/// use of `cpp -C -undef -nostdinc -x assembler-with-cpp`: #include and #include_next,
+/// object-like and function-like macros with # and ##, the conditional directives, #line,
+/// #error, #warning and #pragma once. Comments are kept, unknown directives are passed
+/// through, and the output has the line markers of the external preprocessor.
+///
+/// Included files are memory-mapped and cached for the lifetime of the process, so that
+/// compiling many programs in one process only reads the standard includes once.
+class Preprocessor {
+ public:
+    /// Returns a preprocessor with the include path and the macros of @p options. Returns
+    /// std::nullopt if --builtin-cpp was not given, or if the input or the preprocessor
+    /// options need the external preprocessor.
+    static std::optional<Preprocessor> fromOptions(const ParserOptions &options);
+
+    /// Appends @p directory to the directories searched by #include.
+    void addIncludeDirectory(std::filesystem::path directory);
+
+    /// Defines a macro given as `name`, `name=value` or `name(parameters)=value`, like -D.
+    void define(std::string_view definition);
+
+    /// Removes the definition of the macro @p name, like -U.
+    void undefine(std::string_view name);
+
+    /// Preprocesses @p file. Returns std::nullopt if an error was reported.
+    std::optional<std::string> preprocess(const std::filesystem::path &file) const;
+
+    /// Preprocesses @p text as if it were the contents of @p file.
+    std::optional<std::string> preprocess(std::string_view text,
+                                          const std::filesystem::path &file) const;
+
+ private:
+    /// The directories searched by #include, in order.
+    std::vector<std::filesystem::path> includePath;
+
+    /// The -D and -U options in order, as the text of a #define or #undef directive.
+    std::vector<std::pair<bool, std::string>> commandLine;
+};
+
+/// An input stream which reads a string in place, without copying it. The string must outlive
+/// the stream.
+class StringInputStream : private std::streambuf, public std::istream {
+ public:
+    explicit StringInputStream(std::string_view text) : std::istream(this) {
+        char *data = const_cast<char *>(text.data());
+        setg(data, data, data + text.size());
+    }
+};
+
+}  // namespace P4
+
+#endif /* FRONTENDS_COMMON_PREPROCESSOR_H_ */
@@ -23,6 +23,8 @@ limitations under the License.
 #include "frontends/p4/typeChecking/bindVariables.h"
 #include "frontends/p4/typeMap.h"
 #include "ir/ir.h"
+#include "lib/arena.h"
+#include "lib/log.h"
 #include "lib/nullstream.h"
 // Passes
 #include "actionsInlining.h"
@@ -333,7 +335,17 @@ const IR::P4Program *FrontEnd::run(const CompilerOptions &options, const IR::P4P
     passes.setName("FrontEnd");
     passes.setStopOnError(true);
     passes.addDebugHooks(hooks, true);
+    passes.addDebugHook(metricsPassManager.getSnapshotHook(), true);
+    passes.addDebugHook(metricsPassManager.getProfileHook(program), true);
+    Arena nodeArena;
+    if (options.nodeArena) passes.setNodeArena(&nodeArena, true);
     const IR::P4Program *result = program->apply(passes);
+    if (options.nodeArena) {
+        const auto &stats = nodeArena.getStats();
+        LOG1("FrontEnd allocated " << stats.allocations << " nodes (" << stats.bytes
+                                   << " bytes) in " << stats.chunks << " arena chunks, saving "
+                                   << stats.savedBytes << " bytes");
+    }
     return result;
 }
 
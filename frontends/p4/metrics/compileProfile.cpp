@@ -0,0 +1,74 @@
+#include "frontends/p4/metrics/compileProfile.h"
+
+namespace P4 {
+
+namespace {
+
+class CountNodes : public Inspector {
+ public:
+    size_t count = 0;
+
+    CountNodes() { setName("CountNodes"); }
+    bool preorder(const IR::Node *) override {
+        ++count;
+        return true;
+    }
+};
+
+}  // namespace
+
+size_t CompileProfiler::countNodes(const IR::Node *node) {
+    if (node == nullptr) return 0;
+    CountNodes counter;
+    node->apply(counter);
+    return counter.count;
+}
+
+void CompileProfiler::mark() {
+    lastAllocs = gc_alloc_stats();
+    lastTime = Clock::now();
+}
+
+void CompileProfiler::start(const IR::Node *program) {
+    gc_count_allocs(true);
+    if (countingNodes) {
+        lastProgram = program;
+        lastNodes = countNodes(program);
+    }
+    mark();
+}
+
+void CompileProfiler::afterPass(const char *manager, unsigned seqNo, const char *pass,
+                                const IR::Node *node) {
+    auto now = Clock::now();
+    auto allocs = gc_alloc_stats();
+
+    PassProfile entry;
+    entry.manager = cstring(manager);
+    entry.pass = cstring(pass);
+    entry.seqNo = seqNo;
+    entry.milliseconds = std::chrono::duration<double, std::milli>(now - lastTime).count();
+    entry.allocations = allocs.count - lastAllocs.count;
+    entry.allocatedBytes = allocs.bytes - lastAllocs.bytes;
+    if (countingNodes) {
+        entry.nodesBefore = lastNodes;
+        // A pass which failed returns no program, the next one starts from the same nodes.
+        // The IR is immutable, a pass which returned the same program did not change it.
+        if (node != nullptr && node != lastProgram) {
+            lastProgram = node;
+            lastNodes = countNodes(node);
+        }
+        entry.nodesAfter = node != nullptr ? lastNodes : 0;
+    }
+    profile.push_back(entry);
+
+    mark();
+}
+
+DebugHook CompileProfiler::getHook() {
+    return [this](const char *manager, unsigned seqNo, const char *pass, const IR::Node *node) {
+        afterPass(manager, seqNo, pass, node);
+    };
+}
+
+}  // namespace P4
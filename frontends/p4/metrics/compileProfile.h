@@ -0,0 +1,66 @@
+/*
+Compile-time profile of the compiler passes, collected when the
+"compile-profile" metric is selected. A debug hook attached to a
+PassManager records for every pass its wall time, and the number and
+total size of the allocations done while it ran. With the
+"compile-profile-nodes" metric, it also records the number of IR
+nodes of the program before and after the pass. Counting walks the
+whole program, so it is only done when requested, and only for
+passes which returned a different program.
+
+Debug hooks only run after a pass, so every measurement covers the
+interval since the previous call of the hook. When the hook is
+attached recursively, the cost of a nested pass manager is recorded
+for its own passes, and the entry of the manager itself only covers
+what remains. Time spent in other debug hooks (such as --top4 dumps)
+is included, counting the IR nodes is not. Allocations are only
+counted when the compiler is built with the garbage collector, which
+provides operator new.
+*/
+
+#ifndef FRONTENDS_P4_METRICS_COMPILEPROFILE_H_
+#define FRONTENDS_P4_METRICS_COMPILEPROFILE_H_
+
+#include <chrono>  // NOLINT linter forbids using chrono, but we don't have alternatives
+#include <vector>
+
+#include "frontends/p4/metrics/metricsStructure.h"
+#include "ir/ir.h"
+#include "ir/pass_manager.h"
+#include "lib/gc.h"
+
+namespace P4 {
+
+class CompileProfiler {
+ private:
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<PassProfile> &profile;
+    Clock::time_point lastTime;
+    alloc_stats_t lastAllocs = {0, 0};
+    bool countingNodes;
+    const IR::Node *lastProgram = nullptr;
+    size_t lastNodes = 0;
+
+    /// Starts the measurement of the next pass.
+    void mark();
+
+ public:
+    /// The IR nodes are counted only with @countingNodes.
+    explicit CompileProfiler(std::vector<PassProfile> &profile, bool countingNodes = false)
+        : profile(profile), countingNodes(countingNodes) {}
+
+    /// Starts profiling the passes applied to @program.
+    void start(const IR::Node *program);
+    /// Records the pass which has just finished, @node is the program it returned.
+    void afterPass(const char *manager, unsigned seqNo, const char *pass, const IR::Node *node);
+    /// Returns a hook calling afterPass(), it must not be called after this object is destroyed.
+    DebugHook getHook();
+
+    /// Number of distinct IR nodes reachable from @node.
+    static size_t countNodes(const IR::Node *node);
+};
+
+}  // namespace P4
+
+#endif /* FRONTENDS_P4_METRICS_COMPILEPROFILE_H_ */
@@ -14,7 +14,8 @@ void CyclomaticComplexityCalculator::postorder(const IR::SelectExpression *selec
 
 void CyclomaticComplexityCalculator::postorder(const IR::MethodCallExpression *mce) {
     if (auto pathExpr = mce->method->to<IR::PathExpression>()) {
-        if (pathExpr->path->name.name == "verify"_cs) ++cc;
+        // Compared as a string, interning a literal is not safe on worker threads.
+        if (pathExpr->path->name.name == "verify") ++cc;
     }
 }
 
@@ -25,18 +26,39 @@ bool CyclomaticComplexityCalculator::preorder(const IR::P4Table *table) {
     return false;
 }
 
+void CyclomaticComplexityPass::measure(const IR::Node *block, cstring name) {
+    // The slot is reserved here, so the map keeps the traversal order.
+    unsigned &value = metrics.cyclomaticComplexity[name];
+    CachedBlockMetrics *entry = cache ? &cache->getEntry(block) : nullptr;
+    if (entry && entry->cyclomaticComplexity) {
+        value = *entry->cyclomaticComplexity;
+        return;
+    }
+    if (entry) uncached.emplace_back(&value, entry);
+
+    runBlockTask([block, &value]() {
+        CyclomaticComplexityCalculator calculator;
+        block->apply(calculator);
+        value = calculator.getComplexity();
+    });
+}
+
 bool CyclomaticComplexityPass::preorder(const IR::P4Control *control) {
-    CyclomaticComplexityCalculator calculator;
-    control->apply(calculator);
-    metrics.cyclomaticComplexity[control->name.name] = calculator.getComplexity();
+    measure(control, control->name.name);
     return false;
 }
 
 bool CyclomaticComplexityPass::preorder(const IR::P4Parser *parser) {
-    CyclomaticComplexityCalculator calculator;
-    parser->apply(calculator);
-    metrics.cyclomaticComplexity[parser->name.name] = calculator.getComplexity();
+    measure(parser, parser->name.name);
     return false;
 }
 
+void CyclomaticComplexityPass::end_apply(const IR::Node *root) {
+    // All block tasks have finished, store their results in the cache.
+    for (const auto &[value, entry] : uncached) entry->cyclomaticComplexity = *value;
+    if (!uncached.empty()) cache->markModified();
+    uncached.clear();
+    MetricsCollector::end_apply(root);
+}
+
 }  // namespace P4
@@ -3,11 +3,18 @@ Determines the cyclomatic complexity values of parsers and
 controls. It applies the ccCalculator to each parser and control
 instance found during traversal. The ccCalculator determines the
 CC value by counting decision point nodes (like if statements).
+The calculators of different blocks are independent, so they can
+run on the worker threads of the MetricsEngine.
 */
 
 #ifndef FRONTENDS_P4_METRICS_CYCLOMATICCOMPLEXITY_H_
 #define FRONTENDS_P4_METRICS_CYCLOMATICCOMPLEXITY_H_
 
+#include <utility>
+#include <vector>
+
+#include "frontends/p4/metrics/metricsCache.h"
+#include "frontends/p4/metrics/metricsEngine.h"
 #include "frontends/p4/metrics/metricsStructure.h"
 #include "ir/ir.h"
 
@@ -31,16 +38,23 @@ class CyclomaticComplexityCalculator : public Inspector {
     bool preorder(const IR::P4Table *table) override;
 };
 
-class CyclomaticComplexityPass : public Inspector {
+class CyclomaticComplexityPass : public MetricsCollector {
     Metrics &metrics;
+    MetricsCache *cache;
+    // Values computed by block tasks, which are stored in the cache at the end.
+    std::vector<std::pair<const unsigned *, CachedBlockMetrics *>> uncached;
+
+    void measure(const IR::Node *block, cstring name);
 
  public:
-    explicit CyclomaticComplexityPass(Metrics &metricsRef) : metrics(metricsRef) {
+    explicit CyclomaticComplexityPass(Metrics &metricsRef, MetricsCache *cache = nullptr)
+        : metrics(metricsRef), cache(cache) {
         setName("CyclomaticComplexityPass");
     }
 
     bool preorder(const IR::P4Control *control) override;
     bool preorder(const IR::P4Parser *parser) override;
+    void end_apply(const IR::Node *root) override;
 };
 
 }  // namespace P4
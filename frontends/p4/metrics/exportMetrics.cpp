@@ -1,5 +1,8 @@
 #include "frontends/p4/metrics/exportMetrics.h"
 
+#include "frontends/p4/metrics/metricsBinary.h"
+#include "lib/timer.h"
+
 namespace P4 {
 
 bool ExportMetricsPass::preorder(const IR::P4Program * /*program*/) {
@@ -7,34 +10,55 @@ bool ExportMetricsPass::preorder(const IR::P4Program * /*program*/) {
     size_t pos = isolatedFileName.rfind('.');
     if (pos != std::string::npos) isolatedFileName = filename.string().substr(0, pos);
     isolatedFileName += "_metrics";
+    if (label) isolatedFileName += "-" + label.string();
 
-    std::ofstream textFile(isolatedFileName + ".txt");
-    if (!textFile.is_open()) {
-        error(ErrorType::ERR_IO, "Error: Unable to open file %s.txt", isolatedFileName.c_str());
-        return false;
+    if (exportText) {
+        MetricsOutputFile textFile(isolatedFileName + ".txt");
+        if (!textFile.isOpen()) {
+            error(ErrorType::ERR_IO, "Error: Unable to open file %s.txt", isolatedFileName.c_str());
+            return false;
+        }
+        writeText(textFile);
+        if (!finish(textFile)) return false;
+    }
+
+    if (exportJson) {
+        MetricsOutputFile jsonFile(isolatedFileName + ".json");
+        if (!jsonFile.isOpen()) {
+            error(ErrorType::ERR_IO, "Error: Unable to open file %s.json",
+                  isolatedFileName.c_str());
+            return false;
+        }
+        Util::JsonWriter json(jsonFile.stream());
+        writeJson(json);
+        if (!finish(jsonFile)) return false;
     }
 
-    std::ofstream jsonFile(isolatedFileName + ".json");
-    if (!jsonFile.is_open()) {
-        error(ErrorType::ERR_IO, "Error: Unable to open file %s.json", isolatedFileName.c_str());
-        return false;
+    if (exportSnapshot && !writeMetricsSnapshot(metrics, isolatedFileName + ".bin")) {
+        error(ErrorType::ERR_IO, "Error: Unable to write file %s.bin", isolatedFileName.c_str());
     }
 
-    Util::JsonObject *root = new Util::JsonObject();
+    return false;
+}
+
+bool ExportMetricsPass::finish(MetricsOutputFile &file) const {
+    if (file.close()) return true;
+    error(ErrorType::ERR_IO, "Error: Unable to write file %s", file.getPath().c_str());
+    return false;
+}
+
+void ExportMetricsPass::writeText(MetricsOutputFile &textFile) const {
+    if (label) textFile << "Snapshot: " << label << "\n";
 
     if (selectedMetrics.count("loc"_cs)) {
         textFile << "\nLines of Code: " << metrics.linesOfCode << "\n";
-        root->emplace("lines_of_code", new Util::JsonValue(metrics.linesOfCode));
     }
 
     if (selectedMetrics.count("cyclomatic"_cs)) {
         textFile << "\nCyclomatic Complexity:\n";
-        auto *ccJson = new Util::JsonObject();
         for (const auto &[func, cc] : metrics.cyclomaticComplexity) {
             textFile << "  " << func << ": " << cc << "\n";
-            ccJson->emplace(func, new Util::JsonValue(cc));
         }
-        root->emplace("cyclomatic_complexity", ccJson);
     }
 
     if (selectedMetrics.count("halstead"_cs)) {
@@ -49,23 +73,6 @@ bool ExportMetricsPass::preorder(const IR::P4Program * /*program*/) {
                  << "  Volume: " << metrics.halsteadMetrics.volume << "\n"
                  << "  Effort: " << metrics.halsteadMetrics.effort << "\n"
                  << "  Estimated Bugs: " << metrics.halsteadMetrics.deliveredBugs << "\n";
-
-        auto *halsteadJson = new Util::JsonObject();
-        halsteadJson
-            ->emplace("unique_operators",
-                      new Util::JsonValue(metrics.halsteadMetrics.uniqueOperators))
-            ->emplace("unique_operands",
-                      new Util::JsonValue(metrics.halsteadMetrics.uniqueOperands))
-            ->emplace("total_operators",
-                      new Util::JsonValue(metrics.halsteadMetrics.totalOperators))
-            ->emplace("total_operands", new Util::JsonValue(metrics.halsteadMetrics.totalOperands))
-            ->emplace("vocabulary", new Util::JsonValue(metrics.halsteadMetrics.vocabulary))
-            ->emplace("length", new Util::JsonValue(metrics.halsteadMetrics.length))
-            ->emplace("difficulty", new Util::JsonValue(metrics.halsteadMetrics.difficulty))
-            ->emplace("volume", new Util::JsonValue(metrics.halsteadMetrics.volume))
-            ->emplace("effort", new Util::JsonValue(metrics.halsteadMetrics.effort))
-            ->emplace("estimated_bugs", new Util::JsonValue(metrics.halsteadMetrics.deliveredBugs));
-        root->emplace("halstead", halsteadJson);
     }
 
     if (selectedMetrics.count("unused-code"_cs)) {
@@ -81,17 +88,6 @@ bool ExportMetricsPass::preorder(const IR::P4Program * /*program*/) {
                  << "\tConditionals: " << metrics.unusedCodeInstances.conditionals << "\n"
                  << "\tParameters: " << metrics.unusedCodeInstances.parameters << "\n"
                  << "\tReturns: " << metrics.unusedCodeInstances.returns << "\n";
-
-        auto *unusedJson = new Util::JsonObject();
-        unusedJson->emplace("actions", new Util::JsonValue(metrics.unusedCodeInstances.actions))
-            ->emplace("functions", new Util::JsonValue(metrics.unusedCodeInstances.functions))
-            ->emplace("states", new Util::JsonValue(metrics.unusedCodeInstances.states))
-            ->emplace("variables", new Util::JsonValue(metrics.unusedCodeInstances.variables))
-            ->emplace("enums", new Util::JsonValue(metrics.unusedCodeInstances.enums))
-            ->emplace("conditionals", new Util::JsonValue(metrics.unusedCodeInstances.conditionals))
-            ->emplace("parameters", new Util::JsonValue(metrics.unusedCodeInstances.parameters))
-            ->emplace("returns", new Util::JsonValue(metrics.unusedCodeInstances.returns));
-        root->emplace("unused_code", unusedJson);
     }
 
     if (selectedMetrics.count("nesting-depth"_cs)) {
@@ -99,17 +95,9 @@ bool ExportMetricsPass::preorder(const IR::P4Program * /*program*/) {
                  << "  Average: " << metrics.nestingDepth.avgNestingDepth << "\n"
                  << "  Global Max: " << metrics.nestingDepth.maxNestingDepth << "\n"
                  << "  Individual blocks: \n";
-
-        auto *nestingJson = new Util::JsonObject();
-        auto *blockDepths = new Util::JsonObject();
         for (const auto &[blockName, depth] : metrics.nestingDepth.blockNestingDepth) {
             textFile << "\t" << blockName << ": " << depth << "\n";
-            blockDepths->emplace(blockName, new Util::JsonValue(depth));
         }
-        nestingJson->emplace("average", new Util::JsonValue(metrics.nestingDepth.avgNestingDepth))
-            ->emplace("global_max", new Util::JsonValue(metrics.nestingDepth.maxNestingDepth))
-            ->emplace("individual_blocks", blockDepths);
-        root->emplace("nesting_depth", nestingJson);
     }
 
     if (selectedMetrics.count("header-general"_cs)) {
@@ -118,27 +106,12 @@ bool ExportMetricsPass::preorder(const IR::P4Program * /*program*/) {
                  << "  Avg Fields Per Header: " << metrics.headerMetrics.avgFieldsNum << "\n"
                  << "  Avg Field Size: " << metrics.headerMetrics.avgFieldSize << "\n"
                  << "  Per-header metrics:\n";
-
-        auto *headerJson = new Util::JsonObject();
-        auto *perHeader = new Util::JsonObject();
         for (const auto &[header, fields] : metrics.headerMetrics.fieldsNum) {
             textFile << "\t" << header << ":\n"
                      << "\t  Fields: " << fields << "\n"
                      << "\t  Fields size sum: " << metrics.headerMetrics.fieldSizeSum.at(header)
                      << "\n";
-
-            auto *headerData = new Util::JsonObject();
-            headerData->emplace("fields", new Util::JsonValue(fields))
-                ->emplace("field_size_sum",
-                          new Util::JsonValue(metrics.headerMetrics.fieldSizeSum.at(header)));
-            perHeader->emplace(header, headerData);
         }
-        headerJson->emplace("total_headers", new Util::JsonValue(metrics.headerMetrics.numHeaders))
-            ->emplace("avg_fields_per_header",
-                      new Util::JsonValue(metrics.headerMetrics.avgFieldsNum))
-            ->emplace("avg_field_size", new Util::JsonValue(metrics.headerMetrics.avgFieldSize))
-            ->emplace("per_header_metrics", perHeader);
-        root->emplace("header_metrics", headerJson);
     }
 
     if (selectedMetrics.count("header-manipulation"_cs)) {
@@ -147,26 +120,11 @@ bool ExportMetricsPass::preorder(const IR::P4Program * /*program*/) {
                  << "\n"
                  << "  Total Size: " << metrics.headerManipulationMetrics.total.totalSize << "\n"
                  << "  Per-packet metrics:\n";
-
-        auto *manipulationJson = new Util::JsonObject();
-        auto *perPacketManip = new Util::JsonObject();
         for (const auto &[packet, ops] : metrics.headerManipulationMetrics.perPacket) {
             textFile << "\t" << packet << ":\n"
                      << "\t  Operations: " << ops.numOperations << "\n"
                      << "\t  Size: " << ops.totalSize << "\n";
-
-            auto *packetOps = new Util::JsonObject();
-            packetOps->emplace("operations", new Util::JsonValue(ops.numOperations))
-                ->emplace("size", new Util::JsonValue(ops.totalSize));
-            perPacketManip->emplace(packet, packetOps);
         }
-        manipulationJson
-            ->emplace("total_operations",
-                      new Util::JsonValue(metrics.headerManipulationMetrics.total.numOperations))
-            ->emplace("total_size",
-                      new Util::JsonValue(metrics.headerManipulationMetrics.total.totalSize))
-            ->emplace("per_packet", perPacketManip);
-        root->emplace("header_manipulation", manipulationJson);
     }
 
     if (selectedMetrics.count("header-modification"_cs)) {
@@ -175,26 +133,11 @@ bool ExportMetricsPass::preorder(const IR::P4Program * /*program*/) {
                  << "\n"
                  << "  Total Size: " << metrics.headerModificationMetrics.total.totalSize << "\n"
                  << "  Per-packet metrics:\n";
-
-        auto *modificationJson = new Util::JsonObject();
-        auto *perPacketMod = new Util::JsonObject();
         for (const auto &[packet, ops] : metrics.headerModificationMetrics.perPacket) {
             textFile << "\t" << packet << ":\n"
                      << "\t  Operations: " << ops.numOperations << "\n"
                      << "\t  Size: " << ops.totalSize << "\n";
-
-            auto *packetMod = new Util::JsonObject();
-            packetMod->emplace("operations", new Util::JsonValue(ops.numOperations))
-                ->emplace("size", new Util::JsonValue(ops.totalSize));
-            perPacketMod->emplace(packet, packetMod);
         }
-        modificationJson
-            ->emplace("total_operations",
-                      new Util::JsonValue(metrics.headerModificationMetrics.total.numOperations))
-            ->emplace("total_size",
-                      new Util::JsonValue(metrics.headerModificationMetrics.total.totalSize))
-            ->emplace("per_packet", perPacketMod);
-        root->emplace("header_modification", modificationJson);
     }
 
     if (selectedMetrics.count("match-action"_cs)) {
@@ -213,9 +156,6 @@ bool ExportMetricsPass::preorder(const IR::P4Program * /*program*/) {
                  << "  Max Actions Per Table: "
                  << metrics.matchActionTableMetrics.maxActionsPerTable << "\n"
                  << "  Per-table Metrics:\n";
-
-        auto *tableJson = new Util::JsonObject();
-        auto *perTable = new Util::JsonObject();
         for (const auto &[table, keys] : metrics.matchActionTableMetrics.keysNum) {
             textFile << "  " << table << ":\n"
                      << "\t Actions: " << metrics.matchActionTableMetrics.actionsNum.at(table)
@@ -223,52 +163,16 @@ bool ExportMetricsPass::preorder(const IR::P4Program * /*program*/) {
                      << "\t Keys: " << keys << "\n"
                      << "\t Key size sum: " << metrics.matchActionTableMetrics.keySizeSum.at(table)
                      << "\n";
-
-            auto *tableData = new Util::JsonObject();
-            tableData
-                ->emplace("actions",
-                          new Util::JsonValue(metrics.matchActionTableMetrics.actionsNum.at(table)))
-                ->emplace("keys", new Util::JsonValue(keys))
-                ->emplace(
-                    "key_size_sum",
-                    new Util::JsonValue(metrics.matchActionTableMetrics.keySizeSum.at(table)));
-            perTable->emplace(table, tableData);
         }
-        tableJson
-            ->emplace("num_tables", new Util::JsonValue(metrics.matchActionTableMetrics.numTables))
-            ->emplace("total_keys", new Util::JsonValue(metrics.matchActionTableMetrics.totalKeys))
-            ->emplace("total_key_size",
-                      new Util::JsonValue(metrics.matchActionTableMetrics.totalKeySizeSum))
-            ->emplace("avg_key_size",
-                      new Util::JsonValue(metrics.matchActionTableMetrics.avgKeySize))
-            ->emplace("avg_keys_per_table",
-                      new Util::JsonValue(metrics.matchActionTableMetrics.avgKeysPerTable))
-            ->emplace("max_keys_per_table",
-                      new Util::JsonValue(metrics.matchActionTableMetrics.maxKeysPerTable))
-            ->emplace("total_actions",
-                      new Util::JsonValue(metrics.matchActionTableMetrics.totalActions))
-            ->emplace("avg_actions_per_table",
-                      new Util::JsonValue(metrics.matchActionTableMetrics.avgActionsPerTable))
-            ->emplace("max_actions_per_table",
-                      new Util::JsonValue(metrics.matchActionTableMetrics.maxActionsPerTable))
-            ->emplace("per_table_metrics", perTable);
-        root->emplace("match_action_tables", tableJson);
     }
 
     if (selectedMetrics.count("parser"_cs)) {
         textFile << "\nParser Metrics:\n"
                  << "  States: " << metrics.parserMetrics.totalStates << "\n"
                  << "  Per-parser complexities:\n";
-
-        auto *parserJson = new Util::JsonObject();
-        auto *stateComplexities = new Util::JsonObject();
         for (const auto &[state, complexity] : metrics.parserMetrics.StateComplexity) {
             textFile << "\t" << state << ": " << complexity << "\n";
-            stateComplexities->emplace(state, new Util::JsonValue(complexity));
         }
-        parserJson->emplace("total_states", new Util::JsonValue(metrics.parserMetrics.totalStates))
-            ->emplace("state_complexities", stateComplexities);
-        root->emplace("parser", parserJson);
     }
 
     if (selectedMetrics.count("extern"_cs)) {
@@ -277,27 +181,212 @@ bool ExportMetricsPass::preorder(const IR::P4Program * /*program*/) {
                  << "  Function Calls: " << metrics.externMetrics.externFunctionUses << "\n"
                  << "  Extern Structures: " << metrics.externMetrics.externStructures << "\n"
                  << "  Structure Uses: " << metrics.externMetrics.externStructUses << "\n";
-
-        auto *externJson = new Util::JsonObject();
-        externJson->emplace("functions", new Util::JsonValue(metrics.externMetrics.externFunctions))
-            ->emplace("function_calls",
-                      new Util::JsonValue(metrics.externMetrics.externFunctionUses))
-            ->emplace("structures", new Util::JsonValue(metrics.externMetrics.externStructures))
-            ->emplace("structure_uses",
-                      new Util::JsonValue(metrics.externMetrics.externStructUses));
-        root->emplace("extern", externJson);
     }
 
     if (selectedMetrics.count("inlined"_cs)) {
         textFile << "\nNumber of Inlined Actions: " << metrics.inlinedActions << "\n";
-        root->emplace("inlined_actions", new Util::JsonValue(metrics.inlinedActions));
     }
 
-    jsonFile << root->toString();
-    textFile.close();
-    jsonFile.close();
+    if (selectedMetrics.count("compile-profile"_cs)) {
+        textFile << "\nCompile Profile:\n";
+        for (const auto &pass : metrics.compileProfile) {
+            textFile << "  " << pass.manager << "/" << pass.pass << ": " << pass.milliseconds
+                     << " ms, " << pass.allocations << " allocations (" << pass.allocatedBytes
+                     << " bytes)";
+            if (selectedMetrics.count("compile-profile-nodes"_cs)) {
+                textFile << ", IR nodes " << pass.nodesBefore << " -> " << pass.nodesAfter;
+            }
+            textFile << "\n";
+        }
+    }
+}
+
+void ExportMetricsPass::writeJson(Util::JsonWriter &json) const {
+    json.beginObject();
 
-    return false;
+    if (label) json.member("snapshot", label);
+
+    if (selectedMetrics.count("loc"_cs)) {
+        json.member("lines_of_code", metrics.linesOfCode);
+    }
+
+    if (selectedMetrics.count("cyclomatic"_cs)) {
+        json.key("cyclomatic_complexity").beginObject();
+        for (const auto &[func, cc] : metrics.cyclomaticComplexity) json.key(func).value(cc);
+        json.endObject();
+    }
+
+    if (selectedMetrics.count("halstead"_cs)) {
+        const auto &halstead = metrics.halsteadMetrics;
+        json.key("halstead").beginObject();
+        json.member("unique_operators", halstead.uniqueOperators)
+            .member("unique_operands", halstead.uniqueOperands)
+            .member("total_operators", halstead.totalOperators)
+            .member("total_operands", halstead.totalOperands)
+            .member("vocabulary", halstead.vocabulary)
+            .member("length", halstead.length)
+            .member("difficulty", halstead.difficulty)
+            .member("volume", halstead.volume)
+            .member("effort", halstead.effort)
+            .member("estimated_bugs", halstead.deliveredBugs);
+        json.endObject();
+    }
+
+    if (selectedMetrics.count("unused-code"_cs)) {
+        const auto &unused = metrics.unusedCodeInstances;
+        json.key("unused_code").beginObject();
+        json.member("actions", unused.actions)
+            .member("functions", unused.functions)
+            .member("states", unused.states)
+            .member("variables", unused.variables)
+            .member("enums", unused.enums)
+            .member("conditionals", unused.conditionals)
+            .member("parameters", unused.parameters)
+            .member("returns", unused.returns);
+        json.endObject();
+    }
+
+    if (selectedMetrics.count("nesting-depth"_cs)) {
+        json.key("nesting_depth").beginObject();
+        json.member("average", metrics.nestingDepth.avgNestingDepth)
+            .member("global_max", metrics.nestingDepth.maxNestingDepth);
+        json.key("individual_blocks").beginObject();
+        for (const auto &[blockName, depth] : metrics.nestingDepth.blockNestingDepth) {
+            json.key(blockName).value(depth);
+        }
+        json.endObject();
+        json.endObject();
+    }
+
+    if (selectedMetrics.count("header-general"_cs)) {
+        json.key("header_metrics").beginObject();
+        json.member("total_headers", metrics.headerMetrics.numHeaders)
+            .member("avg_fields_per_header", metrics.headerMetrics.avgFieldsNum)
+            .member("avg_field_size", metrics.headerMetrics.avgFieldSize);
+        json.key("per_header_metrics").beginObject();
+        for (const auto &[header, fields] : metrics.headerMetrics.fieldsNum) {
+            json.key(header).beginObject();
+            json.member("fields", fields)
+                .member("field_size_sum", metrics.headerMetrics.fieldSizeSum.at(header));
+            json.endObject();
+        }
+        json.endObject();
+        json.endObject();
+    }
+
+    auto writePacketMetrics = [&json](std::string_view name, const HeaderPacketMetrics &packets) {
+        json.key(name).beginObject();
+        json.member("total_operations", packets.total.numOperations)
+            .member("total_size", packets.total.totalSize);
+        json.key("per_packet").beginObject();
+        for (const auto &[packet, ops] : packets.perPacket) {
+            json.key(packet).beginObject();
+            json.member("operations", ops.numOperations).member("size", ops.totalSize);
+            json.endObject();
+        }
+        json.endObject();
+        json.endObject();
+    };
+    if (selectedMetrics.count("header-manipulation"_cs)) {
+        writePacketMetrics("header_manipulation", metrics.headerManipulationMetrics);
+    }
+    if (selectedMetrics.count("header-modification"_cs)) {
+        writePacketMetrics("header_modification", metrics.headerModificationMetrics);
+    }
+
+    if (selectedMetrics.count("match-action"_cs)) {
+        const auto &tables = metrics.matchActionTableMetrics;
+        json.key("match_action_tables").beginObject();
+        json.member("num_tables", tables.numTables)
+            .member("total_keys", tables.totalKeys)
+            .member("total_key_size", tables.totalKeySizeSum)
+            .member("avg_key_size", tables.avgKeySize)
+            .member("avg_keys_per_table", tables.avgKeysPerTable)
+            .member("max_keys_per_table", tables.maxKeysPerTable)
+            .member("total_actions", tables.totalActions)
+            .member("avg_actions_per_table", tables.avgActionsPerTable)
+            .member("max_actions_per_table", tables.maxActionsPerTable);
+        json.key("per_table_metrics").beginObject();
+        for (const auto &[table, keys] : tables.keysNum) {
+            json.key(table).beginObject();
+            json.member("actions", tables.actionsNum.at(table))
+                .member("keys", keys)
+                .member("key_size_sum", tables.keySizeSum.at(table));
+            json.endObject();
+        }
+        json.endObject();
+        json.endObject();
+    }
+
+    if (selectedMetrics.count("parser"_cs)) {
+        json.key("parser").beginObject();
+        json.member("total_states", metrics.parserMetrics.totalStates);
+        json.key("state_complexities").beginObject();
+        for (const auto &[state, complexity] : metrics.parserMetrics.StateComplexity) {
+            json.key(state).value(complexity);
+        }
+        json.endObject();
+        json.endObject();
+    }
+
+    if (selectedMetrics.count("extern"_cs)) {
+        json.key("extern").beginObject();
+        json.member("functions", metrics.externMetrics.externFunctions)
+            .member("function_calls", metrics.externMetrics.externFunctionUses)
+            .member("structures", metrics.externMetrics.externStructures)
+            .member("structure_uses", metrics.externMetrics.externStructUses);
+        json.endObject();
+    }
+
+    if (selectedMetrics.count("inlined"_cs)) {
+        json.member("inlined_actions", metrics.inlinedActions);
+    }
+
+    if (selectedMetrics.count("compile-profile"_cs)) {
+        double milliseconds = 0.0;
+        size_t allocations = 0, allocatedBytes = 0;
+        for (const auto &pass : metrics.compileProfile) {
+            milliseconds += pass.milliseconds;
+            allocations += pass.allocations;
+            allocatedBytes += pass.allocatedBytes;
+        }
+        json.key("compile_profile").beginObject();
+        json.member("total_milliseconds", milliseconds)
+            .member("total_allocations", allocations)
+            .member("total_allocated_bytes", allocatedBytes);
+        json.key("passes").beginArray();
+        for (const auto &pass : metrics.compileProfile) {
+            json.beginObject();
+            json.key("manager").value(pass.manager);
+            json.key("pass").value(pass.pass);
+            json.member("seq_no", pass.seqNo)
+                .member("milliseconds", pass.milliseconds)
+                .member("allocations", pass.allocations)
+                .member("allocated_bytes", pass.allocatedBytes);
+            if (selectedMetrics.count("compile-profile-nodes"_cs)) {
+                json.member("nodes_before", pass.nodesBefore)
+                    .member("nodes_after", pass.nodesAfter);
+            }
+            json.endObject();
+        }
+        json.endArray();
+        // Timers started by the compiler with Util::ScopedTimer or Util::withTimer.
+        auto timers = Util::getTimers();
+        if (!timers.empty()) {
+            json.key("timers").beginArray();
+            for (const auto &timer : timers) {
+                json.beginObject();
+                json.key("name").value(timer.timerName);
+                json.member("milliseconds", timer.milliseconds)
+                    .member("invocations", timer.invocations);
+                json.endObject();
+            }
+            json.endArray();
+        }
+        json.endObject();
+    }
+
+    json.endObject();
 }
 
 }  // namespace P4
@@ -1,20 +1,23 @@
 /*
 Exports the collected code metric values into a formatted
-text file, and a json file. The new filenames are based on the
-compiled program name (programName_metrics.txt/json).
+text file, and/or a json file. The new filenames are based on the
+compiled program name (programName_metrics.txt/json). Both files
+are streamed straight from the metrics structure, without building
+an intermediate JSON tree. Optionally, all metrics are also written
+into a binary snapshot (programName_metrics.bin). Labeled snapshots
+taken later in the pipeline add their label to the file names
+(programName_metrics-label.txt/json/bin).
 */
 
 #ifndef FRONTENDS_P4_METRICS_EXPORTMETRICS_H_
 #define FRONTENDS_P4_METRICS_EXPORTMETRICS_H_
 
-#include <cmath>
 #include <filesystem>
-#include <fstream>
-#include <iostream>
+#include <set>
 #include <string>
-#include <unordered_set>
 
 #include "frontends/p4/metrics/metricsStructure.h"
+#include "frontends/p4/metrics/metricsWriter.h"
 #include "ir/ir.h"
 #include "lib/json.h"
 
@@ -27,14 +30,35 @@ class ExportMetricsPass : public Inspector {
     std::filesystem::path filename;
     std::set<cstring> selectedMetrics;
     Metrics &metrics;
+    bool exportText;
+    bool exportJson;
+    bool exportSnapshot;
+    cstring label;
+
+    void writeText(MetricsOutputFile &textFile) const;
+    bool finish(MetricsOutputFile &file) const;
 
  public:
+    /// @format selects the exported files, it is one of "txt", "json" or "both"
+    /// ("none" is used internally when the metrics are exported by the batch mode).
+    /// @snapshot adds the binary snapshot of all metrics, @label names a snapshot taken
+    /// after the frontend.
     explicit ExportMetricsPass(const std::filesystem::path &filename,
-                               std::set<cstring> selectedMetrics, Metrics &metricsRef)
-        : filename(filename), selectedMetrics(selectedMetrics), metrics(metricsRef) {
+                               std::set<cstring> selectedMetrics, Metrics &metricsRef,
+                               cstring format = "both"_cs, bool snapshot = false,
+                               cstring label = nullptr)
+        : filename(filename),
+          selectedMetrics(selectedMetrics),
+          metrics(metricsRef),
+          exportText(format != "json"),
+          exportJson(format != "txt"),
+          exportSnapshot(snapshot),
+          label(label) {
         setName("ExportMetricsPass");
     }
     bool preorder(const IR::P4Program * /*program*/) override;
+    /// Writes the selected metrics as one JSON object.
+    void writeJson(Util::JsonWriter &json) const;
 };
 
 }  // namespace P4
@@ -11,12 +11,13 @@ function call too.
 
 #include <set>
 
+#include "frontends/p4/metrics/metricsEngine.h"
 #include "frontends/p4/metrics/metricsStructure.h"
 #include "ir/ir.h"
 
 namespace P4 {
 
-class ExternalObjectsMetricPass : public Inspector {
+class ExternalObjectsMetricPass : public MetricsCollector {
  private:
     ExternMetrics &metrics;
     std::set<cstring> externFunctions;                   // Standalone extern functions.
@@ -28,6 +28,7 @@ statements in C)
 #include <unordered_set>
 #include <vector>
 
+#include "frontends/p4/metrics/metricsEngine.h"
 #include "frontends/p4/metrics/metricsStructure.h"
 #include "ir/ir.h"
 #include "lib/log.h"
@@ -36,7 +37,7 @@ using namespace P4::literals;
 
 namespace P4 {
 
-class HalsteadMetricsPass : public Inspector {
+class HalsteadMetricsPass : public MetricsCollector {
  private:
     HalsteadMetrics &metrics;
     std::unordered_set<cstring> uniqueUnaryOperators;
@@ -1,13 +1,20 @@
 #include "frontends/p4/metrics/headerMetrics.h"
 
+#include "lib/hash.h"
+
 namespace P4 {
 
-void HeaderMetricsPass::postorder(const IR::Type_Header *header) {
-    cstring headerName = header->getName();
-    metrics.numHeaders++;
-    size_t numFields = 0;
-    size_t sizeSum = 0;
+uint64_t HeaderMetricsPass::fieldTypesHash(const IR::Type_Header *header) const {
+    uint64_t hash = header->fields.size();
+    for (auto field : header->fields) {
+        const IR::Type *type = typeMap->getType(field->type, true);
+        hash = Util::hash_combine(hash, Util::Hash{}(type->toString()));
+    }
+    return hash;
+}
 
+void HeaderMetricsPass::measureFields(const IR::Type_Header *header, size_t &numFields,
+                                      size_t &sizeSum) const {
     for (auto field : header->fields) {
         numFields++;
         const IR::Type *currentType = typeMap->getType(field->type, true);
@@ -28,6 +35,26 @@ void HeaderMetricsPass::postorder(const IR::Type_Header *header) {
             }
         }
     }
+}
+
+void HeaderMetricsPass::postorder(const IR::Type_Header *header) {
+    cstring headerName = header->getName();
+    metrics.numHeaders++;
+    size_t numFields = 0;
+    size_t sizeSum = 0;
+
+    CachedBlockMetrics *entry = cache ? &cache->getEntry(header, fieldTypesHash(header)) : nullptr;
+    if (entry && entry->fieldsNum && entry->fieldSizeSum) {
+        numFields = *entry->fieldsNum;
+        sizeSum = *entry->fieldSizeSum;
+    } else {
+        measureFields(header, numFields, sizeSum);
+        if (entry) {
+            entry->fieldsNum = numFields;
+            entry->fieldSizeSum = sizeSum;
+            cache->markModified();
+        }
+    }
 
     metrics.fieldsNum[headerName] = numFields;
     metrics.fieldSizeSum[headerName] = sizeSum;
@@ -7,22 +7,30 @@ its type, until the field's bit width can be extracted.
 #ifndef FRONTENDS_P4_METRICS_HEADERMETRICS_H_
 #define FRONTENDS_P4_METRICS_HEADERMETRICS_H_
 
+#include "frontends/p4/metrics/metricsCache.h"
+#include "frontends/p4/metrics/metricsEngine.h"
 #include "frontends/p4/metrics/metricsStructure.h"
 #include "frontends/p4/typeMap.h"
 #include "ir/ir.h"
 
 namespace P4 {
 
-class HeaderMetricsPass : public Inspector {
+class HeaderMetricsPass : public MetricsCollector {
  private:
     TypeMap *typeMap;
     HeaderMetrics &metrics;
+    MetricsCache *cache;
     unsigned totalFieldsNum = 0;
     unsigned totalFieldsSize = 0;
 
+    void measureFields(const IR::Type_Header *header, size_t &numFields, size_t &sizeSum) const;
+    /// Hash of the resolved field types, which are not part of the header declaration.
+    uint64_t fieldTypesHash(const IR::Type_Header *header) const;
+
  public:
-    explicit HeaderMetricsPass(TypeMap *typeMap, Metrics &metricsRef)
-        : typeMap(typeMap), metrics(metricsRef.headerMetrics) {
+    explicit HeaderMetricsPass(TypeMap *typeMap, Metrics &metricsRef,
+                               MetricsCache *cache = nullptr)
+        : typeMap(typeMap), metrics(metricsRef.headerMetrics), cache(cache) {
         setName("HeaderMetricsPass");
     }
 
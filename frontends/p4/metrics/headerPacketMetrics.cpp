@@ -18,27 +18,52 @@ cstring ParserAnalyzer::getPacketType(const IR::ParserState *state) const {
     return ""_cs;
 }
 
-void ParserAnalyzer::dfsCumulativeTypes(const IR::ParserState *state, const ParserCallGraph &pcg,
-                                        const cstring &parentType,
-                                        std::unordered_map<const IR::ParserState *, cstring> &types,
-                                        std::unordered_set<const IR::ParserState *> &currentPath) {
-    // If this state was already visited on the current path, stop.
-    if (!currentPath.insert(state).second) return;
-
-    cstring extract = getPacketType(state);
-    cstring cumulative =
-        parentType.isNullOrEmpty()
-            ? extract
-            : (extract.isNullOrEmpty() ? parentType : parentType + "-"_cs + extract);
-
-    types[state] = cumulative;
-    cumulativeTypes.insert(cumulative);
+unsigned ParserAnalyzer::extendType(unsigned parentType, const IR::ParserState *state) {
+    auto it = extracts.find(state);
+    if (it == extracts.end()) it = extracts.emplace(state, getPacketType(state)).first;
+    if (it->second.isNullOrEmpty()) return parentType;
+
+    auto [id, inserted] = typeIds.emplace(std::make_pair(parentType, it->second), 0);
+    if (inserted) {
+        id->second = packetTypes.size();
+        packetTypes.push_back({parentType, it->second});
+        reachedTypes.push_back(false);
+    }
+    return id->second;
+}
 
-    if (auto *callees = const_cast<ParserCallGraph &>(pcg).getCallees(state)) {
-        for (auto *next : *callees) dfsCumulativeTypes(next, pcg, cumulative, types, currentPath);
+void ParserAnalyzer::findLoopStates() {
+    loopStates.clear();
+    for (const auto &[state, callees] : parserCallGraph.getOutEdges()) {
+        std::set<const IR::ParserState *> reachable;
+        for (const auto *next : *callees) parserCallGraph.reachable(next, reachable);
+        if (reachable.count(state)) loopStates.insert(state);
     }
+}
 
+bool ParserAnalyzer::dfsCumulativeTypes(const IR::ParserState *state, unsigned parentType,
+                                        std::unordered_set<const IR::ParserState *> &currentPath) {
+    // If this state was already visited on the current path, stop.
+    if (currentPath.count(state)) return true;
+
+    unsigned type = extendType(parentType, state);
+    // A state outside of loops cannot reach the states on the current path, so it
+    // produces the same types every time it is reached with the same type.
+    if (!loopStates.count(state) && !expandedStates.emplace(state, type).second) return true;
+    if (++expandedPaths > maxPaths) return false;
+    reachedTypes[type] = true;
+
+    auto edges = parserCallGraph.getOutEdges().find(state);
+    if (edges == parserCallGraph.getOutEdges().end()) return true;
+
+    currentPath.insert(state);
+    bool complete = true;
+    for (const auto *next : *edges->second) {
+        complete = dfsCumulativeTypes(next, type, currentPath);
+        if (!complete) break;
+    }
     currentPath.erase(state);
+    return complete;
 }
 
 bool ParserAnalyzer::preorder(const IR::P4Parser *parser) {
@@ -47,15 +72,33 @@ bool ParserAnalyzer::preorder(const IR::P4Parser *parser) {
     parser->apply(buildGraph, getChildContext());
 
     if (auto *start = parser->getDeclByName(IR::ParserState::start)) {
-        std::unordered_map<const IR::ParserState *, cstring> types;
+        findLoopStates();
+        expandedStates.clear();
+        expandedPaths = 0;
         std::unordered_set<const IR::ParserState *> currentPath;
-        dfsCumulativeTypes(start->to<IR::ParserState>(), parserCallGraph, ""_cs, types,
-                           currentPath);
+        if (!dfsCumulativeTypes(start->to<IR::ParserState>(), 0, currentPath)) {
+            warning(ErrorType::WARN_FAILED,
+                    "%1%: more than %2% parser paths, header packet metrics are partial", parser,
+                    maxPaths);
+        }
     }
 
     return false;
 }
 
+void ParserAnalyzer::end_apply(const IR::Node *root) {
+    // Types are created after their parent type, so the parent's name is always known.
+    std::vector<cstring> names(packetTypes.size(), cstring::empty);
+    for (size_t id = 1; id < packetTypes.size(); ++id) {
+        const auto &type = packetTypes[id];
+        names[id] = type.parent == 0 ? type.extract : names[type.parent] + "-"_cs + type.extract;
+    }
+    for (size_t id = 0; id < packetTypes.size(); ++id) {
+        if (reachedTypes[id]) cumulativeTypes.insert(names[id]);
+    }
+    Inspector::end_apply(root);
+}
+
 size_t HeaderPacketMetricsPass::getHeaderFieldSize(const IR::Type *type) const {
     const IR::Type *cur = type;
     while (cur) {
@@ -81,16 +124,27 @@ size_t HeaderPacketMetricsPass::getHeaderSize(const IR::Type_Header *header) con
     return size;
 }
 
+const bitvec &HeaderPacketMetricsPass::getTypesContaining(cstring headerName) {
+    auto [it, inserted] = typesByHeader.emplace(headerName, bitvec());
+    if (inserted) {
+        for (size_t i = 0; i < sortedTypes.size(); ++i) {
+            if (sortedTypes[i].string_view().find(headerName.string_view()) != std::string::npos)
+                it->second.setbit(i);
+        }
+    }
+    return it->second;
+}
+
 void HeaderPacketMetricsPass::updateMetrics(const cstring &headerName, size_t size,
                                             bool isModification) {
-    for (const auto &packetType : cumulativeTypes) {
-        if (packetType.string().find(headerName.string()) != std::string::npos) {
-            auto &target = isModification ? metrics.headerModificationMetrics.perPacket[packetType]
-                                          : metrics.headerManipulationMetrics.perPacket[packetType];
-
-            target.numOperations++;
-            target.totalSize += size;
-        }
+    // Packet types are visited in sorted order, which fixes the order of the per-packet metrics.
+    for (int index : getTypesContaining(headerName)) {
+        cstring packetType = sortedTypes[index];
+        auto &target = isModification ? metrics.headerModificationMetrics.perPacket[packetType]
+                                      : metrics.headerManipulationMetrics.perPacket[packetType];
+
+        target.numOperations++;
+        target.totalSize += size;
     }
 
     auto &total = isModification ? metrics.headerModificationMetrics.total
@@ -101,8 +155,10 @@ void HeaderPacketMetricsPass::updateMetrics(const cstring &headerName, size_t si
 }
 
 bool HeaderPacketMetricsPass::preorder(const IR::P4Program *program) {
-    ParserAnalyzer analyzer(parserCallGraph, cumulativeTypes);
+    ParserAnalyzer analyzer(parserCallGraph, cumulativeTypes, maxParserPaths);
     program->apply(analyzer);
+    sortedTypes.assign(cumulativeTypes.begin(), cumulativeTypes.end());
+    typesByHeader.clear();
     return true;
 }
 
@@ -10,11 +10,20 @@ Only limitation is that it cannot determine packet types created
 with loops completely (it stops when the same state is encountered
 in the current path).
 
+Packet types are interned as (parent type, extracted header) pairs,
+so paths sharing a prefix share its type and extending a path does
+not copy strings. States outside of parser loops produce the same
+types whenever they are reached with the same parent type, so they
+are expanded once per type, which keeps wide select fan-outs from
+enumerating every path. The number of expanded paths is capped
+(--metrics-parser-paths); the metrics of larger parsers are partial.
+
 After the ParserAnalyzer finishes, the main pass collects the metrics
 on a global and per-packet type basis. An operation on a header type is
 added to the metrics of all packet types containing that type (so for
 hdr.ipv4.ttl = 64, the operation size will be added to both "ethernet-ipv4"
-and "ethernet-ipv4-tcp").
+and "ethernet-ipv4-tcp"). The packet types containing a header are found
+once per header name and kept in a bit set over the sorted packet types.
 */
 
 #ifndef FRONTENDS_P4_METRICS_HEADERPACKETMETRICS_H_
@@ -23,10 +32,12 @@ and "ethernet-ipv4-tcp").
 #include "frontends/common/resolveReferences/referenceMap.h"
 #include "frontends/p4/callGraph.h"
 #include "frontends/p4/methodInstance.h"
+#include "frontends/p4/metrics/metricsEngine.h"
 #include "frontends/p4/metrics/metricsStructure.h"
 #include "frontends/p4/parserCallGraph.h"
 #include "frontends/p4/typeChecking/typeChecker.h"
 #include "ir/ir.h"
+#include "lib/bitvec.h"
 
 using namespace P4::literals;
 
@@ -36,41 +47,68 @@ class HeaderPacketMetricsPass;
 
 class ParserAnalyzer : public Inspector {
  private:
+    struct PacketType {
+        unsigned parent;
+        cstring extract;
+    };
+
     ParserCallGraph &parserCallGraph;
     std::set<cstring> &cumulativeTypes;
-    std::unordered_map<cstring, size_t> stateEncounters;
+    size_t maxPaths;
+    size_t expandedPaths = 0;
+    // Interned packet types, type 0 is the empty type.
+    std::vector<PacketType> packetTypes = {{0, cstring::empty}};
+    std::vector<bool> reachedTypes = {false};
+    std::map<std::pair<unsigned, cstring>, unsigned> typeIds;
+    std::unordered_map<const IR::ParserState *, cstring> extracts;
+    std::unordered_set<const IR::ParserState *> loopStates;
+    std::set<std::pair<const IR::ParserState *, unsigned>> expandedStates;
 
     cstring getPacketType(const IR::ParserState *state) const;
-    void dfsCumulativeTypes(const IR::ParserState *state, const ParserCallGraph &pcg,
-                            const cstring &parentType,
-                            std::unordered_map<const IR::ParserState *, cstring> &types,
+    unsigned extendType(unsigned parentType, const IR::ParserState *state);
+    void findLoopStates();
+    /// Returns false if the path cap was reached.
+    bool dfsCumulativeTypes(const IR::ParserState *state, unsigned parentType,
                             std::unordered_set<const IR::ParserState *> &currentPath);
 
  public:
-    ParserAnalyzer(ParserCallGraph &graph, std::set<cstring> &types)
-        : parserCallGraph(graph), cumulativeTypes(types) {
+    static constexpr size_t defaultMaxPaths = 1000000;
+
+    ParserAnalyzer(ParserCallGraph &graph, std::set<cstring> &types,
+                   size_t maxPaths = defaultMaxPaths)
+        : parserCallGraph(graph), cumulativeTypes(types), maxPaths(maxPaths) {
         setName("ParserAnalyzer");
     }
 
     bool preorder(const IR::P4Parser *parser) override;
+    void end_apply(const IR::Node *root) override;
 };
 
-class HeaderPacketMetricsPass : public Inspector {
+class HeaderPacketMetricsPass : public MetricsCollector {
  private:
     TypeMap *typeMap;
     Metrics &metrics;
     ParserCallGraph parserCallGraph;
+    size_t maxParserPaths;
     std::set<cstring> cumulativeTypes;
+    std::vector<cstring> sortedTypes;
+    // Header name -> indices of the packet types in sortedTypes which contain it.
+    std::unordered_map<cstring, bitvec> typesByHeader;
     bool insideParserState;
     bool isValid;
 
+    const bitvec &getTypesContaining(cstring headerName);
     void updateMetrics(const cstring &headerName, size_t size, bool isModification);
     size_t getHeaderFieldSize(const IR::Type *type) const;
     size_t getHeaderSize(const IR::Type_Header *header) const;
 
  public:
-    HeaderPacketMetricsPass(TypeMap *typeMap, Metrics &metrics)
-        : typeMap(typeMap), metrics(metrics), parserCallGraph("parserCallGraph") {
+    HeaderPacketMetricsPass(TypeMap *typeMap, Metrics &metrics,
+                            size_t maxParserPaths = ParserAnalyzer::defaultMaxPaths)
+        : typeMap(typeMap),
+          metrics(metrics),
+          parserCallGraph("parserCallGraph"),
+          maxParserPaths(maxParserPaths) {
         setName("HeaderPacketMetricsPass");
     }
 
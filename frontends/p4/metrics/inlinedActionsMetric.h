@@ -7,12 +7,13 @@ counting unique action names inside of blocks with annotantions of type
 #ifndef FRONTENDS_P4_METRICS_INLINEDACTIONSMETRIC_H_
 #define FRONTENDS_P4_METRICS_INLINEDACTIONSMETRIC_H_
 
+#include "frontends/p4/metrics/metricsEngine.h"
 #include "frontends/p4/metrics/metricsStructure.h"
 #include "ir/ir.h"
 
 namespace P4 {
 
-class InlinedActionsMetricPass : public Inspector {
+class InlinedActionsMetricPass : public MetricsCollector {
  private:
     Metrics &metrics;
     std::unordered_set<cstring> actions;
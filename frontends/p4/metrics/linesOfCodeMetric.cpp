@@ -2,14 +2,32 @@
 
 namespace P4 {
 
+bool LinesOfCodeMetricPass::isCompiledFile(const Util::InputSources *inputSources,
+                                           unsigned fileId) {
+    if (inputSources != sources) {
+        sources = inputSources;
+        compiledFiles.clear();
+    }
+    // Files are only matched by name once.
+    while (compiledFiles.size() <= fileId) {
+        auto name = sources->getFileName(compiledFiles.size());
+        compiledFiles.push_back(name.string().find(sourceFile) != std::string::npos);
+    }
+    return compiledFiles[fileId];
+}
+
 void LinesOfCodeMetricPass::postorder(const IR::Node *node) {
     if (!node) return;
     auto si = node->getSourceInfo();
-    // Only count lines inside of the compiled program.
-    if (!si.isValid() || si.getSourceFile().string().find(sourceFile) == std::string::npos) return;
+    if (!si.isValid()) return;
 
-    for (unsigned L = si.getStart().getLineNumber(); L <= si.getEnd().getLineNumber(); ++L)
-        lines.insert(L);
+    const auto *inputSources = si.getInputSources();
+    for (unsigned L = si.getStart().getLineNumber(); L <= si.getEnd().getLineNumber(); ++L) {
+        auto index = inputSources->getLineIndex(L);
+        // Only count lines inside of the compiled program.
+        if (!isCompiledFile(inputSources, index.fileId)) continue;
+        lines.insert(uint64_t(index.fileId) << 32 | index.sourceLine);
+    }
 }
 
 void LinesOfCodeMetricPass::postorder(const IR::P4Program * /*program*/) {
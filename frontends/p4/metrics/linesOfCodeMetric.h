@@ -1,26 +1,36 @@
 /*
 Counts the number of "real" lines of code in the compiled program
-by inserting the numbers of lines which contain code into a set,
+by inserting the original source lines which contain code into a set,
 and retrieving it's size at the end.
 */
 
 #ifndef FRONTENDS_P4_METRICS_LINESOFCODEMETRIC_H_
 #define FRONTENDS_P4_METRICS_LINESOFCODEMETRIC_H_
 
+#include <cstdint>
 #include <filesystem>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
+#include "frontends/p4/metrics/metricsEngine.h"
 #include "frontends/p4/metrics/metricsStructure.h"
 #include "ir/ir.h"
 
 namespace P4 {
 
-class LinesOfCodeMetricPass : public Inspector {
+class LinesOfCodeMetricPass : public MetricsCollector {
  private:
     Metrics &metrics;
     std::string sourceFile;
-    std::unordered_set<unsigned> lines;
+    /// Original lines containing code, as (file id << 32 | line).
+    std::unordered_set<uint64_t> lines;
+    /// Whether the file with the given id is part of the compiled program,
+    /// for the files of the input sources seen so far.
+    const Util::InputSources *sources = nullptr;
+    std::vector<bool> compiledFiles;
+
+    bool isCompiledFile(const Util::InputSources *inputSources, unsigned fileId);
 
  public:
     explicit LinesOfCodeMetricPass(Metrics &metricsRef, std::filesystem::path sourceFile)
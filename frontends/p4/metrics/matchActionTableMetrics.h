@@ -7,13 +7,14 @@ each key field and extracting its bit width.
 #ifndef FRONTENDS_P4_METRICS_MATCHACTIONTABLEMETRICS_H_
 #define FRONTENDS_P4_METRICS_MATCHACTIONTABLEMETRICS_H_
 
+#include "frontends/p4/metrics/metricsEngine.h"
 #include "frontends/p4/metrics/metricsStructure.h"
 #include "frontends/p4/typeChecking/typeChecker.h"
 #include "ir/ir.h"
 
 namespace P4 {
 
-class MatchActionTableMetricsPass : public Inspector {
+class MatchActionTableMetricsPass : public MetricsCollector {
  private:
     unsigned keySize(const IR::KeyElement *keyElement);
     TypeMap *typeMap;
@@ -0,0 +1,215 @@
+#include "frontends/p4/metrics/metricsBatch.h"
+
+#include <glob.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "frontends/common/parseInput.h"
+#include "frontends/p4/frontend.h"
+#include "frontends/p4/metrics/exportMetrics.h"
+#include "lib/compile_context.h"
+#include "lib/error.h"
+
+namespace P4 {
+
+namespace {
+
+bool isGlobPattern(std::string_view str) { return str.find_first_of("*?[") != str.npos; }
+
+std::filesystem::path workerOutput(const std::filesystem::path &output, size_t worker) {
+    auto path = output;
+    path += "." + std::to_string(worker) + ".part";
+    return path;
+}
+
+}  // namespace
+
+MetricsBatch::MetricsBatch(const CompilerOptions &options, const std::vector<const char *> &files)
+    : options(options), archCache(options.archCacheDir, true) {
+    if (options.metricsBatch) {
+        std::string source = options.metricsBatch.string();
+        addPrograms(source, !isGlobPattern(source));
+    }
+    for (const char *file : files) addPrograms(file, false);
+}
+
+void MetricsBatch::addPrograms(const std::string &source, bool isListFile) {
+    if (isListFile) {
+        std::ifstream list(source);
+        if (!list.is_open()) {
+            error(ErrorType::ERR_IO, "Unable to open the program list %1%", source);
+            return;
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            line.erase(std::find(line.begin(), line.end(), '#'), line.end());
+            auto first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos) continue;
+            auto last = line.find_last_not_of(" \t\r");
+            addPrograms(line.substr(first, last - first + 1), false);
+        }
+        return;
+    }
+
+    if (!isGlobPattern(source)) {
+        programs.push_back(source);
+        return;
+    }
+    glob_t matches;
+    int rc = glob(source.c_str(), 0, nullptr, &matches);
+    if (rc == 0) {
+        for (size_t i = 0; i < matches.gl_pathc; ++i) programs.emplace_back(matches.gl_pathv[i]);
+    } else if (rc == GLOB_NOMATCH) {
+        warning(ErrorType::WARN_MISSING, "No programs match %1%", source);
+    } else {
+        error(ErrorType::ERR_IO, "Unable to expand %1%", source);
+    }
+    globfree(&matches);
+}
+
+void MetricsBatch::preloadIncludes() const {
+    for (const auto &program : programs) {
+        // Errors are reported when the program itself is compiled.
+        auto *context = new P4CContextWithOptions<CompilerOptions>();
+        AutoCompileContext programContext(context);
+        CompilerOptions &programOptions = context->options();
+        programOptions = options;
+        programOptions.file = program;
+        archCache.preload(programOptions);
+    }
+}
+
+void MetricsBatch::compileProgram(const std::string &program, Util::JsonWriter &json) const {
+    // A fresh context per program, so errors and metric values start from zero.
+    auto *context = new P4CContextWithOptions<CompilerOptions>();
+    AutoCompileContext programContext(context);
+    CompilerOptions &programOptions = context->options();
+    programOptions = options;
+    programOptions.file = program;
+    programOptions.metrics = Metrics();
+    // The batch runs programs in parallel, and exports the metrics itself.
+    programOptions.metricsJobs = 1;
+    programOptions.metricsFormat = "none"_cs;
+
+    const IR::P4Program *result = nullptr;
+    try {
+        result = parseP4File(programOptions, &archCache);
+        if (result != nullptr && errorCount() == 0) result = FrontEnd().run(programOptions, result);
+    } catch (const std::exception &bug) {
+        std::cerr << bug.what() << std::endl;
+        result = nullptr;
+    }
+
+    json.beginObject();
+    json.key("program").value(program);
+    if (result != nullptr && errorCount() == 0) {
+        json.key("metrics");
+        ExportMetricsPass(program, programOptions.selectedMetrics, programOptions.metrics)
+            .writeJson(json);
+    } else {
+        json.member("errors", std::max(errorCount(), 1u));
+    }
+    json.endObject();
+}
+
+bool MetricsBatch::runWorker(size_t first, size_t workers, MetricsOutputFile &out) const {
+    for (size_t i = first; i < programs.size(); i += workers) {
+        Util::JsonWriter json(out.stream(), true);
+        compileProgram(programs[i], json);
+        out << '\n';
+        // Finished records are kept even if the worker crashes on a later program.
+        out.flush();
+    }
+    return out.close();
+}
+
+bool MetricsBatch::mergeWorkerOutputs(size_t workers, MetricsOutputFile &out) const {
+    std::vector<std::ifstream> parts;
+    for (size_t worker = 0; worker < workers; ++worker)
+        parts.emplace_back(workerOutput(options.metricsBatchOutput, worker));
+
+    // Worker w compiled the programs w, w + workers, ..., one record per line.
+    bool complete = true;
+    std::string line;
+    for (size_t i = 0; i < programs.size(); ++i) {
+        auto &part = parts[i % workers];
+        if (std::getline(part, line) && !part.eof()) {
+            out << line << '\n';
+            continue;
+        }
+        // The worker died before finishing this record.
+        complete = false;
+        Util::JsonWriter json(out.stream(), true);
+        json.beginObject();
+        json.key("program").value(programs[i]);
+        json.member("crashed", true);
+        json.endObject();
+        out << '\n';
+    }
+    return complete;
+}
+
+bool MetricsBatch::run() {
+    if (options.selectedMetrics.empty()) {
+        error(ErrorType::ERR_EXPECTED, "The metrics batch mode requires --metrics");
+        return false;
+    }
+    if (programs.empty()) {
+        error(ErrorType::ERR_NOT_FOUND, "No programs found for the metrics batch");
+        return false;
+    }
+
+    const auto &outputFile = options.metricsBatchOutput;
+    MetricsOutputFile out(outputFile.string());
+    if (!out.isOpen()) {
+        error(ErrorType::ERR_IO, "Unable to open file %1%", outputFile.string());
+        return false;
+    }
+
+    preloadIncludes();
+    size_t workers = std::min<size_t>(options.metricsJobs, programs.size());
+    if (workers <= 1) {
+        if (runWorker(0, 1, out)) return true;
+        error(ErrorType::ERR_IO, "Unable to write file %1%", outputFile.string());
+        return false;
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+    std::vector<pid_t> children;
+    for (size_t worker = 0; worker < workers; ++worker) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            MetricsOutputFile part(workerOutput(outputFile, worker).string());
+            bool ok = part.isOpen() && runWorker(worker, workers, part);
+            std::cout.flush();
+            _exit(ok ? 0 : 1);
+        }
+        if (pid < 0) {
+            error(ErrorType::ERR_IO, "Unable to start a metrics batch worker");
+            break;
+        }
+        children.push_back(pid);
+    }
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+
+    bool complete = mergeWorkerOutputs(workers, out);
+    std::error_code ec;
+    for (size_t worker = 0; worker < workers; ++worker)
+        std::filesystem::remove(workerOutput(outputFile, worker), ec);
+    if (!complete) warning(ErrorType::WARN_FAILED, "Some metrics batch workers did not finish");
+    if (!out.close()) {
+        error(ErrorType::ERR_IO, "Unable to write file %1%", outputFile.string());
+        return false;
+    }
+    return children.size() == workers;
+}
+
+}  // namespace P4
@@ -0,0 +1,63 @@
+/*
+Batch mode of the code metric collection, which compiles a whole corpus
+of P4 programs in one process and writes a single JSON-lines file with
+one record per program:
+
+{"program":"a.p4","metrics":{"lines_of_code":42,...}}
+{"program":"b.p4","errors":2}
+
+The "metrics" object has the same content as the programName_metrics.json
+file exported for a single compilation. Every program is compiled in a
+fresh compilation context copied from the options of the batch, so errors
+and collected values do not leak between programs. With more than one
+job, the programs are split between forked worker processes, and the
+records are merged back in the order of the input list.
+
+The standard includes at the start of the programs are parsed once per
+batch, before the workers are started, and shared by all programs through
+an ArchitectureCache, which also uses the --arch-cache directory if given.
+*/
+
+#ifndef FRONTENDS_P4_METRICS_METRICSBATCH_H_
+#define FRONTENDS_P4_METRICS_METRICSBATCH_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "frontends/common/architectureCache.h"
+#include "frontends/common/options.h"
+#include "frontends/p4/metrics/metricsWriter.h"
+#include "lib/json.h"
+
+namespace P4 {
+
+class MetricsBatch {
+ private:
+    const CompilerOptions &options;
+    std::vector<std::string> programs;
+    ArchitectureCache archCache;
+
+    /// Adds the programs matching a glob pattern, or listed in a file (one path or pattern
+    /// per line, '#' starts a comment).
+    void addPrograms(const std::string &source, bool isListFile);
+    /// Parses the standard includes of all programs, so that the workers inherit them.
+    void preloadIncludes() const;
+    /// Compiles one program and writes its record, without the trailing newline.
+    void compileProgram(const std::string &program, Util::JsonWriter &json) const;
+    /// Compiles every workers-th program starting at @first, returns false if writing failed.
+    bool runWorker(size_t first, size_t workers, MetricsOutputFile &out) const;
+    bool mergeWorkerOutputs(size_t workers, MetricsOutputFile &out) const;
+
+ public:
+    /// @files are additional programs given on the command line.
+    MetricsBatch(const CompilerOptions &options, const std::vector<const char *> &files);
+
+    size_t size() const { return programs.size(); }
+    /// Compiles all programs and writes the output file, returns false on failure.
+    bool run();
+};
+
+}  // namespace P4
+
+#endif /* FRONTENDS_P4_METRICS_METRICSBATCH_H_ */
@@ -0,0 +1,578 @@
+#include "frontends/p4/metrics/metricsBinary.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+
+#include "frontends/p4/metrics/metricsWriter.h"
+#include "lib/error.h"
+#include "lib/exceptions.h"
+
+namespace P4 {
+
+static_assert(sizeof(MetricsSnapshotHeader) % 8 == 0, "Scalars must stay aligned");
+static_assert(sizeof(MetricsScalars) % 8 == 0, "Map descriptors must stay aligned");
+static_assert(sizeof(MetricsMapDescriptor) == 16, "Unexpected map descriptor layout");
+static_assert(sizeof(MetricsNameRef) == 2 * sizeof(uint32_t), "Unexpected name layout");
+static_assert(sizeof(MetricsPassRecord) == 64, "Unexpected pass record layout");
+
+namespace {
+
+using ValueMap = P4::ordered_map<cstring, unsigned>;
+using PacketMap = P4::ordered_map<cstring, PacketModification>;
+
+/// Metric names used by the diff, one for every column of a map.
+struct MapSpec {
+    MetricsMapId id;
+    const char *columnNames[2];
+};
+
+const MapSpec mapSpecs[] = {
+    {MetricsMapId::CyclomaticComplexity, {"cyclomatic", nullptr}},
+    {MetricsMapId::BlockNestingDepth, {"nesting-depth", nullptr}},
+    {MetricsMapId::HeaderFieldsNum, {"header-fields", nullptr}},
+    {MetricsMapId::HeaderFieldSizeSum, {"header-field-size", nullptr}},
+    {MetricsMapId::TableKeysNum, {"table-keys", nullptr}},
+    {MetricsMapId::TableActionsNum, {"table-actions", nullptr}},
+    {MetricsMapId::TableKeySizeSum, {"table-key-size", nullptr}},
+    {MetricsMapId::ParserStateComplexity, {"parser-state", nullptr}},
+    {MetricsMapId::HeaderManipulation, {"header-manipulation-ops", "header-manipulation-size"}},
+    {MetricsMapId::HeaderModification, {"header-modification-ops", "header-modification-size"}},
+};
+
+/// Program-wide values compared by the diff.
+struct ScalarSpec {
+    const char *name;
+    double (*get)(const MetricsScalars &);
+};
+
+const ScalarSpec scalarSpecs[] = {
+    {"loc", [](const MetricsScalars &s) -> double { return s.linesOfCode; }},
+    {"halstead-effort", [](const MetricsScalars &s) { return s.halsteadEffort; }},
+    {"max-nesting-depth", [](const MetricsScalars &s) -> double { return s.maxNestingDepth; }},
+    {"tables", [](const MetricsScalars &s) -> double { return s.numTables; }},
+    {"total-keys", [](const MetricsScalars &s) -> double { return s.totalKeys; }},
+    {"total-actions", [](const MetricsScalars &s) -> double { return s.totalActions; }},
+    {"parser-states", [](const MetricsScalars &s) -> double { return s.totalStates; }},
+};
+
+void storeCounts(uint32_t *out, const UnusedCodeInstances &counts) {
+    out[0] = counts.variables;
+    out[1] = counts.states;
+    out[2] = counts.enums;
+    out[3] = counts.conditionals;
+    out[4] = counts.actions;
+    out[5] = counts.functions;
+    out[6] = counts.parameters;
+    out[7] = counts.returns;
+}
+
+UnusedCodeInstances loadCounts(const uint32_t *in) {
+    UnusedCodeInstances counts;
+    counts.variables = in[0];
+    counts.states = in[1];
+    counts.enums = in[2];
+    counts.conditionals = in[3];
+    counts.actions = in[4];
+    counts.functions = in[5];
+    counts.parameters = in[6];
+    counts.returns = in[7];
+    return counts;
+}
+
+void storePackets(uint32_t *out, const HeaderPacketMetrics &packets) {
+    const PacketModification *values[] = {&packets.total, &packets.max, &packets.min};
+    for (const auto *value : values) {
+        *out++ = value->numOperations;
+        *out++ = value->totalSize;
+    }
+}
+
+void loadPackets(const uint32_t *in, HeaderPacketMetrics &packets) {
+    PacketModification *values[] = {&packets.total, &packets.max, &packets.min};
+    for (auto *value : values) {
+        value->numOperations = *in++;
+        value->totalSize = *in++;
+    }
+}
+
+MetricsScalars storeScalars(const Metrics &metrics) {
+    MetricsScalars s = {};
+    const auto &halstead = metrics.halsteadMetrics;
+    const auto &tables = metrics.matchActionTableMetrics;
+
+    s.avgNestingDepth = metrics.nestingDepth.avgNestingDepth;
+    s.halsteadDifficulty = halstead.difficulty;
+    s.halsteadVolume = halstead.volume;
+    s.halsteadEffort = halstead.effort;
+    s.halsteadDeliveredBugs = halstead.deliveredBugs;
+    s.avgFieldsNum = metrics.headerMetrics.avgFieldsNum;
+    s.avgFieldSize = metrics.headerMetrics.avgFieldSize;
+    s.avgKeySize = tables.avgKeySize;
+    s.avgKeysPerTable = tables.avgKeysPerTable;
+    s.avgActionsPerTable = tables.avgActionsPerTable;
+
+    s.linesOfCode = metrics.linesOfCode;
+    s.inlinedActions = metrics.inlinedActions;
+    storeCounts(s.unusedCodeInstances, metrics.unusedCodeInstances);
+    storeCounts(s.interPassCounts, metrics.helperVars.interPassCounts);
+    s.maxNestingDepth = metrics.nestingDepth.maxNestingDepth;
+    s.halsteadCounts[0] = halstead.uniqueOperators;
+    s.halsteadCounts[1] = halstead.uniqueOperands;
+    s.halsteadCounts[2] = halstead.totalOperators;
+    s.halsteadCounts[3] = halstead.totalOperands;
+    s.halsteadCounts[4] = halstead.vocabulary;
+    s.halsteadCounts[5] = halstead.length;
+    s.numHeaders = metrics.headerMetrics.numHeaders;
+    storePackets(s.headerManipulation, metrics.headerManipulationMetrics);
+    storePackets(s.headerModification, metrics.headerModificationMetrics);
+    s.numTables = tables.numTables;
+    s.totalKeys = tables.totalKeys;
+    s.totalKeySizeSum = tables.totalKeySizeSum;
+    s.maxKeysPerTable = tables.maxKeysPerTable;
+    s.totalActions = tables.totalActions;
+    s.maxActionsPerTable = tables.maxActionsPerTable;
+    s.totalStates = metrics.parserMetrics.totalStates;
+    s.externMetrics[0] = metrics.externMetrics.externFunctions;
+    s.externMetrics[1] = metrics.externMetrics.externStructures;
+    s.externMetrics[2] = metrics.externMetrics.externFunctionUses;
+    s.externMetrics[3] = metrics.externMetrics.externStructUses;
+    return s;
+}
+
+void loadScalars(const MetricsScalars &s, Metrics &metrics) {
+    auto &halstead = metrics.halsteadMetrics;
+    auto &tables = metrics.matchActionTableMetrics;
+
+    metrics.nestingDepth.avgNestingDepth = s.avgNestingDepth;
+    halstead.difficulty = s.halsteadDifficulty;
+    halstead.volume = s.halsteadVolume;
+    halstead.effort = s.halsteadEffort;
+    halstead.deliveredBugs = s.halsteadDeliveredBugs;
+    metrics.headerMetrics.avgFieldsNum = s.avgFieldsNum;
+    metrics.headerMetrics.avgFieldSize = s.avgFieldSize;
+    tables.avgKeySize = s.avgKeySize;
+    tables.avgKeysPerTable = s.avgKeysPerTable;
+    tables.avgActionsPerTable = s.avgActionsPerTable;
+
+    metrics.linesOfCode = s.linesOfCode;
+    metrics.inlinedActions = s.inlinedActions;
+    metrics.unusedCodeInstances = loadCounts(s.unusedCodeInstances);
+    metrics.helperVars.interPassCounts = loadCounts(s.interPassCounts);
+    metrics.nestingDepth.maxNestingDepth = s.maxNestingDepth;
+    halstead.uniqueOperators = s.halsteadCounts[0];
+    halstead.uniqueOperands = s.halsteadCounts[1];
+    halstead.totalOperators = s.halsteadCounts[2];
+    halstead.totalOperands = s.halsteadCounts[3];
+    halstead.vocabulary = s.halsteadCounts[4];
+    halstead.length = s.halsteadCounts[5];
+    metrics.headerMetrics.numHeaders = s.numHeaders;
+    loadPackets(s.headerManipulation, metrics.headerManipulationMetrics);
+    loadPackets(s.headerModification, metrics.headerModificationMetrics);
+    tables.numTables = s.numTables;
+    tables.totalKeys = s.totalKeys;
+    tables.totalKeySizeSum = s.totalKeySizeSum;
+    tables.maxKeysPerTable = s.maxKeysPerTable;
+    tables.totalActions = s.totalActions;
+    tables.maxActionsPerTable = s.maxActionsPerTable;
+    metrics.parserMetrics.totalStates = s.totalStates;
+    metrics.externMetrics.externFunctions = s.externMetrics[0];
+    metrics.externMetrics.externStructures = s.externMetrics[1];
+    metrics.externMetrics.externFunctionUses = s.externMetrics[2];
+    metrics.externMetrics.externStructUses = s.externMetrics[3];
+}
+
+/// Collects the maps and the name pool of a snapshot.
+class SnapshotBuilder {
+    struct MapData {
+        MetricsMapId id;
+        uint32_t columns;
+        uint32_t entryCount = 0;
+        std::vector<uint32_t> words;
+    };
+    std::vector<MapData> maps;
+    std::vector<MetricsPassRecord> profile;
+    std::string names;
+    std::map<cstring, MetricsNameRef> nameRefs;  // Names are shared between maps.
+
+    MetricsNameRef nameRef(cstring name) {
+        auto [it, inserted] = nameRefs.emplace(name, MetricsNameRef{});
+        if (inserted) {
+            it->second = {static_cast<uint32_t>(names.size()),
+                          static_cast<uint32_t>(name.size())};
+            names += name.string_view();
+        }
+        return it->second;
+    }
+
+    void addName(std::vector<uint32_t> &words, cstring name) {
+        auto ref = nameRef(name);
+        words.push_back(ref.offset);
+        words.push_back(ref.length);
+    }
+
+ public:
+    void add(const std::vector<PassProfile> &passes) {
+        for (const auto &pass : passes) {
+            MetricsPassRecord record = {};
+            record.manager = nameRef(pass.manager);
+            record.pass = nameRef(pass.pass);
+            record.seqNo = pass.seqNo;
+            record.milliseconds = pass.milliseconds;
+            record.allocations = pass.allocations;
+            record.allocatedBytes = pass.allocatedBytes;
+            record.nodesBefore = pass.nodesBefore;
+            record.nodesAfter = pass.nodesAfter;
+            profile.push_back(record);
+        }
+    }
+
+    void add(MetricsMapId id, const ValueMap &values) {
+        auto &map = maps.emplace_back(MapData{id, 1, 0, {}});
+        for (const auto &[name, value] : values) {
+            addName(map.words, name);
+            map.words.push_back(value);
+            map.entryCount++;
+        }
+    }
+
+    void add(MetricsMapId id, const PacketMap &packets) {
+        auto &map = maps.emplace_back(MapData{id, 2, 0, {}});
+        for (const auto &[name, value] : packets) {
+            addName(map.words, name);
+            map.words.push_back(value.numOperations);
+            map.words.push_back(value.totalSize);
+            map.entryCount++;
+        }
+    }
+
+    std::string build(const MetricsScalars &scalars) const {
+        MetricsSnapshotHeader header = {};
+        std::memcpy(header.magic, MetricsSnapshotHeader::expectedMagic, sizeof(header.magic));
+        header.version = MetricsSnapshotHeader::currentVersion;
+        header.byteOrder = MetricsSnapshotHeader::byteOrderMark;
+        header.scalarsOffset = sizeof(header);
+        header.scalarsSize = sizeof(scalars);
+        header.mapsOffset = header.scalarsOffset + header.scalarsSize;
+        header.mapCount = maps.size();
+
+        std::vector<MetricsMapDescriptor> descriptors;
+        uint32_t offset = header.mapsOffset + maps.size() * sizeof(MetricsMapDescriptor);
+        for (const auto &map : maps) {
+            descriptors.push_back({map.id, map.columns, map.entryCount, offset});
+            offset += map.words.size() * sizeof(uint32_t);
+        }
+        // Pass records hold 64-bit values.
+        uint32_t padding = (alignof(MetricsPassRecord) - offset % alignof(MetricsPassRecord)) %
+                           alignof(MetricsPassRecord);
+        header.profileOffset = offset + padding;
+        header.profileCount = profile.size();
+        offset = header.profileOffset + profile.size() * sizeof(MetricsPassRecord);
+        header.namesOffset = offset;
+        header.namesSize = names.size();
+        header.fileSize = offset + names.size();
+
+        std::string data;
+        data.reserve(header.fileSize);
+        data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+        data.append(reinterpret_cast<const char *>(&scalars), sizeof(scalars));
+        data.append(reinterpret_cast<const char *>(descriptors.data()),
+                    descriptors.size() * sizeof(MetricsMapDescriptor));
+        for (const auto &map : maps) {
+            data.append(reinterpret_cast<const char *>(map.words.data()),
+                        map.words.size() * sizeof(uint32_t));
+        }
+        data.append(padding, '\0');
+        data.append(reinterpret_cast<const char *>(profile.data()),
+                    profile.size() * sizeof(MetricsPassRecord));
+        data += names;
+        return data;
+    }
+};
+
+template <typename Map>
+void loadMap(const MetricsSnapshot::Map &from, Map &to) {
+    for (size_t i = 0; i < from.size(); ++i) {
+        auto entry = from.at(i);
+        to[cstring(entry.name())] = entry.value();
+    }
+}
+
+void loadMap(const MetricsSnapshot::Map &from, PacketMap &to) {
+    if (from.columns() < 2) return;
+    for (size_t i = 0; i < from.size(); ++i) {
+        auto entry = from.at(i);
+        to[cstring(entry.name())] = {entry.value(0), entry.value(1)};
+    }
+}
+
+/// Returns true if a value present in both snapshots grew past the threshold.
+bool isRegression(double oldValue, double newValue, double thresholdPercent) {
+    if (newValue <= oldValue) return false;
+    if (oldValue == 0) return true;
+    return (newValue - oldValue) * 100 / oldValue > thresholdPercent;
+}
+
+}  // namespace
+
+bool writeMetricsSnapshot(const Metrics &metrics, const std::string &path) {
+    SnapshotBuilder builder;
+    builder.add(MetricsMapId::CyclomaticComplexity, metrics.cyclomaticComplexity);
+    builder.add(MetricsMapId::BlockNestingDepth, metrics.nestingDepth.blockNestingDepth);
+    builder.add(MetricsMapId::HeaderFieldsNum, metrics.headerMetrics.fieldsNum);
+    builder.add(MetricsMapId::HeaderFieldSizeSum, metrics.headerMetrics.fieldSizeSum);
+    builder.add(MetricsMapId::TableKeysNum, metrics.matchActionTableMetrics.keysNum);
+    builder.add(MetricsMapId::TableActionsNum, metrics.matchActionTableMetrics.actionsNum);
+    builder.add(MetricsMapId::TableKeySizeSum, metrics.matchActionTableMetrics.keySizeSum);
+    builder.add(MetricsMapId::ParserStateComplexity, metrics.parserMetrics.StateComplexity);
+    builder.add(MetricsMapId::HeaderManipulation, metrics.headerManipulationMetrics.perPacket);
+    builder.add(MetricsMapId::HeaderModification, metrics.headerModificationMetrics.perPacket);
+    builder.add(metrics.compileProfile);
+
+    MetricsOutputFile file(path);
+    if (!file.isOpen()) return false;
+    std::string data = builder.build(storeScalars(metrics));
+    file << std::string_view(data);
+    return file.close();
+}
+
+bool MetricsSnapshot::open(const std::string &snapshotPath) {
+    close();
+    path = snapshotPath;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error(ErrorType::ERR_IO, "Unable to open metrics snapshot %1%", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(MetricsSnapshotHeader))) {
+        ::close(fd);
+        error(ErrorType::ERR_INVALID, "%1% is not a metrics snapshot", path);
+        return false;
+    }
+    void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        error(ErrorType::ERR_IO, "Unable to map metrics snapshot %1%", path);
+        return false;
+    }
+    data = static_cast<const char *>(mapped);
+    size = st.st_size;
+    if (!validate()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MetricsSnapshot::close() {
+    if (data) munmap(const_cast<char *>(data), size);
+    data = nullptr;
+    size = 0;
+}
+
+bool MetricsSnapshot::validate() {
+    const auto &h = header();
+    if (std::memcmp(h.magic, MetricsSnapshotHeader::expectedMagic, sizeof(h.magic)) != 0) {
+        error(ErrorType::ERR_INVALID, "%1% is not a metrics snapshot", path);
+        return false;
+    }
+    if (h.byteOrder != MetricsSnapshotHeader::byteOrderMark) {
+        error(ErrorType::ERR_INVALID,
+              "Metrics snapshot %1% was written with a different byte order", path);
+        return false;
+    }
+    if (h.version != MetricsSnapshotHeader::currentVersion) {
+        error(ErrorType::ERR_INVALID, "Unsupported version %1% of metrics snapshot %2%", h.version,
+              path);
+        return false;
+    }
+
+    // Sections must lie within the file and keep their alignment.
+    auto inFile = [this](uint64_t offset, uint64_t length) { return offset + length <= size; };
+    // The same for @count items of @itemSize bytes, without overflowing the multiplication.
+    auto itemsInFile = [this](uint64_t offset, uint64_t count, uint64_t itemSize) {
+        return offset <= size && count <= (size - offset) / itemSize;
+    };
+    auto nameInPool = [&h](const MetricsNameRef &ref) {
+        return uint64_t(ref.offset) + ref.length <= h.namesSize;
+    };
+    bool valid = h.fileSize == size && h.scalarsOffset % alignof(MetricsScalars) == 0 &&
+                 h.scalarsSize >= sizeof(MetricsScalars) &&
+                 inFile(h.scalarsOffset, h.scalarsSize) &&
+                 h.mapsOffset % alignof(MetricsMapDescriptor) == 0 &&
+                 itemsInFile(h.mapsOffset, h.mapCount, sizeof(MetricsMapDescriptor)) &&
+                 h.profileOffset % alignof(MetricsPassRecord) == 0 &&
+                 itemsInFile(h.profileOffset, h.profileCount, sizeof(MetricsPassRecord)) &&
+                 inFile(h.namesOffset, h.namesSize);
+    for (uint32_t i = 0; valid && i < h.mapCount; ++i) {
+        const auto &map = reinterpret_cast<const MetricsMapDescriptor *>(data + h.mapsOffset)[i];
+        // Every entry has a name and at least one value.
+        uint64_t entryWords = 2 + uint64_t(map.columns);
+        valid = map.columns > 0 && map.entriesOffset % alignof(uint32_t) == 0 &&
+                itemsInFile(map.entriesOffset, map.entryCount, entryWords * sizeof(uint32_t));
+        const auto *words = reinterpret_cast<const uint32_t *>(data + map.entriesOffset);
+        for (uint32_t e = 0; valid && e < map.entryCount; ++e, words += entryWords) {
+            valid = nameInPool({words[0], words[1]});
+        }
+    }
+    for (uint32_t i = 0; valid && i < h.profileCount; ++i) {
+        const auto &pass = profileBegin()[i];
+        valid = nameInPool(pass.manager) && nameInPool(pass.pass);
+    }
+    if (!valid) error(ErrorType::ERR_INVALID, "Metrics snapshot %1% is corrupted", path);
+    return valid;
+}
+
+MetricsSnapshot::Map MetricsSnapshot::map(MetricsMapId id) const {
+    const auto &h = header();
+    const auto *maps = reinterpret_cast<const MetricsMapDescriptor *>(data + h.mapsOffset);
+    for (uint32_t i = 0; i < h.mapCount; ++i) {
+        if (maps[i].id == id) return Map(this, &maps[i]);
+    }
+    return Map();
+}
+
+MetricsSnapshot::Entry MetricsSnapshot::Map::at(size_t index) const {
+    BUG_CHECK(index < size(), "Metrics snapshot entry %1% out of range", index);
+    const auto *words =
+        reinterpret_cast<const uint32_t *>(snapshot->data + descriptor->entriesOffset);
+    return Entry(snapshot, words + index * (2 + descriptor->columns));
+}
+
+std::string_view MetricsSnapshot::Entry::name() const {
+    return snapshot->name({words[0], words[1]});
+}
+
+Metrics MetricsSnapshot::toMetrics() const {
+    Metrics metrics;
+    loadScalars(scalars(), metrics);
+    loadMap(map(MetricsMapId::CyclomaticComplexity), metrics.cyclomaticComplexity);
+    loadMap(map(MetricsMapId::BlockNestingDepth), metrics.nestingDepth.blockNestingDepth);
+    loadMap(map(MetricsMapId::HeaderFieldsNum), metrics.headerMetrics.fieldsNum);
+    loadMap(map(MetricsMapId::HeaderFieldSizeSum), metrics.headerMetrics.fieldSizeSum);
+    loadMap(map(MetricsMapId::TableKeysNum), metrics.matchActionTableMetrics.keysNum);
+    loadMap(map(MetricsMapId::TableActionsNum), metrics.matchActionTableMetrics.actionsNum);
+    loadMap(map(MetricsMapId::TableKeySizeSum), metrics.matchActionTableMetrics.keySizeSum);
+    loadMap(map(MetricsMapId::ParserStateComplexity), metrics.parserMetrics.StateComplexity);
+    loadMap(map(MetricsMapId::HeaderManipulation), metrics.headerManipulationMetrics.perPacket);
+    loadMap(map(MetricsMapId::HeaderModification), metrics.headerModificationMetrics.perPacket);
+    for (const auto *record = profileBegin(); record != profileEnd(); ++record) {
+        PassProfile pass;
+        pass.manager = cstring(name(record->manager));
+        pass.pass = cstring(name(record->pass));
+        pass.seqNo = record->seqNo;
+        pass.milliseconds = record->milliseconds;
+        pass.allocations = record->allocations;
+        pass.allocatedBytes = record->allocatedBytes;
+        pass.nodesBefore = record->nodesBefore;
+        pass.nodesAfter = record->nodesAfter;
+        metrics.compileProfile.push_back(pass);
+    }
+    return metrics;
+}
+
+std::vector<MetricsChange> diffMetricsSnapshots(const MetricsSnapshot &before,
+                                                const MetricsSnapshot &after,
+                                                double thresholdPercent) {
+    std::vector<MetricsChange> changes;
+
+    for (const auto &spec : scalarSpecs) {
+        double oldValue = spec.get(before.scalars());
+        double newValue = spec.get(after.scalars());
+        if (oldValue == newValue) continue;
+        MetricsChange change;
+        change.metric = spec.name;
+        change.oldValue = oldValue;
+        change.newValue = newValue;
+        change.regression = isRegression(oldValue, newValue, thresholdPercent);
+        changes.push_back(std::move(change));
+    }
+
+    for (const auto &spec : mapSpecs) {
+        auto oldMap = before.map(spec.id);
+        auto newMap = after.map(spec.id);
+        std::unordered_map<std::string_view, size_t> oldIndex;
+        for (size_t i = 0; i < oldMap.size(); ++i) oldIndex.emplace(oldMap.at(i).name(), i);
+
+        for (size_t column = 0; column < 2 && spec.columnNames[column]; ++column) {
+            bool inOld = column < oldMap.columns();
+            bool inNew = column < newMap.columns();
+            std::vector<bool> matched(oldMap.size());
+
+            for (size_t i = 0; inNew && i < newMap.size(); ++i) {
+                auto entry = newMap.at(i);
+                MetricsChange change;
+                change.metric = spec.columnNames[column];
+                change.name = std::string(entry.name());
+                change.newValue = entry.value(column);
+                auto it = oldIndex.find(entry.name());
+                if (it == oldIndex.end() || !inOld) {
+                    change.added = true;
+                } else {
+                    matched[it->second] = true;
+                    change.oldValue = oldMap.at(it->second).value(column);
+                    if (change.oldValue == change.newValue) continue;
+                    change.regression =
+                        isRegression(change.oldValue, change.newValue, thresholdPercent);
+                }
+                changes.push_back(std::move(change));
+            }
+
+            for (size_t i = 0; inOld && i < oldMap.size(); ++i) {
+                if (matched[i]) continue;
+                auto entry = oldMap.at(i);
+                MetricsChange change;
+                change.metric = spec.columnNames[column];
+                change.name = std::string(entry.name());
+                change.oldValue = entry.value(column);
+                change.removed = true;
+                changes.push_back(std::move(change));
+            }
+        }
+    }
+    return changes;
+}
+
+int runMetricsDiff(const std::vector<const char *> &files, double thresholdPercent) {
+    if (files.size() != 2) {
+        error(ErrorType::ERR_INVALID, "--metrics-diff expects two metrics snapshots, got %1%",
+              files.size());
+        return 2;
+    }
+    MetricsSnapshot before, after;
+    if (!before.open(files[0]) || !after.open(files[1])) return 2;
+
+    unsigned regressions = 0;
+    for (const auto &change : diffMetricsSnapshots(before, after, thresholdPercent)) {
+        std::cout << change.metric;
+        if (!change.name.empty()) std::cout << ' ' << change.name;
+        std::cout << ": ";
+        if (change.added) {
+            std::cout << "added (" << change.newValue << ")";
+        } else if (change.removed) {
+            std::cout << "removed (" << change.oldValue << ")";
+        } else {
+            std::cout << change.oldValue << " -> " << change.newValue;
+            if (change.oldValue != 0) {
+                double percent = (change.newValue - change.oldValue) * 100 / change.oldValue;
+                std::cout << " (" << (percent > 0 ? "+" : "") << percent << "%)";
+            }
+        }
+        if (change.regression) {
+            std::cout << " REGRESSION";
+            regressions++;
+        }
+        std::cout << '\n';
+    }
+    std::cout << regressions << " regression(s) past " << thresholdPercent << "%" << std::endl;
+    return regressions == 0 ? 0 : 1;
+}
+
+}  // namespace P4
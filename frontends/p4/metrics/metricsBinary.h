@@ -0,0 +1,211 @@
+/*
+Compact binary snapshot of the collected code metrics, and a diff of
+two snapshots which reports the blocks and tables whose metrics grew.
+
+A snapshot consists of a fixed header, a record with every scalar
+metric value, a table of map descriptors and the map entries, the
+compile profile records, followed by a pool with the names of all
+entries. All offsets are relative to
+the start of the file and aligned, so a snapshot can be memory-mapped
+and read in place. The maps are identified by MetricsMapId, so readers
+ignore maps they do not know and report missing maps as empty.
+
+The inter-pass name lists of UnusedCodeHelperVars are scratch data
+of the unused code pass and are not stored, only its counts are.
+*/
+
+#ifndef FRONTENDS_P4_METRICS_METRICSBINARY_H_
+#define FRONTENDS_P4_METRICS_METRICSBINARY_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "frontends/p4/metrics/metricsStructure.h"
+
+namespace P4 {
+
+enum class MetricsMapId : uint32_t {
+    CyclomaticComplexity = 1,  // Block name -> complexity.
+    BlockNestingDepth,         // Block name -> depth.
+    HeaderFieldsNum,           // Header name -> number of fields.
+    HeaderFieldSizeSum,        // Header name -> size of fields.
+    TableKeysNum,              // Table name -> number of keys.
+    TableActionsNum,           // Table name -> number of actions.
+    TableKeySizeSum,           // Table name -> size of keys.
+    ParserStateComplexity,     // State name -> complexity.
+    HeaderManipulation,        // Packet type -> operations, size.
+    HeaderModification,        // Packet type -> operations, size.
+};
+
+struct MetricsSnapshotHeader {
+    static constexpr char expectedMagic[4] = {'P', '4', 'M', 'B'};
+    static constexpr uint32_t currentVersion = 2;
+    static constexpr uint32_t byteOrderMark = 0x01020304;
+
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;  // byteOrderMark, as written by the producer.
+    uint32_t fileSize;
+    uint32_t scalarsOffset;
+    uint32_t scalarsSize;
+    uint32_t mapsOffset;  // Array of MetricsMapDescriptor.
+    uint32_t mapCount;
+    uint32_t namesOffset;
+    uint32_t namesSize;
+    uint32_t profileOffset;  // Array of MetricsPassRecord, in the order the passes ran.
+    uint32_t profileCount;
+};
+
+struct MetricsMapDescriptor {
+    MetricsMapId id;
+    uint32_t columns;  // Values stored in every entry.
+    uint32_t entryCount;
+    uint32_t entriesOffset;  // Entries of a MetricsNameRef followed by the column values.
+};
+
+/// Names are stored as an offset into the name pool followed by the length.
+struct MetricsNameRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+/// One PassProfile of the compile profile.
+struct MetricsPassRecord {
+    MetricsNameRef manager;
+    MetricsNameRef pass;
+    uint32_t seqNo;
+    uint32_t reserved;
+    double milliseconds;
+    uint64_t allocations;
+    uint64_t allocatedBytes;
+    uint64_t nodesBefore;
+    uint64_t nodesAfter;
+};
+
+/// Every scalar metric value. Fields are only appended in new versions.
+struct MetricsScalars {
+    double avgNestingDepth;
+    double halsteadDifficulty;
+    double halsteadVolume;
+    double halsteadEffort;
+    double halsteadDeliveredBugs;
+    double avgFieldsNum;
+    double avgFieldSize;
+    double avgKeySize;
+    double avgKeysPerTable;
+    double avgActionsPerTable;
+
+    uint32_t linesOfCode;
+    uint32_t inlinedActions;
+    uint32_t unusedCodeInstances[8];  // In the order of UnusedCodeInstances.
+    uint32_t interPassCounts[8];
+    uint32_t maxNestingDepth;
+    uint32_t halsteadCounts[6];  // Unique/total operators and operands, vocabulary, length.
+    uint32_t numHeaders;
+    uint32_t headerManipulation[6];  // Total, max and min operations and size.
+    uint32_t headerModification[6];
+    uint32_t numTables;
+    uint32_t totalKeys;
+    uint32_t totalKeySizeSum;
+    uint32_t maxKeysPerTable;
+    uint32_t totalActions;
+    uint32_t maxActionsPerTable;
+    uint32_t totalStates;
+    uint32_t externMetrics[4];  // In the order of ExternMetrics.
+    uint32_t reserved;
+};
+
+/// Writes @metrics into a binary snapshot. Returns false if the file could not be written.
+bool writeMetricsSnapshot(const Metrics &metrics, const std::string &path);
+
+/// Read-only view of a memory-mapped snapshot.
+class MetricsSnapshot {
+ private:
+    const char *data = nullptr;
+    size_t size = 0;
+    std::string path;
+
+    bool validate();
+
+ public:
+    class Entry {
+        const MetricsSnapshot *snapshot;
+        const uint32_t *words;
+
+     public:
+        Entry(const MetricsSnapshot *snapshot, const uint32_t *words)
+            : snapshot(snapshot), words(words) {}
+        std::string_view name() const;
+        uint32_t value(size_t column = 0) const { return words[2 + column]; }
+    };
+
+    class Map {
+        const MetricsSnapshot *snapshot = nullptr;
+        const MetricsMapDescriptor *descriptor = nullptr;
+
+     public:
+        Map() = default;
+        Map(const MetricsSnapshot *snapshot, const MetricsMapDescriptor *descriptor)
+            : snapshot(snapshot), descriptor(descriptor) {}
+        size_t size() const { return descriptor ? descriptor->entryCount : 0; }
+        size_t columns() const { return descriptor ? descriptor->columns : 0; }
+        Entry at(size_t index) const;
+    };
+
+    MetricsSnapshot() = default;
+    ~MetricsSnapshot() { close(); }
+    MetricsSnapshot(const MetricsSnapshot &) = delete;
+    MetricsSnapshot &operator=(const MetricsSnapshot &) = delete;
+
+    /// Maps the snapshot in @path into memory, reports an error if it is not a valid snapshot.
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+    const std::string &getPath() const { return path; }
+
+    const MetricsSnapshotHeader &header() const {
+        return *reinterpret_cast<const MetricsSnapshotHeader *>(data);
+    }
+    const MetricsScalars &scalars() const {
+        return *reinterpret_cast<const MetricsScalars *>(data + header().scalarsOffset);
+    }
+    /// Returns the map with the given id, which is empty if the snapshot does not contain it.
+    Map map(MetricsMapId id) const;
+    /// Returns a name of the name pool.
+    std::string_view name(const MetricsNameRef &ref) const {
+        return std::string_view(data + header().namesOffset + ref.offset, ref.length);
+    }
+    const MetricsPassRecord *profileBegin() const {
+        return reinterpret_cast<const MetricsPassRecord *>(data + header().profileOffset);
+    }
+    const MetricsPassRecord *profileEnd() const { return profileBegin() + header().profileCount; }
+
+    /// Copies the snapshot back into the metrics structure.
+    Metrics toMetrics() const;
+};
+
+struct MetricsChange {
+    std::string metric;  // For example "cyclomatic" or "table-keys".
+    std::string name;    // Block, table, header or state name; empty for program totals.
+    double oldValue = 0;
+    double newValue = 0;
+    bool added = false;
+    bool removed = false;
+    bool regression = false;
+};
+
+/// Compares two snapshots and returns every changed value. Values which grew by more
+/// than @thresholdPercent percent (or from zero) are marked as regressions.
+std::vector<MetricsChange> diffMetricsSnapshots(const MetricsSnapshot &before,
+                                                const MetricsSnapshot &after,
+                                                double thresholdPercent);
+
+/// Diffs the snapshots in @files (old, new) and prints the changes to stdout.
+/// Returns 0 if there is no regression, 1 otherwise, or 2 if a snapshot is not readable.
+int runMetricsDiff(const std::vector<const char *> &files, double thresholdPercent);
+
+}  // namespace P4
+
+#endif /* FRONTENDS_P4_METRICS_METRICSBINARY_H_ */
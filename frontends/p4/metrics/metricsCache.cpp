@@ -0,0 +1,200 @@
+#include "frontends/p4/metrics/metricsCache.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "lib/hash.h"
+#include "lib/log.h"
+
+namespace P4 {
+
+namespace {
+
+constexpr const char *cacheHeader = "p4c-metrics-cache";
+
+void readValue(std::istream &in, std::optional<unsigned> &value) {
+    std::string token;
+    in >> token;
+    if (token.empty() || token == "-") return;
+    value = static_cast<unsigned>(std::stoul(token));
+}
+
+void writeValue(std::ostream &out, const std::optional<unsigned> &value) {
+    out << ' ';
+    if (value)
+        out << *value;
+    else
+        out << '-';
+}
+
+void mergeValue(std::optional<unsigned> &value, const std::optional<unsigned> &other) {
+    if (!value) value = other;
+}
+
+/// Hashes the node types, names and literal values of a subtree, in traversal
+/// order. Node ids and source positions are not part of the hash.
+class StructuralHash : public Inspector {
+    uint64_t value = 0;
+
+    void mix(uint64_t data) { value = Util::hash_combine(value, data); }
+    void mix(cstring text) { mix(Util::hash(text.c_str(), text.size())); }
+    void mix(const std::string &text) { mix(Util::hash(text.data(), text.size())); }
+
+ public:
+    StructuralHash() {
+        setName("StructuralHash");
+        // A shared subtree counts at every place where it is used.
+        visitDagOnce = false;
+    }
+    uint64_t result() const { return value; }
+
+    bool preorder(const IR::Node *node) override {
+        mix(node->node_type_name());
+        if (const auto *declaration = node->to<IR::IDeclaration>())
+            mix(declaration->getName().name);
+        if (const auto *path = node->to<IR::Path>()) {
+            mix(path->name.name);
+            mix(static_cast<uint64_t>(path->absolute));
+        } else if (const auto *member = node->to<IR::Member>()) {
+            mix(member->member.name);
+        } else if (const auto *constant = node->to<IR::Constant>()) {
+            mix(constant->value.str());
+        } else if (const auto *boolean = node->to<IR::BoolLiteral>()) {
+            mix(static_cast<uint64_t>(boolean->value));
+        } else if (const auto *string = node->to<IR::StringLiteral>()) {
+            mix(string->value);
+        } else if (const auto *bits = node->to<IR::Type_Bits>()) {
+            mix(static_cast<uint64_t>(bits->size));
+            mix(static_cast<uint64_t>(bits->isSigned));
+        } else if (const auto *parameter = node->to<IR::Parameter>()) {
+            mix(static_cast<uint64_t>(parameter->direction));
+        } else if (const auto *annotation = node->to<IR::Annotation>()) {
+            mix(annotation->name.name);
+        }
+        return true;
+    }
+    // Closes the children of a node, so that different tree shapes hash differently.
+    void postorder(const IR::Node *) override { mix(uint64_t(0)); }
+};
+
+/// Reads the entries of a cache file into @p entries. Returns false if the file
+/// does not exist or has an unknown format.
+bool readEntries(const std::filesystem::path &file,
+                 std::map<uint64_t, CachedBlockMetrics> &entries) {
+    std::ifstream in(file);
+    if (!in.is_open()) return false;
+
+    std::string header;
+    unsigned version = 0;
+    in >> header >> version;
+    if (header != cacheHeader || version != MetricsCache::formatVersion) {
+        LOG1("Ignoring metrics cache " << file << " with an unknown format");
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        std::istringstream fields(line);
+        uint64_t key = 0;
+        if (!(fields >> std::hex >> key)) continue;
+        fields >> std::dec;
+        auto &entry = entries[key];
+        try {
+            readValue(fields, entry.cyclomaticComplexity);
+            readValue(fields, entry.nestingDepth);
+            readValue(fields, entry.fieldsNum);
+            readValue(fields, entry.fieldSizeSum);
+        } catch (const std::exception &) {
+            // Drop corrupted entries, they are recomputed.
+            entries.erase(key);
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+void MetricsCache::load() {
+    if (readEntries(cacheFile, entries))
+        LOG1("Loaded " << entries.size() << " entries from metrics cache " << cacheFile);
+}
+
+uint64_t MetricsCache::getKey(const IR::Node *declaration, uint64_t salt) {
+    auto it = keys.find(declaration);
+    if (it == keys.end()) {
+        StructuralHash hash;
+        declaration->apply(hash);
+        it = keys.emplace(declaration, hash.result()).first;
+    }
+    return salt == 0 ? it->second : Util::hash_combine(it->second, salt);
+}
+
+void MetricsCache::save() {
+    if (!modified) return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheFile.parent_path(), ec);
+
+    // Compilations sharing the cache save one at a time, and each of them merges
+    // the entries saved by the others since it loaded the cache.
+    auto lockFile = cacheFile;
+    lockFile += ".lock";
+    int lock = ::open(lockFile.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (lock < 0 || ::flock(lock, LOCK_EX) != 0) {
+        warning(ErrorType::WARN_FAILED, "Unable to lock metrics cache %1%", lockFile.string());
+        if (lock >= 0) ::close(lock);
+        return;
+    }
+    std::map<uint64_t, CachedBlockMetrics> saved;
+    readEntries(cacheFile, saved);
+    for (const auto &[key, other] : saved) {
+        auto &entry = entries[key];
+        mergeValue(entry.cyclomaticComplexity, other.cyclomaticComplexity);
+        mergeValue(entry.nestingDepth, other.nestingDepth);
+        mergeValue(entry.fieldsNum, other.fieldsNum);
+        mergeValue(entry.fieldSizeSum, other.fieldSizeSum);
+    }
+    writeEntries();
+    // Closing the file releases the lock.
+    ::close(lock);
+}
+
+void MetricsCache::writeEntries() {
+    std::error_code ec;
+    // Write into a temporary file first, so readers never see a partial cache.
+    auto tmpFile = cacheFile;
+    tmpFile += "." + std::to_string(::getpid()) + ".tmp";
+    {
+        std::ofstream out(tmpFile);
+        if (!out.is_open()) {
+            warning(ErrorType::WARN_FAILED, "Unable to write metrics cache %1%", tmpFile.string());
+            return;
+        }
+        out << cacheHeader << ' ' << formatVersion << '\n';
+        for (const auto &[key, entry] : entries) {
+            out << std::hex << key << std::dec;
+            writeValue(out, entry.cyclomaticComplexity);
+            writeValue(out, entry.nestingDepth);
+            writeValue(out, entry.fieldsNum);
+            writeValue(out, entry.fieldSizeSum);
+            out << '\n';
+        }
+    }
+
+    std::filesystem::rename(tmpFile, cacheFile, ec);
+    if (ec) {
+        warning(ErrorType::WARN_FAILED, "Unable to write metrics cache %1%: %2%",
+                cacheFile.string(), ec.message());
+        std::filesystem::remove(tmpFile, ec);
+        return;
+    }
+    modified = false;
+}
+
+}  // namespace P4
@@ -0,0 +1,77 @@
+/*
+On-disk cache of per-declaration metric values, which allows the
+metric collectors to skip declarations that were already analyzed,
+either earlier in the same compilation or by a previous compilation
+of a program sharing the same declaration.
+
+Entries are keyed by a structural hash of the declaration (controls,
+parsers, functions and headers), computed from the node types, names and
+literal values of its IR after the frontend, so the key does not depend
+on node ids or source positions. Only metrics which are fully determined by the declaration
+itself are cached: cyclomatic complexity, nesting depth and header
+field counts and sizes. Values which depend on other parts of the
+program (such as resolved field widths) are mixed into the key by the
+collector through the "salt" argument.
+
+The cache file is a plain text file with one entry per line. It is
+replaced atomically, so it can be loaded at any time, and saved under a
+lock on a separate file, merging the entries other compilations saved in
+the meantime.
+*/
+
+#ifndef FRONTENDS_P4_METRICS_METRICSCACHE_H_
+#define FRONTENDS_P4_METRICS_METRICSCACHE_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <unordered_map>
+
+#include "ir/ir.h"
+
+namespace P4 {
+
+struct CachedBlockMetrics {
+    std::optional<unsigned> cyclomaticComplexity;
+    std::optional<unsigned> nestingDepth;
+    std::optional<unsigned> fieldsNum;
+    std::optional<unsigned> fieldSizeSum;
+};
+
+class MetricsCache {
+ private:
+    std::filesystem::path cacheFile;
+    std::map<uint64_t, CachedBlockMetrics> entries;  // Ordered for a stable file layout.
+    std::unordered_map<const IR::Node *, uint64_t> keys;
+    bool modified = false;
+
+    void load();
+    void writeEntries();
+
+ public:
+    static constexpr const char *fileName = "p4c_metrics.cache";
+    static constexpr unsigned formatVersion = 1;
+
+    explicit MetricsCache(const std::filesystem::path &cacheDir)
+        : cacheFile(cacheDir / fileName) {
+        load();
+    }
+
+    /// Structural hash of a declaration, combined with @salt.
+    uint64_t getKey(const IR::Node *declaration, uint64_t salt = 0);
+    /// Returns the entry of the declaration, which is empty if it was not cached yet.
+    /// Callers which fill in missing values must call markModified().
+    CachedBlockMetrics &getEntry(const IR::Node *declaration, uint64_t salt = 0) {
+        return entries[getKey(declaration, salt)];
+    }
+    void markModified() { modified = true; }
+    size_t size() const { return entries.size(); }
+
+    /// Merges the new values into the cache on disk, if any were added.
+    void save();
+};
+
+}  // namespace P4
+
+#endif /* FRONTENDS_P4_METRICS_METRICSCACHE_H_ */
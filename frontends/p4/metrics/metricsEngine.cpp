@@ -0,0 +1,132 @@
+#include "frontends/p4/metrics/metricsEngine.h"
+
+#include "lib/work_stealing.h"
+
+namespace P4 {
+
+void MetricsCollector::runBlockTask(std::function<void()> task) {
+    if (host && host->jobs > 1)
+        host->blockTasks.push_back(std::move(task));
+    else
+        task();
+}
+
+void MetricsCollector::visit(const IR::Node *node, const char *name) {
+    if (host)
+        host->visitFor(this, node, name);
+    else
+        Inspector::visit(node, name);
+}
+
+void MetricsEngine::visitFor(const MetricsCollector *collector, const IR::Node *node,
+                             const char *name) {
+    size_t index = 0;
+    while (collectors[index].collector != collector) ++index;
+    // The engine context stays on the node whose preorder function is running,
+    // exactly as the collector's own context would.
+    size_t saved = focus;
+    focus = index;
+    Inspector::visit(node, name);
+    focus = saved;
+}
+
+void MetricsEngine::runBlockTasks() {
+    // Errors are rethrown on this thread in task order.
+    auto tasks = std::move(blockTasks);
+    blockTasks.clear();
+    Util::runWorkStealing(tasks.size(), jobs, [&](size_t task, unsigned) { tasks[task](); });
+}
+
+void MetricsEngine::addCollector(MetricsCollector *collector) {
+    CHECK_NULL(collector);
+    BUG_CHECK(collectors.size() < maxCollectors, "Too many metric collectors");
+    collector->host = this;
+    collectors.push_back({collector});
+}
+
+Visitor::profile_t MetricsEngine::init_apply(const IR::Node *root) {
+    auto rv = Inspector::init_apply(root);
+    visitedBy.clear();
+    blockTasks.clear();
+    collectorProfiles.clear();
+    collectorProfiles.reserve(collectors.size());
+    for (auto &slot : collectors) {
+        slot.prunedAt = nullptr;
+        collectorProfiles.push_back(slot.collector->init_apply(root));
+    }
+    return rv;
+}
+
+void MetricsEngine::end_apply(const IR::Node *root) {
+    runBlockTasks();
+    for (auto &slot : collectors) slot.collector->end_apply(root);
+    Inspector::end_apply(root);
+}
+
+void MetricsEngine::end_apply() {
+    // Destroying the profiles ends the collectors' traversals as well.
+    collectorProfiles.clear();
+    visitedBy.clear();
+    blockTasks.clear();
+    Inspector::end_apply();
+}
+
+bool MetricsEngine::preorder(const IR::Node *node) {
+    if (focus != noFocus) {
+        uint64_t bit = uint64_t(1) << focus;
+        uint64_t &visited = visitedBy[node];
+        if ((visited & bit) != 0) return false;
+        visited |= bit;
+        return node->apply_visitor_preorder(*collectors[focus].collector);
+    }
+
+    // Collectors may insert nested nodes into visitedBy, so the node's entry is
+    // updated once all of them ran. A node never occurs below itself.
+    const uint64_t visited = visitedBy[node];
+    uint64_t visiting = 0;
+    bool anyActive = false;
+
+    for (size_t i = 0; i < collectors.size(); ++i) {
+        auto &slot = collectors[i];
+        if (slot.prunedAt) continue;
+
+        uint64_t bit = uint64_t(1) << i;
+        // Skip shared nodes the collector has already seen, as its own traversal would.
+        if ((visited & bit) != 0) {
+            slot.prunedAt = node;
+            continue;
+        }
+        visiting |= bit;
+
+        if (!node->apply_visitor_preorder(*slot.collector)) {
+            slot.prunedAt = node;
+            continue;
+        }
+        anyActive = true;
+    }
+    visitedBy[node] |= visiting;
+
+    if (!anyActive) {
+        // postorder() will not be called for this node, release the collectors here.
+        for (auto &slot : collectors) {
+            if (slot.prunedAt == node) slot.prunedAt = nullptr;
+        }
+    }
+    return anyActive;
+}
+
+void MetricsEngine::postorder(const IR::Node *node) {
+    if (focus != noFocus) {
+        node->apply_visitor_postorder(*collectors[focus].collector);
+        return;
+    }
+    for (auto &slot : collectors) {
+        if (slot.prunedAt == node) {
+            slot.prunedAt = nullptr;
+        } else if (!slot.prunedAt) {
+            node->apply_visitor_postorder(*slot.collector);
+        }
+    }
+}
+
+}  // namespace P4
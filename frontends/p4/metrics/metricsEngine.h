@@ -0,0 +1,104 @@
+/*
+Runs several code metric collectors on a single traversal of the program.
+Every collector is an ordinary Inspector, which can also be applied on its
+own. When hosted by the MetricsEngine, the engine forwards the preorder and
+postorder calls of each visited node to all collectors which are still
+interested in the current subtree, so the program is only walked once no
+matter how many metrics were selected.
+
+Each collector keeps the semantics it would have when applied separately:
+a collector returning false from a preorder function stops receiving calls
+for that subtree, and every collector visits a node shared in the IR DAG
+only once. The traversal context is shared, and collectors have to access
+it through MetricsCollector::context(). A collector may still walk a child
+of the current node by hand with visit(); the engine then forwards that
+subtree to this collector alone.
+
+Collectors can hand independent per-block computations (for example the
+cyclomatic complexity of one control) to runBlockTask(). The engine runs
+these tasks after the traversal on a pool of worker threads, and calls
+end_apply() of the collectors once all of them finished. Each task writes
+only to its own result slot, which the collector reserved in traversal
+order, so the merged results do not depend on the number of threads.
+*/
+
+#ifndef FRONTENDS_P4_METRICS_METRICSENGINE_H_
+#define FRONTENDS_P4_METRICS_METRICSENGINE_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "ir/ir.h"
+#include "lib/hash.h"
+
+namespace P4 {
+
+class MetricsEngine;
+
+class MetricsCollector : public Inspector {
+    MetricsEngine *host = nullptr;
+    friend class MetricsEngine;
+
+ protected:
+    /// Visitor holding the current traversal context, which is the engine
+    /// if the collector is hosted by one, or the collector itself otherwise.
+    const Visitor &context() const;
+    /// Visits a child of the current node from a preorder function, like
+    /// Inspector::visit(), whether or not the collector is hosted.
+    void visit(const IR::Node *node, const char *name = nullptr);
+    /// Runs a computation which only reads the IR and writes state owned by the task.
+    /// The task may be deferred to a worker thread, but it always finishes before
+    /// end_apply(root) of the collector is called.
+    void runBlockTask(std::function<void()> task);
+};
+
+class MetricsEngine : public Inspector {
+ private:
+    struct CollectorSlot {
+        MetricsCollector *collector;
+        // Root of the subtree pruned by the collector, nullptr if it is active.
+        const IR::Node *prunedAt = nullptr;
+    };
+    std::vector<CollectorSlot> collectors;
+    std::vector<profile_t> collectorProfiles;
+    // Node -> bitmask of collectors which have already visited it.
+    absl::flat_hash_map<const IR::Node *, uint64_t, Util::Hash> visitedBy;
+    unsigned jobs;
+    std::vector<std::function<void()>> blockTasks;  // Deferred in traversal order.
+    // Collector walking a subtree with MetricsCollector::visit(), noFocus otherwise.
+    static constexpr size_t noFocus = SIZE_MAX;
+    size_t focus = noFocus;
+
+    friend class MetricsCollector;
+    void runBlockTasks();
+    void visitFor(const MetricsCollector *collector, const IR::Node *node, const char *name);
+
+ public:
+    static constexpr size_t maxCollectors = 64;
+
+    explicit MetricsEngine(unsigned jobs = 1) : jobs(jobs) {
+        setName("MetricsEngine");
+        // Shared nodes are filtered per collector in preorder().
+        visitDagOnce = false;
+    }
+
+    void addCollector(MetricsCollector *collector);
+    bool empty() const { return collectors.empty(); }
+
+    profile_t init_apply(const IR::Node *root) override;
+    void end_apply(const IR::Node *root) override;
+    void end_apply() override;
+    bool preorder(const IR::Node *node) override;
+    void postorder(const IR::Node *node) override;
+};
+
+inline const Visitor &MetricsCollector::context() const {
+    if (host) return *host;
+    return *this;
+}
+
+}  // namespace P4
+
+#endif /* FRONTENDS_P4_METRICS_METRICSENGINE_H_ */
@@ -1,8 +1,14 @@
 #include "frontends/p4/metrics/metricsPassManager.h"
 
+#include <cstring>
+
+#include "absl/strings/str_format.h"
+#include "lib/nullstream.h"
+
 namespace P4 {
 
 void MetricsPassManager::addInlined(PassManager &pm) {
+    const auto &selectedMetrics = settings->selectedMetrics;
     if (selectedMetrics.find("inlined"_cs) != selectedMetrics.end() ||
         selectedMetrics.find("unused-code"_cs) != selectedMetrics.end()) {
         // This pass is necessary for determining the correct unused code values for actions.
@@ -11,33 +17,155 @@ void MetricsPassManager::addInlined(PassManager &pm) {
 }
 
 void MetricsPassManager::addUnusedCode(PassManager &pm, bool isBefore) {
-    if (selectedMetrics.count("unused-code"_cs)) {
+    if (settings->selectedMetrics.count("unused-code"_cs)) {
         pm.addPasses({new UnusedCodeMetricPass(metrics, isBefore)});
     }
 }
 
+namespace {
+
+// Metrics comparing the program before and after frontend optimizations are not snapshotted.
+const std::set<cstring> programMetrics = {"loc"_cs,
+                                          "cyclomatic"_cs,
+                                          "halstead"_cs,
+                                          "nesting-depth"_cs,
+                                          "header-general"_cs,
+                                          "header-manipulation"_cs,
+                                          "header-modification"_cs,
+                                          "match-action"_cs,
+                                          "parser"_cs,
+                                          "extern"_cs};
+
+/// Infers the types of @program into @typeMap in a compilation context of its own, so
+/// that diagnostics do not reach the user or count as errors of the compilation.
+/// Returns false if the program does not type check.
+bool inferTypes(const IR::Node *program, TypeMap &typeMap) {
+    P4CContextWithOptions<CompilerOptions> context;
+    static_cast<ParserOptions &>(context.options()) = P4CContext::get().options();
+    nullstream discarded;
+    context.errorReporter().setOutputStream(&discarded);
+    AutoCompileContext inference(&context);
+    try {
+        // Read-only, the program is not modified.
+        program->apply(TypeChecking(nullptr, &typeMap));
+    } catch (const Util::P4CExceptionBase &) {
+        return false;
+    }
+    return context.errorReporter().getErrorCount() == 0;
+}
+
+}  // namespace
+
+void MetricsPassManager::Settings::addCollectors(MetricsEngine &engine,
+                                                 const std::set<cstring> &metricNames,
+                                                 Metrics &target, TypeMap *targetTypeMap,
+                                                 MetricsCache *cache) const {
+    auto selected = [&](cstring metric) {
+        return metricNames.count(metric) != 0 && selectedMetrics.count(metric) != 0;
+    };
+    if (selected("loc"_cs)) engine.addCollector(new LinesOfCodeMetricPass(target, fileName));
+    if (selected("cyclomatic"_cs))
+        engine.addCollector(new CyclomaticComplexityPass(target, cache));
+    if (selected("halstead"_cs)) engine.addCollector(new HalsteadMetricsPass(target));
+    if (selected("nesting-depth"_cs))
+        engine.addCollector(new NestingDepthMetricPass(target, cache));
+    if (selected("header-general"_cs))
+        engine.addCollector(new HeaderMetricsPass(targetTypeMap, target, cache));
+    if (selected("match-action"_cs))
+        engine.addCollector(new MatchActionTableMetricsPass(targetTypeMap, target));
+    if (selected("parser"_cs)) engine.addCollector(new ParserMetricsPass(target));
+    if (selected("extern"_cs)) engine.addCollector(new ExternalObjectsMetricPass(target));
+
+    if (selected("header-manipulation"_cs) || selected("header-modification"_cs)) {
+        engine.addCollector(new HeaderPacketMetricsPass(targetTypeMap, target, parserPaths));
+    }
+}
+
 void MetricsPassManager::addMetricPasses(PassManager &pm) {
-    if (selectedMetrics.count("loc"_cs))
-        pm.addPasses({new LinesOfCodeMetricPass(metrics, fileName)});
-    if (selectedMetrics.count("cyclomatic"_cs))
-        pm.addPasses({new CyclomaticComplexityPass(metrics)});
-    if (selectedMetrics.count("halstead"_cs)) pm.addPasses({new HalsteadMetricsPass(metrics)});
-    if (selectedMetrics.count("nesting-depth"_cs))
-        pm.addPasses({new NestingDepthMetricPass(metrics)});
-    if (selectedMetrics.count("header-general"_cs))
-        pm.addPasses({new HeaderMetricsPass(typeMap, metrics)});
-    if (selectedMetrics.count("match-action"_cs))
-        pm.addPasses({new MatchActionTableMetricsPass(typeMap, metrics)});
-    if (selectedMetrics.count("parser"_cs)) pm.addPasses({new ParserMetricsPass(metrics)});
-    if (selectedMetrics.count("extern"_cs)) pm.addPasses({new ExternalObjectsMetricPass(metrics)});
-
-    if (selectedMetrics.find("header-manipulation"_cs) != selectedMetrics.end() ||
-        selectedMetrics.find("header-modification"_cs) != selectedMetrics.end()) {
-        pm.addPasses({new HeaderPacketMetricsPass(typeMap, metrics)});
+    const auto &selectedMetrics = settings->selectedMetrics;
+    MetricsCache *cache = nullptr;
+    if (!settings->cacheDir.empty() && !selectedMetrics.empty())
+        cache = new MetricsCache(settings->cacheDir);
+
+    // All collectors share a single traversal of the program.
+    auto *engine = new MetricsEngine(settings->jobs);
+    settings->addCollectors(*engine, programMetrics, metrics, typeMap, cache);
+
+    if (!engine->empty()) pm.addPasses({engine});
+    if (cache) pm.addPasses({new VisitFunctor([cache]() { cache->save(); })});
+
+    if (!selectedMetrics.empty() && settings->format != "none") {
+        pm.addPasses({new ExportMetricsPass(settings->fileName, selectedMetrics, metrics,
+                                            settings->format, settings->snapshot)});
     }
+}
+
+void MetricsPassManager::Settings::collectSnapshot(const IR::Node *program, cstring label) const {
+    if (program == nullptr || !program->is<IR::P4Program>() || format == "none") return;
+    if (::P4::errorCount() > 0) return;
 
-    if (!selectedMetrics.empty()) {
-        pm.addPasses({new ExportMetricsPass(fileName, selectedMetrics, metrics)});
+    std::set<cstring> snapshotMetrics;
+    for (auto metric : selectedMetrics) {
+        if (programMetrics.count(metric)) snapshotMetrics.insert(metric);
     }
+    if (snapshotMetrics.empty()) return;
+
+    // Types of the program at this point, the pipeline's own type map may be stale.
+    // Midend and backend passes may leave programs which the frontend type checker
+    // rejects; such a snapshot is skipped rather than failing a valid compilation.
+    TypeMap snapshotTypeMap;
+    if (!inferTypes(program, snapshotTypeMap)) return;
+
+    Metrics snapshotMetricValues;
+    MetricsEngine engine(jobs);
+    addCollectors(engine, snapshotMetrics, snapshotMetricValues, &snapshotTypeMap, nullptr);
+    program->apply(engine);
+
+    // Numbered in the order they are taken, like the --top4 dumps.
+    auto &count = P4CContext::get().options().metricsSnapshotCount;
+    cstring numberedLabel = absl::StrFormat("%04u-%s", ++count, label.c_str());
+    program->apply(ExportMetricsPass(fileName, snapshotMetrics, snapshotMetricValues, format,
+                                     snapshot, numberedLabel));
+}
+
+void MetricsPassManager::addSnapshot(PassManager &pm, cstring label) {
+    pm.addPasses({new VisitFunctor([settings = settings, label](const IR::Node *program) {
+        settings->collectSnapshot(program, label);
+        return program;
+    })});
 }
+
+DebugHook MetricsPassManager::getSnapshotHook() const {
+    return [settings = settings](const char * /*manager*/, unsigned /*seqNo*/, const char *pass,
+                                 const IR::Node *node) {
+        for (auto substring : settings->afterPasses) {
+            if (strstr(pass, substring.c_str()) != nullptr) {
+                settings->collectSnapshot(node, cstring(pass));
+                return;
+            }
+        }
+    };
+}
+
+DebugHook MetricsPassManager::getProfileHook(const IR::Node *program) {
+    if (!settings->selectedMetrics.count("compile-profile"_cs)) {
+        return [](const char *, unsigned, const char *, const IR::Node *) {};
+    }
+    // The profiler lives as long as the hook.
+    auto profiler = std::make_shared<CompileProfiler>(
+        metrics.compileProfile, settings->selectedMetrics.count("compile-profile-nodes"_cs) != 0);
+    profiler->start(program);
+    return [profiler](const char *manager, unsigned seqNo, const char *pass,
+                      const IR::Node *node) { profiler->afterPass(manager, seqNo, pass, node); };
+}
+
+void MetricsPassManager::exportCompileProfile(const IR::Node *program) {
+    const auto &selectedMetrics = settings->selectedMetrics;
+    if (program == nullptr || !selectedMetrics.count("compile-profile"_cs) ||
+        settings->format == "none")
+        return;
+    program->apply(ExportMetricsPass(settings->fileName, selectedMetrics, metrics,
+                                     settings->format, settings->snapshot));
+}
+
 }  // namespace P4
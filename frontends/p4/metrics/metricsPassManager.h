@@ -1,16 +1,34 @@
 /*
 Adds code metric collection passes to the frontend pipeline,
-based on the "selectedMetrics" option. If any metrics were
-selected by the user, the pass which exports them is added
-as well.
+based on the "selectedMetrics" option. The collectors added by
+addMetricPasses are hosted by a single MetricsEngine, so they
+share one traversal of the program. If any metrics were selected
+by the user, the pass which exports them is added as well.
+
+Labeled snapshots of the metrics can be taken at any later point
+of a pass pipeline, for example in a midend or a backend, either
+by adding a snapshot pass, or through a debug hook which takes a
+snapshot after every pass selected by --metrics-after. Snapshots
+contain the metrics which only depend on the current program (not
+unused-code and inlined), and are exported into their own files
+(programName_metrics-NNNN-label.json/txt/bin).
+
+The "compile-profile" metric records the cost of the passes of every
+pipeline the profile hook is attached to. Pipelines which run after
+the frontend export all metrics again once they finish, so the files
+contain the profile of all passes which ran so far.
 */
 
 #ifndef FRONTENDS_P4_METRICS_METRICSPASSMANAGER_H_
 #define FRONTENDS_P4_METRICS_METRICSPASSMANAGER_H_
 
 #include <filesystem>
+#include <memory>
+#include <set>
+#include <vector>
 
 #include "frontends/common/options.h"
+#include "frontends/p4/metrics/compileProfile.h"
 #include "frontends/p4/metrics/cyclomaticComplexity.h"
 #include "frontends/p4/metrics/exportMetrics.h"
 #include "frontends/p4/metrics/externalObjectsMetric.h"
@@ -20,36 +38,76 @@ as well.
 #include "frontends/p4/metrics/inlinedActionsMetric.h"
 #include "frontends/p4/metrics/linesOfCodeMetric.h"
 #include "frontends/p4/metrics/matchActionTableMetrics.h"
+#include "frontends/p4/metrics/metricsCache.h"
+#include "frontends/p4/metrics/metricsEngine.h"
 #include "frontends/p4/metrics/metricsStructure.h"
 #include "frontends/p4/metrics/nestingDepthMetric.h"
 #include "frontends/p4/metrics/parserMetrics.h"
 #include "frontends/p4/metrics/unusedCodeMetric.h"
 #include "ir/ir.h"
+#include "ir/pass_manager.h"
 
 using namespace P4::literals;
 
 namespace P4 {
 
-class PassManager;
-
 class MetricsPassManager {
  private:
-    const std::set<cstring> &selectedMetrics;
+    /// The settings of the collection. They are shared with the passes and hooks created
+    /// by this object, which may run after it is destroyed.
+    struct Settings {
+        std::set<cstring> selectedMetrics;
+        std::filesystem::path fileName;
+        std::filesystem::path cacheDir;
+        unsigned jobs;
+        cstring format;
+        bool snapshot;
+        size_t parserPaths;
+        std::vector<cstring> afterPasses;
+
+        /// Adds the collectors of the metrics in @metricNames which are selected by the user.
+        void addCollectors(MetricsEngine &engine, const std::set<cstring> &metricNames,
+                           Metrics &target, TypeMap *targetTypeMap, MetricsCache *cache) const;
+        void collectSnapshot(const IR::Node *program, cstring label) const;
+    };
+
+    std::shared_ptr<const Settings> settings;
     TypeMap *typeMap;
     Metrics &metrics;
-    std::filesystem::path fileName;
 
  public:
     MetricsPassManager(const CompilerOptions &options, TypeMap *typeMap, Metrics &metricsRef)
-        : selectedMetrics(options.selectedMetrics),
+        : settings(std::make_shared<const Settings>(
+              Settings{options.selectedMetrics, options.file, options.metricsCacheDir,
+                       options.metricsJobs, options.metricsFormat, options.metricsSnapshot,
+                       options.metricsParserPaths, options.metricsAfterPasses})),
           typeMap(typeMap),
-          metrics(metricsRef),
-          fileName(options.file) {}
+          metrics(metricsRef) {}
 
     Metrics &getMetrics() { return metrics; }
     void addInlined(PassManager &pm);
     void addUnusedCode(PassManager &pm, bool isBefore);
     void addMetricPasses(PassManager &pm);
+
+    /// Collects the metrics of @program and exports them as a snapshot labeled @label.
+    /// The types are inferred again on the side, a snapshot of a program which does not
+    /// type check any more is skipped without reporting errors.
+    void collectSnapshot(const IR::Node *program, cstring label) const {
+        settings->collectSnapshot(program, label);
+    }
+    /// Adds a pass which takes a labeled snapshot at this point of @pm.
+    void addSnapshot(PassManager &pm, cstring label);
+    /// Returns a hook which takes a snapshot after every pass whose name contains one of
+    /// the --metrics-after substrings, labeled with the pass name. Like the other metrics
+    /// hooks, it is meant to be added recursively, so that nested passes are seen too.
+    DebugHook getSnapshotHook() const;
+
+    /// Returns a hook profiling the passes applied to @program, if "compile-profile" is
+    /// selected. It must be attached right before @program is processed.
+    DebugHook getProfileHook(const IR::Node *program);
+    /// Exports all metrics again, including the profile of the passes which ran after
+    /// the frontend.
+    void exportCompileProfile(const IR::Node *program);
 };
 
 }  // namespace P4
@@ -6,7 +6,9 @@ Structure definitions used by the code metric collection passes.
 #define FRONTENDS_P4_METRICS_METRICSSTRUCTURE_H_
 
 #include <string>
+#include <vector>
 
+#include "frontends/p4/metrics/scopedNameIndex.h"
 #include "lib/cstring.h"
 #include "lib/ordered_map.h"
 
@@ -59,9 +61,10 @@ struct ExternMetrics {
 
 struct UnusedCodeHelperVars {  // Variables for storing inter-pass data.
     UnusedCodeInstances interPassCounts;
-    std::vector<cstring> beforeActions;
+    // Names collected before optimizations, matched against the names collected after them.
+    ScopedNameIndex beforeActions;
     std::vector<cstring> afterActions;
-    std::vector<cstring> beforeVariables;
+    ScopedNameIndex beforeVariables;
     std::vector<cstring> afterVariables;
 };
 
@@ -116,6 +119,17 @@ struct HeaderMetrics {
     P4::ordered_map<cstring, unsigned> fieldSizeSum;
 };
 
+struct PassProfile {  // Cost of one compiler pass.
+    cstring manager;  // Name of the pass manager running the pass.
+    cstring pass;
+    unsigned seqNo = 0;  // Position of the pass in its manager.
+    double milliseconds = 0.0;
+    size_t allocations = 0;
+    size_t allocatedBytes = 0;
+    size_t nodesBefore = 0;  // IR nodes of the program before and after the pass.
+    size_t nodesAfter = 0;
+};
+
 struct Metrics {
     unsigned linesOfCode = 0;
     unsigned inlinedActions = 0;
@@ -130,6 +144,7 @@ struct Metrics {
     ParserMetrics parserMetrics;
     P4::ordered_map<cstring, unsigned> cyclomaticComplexity;  // Function name -> CC value.
     ExternMetrics externMetrics;
+    std::vector<PassProfile> compileProfile;  // In the order the passes ran.
 };
 
 }  // namespace P4
@@ -0,0 +1,107 @@
+#include "frontends/p4/metrics/metricsWriter.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+namespace P4 {
+
+MetricsOutputFile::MetricsOutputFile(std::string path) : path(std::move(path)) {
+    fd = ::open(this->path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd >= 0) {
+        buffer.resize(bufferSize);
+        setp(buffer.data(), buffer.data() + buffer.size());
+    }
+}
+
+void MetricsOutputFile::write(const char *data, size_t size) {
+    if (fd < 0) return;
+    if (size > static_cast<size_t>(epptr() - pptr())) {
+        flush();
+        // Large writes bypass the buffer.
+        if (size > buffer.size()) {
+            while (size > 0 && !failed) {
+                ssize_t written = ::write(fd, data, size);
+                if (written < 0 && errno == EINTR) continue;
+                if (written <= 0) {
+                    failed = true;
+                    break;
+                }
+                data += written;
+                size -= written;
+            }
+            return;
+        }
+    }
+    memcpy(pptr(), data, size);
+    pbump(static_cast<int>(size));
+}
+
+void MetricsOutputFile::flush() {
+    const char *data = pbase();
+    size_t remaining = pptr() - pbase();
+    while (remaining > 0 && !failed) {
+        ssize_t written = ::write(fd, data, remaining);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) {
+            failed = true;
+            break;
+        }
+        data += written;
+        remaining -= written;
+    }
+    setp(pbase(), epptr());
+}
+
+MetricsOutputFile::int_type MetricsOutputFile::overflow(int_type c) {
+    if (fd < 0) return traits_type::eof();
+    flush();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize MetricsOutputFile::xsputn(const char *data, std::streamsize size) {
+    if (fd < 0) return 0;
+    write(data, size);
+    return size;
+}
+
+int MetricsOutputFile::sync() {
+    if (fd >= 0) flush();
+    return failed ? -1 : 0;
+}
+
+bool MetricsOutputFile::close() {
+    if (fd < 0) return !failed;
+    flush();
+    if (::close(fd) != 0) failed = true;
+    fd = -1;
+    setp(nullptr, nullptr);
+    return !failed;
+}
+
+MetricsOutputFile &MetricsOutputFile::operator<<(unsigned long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    write(digits, result.ptr - digits);
+    return *this;
+}
+
+MetricsOutputFile &MetricsOutputFile::operator<<(double value) {
+    // "%g" with the default precision of 6 digits matches the output of std::ostream.
+    char digits[32];
+    int length = snprintf(digits, sizeof(digits), "%g", value);
+    if (length > 0) write(digits, std::min<size_t>(length, sizeof(digits) - 1));
+    return *this;
+}
+
+}  // namespace P4
@@ -0,0 +1,79 @@
+/*
+Output file used to export the collected code metrics.
+MetricsOutputFile appends formatted values into a fixed-size buffer,
+which is flushed straight to a file descriptor. It is also a stream
+buffer, so the JSON exports are written through Util::JsonWriter on
+top of stream() while the metrics are being walked, and no
+intermediate JSON tree is built.
+*/
+
+#ifndef FRONTENDS_P4_METRICS_METRICSWRITER_H_
+#define FRONTENDS_P4_METRICS_METRICSWRITER_H_
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lib/cstring.h"
+
+namespace P4 {
+
+class MetricsOutputFile : public std::streambuf {
+ private:
+    static constexpr size_t bufferSize = 64 * 1024;
+
+    std::string path;
+    int fd = -1;
+    bool failed = false;
+    /// The put area of the stream buffer.
+    std::vector<char> buffer;
+    std::ostream out{this};
+
+    void write(const char *data, size_t size);
+
+ protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char *data, std::streamsize size) override;
+    int sync() override;
+
+ public:
+    explicit MetricsOutputFile(std::string path);
+    ~MetricsOutputFile() override { close(); }
+    MetricsOutputFile(const MetricsOutputFile &) = delete;
+    MetricsOutputFile &operator=(const MetricsOutputFile &) = delete;
+
+    bool isOpen() const { return fd >= 0; }
+    const std::string &getPath() const { return path; }
+    /// A stream writing into the same buffer, e.g. for Util::JsonWriter.
+    std::ostream &stream() { return out; }
+    void flush();
+    /// Flushes and closes the file, returns false if any write failed.
+    bool close();
+
+    MetricsOutputFile &operator<<(std::string_view str) {
+        write(str.data(), str.size());
+        return *this;
+    }
+    MetricsOutputFile &operator<<(const std::string &str) { return *this << std::string_view(str); }
+    MetricsOutputFile &operator<<(const char *str) { return *this << std::string_view(str); }
+    MetricsOutputFile &operator<<(cstring str) { return *this << str.string_view(); }
+    MetricsOutputFile &operator<<(char c) {
+        write(&c, 1);
+        return *this;
+    }
+    MetricsOutputFile &operator<<(unsigned long long value);
+    MetricsOutputFile &operator<<(unsigned value) {
+        return *this << static_cast<unsigned long long>(value);
+    }
+    MetricsOutputFile &operator<<(unsigned long value) {
+        return *this << static_cast<unsigned long long>(value);
+    }
+    /// Formatted like std::ostream with the default precision.
+    MetricsOutputFile &operator<<(double value);
+};
+
+}  // namespace P4
+
+#endif /* FRONTENDS_P4_METRICS_METRICSWRITER_H_ */
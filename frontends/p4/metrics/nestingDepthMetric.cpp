@@ -2,43 +2,61 @@
 
 namespace P4 {
 
-bool NestingDepthMetricPass::increment() {
+bool NestingDepthCalculator::increment() {
     currentDepth++;
-    if (currentDepth > currentMax) currentMax = currentDepth;
+    if (currentDepth > maxDepth) maxDepth = currentDepth;
     return true;
 }
 
-void NestingDepthMetricPass::decrement() {
+void NestingDepthCalculator::decrement() {
     if (currentDepth > 0) currentDepth--;
 }
 
-bool NestingDepthMetricPass::enter() {
-    currentDepth = currentMax = 0;
-    return true;
+bool NestingDepthCalculator::preorder(const IR::ParserState * /*state*/) { return increment(); }
+bool NestingDepthCalculator::preorder(const IR::SelectExpression * /*stmt*/) { return increment(); }
+bool NestingDepthCalculator::preorder(const IR::BlockStatement * /*stmt*/) { return increment(); }
+void NestingDepthCalculator::postorder(const IR::ParserState * /*state*/) { decrement(); }
+void NestingDepthCalculator::postorder(const IR::SelectExpression * /*stmt*/) { decrement(); }
+void NestingDepthCalculator::postorder(const IR::BlockStatement * /*stmt*/) { decrement(); }
+
+void NestingDepthMetricPass::measure(const IR::IDeclaration *block) {
+    // The slot is reserved here, so the map keeps the traversal order.
+    unsigned &depth = metrics.blockNestingDepth[block->getName().name];
+    const IR::Node *node = block->getNode();
+    CachedBlockMetrics *entry = cache ? &cache->getEntry(node) : nullptr;
+    if (entry && entry->nestingDepth) {
+        depth = *entry->nestingDepth;
+        return;
+    }
+    if (entry) uncached.emplace_back(&depth, entry);
+
+    runBlockTask([node, &depth]() {
+        NestingDepthCalculator calculator;
+        node->apply(calculator);
+        depth = calculator.getDepth();
+    });
 }
 
-void NestingDepthMetricPass::logDepth(const cstring name) {
-    metrics.blockNestingDepth[name] = currentMax;
+bool NestingDepthMetricPass::preorder(const IR::P4Parser *parser) {
+    measure(parser);
+    return false;
 }
 
-bool NestingDepthMetricPass::preorder(const IR::P4Parser * /*parser*/) { return enter(); }
-bool NestingDepthMetricPass::preorder(const IR::P4Control * /*control*/) { return enter(); }
-bool NestingDepthMetricPass::preorder(const IR::Function * /*function*/) { return enter(); }
-void NestingDepthMetricPass::postorder(const IR::P4Parser *parser) { logDepth(parser->name.name); }
-void NestingDepthMetricPass::postorder(const IR::P4Control *control) {
-    logDepth(control->name.name);
+bool NestingDepthMetricPass::preorder(const IR::P4Control *control) {
+    measure(control);
+    return false;
 }
-void NestingDepthMetricPass::postorder(const IR::Function *function) {
-    logDepth(function->name.name);
+
+bool NestingDepthMetricPass::preorder(const IR::Function *function) {
+    measure(function);
+    return false;
 }
-bool NestingDepthMetricPass::preorder(const IR::ParserState * /*state*/) { return increment(); }
-bool NestingDepthMetricPass::preorder(const IR::SelectExpression * /*stmt*/) { return increment(); }
-bool NestingDepthMetricPass::preorder(const IR::BlockStatement * /*stmt*/) { return increment(); }
-void NestingDepthMetricPass::postorder(const IR::ParserState * /*state*/) { decrement(); }
-void NestingDepthMetricPass::postorder(const IR::SelectExpression * /*stmt*/) { decrement(); }
-void NestingDepthMetricPass::postorder(const IR::BlockStatement * /*stmt*/) { decrement(); }
-
-void NestingDepthMetricPass::postorder(const IR::P4Program * /*program*/) {
+
+void NestingDepthMetricPass::end_apply(const IR::Node *root) {
+    for (const auto &[depth, entry] : uncached) entry->nestingDepth = *depth;
+    if (!uncached.empty()) cache->markModified();
+    uncached.clear();
+
     unsigned total = 0;
     unsigned count = 0;
     metrics.maxNestingDepth = 0;
@@ -54,6 +72,7 @@ void NestingDepthMetricPass::postorder(const IR::P4Program * /*program*/) {
     } else {
         metrics.avgNestingDepth = 0.0;
     }
+    MetricsCollector::end_apply(root);
 }
 
 }  // namespace P4
@@ -2,46 +2,63 @@
 Determines the maximum nesting depth of the compiled program,
 and of every major abstraction (controls, parsers, functions),
 by increasing/decreasing a counter when entering/exiting block
-statements, select statements and parser states.
+statements, select statements and parser states. The depth of
+each block is determined by a separate calculator, so the blocks
+can be measured on the worker threads of the MetricsEngine.
 */
 
 #ifndef FRONTENDS_P4_METRICS_NESTINGDEPTHMETRIC_H_
 #define FRONTENDS_P4_METRICS_NESTINGDEPTHMETRIC_H_
 
+#include <utility>
+#include <vector>
+
+#include "frontends/p4/metrics/metricsCache.h"
+#include "frontends/p4/metrics/metricsEngine.h"
 #include "frontends/p4/metrics/metricsStructure.h"
 #include "ir/ir.h"
 
 namespace P4 {
 
-class NestingDepthMetricPass : public Inspector {
- private:
-    NestingDepthMetrics &metrics;
-    unsigned currentDepth;
-    unsigned currentMax;
+class NestingDepthCalculator : public Inspector {
+    unsigned currentDepth = 0;
+    unsigned maxDepth = 0;
 
- public:
-    explicit NestingDepthMetricPass(Metrics &metricsRef)
-        : metrics(metricsRef.nestingDepth), currentDepth(0), currentMax(0) {
-        setName("NestingDepthPass");
-    }
     bool increment();
     void decrement();
-    void logDepth(const cstring name);
-    bool enter();
-
-    bool preorder(const IR::P4Parser * /*parser*/) override;
-    bool preorder(const IR::P4Control * /*control*/) override;
-    bool preorder(const IR::Function * /*function*/) override;
-    void postorder(const IR::P4Parser *parser) override;
-    void postorder(const IR::P4Control *control) override;
-    void postorder(const IR::Function *function) override;
+
+ public:
+    NestingDepthCalculator() { setName("NestingDepthCalculator"); }
+    unsigned getDepth() const { return maxDepth; }
+
     bool preorder(const IR::ParserState * /*state*/) override;
     bool preorder(const IR::SelectExpression * /*stmt*/) override;
     bool preorder(const IR::BlockStatement * /*stmt*/) override;
     void postorder(const IR::ParserState * /*state*/) override;
     void postorder(const IR::SelectExpression * /*stmt*/) override;
     void postorder(const IR::BlockStatement * /*stmt*/) override;
-    void postorder(const IR::P4Program * /*program*/) override;
+};
+
+class NestingDepthMetricPass : public MetricsCollector {
+ private:
+    NestingDepthMetrics &metrics;
+    MetricsCache *cache;
+    // Depths computed by block tasks, which are stored in the cache at the end.
+    std::vector<std::pair<const unsigned *, CachedBlockMetrics *>> uncached;
+
+    void measure(const IR::IDeclaration *block);
+
+ public:
+    explicit NestingDepthMetricPass(Metrics &metricsRef, MetricsCache *cache = nullptr)
+        : metrics(metricsRef.nestingDepth), cache(cache) {
+        setName("NestingDepthPass");
+    }
+
+    bool preorder(const IR::P4Parser *parser) override;
+    bool preorder(const IR::P4Control *control) override;
+    bool preorder(const IR::Function *function) override;
+    /// Calculate the program-wide values once all blocks were measured.
+    void end_apply(const IR::Node *root) override;
 };
 
 }  // namespace P4
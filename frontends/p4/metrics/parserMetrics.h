@@ -7,12 +7,13 @@ and collecting the number of states of each encountered parser
 #define FRONTENDS_P4_METRICS_PARSERMETRICS_H_
 
 #include "frontends/p4/metrics/cyclomaticComplexity.h"
+#include "frontends/p4/metrics/metricsEngine.h"
 #include "frontends/p4/metrics/metricsStructure.h"
 #include "ir/ir.h"
 
 namespace P4 {
 
-class ParserMetricsPass : public Inspector {
+class ParserMetricsPass : public MetricsCollector {
  private:
     ParserMetrics &metrics;
 
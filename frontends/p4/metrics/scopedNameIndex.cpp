@@ -0,0 +1,90 @@
+#include "frontends/p4/metrics/scopedNameIndex.h"
+
+#include <queue>
+
+#include "lib/exceptions.h"
+
+namespace P4 {
+
+unsigned ScopedNameIndex::child(unsigned node, char c) const {
+    for (const auto &[label, next] : nodes[node].children) {
+        if (label == c) return next;
+    }
+    return 0;
+}
+
+void ScopedNameIndex::insert(cstring name) {
+    BUG_CHECK(!built, "Cannot insert %1% into a name index which was already matched", name);
+    unsigned node = 0;
+    for (char c : name.string_view()) {
+        unsigned next = child(node, c);
+        if (next == 0) {
+            next = nodes.size();
+            nodes[node].children.emplace_back(c, next);
+            nodes.emplace_back();
+        }
+        node = next;
+    }
+    nodes[node].terminal = true;
+    names.push_back(name);
+    nameNodes.push_back(node);
+}
+
+void ScopedNameIndex::build() {
+    // Breadth-first traversal, so failure links of shallower nodes are always known.
+    std::queue<unsigned> pending;
+    for (const auto &entry : nodes[0].children) pending.push(entry.second);
+
+    while (!pending.empty()) {
+        unsigned node = pending.front();
+        pending.pop();
+        unsigned fail = nodes[node].fail;
+        nodes[node].output = nodes[fail].terminal ? fail : nodes[fail].output;
+
+        for (const auto &[c, next] : nodes[node].children) {
+            unsigned f = fail;
+            unsigned target = child(f, c);
+            while (f != 0 && target == 0) {
+                f = nodes[f].fail;
+                target = child(f, c);
+            }
+            nodes[next].fail = target;
+            pending.push(next);
+        }
+    }
+    built = true;
+}
+
+void ScopedNameIndex::match(std::string_view text) {
+    if (!built) build();
+    // The empty name is a substring of every name.
+    nodes[0].matched = true;
+
+    unsigned node = 0;
+    for (char c : text) {
+        unsigned next = child(node, c);
+        while (node != 0 && next == 0) {
+            node = nodes[node].fail;
+            next = child(node, c);
+        }
+        node = next;
+
+        // Mark every name ending here. A matched node has all of its outputs matched
+        // already, so each node is marked at most once.
+        unsigned out = nodes[node].terminal ? node : nodes[node].output;
+        while (out != 0 && !nodes[out].matched) {
+            nodes[out].matched = true;
+            out = nodes[out].output;
+        }
+    }
+}
+
+unsigned ScopedNameIndex::countUnmatched() const {
+    unsigned count = 0;
+    for (unsigned node : nameNodes) {
+        if (!nodes[node].matched) count++;
+    }
+    return count;
+}
+
+}  // namespace P4
@@ -0,0 +1,60 @@
+/*
+Index of scoped names (for example "MyIngress.if_12.tmp"), which
+determines which of the indexed names occur as a substring of some
+other set of names. It is used to compare the names collected before
+and after frontend optimizations, where transformed names can carry
+suffixes added by renaming passes such as UniqueNames ("tmp_0").
+
+The names are stored in a trie extended with failure links
+(Aho-Corasick automaton), so matching all names against all
+transformed names is linear in the total length of the names,
+instead of requiring a substring search for every pair of names.
+*/
+
+#ifndef FRONTENDS_P4_METRICS_SCOPEDNAMEINDEX_H_
+#define FRONTENDS_P4_METRICS_SCOPEDNAMEINDEX_H_
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "lib/cstring.h"
+
+namespace P4 {
+
+class ScopedNameIndex {
+ private:
+    struct TrieNode {
+        std::vector<std::pair<char, unsigned>> children;
+        unsigned fail = 0;
+        // Closest node on the failure path which ends an indexed name.
+        unsigned output = 0;
+        bool terminal = false;
+        bool matched = false;
+    };
+    std::vector<TrieNode> nodes = std::vector<TrieNode>(1);
+    std::vector<cstring> names;
+    std::vector<unsigned> nameNodes;  // Index of a name -> trie node ending it.
+    bool built = false;
+
+    unsigned child(unsigned node, char c) const;
+    void build();
+
+ public:
+    /// Adds a name to the index. All names have to be added before matching starts.
+    void insert(cstring name);
+    /// Marks all indexed names which occur as a substring of @text.
+    void match(std::string_view text);
+    /// Returns true if the name at position @index was found by a call to match().
+    bool isMatched(size_t index) const { return nodes[nameNodes.at(index)].matched; }
+    /// Number of indexed names (counting duplicates) which were not found by match().
+    unsigned countUnmatched() const;
+
+    const std::vector<cstring> &getNames() const { return names; }
+    size_t size() const { return names.size(); }
+    bool empty() const { return names.empty(); }
+};
+
+}  // namespace P4
+
+#endif /* FRONTENDS_P4_METRICS_SCOPEDNAMEINDEX_H_ */
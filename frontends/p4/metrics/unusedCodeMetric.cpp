@@ -45,7 +45,7 @@ bool UnusedCodeMetricPass::preorder(const IR::P4Action *action) {
         scope.empty() ? action->getName().name : scope.back() + "."_cs + action->getName().name;
 
     if (isBefore)
-        metrics.helperVars.beforeActions.push_back(scopedName);
+        metrics.helperVars.beforeActions.insert(scopedName);
     else
         metrics.helperVars.afterActions.push_back(scopedName);
 
@@ -63,7 +63,7 @@ void UnusedCodeMetricPass::postorder(const IR::Declaration_Variable *node) {
     cstring scopedName = scope.empty() ? name : scope.back() + "."_cs + name;
 
     if (isBefore)
-        metrics.helperVars.beforeVariables.push_back(scopedName);
+        metrics.helperVars.beforeVariables.insert(scopedName);
     else
         metrics.helperVars.afterVariables.push_back(scopedName);
 }
@@ -91,16 +91,14 @@ void UnusedCodeMetricPass::recordBefore() {
 void UnusedCodeMetricPass::recordAfter() {
     metrics.unusedCodeInstances = metrics.helperVars.interPassCounts - currentInstancesCount;
 
-    // Calculate the number of unused actions.
-    for (const auto &beforeAction : metrics.helperVars.beforeActions) {
-        bool found = std::any_of(
-            metrics.helperVars.afterActions.begin(), metrics.helperVars.afterActions.end(),
-            [&](const cstring &afterAction) {
-                return afterAction.string().find(beforeAction.string()) != std::string::npos;
-            });
-
-        if (!found) metrics.unusedCodeInstances.actions++;
+    // Calculate the number of unused actions, which are the original actions whose
+    // names are not contained in any of the transformed action names.
+    auto &helperVars = metrics.helperVars;
+    for (const auto &afterAction : helperVars.afterActions) {
+        helperVars.beforeActions.match(afterAction.string_view());
     }
+    metrics.unusedCodeInstances.actions += helperVars.beforeActions.countUnmatched();
+
     // Disregard actions that were inlined.
     metrics.unusedCodeInstances.actions =
         metrics.inlinedActions > metrics.unusedCodeInstances.actions
@@ -108,18 +106,14 @@ void UnusedCodeMetricPass::recordAfter() {
             : metrics.unusedCodeInstances.actions - metrics.inlinedActions;
 
     // Calculate the number of unused variables.
-    for (const auto &beforeVar : metrics.helperVars.beforeVariables) {
-        bool found =
-            std::any_of(metrics.helperVars.afterVariables.begin(),
-                        metrics.helperVars.afterVariables.end(), [&](const cstring &afterVar) {
-                            return afterVar.string().find(beforeVar.string()) != std::string::npos;
-                        });
-        if (!found) metrics.unusedCodeInstances.variables++;
+    for (const auto &afterVar : helperVars.afterVariables) {
+        helperVars.beforeVariables.match(afterVar.string_view());
     }
+    metrics.unusedCodeInstances.variables += helperVars.beforeVariables.countUnmatched();
 
     if (LOGGING(3)) {
         std::cout << "Original actions: \n";
-        for (const auto &before : metrics.helperVars.beforeActions)
+        for (const auto &before : metrics.helperVars.beforeActions.getNames())
             std::cout << " - " << before << std::endl;
 
         std::cout << "Transformed actions: \n";
@@ -127,7 +121,7 @@ void UnusedCodeMetricPass::recordAfter() {
             std::cout << " - " << after << std::endl;
 
         std::cout << "Original variables: \n";
-        for (const auto &before : metrics.helperVars.beforeVariables)
+        for (const auto &before : metrics.helperVars.beforeVariables.getNames())
             std::cout << " - " << before << std::endl;
 
         std::cout << "Transformed variables: \n";
@@ -14,6 +14,7 @@ comparing collected data from the previous run with the new data.
 #include <string>
 #include <vector>
 
+#include "frontends/p4/metrics/metricsEngine.h"
 #include "frontends/p4/metrics/metricsStructure.h"
 #include "ir/ir.h"
 #include "lib/log.h"
@@ -22,7 +23,7 @@ using namespace P4::literals;
 
 namespace P4 {
 
-class UnusedCodeMetricPass : public Inspector {
+class UnusedCodeMetricPass : public MetricsCollector {
  private:
     Metrics &metrics;
     UnusedCodeInstances currentInstancesCount;
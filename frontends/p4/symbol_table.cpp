@@ -17,6 +17,7 @@ limitations under the License.
 #include "symbol_table.h"
 
 #include <sstream>
+#include <utility>
 
 #include "lib/cstring.h"
 #include "lib/error.h"
@@ -33,6 +34,10 @@ class NamedSymbol : public ICastable {
     Namespace *parent;
     cstring name;
 
+    void serializeHeader(std::ostream &into, unsigned depth, char kind) const {
+        into << depth << ' ' << kind << ' ' << template_args << ' ' << name;
+    }
+
  public:
     NamedSymbol(cstring name, Util::SourceInfo si) : sourceInfo(si), parent(nullptr), name(name) {}
     virtual ~NamedSymbol() {}
@@ -54,6 +59,9 @@ class NamedSymbol : public ICastable {
         return typeid(*this) == typeid(*other);
     }
     virtual const Namespace *symNamespace() const;
+    /// Writes the symbol for ProgramStructure::serialize: its depth, kind, template flag and
+    /// name, followed by data specific to the kind.
+    virtual void serialize(std::ostream &into, unsigned depth) const = 0;
 
     bool template_args = false;  // does the symbol expect template args
 
@@ -105,6 +113,10 @@ class Namespace : public NamedSymbol {
         into << s;
         into << "}" << std::endl;
     }
+    /// Writes the contents of the namespace, nested one level deeper than the namespace.
+    void serialize(std::ostream &into, unsigned depth) const override {
+        for (auto it : contents) it.second->serialize(into, depth);
+    }
     void clear() { contents.clear(); }
     static const Namespace empty;
 
@@ -116,12 +128,18 @@ const Namespace *NamedSymbol::symNamespace() const { return &Namespace::empty; }
 
 class Object : public NamedSymbol {
     const Namespace *typeNamespace = &Namespace::empty;
+    cstring type;
 
  public:
-    Object(cstring name, Util::SourceInfo si) : NamedSymbol(name, si) {}
+    Object(cstring name, Util::SourceInfo si, cstring type) : NamedSymbol(name, si), type(type) {}
     cstring toString() const override { return "Object "_cs + getName(); }
     const Namespace *symNamespace() const override { return typeNamespace; }
     void setNamespace(const Namespace *ns) { typeNamespace = ns; }
+    cstring getType() const { return type; }
+    void serialize(std::ostream &into, unsigned depth) const override {
+        serializeHeader(into, depth, 'O');
+        into << ' ' << type << std::endl;
+    }
 
     DECLARE_TYPEINFO(Object, NamedSymbol);
 };
@@ -130,6 +148,10 @@ class SimpleType : public NamedSymbol {
  public:
     SimpleType(cstring name, Util::SourceInfo si) : NamedSymbol(name, si) {}
     cstring toString() const override { return "SimpleType "_cs + getName(); }
+    void serialize(std::ostream &into, unsigned depth) const override {
+        serializeHeader(into, depth, 'T');
+        into << std::endl;
+    }
 
     DECLARE_TYPEINFO(SimpleType, NamedSymbol);
 };
@@ -140,6 +162,11 @@ class ContainerType : public Namespace {
     ContainerType(cstring name, Util::SourceInfo si, bool allowDuplicates)
         : Namespace(name, si, allowDuplicates) {}
     cstring toString() const override { return "ContainerType "_cs + getName(); }
+    void serialize(std::ostream &into, unsigned depth) const override {
+        serializeHeader(into, depth, 'C');
+        into << ' ' << allowDuplicates << std::endl;
+        Namespace::serialize(into, depth + 1);
+    }
 
     DECLARE_TYPEINFO(ContainerType, Namespace);
 };
@@ -199,7 +226,7 @@ void ProgramStructure::declareObject(IR::ID id, cstring type) {
 
     LOG3("ProgramStructure: adding object " << id << " with type " << type);
     auto type_sym = lookup(type);
-    auto o = new Object(id.name, id.srcInfo);
+    auto o = new Object(id.name, id.srcInfo, type);
     if (type_sym)
         if (auto tns = type_sym->to<Namespace>()) o->setNamespace(tns);
     currentNamespace->declare(o);
@@ -283,6 +310,68 @@ cstring ProgramStructure::toString() const {
     return cstring(res.str());
 }
 
+std::string ProgramStructure::serialize() const {
+    std::stringstream res;
+    rootNamespace->serialize(res, 0);
+    return res.str();
+}
+
+bool ProgramStructure::deserialize(std::string_view symbols) {
+    std::stringstream in{std::string(symbols)};
+    // The namespaces enclosing the next symbol, indexed by depth.
+    std::vector<Namespace *> scopes = {rootNamespace};
+    std::vector<std::pair<Object *, const Namespace *>> objects;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::stringstream fields(line);
+        unsigned depth;
+        char kind;
+        bool templateArgs;
+        std::string name;
+        if (!(fields >> depth >> kind >> templateArgs >> name) || depth >= scopes.size())
+            return false;
+        scopes.resize(depth + 1);
+        auto *parent = scopes.back();
+        NamedSymbol *symbol = nullptr;
+        switch (kind) {
+            case 'O': {
+                std::string type;
+                std::getline(fields >> std::ws, type);
+                auto *o = new Object(cstring(name), Util::SourceInfo(), cstring(type));
+                objects.emplace_back(o, parent);
+                symbol = o;
+                break;
+            }
+            case 'T':
+                symbol = new SimpleType(cstring(name), Util::SourceInfo());
+                break;
+            case 'C': {
+                bool allowDuplicates;
+                if (!(fields >> allowDuplicates)) return false;
+                auto *ct = new ContainerType(cstring(name), Util::SourceInfo(), allowDuplicates);
+                ct->setParent(parent);
+                scopes.push_back(ct);
+                symbol = ct;
+                break;
+            }
+            default:
+                return false;
+        }
+        symbol->template_args = templateArgs;
+        parent->declare(symbol);
+    }
+    // Objects refer to the namespace of their type, which may be declared after them.
+    for (auto [o, parent] : objects) {
+        for (auto *ns = parent; ns != nullptr; ns = ns->getParent()) {
+            if (auto *typeSym = ns->lookup(o->getType())) {
+                if (auto *tns = typeSym->to<Namespace>()) o->setNamespace(tns);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
 void ProgramStructure::clear() {
     rootNamespace->clear();
     currentNamespace = rootNamespace;
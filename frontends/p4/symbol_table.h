@@ -22,6 +22,8 @@ limitations under the License.
 /* A very simple symbol table that recognizes types; necessary because
    the v1.2 grammar is ambiguous without type information */
 
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -85,6 +87,14 @@ class ProgramStructure final {
 
     cstring toString() const;
     void clear();
+
+    /// Writes the symbols of the root namespace, and the symbols nested in them, one per
+    /// line. Used to cache the symbols declared by the standard includes.
+    std::string serialize() const;
+
+    /// Declares the symbols written by serialize() in the root namespace. The declarations
+    /// have no source positions. Returns false if @p symbols is malformed.
+    bool deserialize(std::string_view symbols);
 };
 
 }  // namespace P4::Util
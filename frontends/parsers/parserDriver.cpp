@@ -8,6 +8,10 @@
 
 #include <boost/format.hpp>
 
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/strip.h"
+
 #include "frontends/common/constantFolding.h"
 #include "frontends/common/options.h"
 #include "frontends/parsers/p4/p4AnnotationLexer.hpp"
@@ -15,6 +19,7 @@
 #include "frontends/parsers/p4/p4parser.hpp"
 #include "frontends/parsers/v1/v1lexer.hpp"
 #include "frontends/parsers/v1/v1parser.hpp"
+#include "ir/json_loader.h"
 #include "lib/error.h"
 
 #ifdef HAVE_LIBBOOST_IOSTREAMS
@@ -175,6 +180,80 @@ P4ParserDriver::parseProgramSources(FILE *in, std::string_view sourceFile,
     return parseProgramSources(inputStream.get(), sourceFile, sourceLine);
 }
 
+/* static */ const IR::P4Program *P4ParserDriver::parse(Prelude &prelude, std::istream &in,
+                                                        std::string_view sourceFile,
+                                                        unsigned sourceLine /* = 1 */) {
+    LOG1("Parsing P4-16 program " << sourceFile);
+
+    P4ParserDriver driver;
+    if (prelude.program == nullptr && prelude.ir.empty()) {
+        std::istringstream text(prelude.text);
+        P4Lexer lexer(text);
+        if (!driver.parse(lexer, sourceFile)) return nullptr;
+        prelude.program = new IR::P4Program(driver.nodes->srcInfo, *driver.nodes);
+        prelude.symbols = driver.structure->serialize();
+    } else if (!driver.loadPrelude(prelude, sourceFile)) {
+        LOG1("Parsing the prelude of " << sourceFile << " again, it cannot be loaded");
+        prelude.program = nullptr;
+        prelude.ir.clear();
+        return parse(prelude, in, sourceFile, sourceLine);
+    }
+    driver.copyErrorDeclaration();
+
+    P4Lexer lexer(in);
+    if (!driver.parse(lexer, sourceFile, sourceLine)) return nullptr;
+    return new IR::P4Program(driver.nodes->srcInfo, *driver.nodes);
+}
+
+bool P4ParserDriver::loadPrelude(Prelude &prelude, std::string_view sourceFile) {
+    if (!structure->deserialize(prelude.symbols)) return false;
+
+    // Append the text to the sources the way the lexer does, so that the source positions of
+    // the declarations refer to the same text again.
+    sources->mapLine(sourceFile, 1);
+    std::string_view text = prelude.text;
+    while (!text.empty()) {
+        auto end = text.find('\n');
+        std::string line(text.substr(0, end));
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        sources->appendText(line.c_str());
+        // Line markers of the preprocessor: # 12 "file" or #line 12 "file".
+        std::string_view marker = line;
+        if (absl::ConsumePrefix(&marker, "# ") || absl::ConsumePrefix(&marker, "#line")) {
+            marker = absl::StripLeadingAsciiWhitespace(marker);
+            unsigned number = 0;
+            auto digits = marker.find_first_not_of("0123456789");
+            if (digits != 0 && digits != std::string_view::npos &&
+                absl::SimpleAtoi(marker.substr(0, digits), &number)) {
+                auto file = absl::StripLeadingAsciiWhitespace(marker.substr(digits));
+                if (absl::ConsumePrefix(&file, "\"")) {
+                    sources->mapLine(file.substr(0, file.find('"')), number);
+                }
+            }
+        }
+        if (end != std::string_view::npos) sources->appendText("\n");
+    }
+
+    if (prelude.program == nullptr) {
+        std::istringstream ir(prelude.ir);
+        JSONLoader loader(ir, sources);
+        if (!loader.is<JsonObject>()) return false;
+        loader >> prelude.program;
+        if (prelude.program == nullptr) return false;
+    }
+    nodes->append(prelude.program->objects);
+    return true;
+}
+
+void P4ParserDriver::copyErrorDeclaration() {
+    for (auto &node : *nodes) {
+        if (const auto *error = node->to<IR::Type_Error>()) {
+            allErrors = error->clone();
+            node = allErrors;
+        }
+    }
+}
+
 template <typename T>
 const T *P4ParserDriver::parse(P4AnnotationLexer::Type type, const Util::SourceInfo &srcInfo,
                                const IR::Vector<IR::AnnotationToken> &body) {
@@ -124,6 +124,35 @@ class P4ParserDriver final : public AbstractParserDriver {
     static std::pair<const IR::P4Program *, const Util::InputSources *> parseProgramSources(
         FILE *in, std::string_view sourceFile, unsigned sourceLine = 1);
 
+    /// The standard includes at the start of a P4-16 program, which are preprocessed and
+    /// parsed once and then shared by all programs starting with them, see ArchitectureCache.
+    struct Prelude {
+        /// The preprocessed text.
+        std::string text;
+
+        /// The declarations, once parsed or loaded. Programs parsed with the same Prelude
+        /// object share them.
+        const IR::P4Program *program = nullptr;
+
+        /// The declarations, in the JSON IR format with source positions in `text`, if they
+        /// were loaded from a cache entry.
+        std::string ir;
+
+        /// The symbols declared by the prelude, see Util::ProgramStructure::serialize.
+        std::string symbols;
+    };
+
+    /**
+     * Parse a P4-16 program which consists of @p prelude followed by @p in. If the prelude
+     * has no declarations yet, its text is parsed, and its program and symbols are filled in.
+     * Otherwise only @p in is parsed, and the declarations and symbols of the prelude are
+     * reused.
+     *
+     * @returns a P4Program object if parsing was successful, or null otherwise.
+     */
+    static const IR::P4Program *parse(Prelude &prelude, std::istream &in,
+                                      std::string_view sourceFile, unsigned sourceLine = 1);
+
     /**
      * Parses a P4-16 annotation body.
      *
@@ -220,6 +249,15 @@ class P4ParserDriver final : public AbstractParserDriver {
     const T *parse(P4AnnotationLexer::Type type, const Util::SourceInfo &srcInfo,
                    const IR::Vector<IR::AnnotationToken> &body);
 
+    /// Restores the state after parsing @p prelude, without parsing it. The declarations are
+    /// loaded from its JSON IR if it has none yet. Returns false if the prelude cannot be
+    /// loaded.
+    bool loadPrelude(Prelude &prelude, std::string_view sourceFile);
+
+    /// Makes the error declaration parsed so far immutable: later error declarations are
+    /// merged into a copy of it.
+    void copyErrorDeclaration();
+
     /// All P4 `error` declarations are merged together in the node, which is
     /// lazily created the first time we see an `error` declaration. (This node
     /// is present in @declarations as well.)
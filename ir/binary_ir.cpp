@@ -0,0 +1,357 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#include "frontends/common/constantParsing.h"
+#include "ir/binary_ir_reader.h"
+#include "ir/binary_ir_writer.h"
+#include "lib/error.h"
+#include "lib/exceptions.h"
+
+namespace P4 {
+
+static_assert(sizeof(BinaryIRHeader) % 8 == 0, "Node table must stay aligned");
+static_assert(sizeof(BinaryIRNodeEntry) == 16, "Unexpected node entry layout");
+static_assert(sizeof(BinaryIRStringRef) == 16, "Unexpected string layout");
+
+namespace {
+
+uint64_t align8(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
+
+}  // namespace
+
+uint32_t BinaryIRWriter::stringIndex(cstring s) {
+    if (s.isNull()) return 0;
+    auto [it, inserted] = stringIndices.emplace(s, strings.size());
+    if (inserted) strings.push_back(s);
+    return it->second;
+}
+
+uint32_t BinaryIRWriter::typeIndex(cstring type) {
+    auto [it, inserted] = typeIndices.emplace(type, types.size());
+    if (inserted) types.push_back(stringIndex(type));
+    return it->second;
+}
+
+uint32_t BinaryIRWriter::nodeIndex(const IR::Node *node) {
+    auto [it, inserted] = nodeIndices.emplace(node, nodes.size());
+    if (inserted) {
+        nodes.push_back(node);
+        entries.push_back({});
+        pending.push_back(it->second);
+    }
+    return it->second;
+}
+
+void BinaryIRWriter::writeNodeRef(const IR::Node *node) {
+    writeVarint(node == nullptr ? 0 : uint64_t(nodeIndex(node)) + 1);
+}
+
+void BinaryIRWriter::encodeBigInt(const big_int &v) {
+    std::string bytes;
+    if (v != 0) export_bits(big_int(abs(v)), std::back_inserter(bytes), 8);
+    writeVarint(uint64_t(bytes.size()) << 1 | (v < 0 ? 1 : 0));
+    records.append(bytes);
+}
+
+void BinaryIRWriter::encode(const bitvec &v) {
+    // The set bits, as the distances from the previous one.
+    std::vector<uint64_t> gaps;
+    int previous = -1;
+    for (int bit = v.ffs(); bit >= 0; bit = v.ffs(bit + 1)) {
+        gaps.push_back(bit - previous - 1);
+        previous = bit;
+    }
+    encode(gaps);
+}
+
+void BinaryIRWriter::encode(const UnparsedConstant *v) {
+    encode(v != nullptr);
+    if (v == nullptr) return;
+    encode(v->text);
+    encode(v->skip);
+    encode(v->base);
+    encode(v->hasWidth);
+}
+
+bool BinaryIRWriter::write(std::ostream &out, const IR::Node *root) {
+    BUG_CHECK(root != nullptr, "No IR to write");
+    records.clear();
+    entries.clear();
+    nodes.clear();
+    nodeIndices.clear();
+    pending.clear();
+    strings.assign(1, cstring());
+    stringIndices.clear();
+    types.clear();
+    typeIndices.clear();
+
+    // Records are written depth-first, so that the records of a subtree are close together.
+    nodeIndex(root);
+    while (!pending.empty()) {
+        auto index = pending.back();
+        pending.pop_back();
+        auto children = pending.size();
+        uint64_t offset = records.size();
+        nodes[index]->toBinary(*this);
+        if (dumpSourceInfo) nodes[index]->sourceInfoToBinary(*this);
+        BUG_CHECK(records.size() - offset <= UINT32_MAX, "%1%: record too large", nodes[index]);
+        entries[index] = {offset, static_cast<uint32_t>(records.size() - offset),
+                          typeIndex(nodes[index]->node_type_name())};
+        std::reverse(pending.begin() + children, pending.end());
+    }
+
+    std::string pool;
+    std::vector<BinaryIRStringRef> stringRefs;
+    for (auto s : strings) {
+        stringRefs.push_back({pool.size(), s.isNull() ? 0 : s.size()});
+        if (!s.isNull()) pool.append(s.string_view());
+    }
+
+    BinaryIRHeader header = {};
+    std::memcpy(header.magic, BinaryIRHeader::expectedMagic, sizeof(header.magic));
+    header.version = BinaryIRHeader::currentVersion;
+    header.byteOrder = BinaryIRHeader::byteOrderMark;
+    header.flags = dumpSourceInfo ? BinaryIRHeader::withSourceInfo : 0;
+    header.nodesOffset = sizeof(header);
+    header.nodeCount = entries.size();
+    header.typesOffset = header.nodesOffset + entries.size() * sizeof(BinaryIRNodeEntry);
+    header.typeCount = types.size();
+    header.stringsOffset = align8(header.typesOffset + types.size() * sizeof(uint32_t));
+    header.stringCount = stringRefs.size();
+    header.recordsOffset = header.stringsOffset + stringRefs.size() * sizeof(BinaryIRStringRef);
+    header.recordsSize = records.size();
+    header.poolOffset = header.recordsOffset + records.size();
+    header.poolSize = pool.size();
+    header.fileSize = header.poolOffset + pool.size();
+
+    auto writeSection = [&out](const void *section, size_t size) {
+        out.write(static_cast<const char *>(section), static_cast<std::streamsize>(size));
+    };
+    writeSection(&header, sizeof(header));
+    writeSection(entries.data(), entries.size() * sizeof(BinaryIRNodeEntry));
+    writeSection(types.data(), types.size() * sizeof(uint32_t));
+    static const char padding[8] = {};
+    writeSection(padding, header.stringsOffset - header.typesOffset - types.size() * 4);
+    writeSection(stringRefs.data(), stringRefs.size() * sizeof(BinaryIRStringRef));
+    writeSection(records.data(), records.size());
+    writeSection(pool.data(), pool.size());
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+bool BinaryIRReader::open(const std::string &irPath) {
+    close();
+    path = irPath;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error(ErrorType::ERR_IO, "Unable to open binary IR file %1%", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(BinaryIRHeader))) {
+        ::close(fd);
+        error(ErrorType::ERR_INVALID, "%1% is not a binary IR file", path);
+        return false;
+    }
+    void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        error(ErrorType::ERR_IO, "Unable to map binary IR file %1%", path);
+        return false;
+    }
+    data = static_cast<const char *>(mapped);
+    size = st.st_size;
+    if (!validate()) {
+        close();
+        return false;
+    }
+    const auto &h = header();
+    entries = reinterpret_cast<const BinaryIRNodeEntry *>(data + h.nodesOffset);
+    types = reinterpret_cast<const uint32_t *>(data + h.typesOffset);
+    stringRefs = reinterpret_cast<const BinaryIRStringRef *>(data + h.stringsOffset);
+    records = reinterpret_cast<const uint8_t *>(data + h.recordsOffset);
+    pool = data + h.poolOffset;
+    nodes.assign(h.nodeCount, nullptr);
+    loading.assign(h.nodeCount, false);
+    strings.assign(h.stringCount, cstring());
+    factories.assign(h.typeCount, nullptr);
+    return true;
+}
+
+void BinaryIRReader::close() {
+    if (data) munmap(const_cast<char *>(data), size);
+    data = nullptr;
+    size = 0;
+    nodes.clear();
+    loading.clear();
+    created = 0;
+    strings.clear();
+    factories.clear();
+    cursor = end = nullptr;
+    corrupted = reported = false;
+}
+
+bool BinaryIRReader::validate() {
+    const auto &h = header();
+    if (std::memcmp(h.magic, BinaryIRHeader::expectedMagic, sizeof(h.magic)) != 0) {
+        error(ErrorType::ERR_INVALID, "%1% is not a binary IR file", path);
+        return false;
+    }
+    if (h.byteOrder != BinaryIRHeader::byteOrderMark) {
+        error(ErrorType::ERR_INVALID, "Binary IR file %1% was written with a different byte order",
+              path);
+        return false;
+    }
+    if (h.version != BinaryIRHeader::currentVersion) {
+        error(ErrorType::ERR_INVALID, "Unsupported version %1% of binary IR file %2%", h.version,
+              path);
+        return false;
+    }
+
+    // Sections must lie within the file and keep their alignment. The records themselves are
+    // only checked when they are read.
+    auto inFile = [this](uint64_t offset, uint64_t count, uint64_t elementSize) {
+        return offset <= size && count <= (size - offset) / elementSize;
+    };
+    bool valid = h.fileSize == size && h.nodeCount > 0 && h.nodesOffset % 8 == 0 &&
+                 inFile(h.nodesOffset, h.nodeCount, sizeof(BinaryIRNodeEntry)) &&
+                 h.typesOffset % 4 == 0 && inFile(h.typesOffset, h.typeCount, sizeof(uint32_t)) &&
+                 h.stringsOffset % 8 == 0 && h.stringCount > 0 &&
+                 inFile(h.stringsOffset, h.stringCount, sizeof(BinaryIRStringRef)) &&
+                 inFile(h.recordsOffset, h.recordsSize, 1) && inFile(h.poolOffset, h.poolSize, 1);
+    const auto *nodeEntries = reinterpret_cast<const BinaryIRNodeEntry *>(data + h.nodesOffset);
+    for (uint64_t i = 0; valid && i < h.nodeCount; ++i) {
+        const auto &entry = nodeEntries[i];
+        valid = entry.type < h.typeCount && entry.offset <= h.recordsSize &&
+                entry.size <= h.recordsSize - entry.offset;
+    }
+    const auto *typeNames = reinterpret_cast<const uint32_t *>(data + h.typesOffset);
+    for (uint64_t i = 0; valid && i < h.typeCount; ++i) {
+        valid = typeNames[i] > 0 && typeNames[i] < h.stringCount;
+    }
+    const auto *refs = reinterpret_cast<const BinaryIRStringRef *>(data + h.stringsOffset);
+    for (uint64_t i = 0; valid && i < h.stringCount; ++i) {
+        valid = refs[i].offset <= h.poolSize && refs[i].length <= h.poolSize - refs[i].offset;
+    }
+    if (!valid) error(ErrorType::ERR_INVALID, "Binary IR file %1% is corrupted", path);
+    return valid;
+}
+
+cstring BinaryIRReader::readString() {
+    auto index = readVarint();
+    if (index == 0) return cstring();
+    if (index >= strings.size()) {
+        corrupted = true;
+        return cstring();
+    }
+    auto &s = strings[index];
+    if (s.isNull()) s = cstring(std::string_view(pool + stringRefs[index].offset,
+                                                 stringRefs[index].length));
+    return s;
+}
+
+cstring BinaryIRReader::nodeType(size_t index) {
+    BUG_CHECK(index < nodeCount(), "Node %1% is not in %2%", index, path);
+    auto &s = strings[types[entries[index].type]];
+    const auto &ref = stringRefs[types[entries[index].type]];
+    if (s.isNull()) s = cstring(std::string_view(pool + ref.offset, ref.length));
+    return s;
+}
+
+IR::Node *BinaryIRReader::readNodeRef(BinaryNodeFactoryFn fallback) {
+    auto index = readVarint();
+    if (index == 0) return nullptr;
+    return createNode(index - 1, fallback);
+}
+
+IR::Node *BinaryIRReader::createNode(uint64_t index, BinaryNodeFactoryFn fallback) {
+    if (index >= nodes.size() || loading[index]) {
+        // A reference to a node which does not exist, or to a node which contains it.
+        corrupted = true;
+        return nullptr;
+    }
+    if (nodes[index] != nullptr) return nodes[index];
+    const auto &entry = entries[index];
+    auto &factory = factories[entry.type];
+    if (factory == nullptr) {
+        if (auto it = IR::binary_unpacker_table.find(nodeType(index));
+            it != IR::binary_unpacker_table.end())
+            factory = it->second;
+        else
+            factory = fallback;
+    }
+    if (factory == nullptr) {
+        corrupted = true;
+        return nullptr;
+    }
+
+    loading[index] = true;
+    const auto *savedCursor = cursor;
+    const auto *savedEnd = end;
+    cursor = records + entry.offset;
+    end = cursor + entry.size;
+    auto *node = factory(*this);
+    if (header().flags & BinaryIRHeader::withSourceInfo) node->sourceInfoFromBinary(*this);
+    if (cursor != end) corrupted = true;
+    cursor = savedCursor;
+    end = savedEnd;
+    loading[index] = false;
+    nodes[index] = node;
+    ++created;
+    return node;
+}
+
+const IR::Node *BinaryIRReader::node(size_t index) {
+    BUG_CHECK(index < nodeCount(), "Node %1% is not in %2%", index, path);
+    const auto *result = corrupted ? nullptr : createNode(index, nullptr);
+    if (!corrupted) return result;
+    if (!reported) error(ErrorType::ERR_INVALID, "Binary IR file %1% is corrupted", path);
+    reported = true;
+    return nullptr;
+}
+
+void BinaryIRReader::decode(big_int &v) {
+    auto header = readVarint();
+    auto bytes = header >> 1;
+    if (bytes > uint64_t(end - cursor)) {
+        corrupted = true;
+        bytes = 0;
+    }
+    v = 0;
+    if (bytes > 0) import_bits(v, cursor, cursor + bytes, 8);
+    cursor += bytes;
+    if (header & 1) v = -v;
+}
+
+void BinaryIRReader::decode(bitvec &v) {
+    v.clear();
+    uint64_t bit = 0;
+    for (size_t count = loadSize(), i = 0; i < count; ++i, ++bit) {
+        bit += readVarint();
+        if (bit > UINT32_MAX) {
+            corrupted = true;
+            return;
+        }
+        v.setbit(bit);
+    }
+}
+
+void BinaryIRReader::decode(UnparsedConstant *&v) {
+    bool present = false;
+    decode(present);
+    v = nullptr;
+    if (!present) return;
+    v = new UnparsedConstant();
+    decode(v->text);
+    decode(v->skip);
+    decode(v->base);
+    decode(v->hasWidth);
+}
+
+}  // namespace P4
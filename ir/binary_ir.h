@@ -0,0 +1,68 @@
+/*
+Binary IR files, a compact alternative to the JSON dumps of --toJSON which
+can be memory-mapped and loaded lazily (see BinaryIRWriter and
+BinaryIRReader).
+
+A file consists of a fixed header, followed by the node table, the type
+table, the string table, the node records and the string pool. Every
+node reachable from the root is stored once, as a record with the fields
+written by its toBinary method. Records refer to other nodes by their
+index in the node table and to cstrings by their index in the string
+table, so nodes shared in the IR stay shared, and every string is stored
+once. The root is the first node of the table. Nodes which are inline in
+other nodes are stored within the record of the node containing them. If
+the file has source info, every node is followed by its source info,
+including the inline ones.
+
+Within the records, integers are variable-length (signed ones zigzag
+encoded), containers are stored as their size followed by the elements,
+and references are stored as the index plus one, zero meaning null.
+*/
+
+#ifndef IR_BINARY_IR_H_
+#define IR_BINARY_IR_H_
+
+#include <cstdint>
+
+namespace P4 {
+
+struct BinaryIRHeader {
+    static constexpr char expectedMagic[4] = {'P', '4', 'I', 'R'};
+    static constexpr uint32_t currentVersion = 1;
+    static constexpr uint32_t byteOrderMark = 0x01020304;
+
+    /// Set in flags if the records end with the source info of the nodes.
+    static constexpr uint32_t withSourceInfo = 1;
+
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;  // byteOrderMark, as written by the producer.
+    uint32_t flags;
+    uint64_t fileSize;
+    uint64_t nodesOffset;  // Array of BinaryIRNodeEntry.
+    uint64_t nodeCount;
+    uint64_t typesOffset;  // Array of uint32_t string indices, the node_type_name() of each type.
+    uint64_t typeCount;
+    uint64_t stringsOffset;  // Array of BinaryIRStringRef, entry 0 is the null cstring.
+    uint64_t stringCount;
+    uint64_t recordsOffset;
+    uint64_t recordsSize;
+    uint64_t poolOffset;
+    uint64_t poolSize;
+};
+
+struct BinaryIRNodeEntry {
+    uint64_t offset;  // Relative to the start of the records.
+    uint32_t size;
+    uint32_t type;  // Index in the type table.
+};
+
+/// Strings are stored as an offset into the string pool followed by the length.
+struct BinaryIRStringRef {
+    uint64_t offset;
+    uint64_t length;
+};
+
+}  // namespace P4
+
+#endif /* IR_BINARY_IR_H_ */
@@ -0,0 +1,452 @@
+#ifndef IR_BINARY_IR_READER_H_
+#define IR_BINARY_IR_READER_H_
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "ir/binary_ir.h"
+#include "ir/ir.h"
+#include "ir/json_loader.h"
+#include "lib/big_int.h"
+#include "lib/bitvec.h"
+#include "lib/cstring.h"
+#include "lib/ltbitmatrix.h"
+#include "lib/match.h"
+#include "lib/ordered_map.h"
+#include "lib/ordered_set.h"
+#include "lib/safe_vector.h"
+#include "lib/string_map.h"
+
+namespace P4 {
+
+struct UnparsedConstant;
+
+/// Read-only view of a memory-mapped binary IR file written by BinaryIRWriter. Nodes are
+/// only created when they are requested: node() creates a node together with the nodes it
+/// refers to, which reads the records of that subtree only. Every node is created once, so
+/// nodes shared in the written IR are shared again.
+class BinaryIRReader {
+    template <typename T>
+    class has_fromBinary {
+        typedef char small;
+        typedef struct {
+            char c[2];
+        } big;
+
+        template <typename C>
+        static small test(decltype(&C::fromBinary));
+        template <typename C>
+        static big test(...);
+
+     public:
+        static const bool value = sizeof(test<T>(0)) == sizeof(char);
+    };
+
+    template <typename T>
+    class has_fromJSON {
+        typedef char small;
+        typedef struct {
+            char c[2];
+        } big;
+
+        template <typename C>
+        static small test(decltype(&C::fromJSON));
+        template <typename C>
+        static big test(...);
+
+     public:
+        static const bool value = sizeof(test<T>(0)) == sizeof(char);
+    };
+
+    const char *data = nullptr;
+    size_t size = 0;
+    std::string path;
+
+    const BinaryIRNodeEntry *entries = nullptr;
+    const uint32_t *types = nullptr;
+    const BinaryIRStringRef *stringRefs = nullptr;
+    const uint8_t *records = nullptr;
+    const char *pool = nullptr;
+
+    /// The nodes created so far, by index.
+    std::vector<IR::Node *> nodes;
+    /// Set for the nodes whose records are being read.
+    std::vector<bool> loading;
+    size_t created = 0;
+    std::vector<cstring> strings;
+    std::vector<BinaryNodeFactoryFn> factories;
+
+    /// The part of the record which is being read.
+    const uint8_t *cursor = nullptr;
+    const uint8_t *end = nullptr;
+
+    /// Set when a record does not match the types it is read into.
+    bool corrupted = false;
+    bool reported = false;
+
+    bool validate();
+    IR::Node *createNode(uint64_t index, BinaryNodeFactoryFn fallback);
+    IR::Node *readNodeRef(BinaryNodeFactoryFn fallback = nullptr);
+    cstring readString();
+
+    uint8_t readByte() {
+        if (cursor == end) {
+            corrupted = true;
+            return 0;
+        }
+        return *cursor++;
+    }
+    uint64_t readVarint() {
+        uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = readByte();
+            v |= uint64_t(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return v;
+        }
+        corrupted = true;
+        return v;
+    }
+    std::string_view readBytes() {
+        auto length = readVarint();
+        if (length > uint64_t(end - cursor)) {
+            corrupted = true;
+            return {};
+        }
+        std::string_view bytes(reinterpret_cast<const char *>(cursor), length);
+        cursor += length;
+        return bytes;
+    }
+
+ public:
+    BinaryIRReader() = default;
+    ~BinaryIRReader() { close(); }
+    BinaryIRReader(const BinaryIRReader &) = delete;
+    BinaryIRReader &operator=(const BinaryIRReader &) = delete;
+
+    /// Maps the binary IR file @p path into memory, reports an error if it is not a valid
+    /// binary IR file.
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+    const std::string &getPath() const { return path; }
+
+    const BinaryIRHeader &header() const { return *reinterpret_cast<const BinaryIRHeader *>(data); }
+    size_t nodeCount() const { return header().nodeCount; }
+    /// The node_type_name() of the node with @p index.
+    cstring nodeType(size_t index);
+    /// The number of nodes created so far.
+    size_t createdNodes() const { return created; }
+
+    /// Returns the node with @p index, creating it and the nodes it refers to if needed.
+    /// Reports an error and returns null if their records are corrupted.
+    const IR::Node *node(size_t index);
+    const IR::Node *root() { return node(0); }
+
+    /// Loads the next value of the record being read, used by the binary constructors.
+    template <typename T>
+    void load(T &v) {
+        decode(v);
+    }
+    /// Loads the size of a container, which cannot be larger than the rest of the record.
+    size_t loadSize() {
+        auto count = readVarint();
+        if (count > uint64_t(end - cursor)) {
+            corrupted = true;
+            return 0;
+        }
+        return count;
+    }
+
+ private:
+    template <typename T>
+    void decode(safe_vector<T> &v) {
+        v.clear();
+        for (size_t count = loadSize(); count > 0; --count) {
+            T temp{};
+            decode(temp);
+            v.push_back(std::move(temp));
+        }
+    }
+    template <typename T>
+    void decode(std::vector<T> &v) {
+        v.clear();
+        for (size_t count = loadSize(); count > 0; --count) {
+            T temp{};
+            decode(temp);
+            v.push_back(std::move(temp));
+        }
+    }
+    template <typename T>
+    void decode(std::set<T> &v) {
+        v.clear();
+        for (size_t count = loadSize(); count > 0; --count) {
+            T temp{};
+            decode(temp);
+            v.insert(std::move(temp));
+        }
+    }
+    template <typename T>
+    void decode(ordered_set<T> &v) {
+        v.clear();
+        for (size_t count = loadSize(); count > 0; --count) {
+            T temp{};
+            decode(temp);
+            v.insert(std::move(temp));
+        }
+    }
+    template <typename Map>
+    void decodeMap(Map &v) {
+        v.clear();
+        for (size_t count = loadSize(); count > 0; --count) {
+            std::pair<typename Map::key_type, typename Map::mapped_type> temp{};
+            decode(temp);
+            v.emplace(std::move(temp.first), std::move(temp.second));
+        }
+    }
+    template <typename K, typename V>
+    void decode(std::map<K, V> &v) {
+        decodeMap(v);
+    }
+    template <typename K, typename V>
+    void decode(std::multimap<K, V> &v) {
+        decodeMap(v);
+    }
+    template <typename K, typename V>
+    void decode(ordered_map<K, V> &v) {
+        decodeMap(v);
+    }
+    template <typename V>
+    void decode(string_map<V> &v) {
+        decodeMap(v);
+    }
+
+    template <typename T, typename U>
+    void decode(std::pair<T, U> &v) {
+        decode(v.first);
+        decode(v.second);
+    }
+
+    template <typename T>
+    void decode(std::optional<T> &v) {
+        bool valid = false;
+        decode(valid);
+        if (!valid) {
+            v = std::nullopt;
+            return;
+        }
+        T value{};
+        decode(value);
+        v = std::move(value);
+    }
+
+    template <size_t N, class Variant>
+    void decodeVariant(size_t index, Variant &v) {
+        if constexpr (N < std::variant_size_v<Variant>) {
+            if (index == N) {
+                v.template emplace<N>();
+                decode(std::get<N>(v));
+            } else {
+                decodeVariant<N + 1>(index, v);
+            }
+        } else {
+            corrupted = true;
+        }
+    }
+    template <class... Types>
+    void decode(std::variant<Types...> &v) {
+        decodeVariant<0>(readVarint(), v);
+    }
+
+    void decode(bool &v) { v = readByte() != 0; }
+    template <typename T>
+    std::enable_if_t<std::is_integral_v<T>> decode(T &v) {
+        auto value = readVarint();
+        if constexpr (std::is_signed_v<T>) {
+            v = static_cast<T>(static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1)));
+        } else {
+            v = static_cast<T>(value);
+        }
+    }
+    template <typename T>
+    std::enable_if_t<std::is_enum_v<T>> decode(T &v) {
+        std::underlying_type_t<T> value{};
+        decode(value);
+        v = static_cast<T>(value);
+    }
+    template <typename T>
+    std::enable_if_t<std::is_floating_point_v<T>> decode(T &v) {
+        double value = 0;
+        if (uint64_t(end - cursor) < sizeof(value)) {
+            corrupted = true;
+        } else {
+            std::memcpy(&value, cursor, sizeof(value));
+            cursor += sizeof(value);
+        }
+        v = static_cast<T>(value);
+    }
+    void decode(big_int &v);
+
+    void decode(cstring &v) { v = readString(); }
+    void decode(std::string &v) { v = std::string(readBytes()); }
+    void decode(IR::ID &v) {
+        v.name = readString();
+        v.originalName = readString();
+    }
+
+    void decode(LTBitMatrix &m) { std::string(readBytes()).c_str() >> m; }
+    void decode(bitvec &v);
+    void decode(match_t &v) {
+        decode(v.word0);
+        decode(v.word1);
+    }
+    void decode(UnparsedConstant *&v);
+
+    template <typename T>
+    std::enable_if_t<has_fromBinary<T>::value && !std::is_base_of_v<IR::Node, T> &&
+                     std::is_pointer_v<decltype(T::fromBinary(std::declval<BinaryIRReader &>()))>>
+    decode(T &v) {
+        v = *T::fromBinary(*this);
+    }
+    template <typename T>
+    std::enable_if_t<has_fromBinary<T>::value && !std::is_base_of_v<IR::Node, T> &&
+                     std::is_pointer_v<decltype(T::fromBinary(std::declval<BinaryIRReader &>()))>>
+    decode(T *&v) {
+        bool present = false;
+        decode(present);
+        v = present ? T::fromBinary(*this) : nullptr;
+    }
+    /// Types outside the IR may also return their value from fromBinary.
+    template <typename T>
+    std::enable_if_t<has_fromBinary<T>::value && !std::is_base_of_v<IR::Node, T> &&
+                     !std::is_pointer_v<decltype(T::fromBinary(std::declval<BinaryIRReader &>()))>>
+    decode(T &v) {
+        v = T::fromBinary(*this);
+    }
+    template <typename T>
+    std::enable_if_t<has_fromBinary<T>::value && !std::is_base_of_v<IR::Node, T> &&
+                     !std::is_pointer_v<decltype(T::fromBinary(std::declval<BinaryIRReader &>()))>>
+    decode(T *&v) {
+        bool present = false;
+        decode(present);
+        v = present ? new T(T::fromBinary(*this)) : nullptr;
+    }
+    /// Types outside the IR which can only be written as JSON are stored as JSON text.
+    template <typename T>
+    std::enable_if_t<!has_fromBinary<T>::value && has_fromJSON<T>::value &&
+                     !std::is_base_of_v<IR::INode, T>>
+    decode(T &v) {
+        std::istringstream json{std::string(readBytes())};
+        JSONLoader(json) >> v;
+    }
+    template <typename T>
+    std::enable_if_t<!has_fromBinary<T>::value && has_fromJSON<T>::value &&
+                     !std::is_base_of_v<IR::INode, T>>
+    decode(T *&v) {
+        bool present = false;
+        decode(present);
+        v = nullptr;
+        if (present) {
+            std::istringstream json{std::string(readBytes())};
+            JSONLoader(json) >> v;
+        }
+    }
+
+    /// Nodes inline in other nodes are read in place, with their source info if it was written.
+    template <typename T>
+    std::enable_if_t<std::is_base_of_v<IR::Node, T>> decode(T &v) {
+        v = T(*this);
+        if (header().flags & BinaryIRHeader::withSourceInfo) v.sourceInfoFromBinary(*this);
+    }
+
+    template <typename T>
+    std::enable_if_t<std::is_base_of_v<IR::INode, T>> decode(const T *&v) {
+        v = nullptr;
+        if (auto *node = readNodeRef()) {
+            v = node->template to<T>();
+            if (v == nullptr) corrupted = true;
+        }
+    }
+    /// Vectors and name maps are not in IR::binary_unpacker_table, they are created with the
+    /// factory of the type they are read into.
+    template <typename T>
+    void decode(const IR::Vector<T> *&v) {
+        decodeWith(v, [](BinaryIRReader &binary) -> IR::Node * {
+            return IR::Vector<T>::fromBinary(binary);
+        });
+    }
+    template <typename T>
+    void decode(const IR::IndexedVector<T> *&v) {
+        decodeWith(v, [](BinaryIRReader &binary) -> IR::Node * {
+            return IR::IndexedVector<T>::fromBinary(binary);
+        });
+    }
+    template <class T, template <class K, class V, class COMP, class ALLOC> class MAP, class COMP,
+              class ALLOC>
+    void decode(const IR::NameMap<T, MAP, COMP, ALLOC> *&v) {
+        decodeWith(v, [](BinaryIRReader &binary) -> IR::Node * {
+            return IR::NameMap<T, MAP, COMP, ALLOC>::fromBinary(binary);
+        });
+    }
+    template <typename T>
+    void decodeWith(const T *&v, BinaryNodeFactoryFn factory) {
+        v = nullptr;
+        if (auto *node = readNodeRef(factory)) {
+            v = node->template to<T>();
+            if (v == nullptr) corrupted = true;
+        }
+    }
+
+    template <typename T, size_t N>
+    void decode(T (&v)[N]) {
+        for (auto &el : v) decode(el);
+    }
+};
+
+template <class T>
+IR::Vector<T>::Vector(BinaryIRReader &binary) : VectorBase(binary) {
+    binary.load(vec);
+}
+template <class T>
+IR::Vector<T> *IR::Vector<T>::fromBinary(BinaryIRReader &binary) {
+    return new Vector<T>(binary);
+}
+template <class T>
+IR::IndexedVector<T>::IndexedVector(BinaryIRReader &binary) : Vector<T>(binary) {
+    for (const auto *el : *this) insertInMap(el);
+}
+template <class T>
+IR::IndexedVector<T> *IR::IndexedVector<T>::fromBinary(BinaryIRReader &binary) {
+    return new IndexedVector<T>(binary);
+}
+template <class T, template <class K, class V, class COMP, class ALLOC> class MAP /*= std::map */,
+          class COMP /*= std::less<cstring>*/,
+          class ALLOC /*= std::allocator<std::pair<cstring, const T*>>*/>
+IR::NameMap<T, MAP, COMP, ALLOC>::NameMap(BinaryIRReader &binary) : Node(binary) {
+    for (size_t count = binary.loadSize(); count > 0; --count) {
+        cstring name;
+        const T *value = nullptr;
+        binary.load(name);
+        binary.load(value);
+        symbols.emplace(name, value);
+    }
+}
+template <class T, template <class K, class V, class COMP, class ALLOC> class MAP /*= std::map */,
+          class COMP /*= std::less<cstring>*/,
+          class ALLOC /*= std::allocator<std::pair<cstring, const T*>>*/>
+IR::NameMap<T, MAP, COMP, ALLOC> *IR::NameMap<T, MAP, COMP, ALLOC>::fromBinary(
+    BinaryIRReader &binary) {
+    return new IR::NameMap<T, MAP, COMP, ALLOC>(binary);
+}
+
+}  // namespace P4
+
+#endif /* IR_BINARY_IR_READER_H_ */
@@ -0,0 +1,263 @@
+#ifndef IR_BINARY_IR_WRITER_H_
+#define IR_BINARY_IR_WRITER_H_
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "ir/binary_ir.h"
+#include "ir/id.h"
+#include "ir/json_generator.h"
+#include "ir/node.h"
+#include "lib/big_int.h"
+#include "lib/bitvec.h"
+#include "lib/cstring.h"
+#include "lib/ltbitmatrix.h"
+#include "lib/match.h"
+#include "lib/ordered_map.h"
+#include "lib/ordered_set.h"
+#include "lib/safe_vector.h"
+#include "lib/string_map.h"
+
+namespace P4 {
+
+struct UnparsedConstant;
+
+/// Writes an IR tree into a binary IR file (see ir/binary_ir.h), which BinaryIRReader loads.
+/// The node classes write their fields with emit() in their toBinary methods, which the IR
+/// generator creates from the IR definitions in the order their binary constructors load them.
+class BinaryIRWriter {
+    template <typename T>
+    class has_toBinary {
+        typedef char small;
+        typedef struct {
+            char c[2];
+        } big;
+
+        template <typename C>
+        static small test(decltype(&C::toBinary));
+        template <typename C>
+        static big test(...);
+
+     public:
+        static const bool value = sizeof(test<T>(0)) == sizeof(char);
+    };
+
+    template <typename T>
+    class has_toJSON {
+        typedef char small;
+        typedef struct {
+            char c[2];
+        } big;
+
+        template <typename C>
+        static small test(decltype(&C::toJSON));
+        template <typename C>
+        static big test(...);
+
+     public:
+        static const bool value = sizeof(test<T>(0)) == sizeof(char);
+    };
+
+    bool dumpSourceInfo;
+
+    /// The records of the nodes, in the order of the node table.
+    std::string records;
+    std::vector<BinaryIRNodeEntry> entries;
+    std::vector<const IR::Node *> nodes;
+    std::unordered_map<const IR::Node *, uint32_t> nodeIndices;
+    /// The nodes whose records are still to be written, the next one last.
+    std::vector<uint32_t> pending;
+
+    std::vector<cstring> strings;
+    std::unordered_map<cstring, uint32_t> stringIndices;
+    std::vector<uint32_t> types;
+    std::unordered_map<cstring, uint32_t> typeIndices;
+
+    uint32_t stringIndex(cstring s);
+    uint32_t typeIndex(cstring type);
+    uint32_t nodeIndex(const IR::Node *node);
+    void writeNodeRef(const IR::Node *node);
+
+    void writeVarint(uint64_t v) {
+        while (v >= 0x80) {
+            records.push_back(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        records.push_back(static_cast<char>(v));
+    }
+    void writeBytes(std::string_view bytes) {
+        writeVarint(bytes.size());
+        records.append(bytes);
+    }
+
+ public:
+    /// If @p dumpSourceInfo is set, the nodes are written with their source info, like
+    /// the JSONGenerator does with the same argument.
+    explicit BinaryIRWriter(bool dumpSourceInfo = false) : dumpSourceInfo(dumpSourceInfo) {}
+
+    /// Writes @p root and every node reachable from it to @p out. Returns false if the output
+    /// could not be written.
+    bool write(std::ostream &out, const IR::Node *root);
+
+    template <typename T>
+    void emit(const T &v) {
+        encode(v);
+    }
+
+ private:
+    template <typename Range>
+    void encodeRange(const Range &v) {
+        writeVarint(v.size());
+        for (auto &el : v) encode(el);
+    }
+
+    template <typename T>
+    void encode(const safe_vector<T> &v) {
+        encodeRange(v);
+    }
+    template <typename T>
+    void encode(const std::vector<T> &v) {
+        encodeRange(v);
+    }
+    template <typename T>
+    void encode(const std::set<T> &v) {
+        encodeRange(v);
+    }
+    template <typename T>
+    void encode(const ordered_set<T> &v) {
+        encodeRange(v);
+    }
+    template <typename K, typename V>
+    void encode(const std::map<K, V> &v) {
+        encodeRange(v);
+    }
+    template <typename K, typename V>
+    void encode(const std::multimap<K, V> &v) {
+        encodeRange(v);
+    }
+    template <typename K, typename V>
+    void encode(const ordered_map<K, V> &v) {
+        encodeRange(v);
+    }
+    template <typename V>
+    void encode(const string_map<V> &v) {
+        encodeRange(v);
+    }
+
+    template <typename T, typename U>
+    void encode(const std::pair<T, U> &v) {
+        encode(v.first);
+        encode(v.second);
+    }
+
+    template <typename T>
+    void encode(const std::optional<T> &v) {
+        encode(v.has_value());
+        if (v) encode(*v);
+    }
+
+    template <class... Types>
+    void encode(const std::variant<Types...> &v) {
+        writeVarint(v.index());
+        std::visit([this](auto &value) { this->encode(value); }, v);
+    }
+
+    template <typename T>
+    std::enable_if_t<std::is_same_v<T, bool>> encode(T v) {
+        records.push_back(v ? 1 : 0);
+    }
+    template <typename T>
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>> encode(T v) {
+        if constexpr (std::is_signed_v<T>) {
+            auto value = static_cast<int64_t>(v);
+            writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+        } else {
+            writeVarint(v);
+        }
+    }
+    template <typename T>
+    std::enable_if_t<std::is_enum_v<T>> encode(T v) {
+        encode(static_cast<std::underlying_type_t<T>>(v));
+    }
+    template <typename T>
+    std::enable_if_t<std::is_floating_point_v<T>> encode(T v) {
+        auto value = static_cast<double>(v);
+        records.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    template <typename T>
+    std::enable_if_t<std::is_same_v<T, big_int>> encode(const T &v) {
+        encodeBigInt(v);
+    }
+    void encodeBigInt(const big_int &v);
+
+    void encode(cstring v) { writeVarint(stringIndex(v)); }
+    void encode(const std::string &v) { writeBytes(v); }
+    void encode(const IR::ID &v) {
+        encode(v.name);
+        encode(v.originalName);
+    }
+
+    void encode(const LTBitMatrix &v) {
+        std::stringstream text;
+        text << v;
+        writeBytes(text.str());
+    }
+    void encode(const bitvec &v);
+    void encode(const match_t &v) {
+        encode(v.word0);
+        encode(v.word1);
+    }
+    void encode(const UnparsedConstant *v);
+
+    template <typename T>
+    std::enable_if_t<has_toBinary<T>::value && !std::is_base_of_v<IR::Node, T>> encode(
+        const T &v) {
+        v.toBinary(*this);
+    }
+    /// Types outside the IR which can only be written as JSON are stored as JSON text.
+    template <typename T>
+    std::enable_if_t<!has_toBinary<T>::value && has_toJSON<T>::value &&
+                     !std::is_base_of_v<IR::INode, T>>
+    encode(const T &v) {
+        std::stringstream json;
+        JSONGenerator(json).emit(v);
+        writeBytes(json.str());
+    }
+
+    /// Nodes inline in other nodes are written in place, with their source info if requested.
+    void encode(const IR::Node &v) {
+        v.toBinary(*this);
+        if (dumpSourceInfo) v.sourceInfoToBinary(*this);
+    }
+
+    template <typename T>
+    std::enable_if_t<std::is_base_of_v<IR::INode, T>> encode(const T *v) {
+        writeNodeRef(v ? v->getNode() : nullptr);
+    }
+    template <typename T>
+    std::enable_if_t<!std::is_base_of_v<IR::INode, T> &&
+                     (has_toBinary<T>::value || has_toJSON<T>::value)>
+    encode(const T *v) {
+        encode(v != nullptr);
+        if (v) encode(*v);
+    }
+
+    template <typename T, size_t N>
+    void encode(const T (&v)[N]) {
+        for (auto &el : v) encode(el);
+    }
+};
+
+}  // namespace P4
+
+#endif /* IR_BINARY_IR_WRITER_H_ */
@@ -14,6 +14,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "ir/binary_ir_reader.h"
+#include "ir/binary_ir_writer.h"
 #include "ir/json_generator.h"
 #include "ir/json_loader.h"
 
@@ -27,4 +29,16 @@ std::pair<int, int> rangeFromJSON(JSONLoader &json) {
     return endpoints;
 }
 
+void rangeToBinary(BinaryIRWriter &binary, int lo, int hi) {
+    binary.emit(lo);
+    binary.emit(hi);
+}
+
+std::pair<int, int> rangeFromBinary(BinaryIRReader &binary) {
+    std::pair<int, int> endpoints;
+    binary.load(endpoints.first);
+    binary.load(endpoints.second);
+    return endpoints;
+}
+
 }  // namespace P4::BitRange
@@ -28,6 +28,8 @@ limitations under the License.
 
 namespace P4 {
 class JSONLoader;
+class BinaryIRReader;
+class BinaryIRWriter;
 }  // namespace P4
 
 namespace P4::IR {
@@ -84,6 +86,7 @@ class IndexedVector : public Vector<T> {
         insert(Vector<T>::end(), start, end);
     }
     explicit IndexedVector(JSONLoader &json);
+    explicit IndexedVector(BinaryIRReader &binary);
 
     void clear() {
         IR::Vector<T>::clear();
@@ -221,6 +224,7 @@ class IndexedVector : public Vector<T> {
 
     void toJSON(JSONGenerator &json) const override;
     static IndexedVector<T> *fromJSON(JSONLoader &json);
+    static IndexedVector<T> *fromBinary(BinaryIRReader &binary);
     void validate() const override {
         if (invalid) return;  // don't crash the compiler because an error happened
         for (auto el : *this) {
@@ -22,6 +22,7 @@ limitations under the License.
 #include <string_view>
 #include <unordered_set>
 #include <variant>
+#include <vector>
 
 #include "ir/node.h"
 #include "lib/bitvec.h"
@@ -40,6 +41,7 @@ class JSONGenerator {
     std::unordered_set<int> node_refs;
     std::ostream &out;
     bool dumpSourceInfo;
+    bool dumpSourcePositions = false;
 
     template <typename T>
     class has_toJSON {
@@ -93,6 +95,13 @@ class JSONGenerator {
     explicit JSONGenerator(std::ostream &out, bool dumpSourceInfo = false)
         : out(out), dumpSourceInfo(dumpSourceInfo) {}
 
+    /// Emits the positions of nodes in the InputSources they were parsed from, which a
+    /// JSONLoader given the same sources restores.
+    JSONGenerator &withSourcePositions() {
+        dumpSourcePositions = true;
+        return *this;
+    }
+
     state_restore_t begin_vector() {
         if (output_state == OBJ_START) output_state = OBJ_END;
         BUG_CHECK(output_state != VEC_START, "invalid json output state in begin_vector");
@@ -327,6 +336,13 @@ class JSONGenerator {
             if (dumpSourceInfo) {
                 v.sourceInfoToJSON(*this);
             }
+            if (dumpSourcePositions && v.srcInfo.isValid()) {
+                const auto &start = v.srcInfo.getStart();
+                const auto &end = v.srcInfo.getEnd();
+                emit("Source_Position",
+                     std::vector<unsigned>{start.getLineNumber(), start.getColumnNumber(),
+                                           end.getLineNumber(), end.getColumnNumber()});
+            }
         }
         end_object(t);
     }
@@ -57,9 +57,11 @@ class JSONLoader {
     std::unordered_map<int, IR::Node *> &node_refs;
     std::unique_ptr<JsonData> json_root;
     const JsonData *json = nullptr;
+    const Util::InputSources *sources = nullptr;
 
-    JSONLoader(const JsonData *json, std::unordered_map<int, IR::Node *> &refs)
-        : node_refs(refs), json(json) {}
+    JSONLoader(const JsonData *json, std::unordered_map<int, IR::Node *> &refs,
+               const Util::InputSources *sources)
+        : node_refs(refs), json(json), sources(sources) {}
 
  public:
     explicit JSONLoader(std::istream &in)
@@ -68,8 +70,15 @@ class JSONLoader {
         json = json_root.get();
     }
 
+    /// Loads nodes which were emitted with their source positions (see
+    /// JSONGenerator::withSourcePositions) from a program parsed into @p sources. The nodes
+    /// get fresh ids, so that they can become part of the program being compiled.
+    JSONLoader(std::istream &in, const Util::InputSources *sources) : JSONLoader(in) {
+        this->sources = sources;
+    }
+
     JSONLoader(const JSONLoader &unpacker, std::string_view field)
-        : node_refs(unpacker.node_refs), json(nullptr) {
+        : node_refs(unpacker.node_refs), json(nullptr), sources(unpacker.sources) {
         if (!unpacker) return;
         if (auto *obj = unpacker.json->to<JsonObject>()) {
             if (auto it = obj->find(field); it != obj->end()) {
@@ -79,6 +88,9 @@ class JSONLoader {
     }
 
     explicit operator bool() const { return json != nullptr; }
+    /// The sources the positions of the loaded nodes refer to, or null if the nodes have no
+    /// source positions.
+    [[nodiscard]] const Util::InputSources *getSources() const { return sources; }
     template <typename T>
     [[nodiscard]] bool is() const {
         return json && json->is<T>();
@@ -387,12 +399,12 @@ class JSONLoader {
  public:
     template <typename T>
     void load(const JsonData &json, T &v) {
-        JSONLoader(&json, node_refs).unpack_json(v);
+        JSONLoader(&json, node_refs, sources).unpack_json(v);
     }
 
     template <typename T>
     void load(const std::unique_ptr<JsonData> &json, T &v) {
-        JSONLoader(json.get(), node_refs).unpack_json(v);
+        JSONLoader(json.get(), node_refs, sources).unpack_json(v);
     }
 
     template <typename T>
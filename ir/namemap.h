@@ -28,6 +28,8 @@ limitations under the License.
 
 namespace P4 {
 class JSONLoader;
+class BinaryIRReader;
+class BinaryIRWriter;
 }  // namespace P4
 
 namespace P4::IR {
@@ -55,6 +57,7 @@ class NameMap : public Node {
     NameMap(const NameMap &) = default;
     NameMap(NameMap &&) = default;
     explicit NameMap(JSONLoader &);
+    explicit NameMap(BinaryIRReader &);
     NameMap &operator=(const NameMap &) = default;
     NameMap &operator=(NameMap &&) = default;
     typedef typename map_t::value_type value_type;
@@ -150,6 +153,8 @@ class NameMap : public Node {
     void visit_children(Visitor &v, const char *) const override;
     void toJSON(JSONGenerator &json) const override;
     static NameMap<T, MAP, COMP, ALLOC> *fromJSON(JSONLoader &json);
+    void toBinary(BinaryIRWriter &binary) const override;
+    static NameMap<T, MAP, COMP, ALLOC> *fromBinary(BinaryIRReader &binary);
 
     Util::Enumerator<const T *> *valueEnumerator() const {
         return Util::enumerate(Values(symbols));
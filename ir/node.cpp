@@ -20,13 +20,17 @@ limitations under the License.
 #include "node.h"
 
 #include <ostream>
+#include <vector>
 // use in combination with "raise" below
 // #include <csignal>
 
+#include "ir/binary_ir_reader.h"
+#include "ir/binary_ir_writer.h"
 #include "ir/declaration.h"
 #include "ir/ir.h"
 #include "ir/json_generator.h"
 #include "ir/json_loader.h"
+#include "lib/arena.h"
 #include "lib/indent.h"
 #include "lib/json.h"
 #include "lib/log.h"
@@ -37,6 +41,16 @@ void IR::Node::traceVisit(const char *visitor) const {
     LOG3("Visiting " << visitor << " " << id << ":" << node_type_name());
 }
 
+void *IR::Node::operator new(size_t size) {
+    if (auto *arena = Arena::current()) return arena->allocate(size);
+    return ::operator new(size);
+}
+
+void IR::Node::operator delete(void *p) {
+    // Arena chunks are only freed as a whole.
+    if (!Arena::isArenaAllocated(p)) ::operator delete(p);
+}
+
 void IR::Node::traceCreation() const {
     /*
       You can use this to trigger a breakpoint in the debugger when a
@@ -47,7 +61,14 @@ void IR::Node::traceCreation() const {
     LOG5("Created node " << id);
 }
 
-int IR::Node::currentId = 0;
+std::atomic<int> IR::Node::currentId = 0;
+
+void IR::Node::reserveId(int id) {
+    int current = currentId.load(std::memory_order_relaxed);
+    while (id >= current &&
+           !currentId.compare_exchange_weak(current, id + 1, std::memory_order_relaxed)) {
+    }
+}
 
 void IR::Node::toJSON(JSONGenerator &json) const {
     json.emit("Node_ID", id);
@@ -56,10 +77,21 @@ void IR::Node::toJSON(JSONGenerator &json) const {
 
 IR::Node::Node(JSONLoader &json) : id(-1) {
     json.load("Node_ID", id);
+    if (id < 0 || json.getSources() != nullptr)
+        id = nextId();
+    else
+        reserveId(id);
+    clone_id = id;
+}
+
+void IR::Node::toBinary(BinaryIRWriter &binary) const { binary.emit(id); }
+
+IR::Node::Node(BinaryIRReader &binary) : id(-1) {
+    binary.load(id);
     if (id < 0)
-        id = currentId++;
-    else if (id >= currentId)
-        currentId = id + 1;
+        id = nextId();
+    else
+        reserveId(id);
     clone_id = id;
 }
 
@@ -155,6 +187,14 @@ void IR::Node::sourceInfoToJSON(JSONGenerator &json) const {
 }
 
 void IR::Node::sourceInfoFromJSON(JSONLoader &json) {
+    if (const auto *sources = json.getSources()) {
+        std::vector<unsigned> position;
+        if (json.load("Source_Position", position) && position.size() == 4) {
+            srcInfo = Util::SourceInfo(sources, Util::SourcePosition(position[0], position[1]),
+                                       Util::SourcePosition(position[2], position[3]));
+        }
+        return;
+    }
     if (auto si = JSONLoader(json, "Source_Info")) {
         si.load("filename", srcInfo.filename);
         si.load("line", srcInfo.line);
@@ -163,6 +203,36 @@ void IR::Node::sourceInfoFromJSON(JSONLoader &json) {
     }
 }
 
+void IR::Node::sourceInfoToBinary(BinaryIRWriter &binary) const {
+    Util::SourceInfo si = srcInfo;
+    unsigned lineNumber, columnNumber;
+    cstring fName = prepareSourceInfoForJSON(si, &lineNumber, &columnNumber);
+    if (fName != nullptr) {
+        binary.emit(fName);
+        binary.emit(static_cast<int>(lineNumber));
+        binary.emit(static_cast<int>(columnNumber));
+        binary.emit(si.toBriefSourceFragment());
+    } else if (si.line != -1 && srcInfo.filename != nullptr) {
+        // The source info was loaded from a file, like in sourceInfoJsonObj().
+        binary.emit(srcInfo.filename);
+        binary.emit(srcInfo.line);
+        binary.emit(srcInfo.column);
+        binary.emit(srcInfo.srcBrief);
+    } else {
+        binary.emit(cstring());
+    }
+}
+
+void IR::Node::sourceInfoFromBinary(BinaryIRReader &binary) {
+    cstring filename;
+    binary.load(filename);
+    if (filename == nullptr) return;
+    srcInfo.filename = filename;
+    binary.load(srcInfo.line);
+    binary.load(srcInfo.column);
+    binary.load(srcInfo.srcBrief);
+}
+
 IRNODE_DEFINE_APPLY_OVERLOAD(Node, , )
 
 }  // namespace P4
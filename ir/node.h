@@ -17,6 +17,8 @@ limitations under the License.
 #ifndef IR_NODE_H_
 #define IR_NODE_H_
 
+#include <atomic>
+#include <cstddef>
 #include <iosfwd>
 
 #include "ir-tree-macros.h"
@@ -34,6 +36,8 @@ class Modifier;
 class Transform;
 class JSONGenerator;
 class JSONLoader;
+class BinaryIRWriter;
+class BinaryIRReader;
 }  // namespace P4
 
 namespace P4::Util {
@@ -109,7 +113,12 @@ class Node : public virtual INode {
     Node &operator=(Node &&) = default;
 
  protected:
-    static int currentId;
+    /// The id of the next node. Nodes may be created by several threads, e.g. the workers
+    /// of p4testgen; the ids only have to be unique, so relaxed increments are enough.
+    static std::atomic<int> currentId;
+    static int nextId() { return currentId.fetch_add(1, std::memory_order_relaxed); }
+    /// Makes sure nodes created later do not reuse @id, which was loaded from a file.
+    static void reserveId(int id);
     void traceVisit(const char *visitor) const;
     friend class ::P4::Visitor;
     friend class ::P4::Inspector;
@@ -123,14 +132,17 @@ class Node : public virtual INode {
     int id;        // unique id for each node
     int clone_id;  // unique id this node was cloned from (recursively)
     void traceCreation() const;
-    Node() : id(currentId++), clone_id(id) { traceCreation(); }
-    explicit Node(Util::SourceInfo si) : srcInfo(si), id(currentId++), clone_id(id) {
+    Node() : id(nextId()), clone_id(id) { traceCreation(); }
+    explicit Node(Util::SourceInfo si) : srcInfo(si), id(nextId()), clone_id(id) {
         traceCreation();
     }
-    Node(const Node &other) : srcInfo(other.srcInfo), id(currentId++), clone_id(other.clone_id) {
+    Node(const Node &other) : srcInfo(other.srcInfo), id(nextId()), clone_id(other.clone_id) {
         traceCreation();
     }
     virtual ~Node() {}
+    /// Nodes are placed in the current Arena of the thread, if there is one.
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
     const Node *apply(Visitor &v, const Visitor_Context *ctxt = nullptr) const;
     const Node *apply(Visitor &&v, const Visitor_Context *ctxt = nullptr) const {
         return apply(v, ctxt);
@@ -150,6 +162,10 @@ class Node : public virtual INode {
     void sourceInfoToJSON(JSONGenerator &json) const;
     void sourceInfoFromJSON(JSONLoader &json);
     Util::JsonObject *sourceInfoJsonObj() const;
+    explicit Node(BinaryIRReader &binary);
+    virtual void toBinary(BinaryIRWriter &binary) const;
+    void sourceInfoToBinary(BinaryIRWriter &binary) const;
+    void sourceInfoFromBinary(BinaryIRReader &binary);
     /* operator== does a 'shallow' comparison, comparing two Node subclass objects for equality,
      * and comparing pointers in the Node directly for equality */
     virtual bool operator==(const Node &a) const { return this->typeId() == a.typeId(); }
@@ -0,0 +1,61 @@
+#include "ir/parallel_inspector.h"
+
+#include <memory>
+#include <vector>
+
+#include "lib/work_stealing.h"
+
+namespace P4 {
+
+bool ParallelInspector::isParallel(const IR::Node *declaration) const {
+    return declaration->is<IR::P4Control>() || declaration->is<IR::P4Parser>() ||
+           declaration->is<IR::Function>();
+}
+
+void ParallelInspector::visitInParallel(const IR::Vector<IR::Node> &objects, size_t begin,
+                                        size_t end, const char *childName) {
+    std::vector<std::unique_ptr<ParallelInspector>> workers(end - begin);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        auto *worker = cloneWorker();
+        CHECK_NULL(worker);
+        worker->workerContext = *getChildContext();
+        worker->workerContext.child_index = begin + i;
+        worker->startWorker(&worker->workerContext);
+        workers[i].reset(worker);
+    }
+
+    Util::runWorkStealing(workers.size(), threads, [&](size_t task, unsigned) {
+        workers[task]->visit(objects.at(begin + task), childName);
+    });
+    getChildContext()->child_index = end;
+
+    for (auto &worker : workers) reduce(*worker);
+}
+
+bool ParallelInspector::preorder(const IR::Vector<IR::Node> *objects) {
+    if (threads <= 1 || !getParent<IR::P4Program>()) return true;
+    BUG_CHECK(!joinFlows, "%1%: joinFlows is not supported by parallel traversals", name());
+
+    // Elements are visited with the name of the vector itself, as in Vector::visit_children.
+    const char *childName = getContext()->child_name;
+    auto parallel = [&](size_t i) {
+        return objects->at(i) != nullptr && isParallel(objects->at(i));
+    };
+    for (size_t i = 0; i < objects->size();) {
+        if (!parallel(i)) {
+            visit(objects->at(i), childName);
+            ++i;
+            continue;
+        }
+        size_t end = i + 1;
+        while (end < objects->size() && parallel(end)) ++end;
+        visitInParallel(*objects, i, end, childName);
+        i = end;
+    }
+
+    // The children have been visited, finish the vector as the traversal would.
+    objects->apply_visitor_postorder(*this);
+    return false;
+}
+
+}  // namespace P4
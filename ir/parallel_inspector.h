@@ -0,0 +1,53 @@
+#ifndef IR_PARALLEL_INSPECTOR_H_
+#define IR_PARALLEL_INSPECTOR_H_
+
+#include "ir/ir.h"
+#include "ir/visitor.h"
+
+namespace P4 {
+
+/// An Inspector which visits independent top-level declarations of a P4Program
+/// (by default controls, parsers and functions) on a pool of worker threads.
+///
+/// Every such declaration is visited by its own worker, created by cloneWorker(), which
+/// has its own Tracker and sees the same context as the declaration would have in a
+/// sequential traversal. Once a run of consecutive parallel declarations is done, the
+/// workers are merged into this visitor by reduce() in declaration order, so the result
+/// does not depend on the number of threads. Other declarations are visited by this
+/// visitor in program order.
+///
+/// This is only correct for read-only analyses where the result for a declaration does
+/// not depend on what was seen in other declarations. Shared nodes below different
+/// declarations are visited once per worker, and the workers' init_apply and end_apply
+/// are not called. Workers may allocate, but they must not report errors or warnings,
+/// which are not thread-safe. With a single thread the traversal is sequential and no
+/// workers are created.
+class ParallelInspector : public Inspector {
+    unsigned threads;
+    Context workerContext;  // Context of the declaration visited by a worker.
+
+    void visitInParallel(const IR::Vector<IR::Node> &objects, size_t begin, size_t end,
+                         const char *childName);
+
+ protected:
+    /// Returns a new worker with the configuration of this visitor and empty results.
+    virtual ParallelInspector *cloneWorker() const = 0;
+    /// Merges the results of @worker, which has visited one declaration, into this visitor.
+    virtual void reduce(const ParallelInspector &worker) = 0;
+    /// Returns true if @declaration can be visited concurrently with other declarations.
+    virtual bool isParallel(const IR::Node *declaration) const;
+
+ public:
+    explicit ParallelInspector(unsigned threads = 1) : threads(threads) {}
+
+    unsigned getThreads() const { return threads; }
+    void setThreads(unsigned threads) { this->threads = threads; }
+
+    using Inspector::preorder;
+    /// Visits the objects of a P4Program, subclasses which override this must call it.
+    bool preorder(const IR::Vector<IR::Node> *objects) override;
+};
+
+}  // namespace P4
+
+#endif /* IR_PARALLEL_INSPECTOR_H_ */
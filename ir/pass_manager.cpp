@@ -71,8 +71,11 @@ const IR::Node *PassManager::apply_visitor(const IR::Node *program, const char *
     early_exit_flag = false;
     unsigned initial_error_count = ::P4::errorCount();
     BUG_CHECK(running, "not calling apply properly");
+    Arena::Scope arena_scope(nodeArena);
+    if (nodeArena) nodeArena->newRegion();
     for (auto it = passes.begin(); it != passes.end();) {
         Visitor *v = *it;
+        if (nodeArena && regionPerPass) nodeArena->newRegion();
         if (auto b = dynamic_cast<Backtrack *>(v)) {
             if (!b->never_backtracks()) {
                 backup.emplace_back(it, program);
@@ -25,6 +25,7 @@ limitations under the License.
 
 #include "ir/node.h"
 #include "ir/visitor.h"
+#include "lib/arena.h"
 #include "lib/cstring.h"
 #include "lib/exceptions.h"
 #include "lib/safe_vector.h"
@@ -48,6 +49,8 @@ class PassManager : virtual public Visitor, virtual public Backtrack {
     bool stop_on_error = true;
     bool running = false;
     unsigned seqNo = 0;
+    Arena *nodeArena = nullptr;  // if set, IR nodes created by the passes are placed here
+    bool regionPerPass = false;
     void runDebugHooks(const char *visitorName, const IR::Node *node);
     profile_t init_apply(const IR::Node *root) override {
         running = true;
@@ -120,6 +123,13 @@ class PassManager : virtual public Visitor, virtual public Backtrack {
                 if (auto child = dynamic_cast<PassManager *>(pass))
                     child->addDebugHooks(hooks, recursive);
     }
+    /// Places the IR nodes created while the passes run in @arena, which must outlive this
+    /// pass manager. Each run starts a new region of the arena; with @regionPerPass, each
+    /// pass does. Nested pass managers without an arena of their own use this one.
+    void setNodeArena(Arena *arena, bool regionPerPass = false) {
+        nodeArena = arena;
+        this->regionPerPass = regionPerPass;
+    }
     void early_exit() { early_exit_flag = true; }
     PassManager *clone() const override { return new PassManager(*this); }
 };
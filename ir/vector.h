@@ -25,6 +25,8 @@ limitations under the License.
 
 namespace P4 {
 class JSONLoader;
+class BinaryIRReader;
+class BinaryIRWriter;
 }  // namespace P4
 
 namespace P4::IR {
@@ -49,6 +51,7 @@ class VectorBase : public Node {
 
  protected:
     explicit VectorBase(JSONLoader &json) : Node(json) {}
+    explicit VectorBase(BinaryIRReader &binary) : Node(binary) {}
 
     DECLARE_TYPEINFO_WITH_TYPEID(VectorBase, NodeKind::VectorBase, Node);
 };
@@ -65,6 +68,7 @@ class Vector : public VectorBase {
     Vector(const Vector &) = default;
     Vector(Vector &&) = default;
     explicit Vector(JSONLoader &json);
+    explicit Vector(BinaryIRReader &binary);
     Vector &operator=(const Vector &) = default;
     Vector &operator=(Vector &&) = default;
     explicit Vector(const T *a) { vec.emplace_back(a); }
@@ -75,6 +79,7 @@ class Vector : public VectorBase {
     Vector(Util::Enumerator<const T *> *e)  // NOLINT(runtime/explicit)
         : vec(e->begin(), e->end()) {}
     static Vector<T> *fromJSON(JSONLoader &json);
+    static Vector<T> *fromBinary(BinaryIRReader &binary);
 
     using iterator = typename safe_vector<const T *>::iterator;
     using const_iterator = typename safe_vector<const T *>::const_iterator;
@@ -192,6 +197,7 @@ class Vector : public VectorBase {
     virtual void parallel_visit_children(Visitor &v, const char *name = nullptr);
     virtual void parallel_visit_children(Visitor &v, const char *name = nullptr) const;
     void toJSON(JSONGenerator &json) const override;
+    void toBinary(BinaryIRWriter &binary) const override;
     Util::Enumerator<const T *> *getEnumerator() const { return Util::enumerate(vec); }
     template <typename S>
     Util::Enumerator<const S *> *only() const {
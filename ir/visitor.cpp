@@ -18,8 +18,16 @@ limitations under the License.
 
 #include <config.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
@@ -48,6 +56,182 @@ namespace P4 {
 
 enum class VisitStatus : unsigned { New, Revisit, Busy, Done };
 
+static std::atomic<bool> dense_visit_state = false;
+
+void Visitor::setDenseVisitState(bool enable) { dense_visit_state = enable; }
+
+/** @class VisitStateMap
+ *  @brief Visit state of the nodes of one traversal, used by the trackers.
+ *
+ *  By default the state is kept in a hash map keyed by the node.  With
+ *  Visitor::setDenseVisitState, the state of a node is kept in a slot of a dense
+ *  array indexed by the node's id instead, which avoids hashing on every visit.
+ *  The ids of the used slots are listed, so that removing nodes and clearing the
+ *  array only touch those.  Nodes whose slot is taken by another node with the
+ *  same id (ids are copied by assignment) still go to the hash map.
+ *
+ *  Like the hash map, the array is scanned by the garbage collector, so it keeps
+ *  the nodes it holds alive.  The array is cleared and returned to a small pool by
+ *  `release()`, at the end of the traversal; the state is lost at that point.
+ *  Arrays beyond the capacity of the pool, or too large to be kept, are freed.
+ */
+template <class Info>
+class VisitStateMap {
+    struct slot_t {
+        const IR::Node *node;  // nullptr for an unused slot
+        Info info;
+    };
+    static_assert(std::is_trivially_copyable_v<slot_t>);
+
+    struct storage_t {
+        slot_t *slots = nullptr;
+        size_t size = 0;
+        std::vector<uint32_t> used;  // ids of the used slots
+    };
+    struct pool_t {
+        std::mutex lock;
+        std::vector<storage_t *> free;
+    };
+    static pool_t &pool() {
+        static pool_t *pool = new pool_t;
+        return *pool;
+    }
+
+    static constexpr size_t max_dense_id = size_t(1) << 26;
+    /// Limits of the arrays kept for later traversals.
+    static constexpr size_t max_pooled = 8;
+    static constexpr size_t max_pooled_size = size_t(1) << 20;
+
+    storage_t *dense = nullptr;
+    absl::flat_hash_map<const IR::Node *, Info, Util::Hash> map;
+
+    static slot_t *alloc_slots(size_t size) {
+#if HAVE_LIBGC
+        auto *rv = static_cast<slot_t *>(GC_MALLOC(size * sizeof(slot_t)));
+#else
+        auto *rv = static_cast<slot_t *>(malloc(size * sizeof(slot_t)));
+#endif
+        if (!rv) throw std::bad_alloc();
+        memset(static_cast<void *>(rv), 0, size * sizeof(slot_t));
+        return rv;
+    }
+
+    static void free_slots(slot_t *slots) {
+#if HAVE_LIBGC
+        GC_FREE(slots);
+#else
+        free(slots);
+#endif
+    }
+
+    void grow(size_t id) {
+        size_t size = std::max({id + 1, dense->size * 2, size_t(1024)});
+        slot_t *slots = alloc_slots(size);
+        if (dense->size)
+            memcpy(static_cast<void *>(slots), dense->slots, dense->size * sizeof(slot_t));
+        free_slots(dense->slots);
+        dense->slots = slots;
+        dense->size = size;
+    }
+
+    slot_t *find_slot(const IR::Node *n) const {
+        // Optional children are looked up as nullptr, which the map also accepts.
+        if (dense && n && n->id >= 0 && size_t(n->id) < dense->size) {
+            auto *slot = &dense->slots[n->id];
+            if (slot->node == n) return slot;
+        }
+        return nullptr;
+    }
+
+ public:
+    explicit VisitStateMap(size_t map_size) : map(map_size) {
+        if (!dense_visit_state) return;
+        auto &p = pool();
+        {
+            std::lock_guard<std::mutex> guard(p.lock);
+            if (!p.free.empty()) {
+                dense = p.free.back();
+                p.free.pop_back();
+            }
+        }
+        if (!dense) dense = new storage_t;
+    }
+    ~VisitStateMap() { release(); }
+    VisitStateMap(const VisitStateMap &) = delete;
+    VisitStateMap &operator=(const VisitStateMap &) = delete;
+
+    Info *find(const IR::Node *n) {
+        if (auto *slot = find_slot(n)) return &slot->info;
+        if (map.empty()) return nullptr;
+        auto it = map.find(n);
+        return it == map.end() ? nullptr : &it->second;
+    }
+    const Info *find(const IR::Node *n) const { return const_cast<VisitStateMap *>(this)->find(n); }
+
+    /** Adds @n with @info unless it is already present.
+     *
+     * @return The state of @n, which is only valid until the next insertion, and true
+     * if it was added.
+     */
+    std::pair<Info *, bool> emplace(const IR::Node *n, const Info &info) {
+        if (auto *existing = find(n)) return {existing, false};
+        if (dense && n && n->id >= 0 && size_t(n->id) < max_dense_id) {
+            if (size_t(n->id) >= dense->size) grow(n->id);
+            auto *slot = &dense->slots[n->id];
+            if (slot->node == nullptr) {
+                *slot = slot_t{n, info};
+                dense->used.push_back(n->id);
+                return {&slot->info, true};
+            }
+        }
+        return {&map.emplace(n, info).first->second, true};
+    }
+
+    /// Removes the nodes whose state satisfies @pred.
+    template <class Pred>
+    void erase_if(Pred pred) {
+        if (dense) {
+            auto &used = dense->used;
+            size_t kept = 0;
+            for (auto id : used) {
+                auto &slot = dense->slots[id];
+                if (pred(slot.info))
+                    slot = slot_t{};
+                else
+                    used[kept++] = id;
+            }
+            used.resize(kept);
+        }
+        for (auto it = map.begin(); it != map.end();) {
+            if (pred(it->second))
+                // `map` is abseil map, therefore erase does not return iterator, use
+                // post-increment
+                map.erase(it++);
+            else
+                ++it;
+        }
+    }
+
+    /// Clears the dense array and returns it to the pool, forgetting the nodes it held.
+    void release() {
+        if (!dense) return;
+        for (auto id : dense->used) dense->slots[id] = slot_t{};
+        dense->used.clear();
+        auto &p = pool();
+        {
+            std::lock_guard<std::mutex> guard(p.lock);
+            if (dense->size <= max_pooled_size && p.free.size() < max_pooled) {
+                p.free.push_back(dense);
+                dense = nullptr;
+                return;
+            }
+        }
+        free_slots(dense->slots);
+        delete dense;
+        dense = nullptr;
+    }
+};
+
 /** @class Visitor::ChangeTracker
  *  @brief Assists visitors in traversing the IR.
 
@@ -64,9 +248,8 @@ class Visitor::ChangeTracker {
         bool visitOnce;
         const IR::Node *result;
     };
-    using visited_t = absl::flat_hash_map<const IR::Node *, visit_info_t, Util::Hash>;
     bool forceClone;
-    visited_t visited;
+    VisitStateMap<visit_info_t> visited;
 
  public:
     explicit ChangeTracker(bool forceClone)
@@ -84,12 +267,12 @@ class Visitor::ChangeTracker {
      */
     [[nodiscard]] VisitStatus try_start(const IR::Node *n, bool defaultVisitOnce) {
         // Initialization
-        auto [it, inserted] = visited.emplace(n, visit_info_t{true, defaultVisitOnce, n});
+        auto [info, inserted] = visited.emplace(n, visit_info_t{true, defaultVisitOnce, n});
 
         if (!inserted) {  // We already seen this node, determine its status
-            if (it->second.visit_in_progress) return VisitStatus::Busy;
-            if (it->second.visitOnce) return VisitStatus::Done;
-            it->second.visit_in_progress = true;
+            if (info->visit_in_progress) return VisitStatus::Busy;
+            if (info->visitOnce) return VisitStatus::Done;
+            info->visit_in_progress = true;
             return VisitStatus::Revisit;
         }
 
@@ -110,10 +293,9 @@ class Visitor::ChangeTracker {
      * previously been invoked.
      */
     bool finish(const IR::Node *orig, const IR::Node *final) {
-        auto it = visited.find(orig);
-        if (it == visited.end()) BUG("visitor state tracker corrupted");
+        visit_info_t *orig_visit_info = visited.find(orig);
+        if (!orig_visit_info) BUG("visitor state tracker corrupted");
 
-        visit_info_t *orig_visit_info = &(it->second);
         orig_visit_info->visit_in_progress = false;
         if (!final) {
             orig_visit_info->result = final;
@@ -122,7 +304,7 @@ class Visitor::ChangeTracker {
             orig_visit_info->result = final;
             visited.emplace(final, visit_info_t{false, orig_visit_info->visitOnce, final});
             return true;
-        } else if (visited.count(final)) {
+        } else if (visited.find(final)) {
             // coalescing with some previously visited node, so we don't want to undo
             // the coalesce
             orig_visit_info->result = final;
@@ -137,22 +319,15 @@ class Visitor::ChangeTracker {
 
     /** Return a visitOnce flag for node @n */
     [[nodiscard]] bool shouldVisitOnce(const IR::Node *n) const {
-        auto it = visited.find(n);
-        if (it == visited.end()) BUG("visitor state tracker corrupted");
-        return it->second.visitOnce;
+        const auto *info = visited.find(n);
+        if (!info) BUG("visitor state tracker corrupted");
+        return info->visitOnce;
     }
 
     /** Forget nodes that have already been visited, allowing them to be visited
      * again. */
     void revisit_visited() {
-        for (auto it = visited.begin(); it != visited.end();) {
-            if (!it->second.visit_in_progress)
-                // `visited` is abseil map, therefore erase does not return iterator, use
-                // post-increment
-                visited.erase(it++);
-            else
-                ++it;
-        }
+        visited.erase_if([](const visit_info_t &info) { return !info.visit_in_progress; });
     }
 
     /** Determine whether @n is currently being visited and the visitor has not finished
@@ -161,8 +336,8 @@ class Visitor::ChangeTracker {
      * @return true if @n is being visited and has not finished
      */
     [[nodiscard]] bool busy(const IR::Node *n) const {
-        auto it = visited.find(n);
-        return it != visited.end() && it->second.visit_in_progress;
+        const auto *info = visited.find(n);
+        return info && info->visit_in_progress;
     }
 
     /** Determine whether @n has been visited and the visitor has finished
@@ -173,8 +348,8 @@ class Visitor::ChangeTracker {
      * @return true if @n has been visited and the visitor is finished and visitOnce is true
      */
     [[nodiscard]] bool done(const IR::Node *n) const {
-        auto it = visited.find(n);
-        return it != visited.end() && !it->second.visit_in_progress && it->second.visitOnce;
+        const auto *info = visited.find(n);
+        return info && !info->visit_in_progress && info->visitOnce;
     }
 
     /** Produce the result of visiting @n.
@@ -184,9 +359,9 @@ class Visitor::ChangeTracker {
      * if `start(@n)` has not been invoked.
      */
     const IR::Node *result(const IR::Node *n) const {
-        auto it = visited.find(n);
-        if (it == visited.end()) return n;
-        return it->second.result;
+        const auto *info = visited.find(n);
+        if (!info) return n;
+        return info->result;
     }
 
     /** Produce the final result of visiting @n.
@@ -195,21 +370,26 @@ class Visitor::ChangeTracker {
      * been invoked.
      */
     const IR::Node *finalResult(const IR::Node *n) const {
-        auto it = visited.find(n);
-        bool done = it != visited.end() && !it->second.visit_in_progress && it->second.visitOnce;
-        return done ? it->second.result : nullptr;
+        const auto *info = visited.find(n);
+        bool done = info && !info->visit_in_progress && info->visitOnce;
+        return done ? info->result : nullptr;
     }
 
     void visitOnce(const IR::Node *n) {
-        auto it = visited.find(n);
-        if (it == visited.end()) BUG("visitor state tracker corrupted");
-        it->second.visitOnce = true;
+        auto *info = visited.find(n);
+        if (!info) BUG("visitor state tracker corrupted");
+        info->visitOnce = true;
     }
 
     void visitAgain(const IR::Node *n) {
-        auto it = visited.find(n);
-        if (it == visited.end()) BUG("visitor state tracker corrupted");
-        it->second.visitOnce = false;
+        auto *info = visited.find(n);
+        if (!info) BUG("visitor state tracker corrupted");
+        info->visitOnce = false;
+    }
+
+    /** Called at the end of the traversal, releases the dense state. */
+    void release() {
+        visited.release();
     }
 };
 
@@ -225,8 +405,7 @@ class Visitor::Tracker {
     struct info_t {
         bool done, visitOnce;
     };
-    using visited_t = absl::flat_hash_map<const IR::Node *, info_t, Util::Hash>;
-    visited_t visited;
+    VisitStateMap<info_t> visited;
 
  public:
     Tracker()
@@ -236,14 +415,7 @@ class Visitor::Tracker {
     /** Forget nodes that have already been visited, allowing them to be visited
      * again. */
     void revisit_visited() {
-        for (auto it = visited.begin(); it != visited.end();) {
-            if (it->second.done)
-                // `visited` is abseil map, therefore erase does not return iterator, use
-                // post-increment
-                visited.erase(it++);
-            else
-                ++it;
-        }
+        visited.erase_if([](const info_t &info) { return info.done; });
     }
 
     /** Begin tracking @n during a visiting pass.  Use `finish(@n)` to mark @n as
@@ -257,12 +429,12 @@ class Visitor::Tracker {
      */
     [[nodiscard]] VisitStatus try_start(const IR::Node *n, bool defaultVisitOnce) {
         // Initialization
-        auto [it, inserted] = visited.emplace(n, info_t{false, defaultVisitOnce});
+        auto [info, inserted] = visited.emplace(n, info_t{false, defaultVisitOnce});
 
         if (!inserted) {  // We already seen this node, determine its status
-            if (!it->second.done) return VisitStatus::Busy;
-            if (it->second.visitOnce) return VisitStatus::Done;
-            it->second.done = false;
+            if (!info->done) return VisitStatus::Busy;
+            if (info->visitOnce) return VisitStatus::Done;
+            info->done = false;
             return VisitStatus::Revisit;
         }
 
@@ -281,10 +453,10 @@ class Visitor::Tracker {
      * previously been invoked.
      */
     void finish(const IR::Node *n) {
-        auto it = visited.find(n);
-        if (it == visited.end()) BUG("visitor state tracker corrupted");
+        auto *info = visited.find(n);
+        if (!info) BUG("visitor state tracker corrupted");
 
-        it->second.done = true;
+        info->done = true;
     }
 
     /** Determine whether @n is currently being visited and the visitor has not finished
@@ -293,8 +465,8 @@ class Visitor::Tracker {
      * @return true if @n is being visited and has not finished
      */
     [[nodiscard]] bool busy(const IR::Node *n) const {
-        auto it = visited.find(n);
-        return it != visited.end() && !it->second.done;
+        const auto *info = visited.find(n);
+        return info && !info->done;
     }
 
     /** Determine whether @n has been visited and the visitor has finished
@@ -305,28 +477,31 @@ class Visitor::Tracker {
      * @return true if @n has been visited and the visitor is finished and visitOnce is true
      */
     [[nodiscard]] bool done(const IR::Node *n) const {
-        auto it = visited.find(n);
-        return it != visited.end() && it->second.done && it->second.visitOnce;
+        const auto *info = visited.find(n);
+        return info && info->done && info->visitOnce;
     }
 
     /** Return a visitOnce flag for node @n */
     bool shouldVisitOnce(const IR::Node *n) const {
-        auto it = visited.find(n);
-        if (it == visited.end()) BUG("visitor state tracker corrupted");
-        return it->second.visitOnce;
+        const auto *info = visited.find(n);
+        if (!info) BUG("visitor state tracker corrupted");
+        return info->visitOnce;
     }
 
     void visitOnce(const IR::Node *n) {
-        auto it = visited.find(n);
-        if (it == visited.end()) BUG("visitor state tracker corrupted");
-        it->second.visitOnce = true;
+        auto *info = visited.find(n);
+        if (!info) BUG("visitor state tracker corrupted");
+        info->visitOnce = true;
     }
 
     void visitAgain(const IR::Node *n) {
-        auto it = visited.find(n);
-        if (it == visited.end()) BUG("visitor state tracker corrupted");
-        it->second.visitOnce = false;
+        auto *info = visited.find(n);
+        if (!info) BUG("visitor state tracker corrupted");
+        info->visitOnce = false;
     }
+
+    /** Called at the end of the traversal, releases the dense state. */
+    void release() { visited.release(); }
 };
 
 // static
@@ -370,6 +545,10 @@ Visitor::profile_t Inspector::init_apply(const IR::Node *root) {
     visited = std::make_shared<Tracker>();
     return rv;
 }
+void Inspector::startWorker(const Context *context) {
+    visited = std::make_shared<Tracker>();
+    ctxt = context;
+}
 Visitor::profile_t Transform::init_apply(const IR::Node *root) {
     auto rv = Visitor::init_apply(root);
     visited = std::make_shared<ChangeTracker>(forceClone);
@@ -378,7 +557,7 @@ Visitor::profile_t Transform::init_apply(const IR::Node *root) {
 void Visitor::end_apply() {}
 void Visitor::end_apply(const IR::Node *) {}
 
-static indent_t profile_indent;
+static thread_local indent_t profile_indent;  // Visitors can run on several threads.
 static absl::Time first_start = absl::InfinitePast();
 
 Visitor::profile_t::profile_t(Visitor &v_) : v(v_) {
@@ -395,11 +574,22 @@ Visitor::profile_t::profile_t(profile_t &&a) : v(a.v), start(a.start) {
 Visitor::profile_t::~profile_t() {
     if (start != absl::InfinitePast()) {
         v.end_apply();
+        v.release_visit_state();
         --profile_indent;
         LOG1(profile_indent << v.name() << ' ' << (absl::Now() - start));
     }
 }
 
+void Inspector::release_visit_state() {
+    if (visited) visited->release();
+}
+void Modifier::release_visit_state() {
+    if (visited) visited->release();
+}
+void Transform::release_visit_state() {
+    if (visited) visited->release();
+}
+
 void Inspector::visitOnce() const { visited->visitOnce(getOriginal()); }
 void Modifier::visitOnce() const { visited->visitOnce(getOriginal()); }
 void Transform::visitOnce() const { visited->visitOnce(getOriginal()); }
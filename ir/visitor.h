@@ -116,6 +116,10 @@ class Visitor {
     // of an exception, as there is no root in that case.
     virtual void end_apply();
     virtual void end_apply(const IR::Node *root);
+    /// Keeps the visit state of the nodes in dense arrays indexed by the node ids instead of
+    /// hash maps, in the traversals started after the call. The arrays are reused across
+    /// traversals, the state of a traversal is dropped when its apply() ends.
+    static void setDenseVisitState(bool enable);
 
     // apply_visitor is the main traversal function that manages the
     // depth-first recursive traversal.  `visit` is a convenience function
@@ -375,6 +379,8 @@ class Visitor {
 
  private:
     virtual void visitor_const_error();
+    // Called when a traversal started by init_apply ends
+    virtual void release_visit_state() {}
     const Context *ctxt = nullptr;  // should be readonly to subclasses
     friend class Inspector;
     friend class Modifier;
@@ -386,6 +392,7 @@ class Modifier : public virtual Visitor {
     std::shared_ptr<ChangeTracker> visited;
     void visitor_const_error() override;
     bool check_clone(const Visitor *) override;
+    void release_visit_state() override;
 
  public:
     profile_t init_apply(const IR::Node *root) override;
@@ -413,6 +420,7 @@ class Modifier : public virtual Visitor {
 class Inspector : public virtual Visitor {
     std::shared_ptr<Tracker> visited;
     bool check_clone(const Visitor *) override;
+    void release_visit_state() override;
 
  public:
     profile_t init_apply(const IR::Node *root) override;
@@ -432,6 +440,11 @@ class Inspector : public virtual Visitor {
     bool visit_in_progress(const IR::Node *n) const;
     void visitOnce() const override;
     void visitAgain() const override;
+
+ protected:
+    /// Prepares this visitor, usually a clone, to traverse subtrees concurrently with
+    /// the visitor it was cloned from: it gets its own Tracker and continues below @context.
+    void startWorker(const Context *context);
 };
 
 class Transform : public virtual Visitor {
@@ -439,6 +452,7 @@ class Transform : public virtual Visitor {
     bool prune_flag = false;
     void visitor_const_error() override;
     bool check_clone(const Visitor *) override;
+    void release_visit_state() override;
 
  public:
     profile_t init_apply(const IR::Node *root) override;
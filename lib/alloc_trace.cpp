@@ -1,6 +1,7 @@
 #include "alloc_trace.h"
 
 #include "absl/debugging/symbolize.h"
+#include "arena.h"
 #include "hex.h"
 #include "log.h"
 #include "n4.h"
@@ -86,6 +87,15 @@ std::ostream &operator<<(std::ostream &out, const AllocTrace &at) {
 #endif
 
     out << "Allocated a total of " << n4(total_total) << "B memory";
+    auto arenas = Arena::totals();
+    if (size_t placed = arenas.allocations - at.arenasAtStart.allocations) {
+        out << Log::endl
+            << "of which " << n4(arenas.bytes - at.arenasAtStart.bytes) << "B in " << placed
+            << " calls were placed in arenas, saving "
+            << n4(arenas.savedBytes - at.arenasAtStart.savedBytes) << "B; "
+            << n4(arenas.reclaimedBytes - at.arenasAtStart.reclaimedBytes)
+            << "B of arena chunks were reclaimed";
+    }
     for (auto &s : sorted) {
         if (s.first < 1000000) break;  // ignore little stuff
         size_t count = 0;
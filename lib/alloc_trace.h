@@ -20,6 +20,7 @@ limitations under the License.
 #include <map>
 #include <ostream>
 
+#include "arena.h"
 #include "config.h"
 #include "exceptions.h"
 #include "gc.h"
@@ -44,6 +45,7 @@ class AllocTrace {
         }
     };
     std::map<backtrace, std::map<size_t, int>> data;
+    Arena::Stats arenasAtStart;  // to report the arena allocations done while tracing
     void count(void **, size_t);
     static void callback(void *t, void **bt, size_t sz) {
         static_cast<AllocTrace *>(t)->count(bt, sz);
@@ -52,7 +54,10 @@ class AllocTrace {
  public:
     void clear() { data.clear(); }
 #if HAVE_LIBGC
-    alloc_trace_cb_t start() { return set_alloc_trace(callback, this); }
+    alloc_trace_cb_t start() {
+        arenasAtStart = Arena::totals();
+        return set_alloc_trace(callback, this);
+    }
     void stop(alloc_trace_cb_t old) {
         auto tmp = set_alloc_trace(old);
         BUG_CHECK(tmp.fn == callback && tmp.arg == this, "AllocTrace stopped when not running");
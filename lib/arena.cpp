@@ -0,0 +1,136 @@
+#include "lib/arena.h"
+
+#include <config.h>
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+#if HAVE_LIBGC
+#include <gc/gc.h>
+#endif
+
+#include "lib/gc.h"
+
+namespace P4 {
+
+namespace {
+
+/// Alignment of every object in a chunk, as guaranteed by operator new.
+constexpr size_t objectAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+/// Start of a chunk left free, so no object starts at the address the collector knows.
+constexpr size_t chunkHeader = objectAlignment;
+/// Size granule of small objects of the collector.
+constexpr size_t gcGranule = 2 * sizeof(void *);
+
+constexpr size_t roundUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+struct Totals {
+    std::atomic<size_t> allocations = 0;
+    std::atomic<size_t> bytes = 0;
+    std::atomic<size_t> savedBytes = 0;
+    std::atomic<size_t> chunks = 0;
+    std::atomic<size_t> chunkBytes = 0;
+    std::atomic<size_t> reclaimedChunks = 0;
+    std::atomic<size_t> reclaimedBytes = 0;
+};
+
+Totals &globalTotals() {
+    static Totals *totals = new Totals;
+    return *totals;
+}
+
+thread_local Arena *currentArena = nullptr;
+
+#if HAVE_LIBGC
+void chunkReclaimed(void *, void *size) {
+    globalTotals().reclaimedChunks.fetch_add(1, std::memory_order_relaxed);
+    globalTotals().reclaimedBytes.fetch_add(reinterpret_cast<uintptr_t>(size),
+                                            std::memory_order_relaxed);
+}
+#endif
+
+}  // namespace
+
+Arena::Arena(size_t chunkSize) : chunkSize(roundUp(chunkSize, objectAlignment)) {}
+
+void *Arena::allocateChunk() {
+#if HAVE_LIBGC
+    void *chunk = GC_MALLOC(chunkSize);
+    if (!chunk) throw std::bad_alloc();
+    GC_REGISTER_FINALIZER_NO_ORDER(chunk, chunkReclaimed, reinterpret_cast<void *>(chunkSize),
+                                   nullptr, nullptr);
+    stats.chunks++;
+    stats.chunkBytes += chunkSize;
+    globalTotals().chunks.fetch_add(1, std::memory_order_relaxed);
+    globalTotals().chunkBytes.fetch_add(chunkSize, std::memory_order_relaxed);
+    return chunk;
+#else
+    return nullptr;
+#endif
+}
+
+void *Arena::allocate(size_t size) {
+#if HAVE_LIBGC
+    size_t rounded = roundUp(size, objectAlignment);
+    if (rounded > chunkSize / 4) return ::operator new(size);
+    if (next == nullptr || static_cast<size_t>(limit - next) < rounded) {
+        // The rest of the current chunk is left unused.
+        next = static_cast<char *>(allocateChunk()) + chunkHeader;
+        limit = next - chunkHeader + chunkSize;
+    }
+    void *rv = next;
+    next += rounded;
+
+    // Without the arena, the collector would add a byte to recognize pointers past the end.
+    size_t saved = roundUp(size + GC_get_all_interior_pointers(), gcGranule) - rounded;
+    stats.allocations++;
+    stats.bytes += size;
+    stats.savedBytes += saved;
+    globalTotals().allocations.fetch_add(1, std::memory_order_relaxed);
+    globalTotals().bytes.fetch_add(size, std::memory_order_relaxed);
+    globalTotals().savedBytes.fetch_add(saved, std::memory_order_relaxed);
+    // Skip this function and the class-specific operator new calling it.
+    gc_trace_alloc(size, 2);
+    return rv;
+#else
+    return ::operator new(size);
+#endif
+}
+
+Arena::Stats Arena::totals() {
+    auto &t = globalTotals();
+    Stats rv;
+    rv.allocations = t.allocations.load(std::memory_order_relaxed);
+    rv.bytes = t.bytes.load(std::memory_order_relaxed);
+    rv.savedBytes = t.savedBytes.load(std::memory_order_relaxed);
+    rv.chunks = t.chunks.load(std::memory_order_relaxed);
+    rv.chunkBytes = t.chunkBytes.load(std::memory_order_relaxed);
+    rv.reclaimedChunks = t.reclaimedChunks.load(std::memory_order_relaxed);
+    rv.reclaimedBytes = t.reclaimedBytes.load(std::memory_order_relaxed);
+    return rv;
+}
+
+bool Arena::isArenaAllocated(const void *p) {
+#if HAVE_LIBGC
+    // Objects allocated individually start at the beginning of their block, arena objects
+    // never do because of the chunk header.
+    void *base = GC_base(const_cast<void *>(p));
+    return base != nullptr && base != p;
+#else
+    (void)p;
+    return false;
+#endif
+}
+
+Arena *Arena::current() { return currentArena; }
+
+Arena::Scope::Scope(Arena *arena) : saved(currentArena) {
+    if (arena) currentArena = arena;
+}
+
+Arena::Scope::~Scope() { currentArena = saved; }
+
+}  // namespace P4
@@ -0,0 +1,77 @@
+#ifndef LIB_ARENA_H_
+#define LIB_ARENA_H_
+
+#include <cstddef>
+
+namespace P4 {
+
+/// A bump allocator for objects which are freed in bulk, used for IR nodes (see
+/// IR::Node::operator new). Objects are placed one after another in large chunks
+/// obtained from the garbage collector, and a chunk is freed as a whole once the
+/// collector finds no pointer into any of its objects. The arena itself only holds on
+/// to the chunk it is currently filling.
+///
+/// Allocations are split into regions: after newRegion(), objects never share a chunk
+/// with objects allocated before. Starting a region per pass keeps the nodes a pass
+/// created and dropped from being retained by nodes which survive from other passes.
+/// Unused objects are not freed individually: as long as a chunk is reachable, its dead
+/// objects and everything they point to stay alive.
+///
+/// Objects are only placed in chunks when the compiler is built with the garbage
+/// collector, otherwise allocate() simply calls operator new. An arena is not
+/// thread-safe; the arena used for IR nodes is set per thread with Arena::Scope.
+class Arena {
+ public:
+    struct Stats {
+        size_t allocations = 0;  // Objects placed in chunks.
+        size_t bytes = 0;        // Bytes requested by these objects.
+        size_t savedBytes = 0;   // Padding the collector would have added to them.
+        size_t chunks = 0;
+        size_t chunkBytes = 0;
+        // Chunks found unreachable and freed by the collector, only counted in totals().
+        size_t reclaimedChunks = 0;
+        size_t reclaimedBytes = 0;
+    };
+
+    /// Objects larger than a quarter of a chunk are allocated individually.
+    explicit Arena(size_t chunkSize = 256 * 1024);
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t size);
+    /// Starts a new region, see the class description.
+    void newRegion() { next = limit = nullptr; }
+    const Stats &getStats() const { return stats; }
+
+    /// Statistics of all arenas. Reclaimed chunks are only known once the collector ran.
+    static Stats totals();
+    /// True if @p was placed in a chunk of an arena, such objects must not be deleted.
+    static bool isArenaAllocated(const void *p);
+
+    /// The arena IR nodes are allocated in on this thread, or null.
+    static Arena *current();
+
+    /// Makes @arena the current arena of this thread until the scope ends. A null
+    /// @arena keeps the current one.
+    class Scope {
+        Arena *saved;
+
+     public:
+        explicit Scope(Arena *arena);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+ private:
+    size_t chunkSize;
+    char *next = nullptr;
+    char *limit = nullptr;
+    Stats stats;
+
+    void *allocateChunk();
+};
+
+}  // namespace P4
+
+#endif /* LIB_ARENA_H_ */
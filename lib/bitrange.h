@@ -64,6 +64,8 @@ class bitranges {
 
 class JSONGenerator;
 class JSONLoader;
+class BinaryIRWriter;
+class BinaryIRReader;
 
 namespace BitRange {
 
@@ -212,6 +214,10 @@ struct MinToMax {};
 void rangeToJSON(JSONGenerator &json, int lo, int hi);
 std::pair<int, int> rangeFromJSON(JSONLoader &json);
 
+/// Binary IR serialization/deserialization helpers.
+void rangeToBinary(BinaryIRWriter &binary, int lo, int hi);
+std::pair<int, int> rangeFromBinary(BinaryIRReader &binary);
+
 }  // namespace BitRange
 
 /// Units in which a range can be specified.
@@ -468,6 +474,12 @@ struct HalfOpenRange {
         return HalfOpenRange(BitRange::rangeFromJSON(json));
     }
 
+    /// Binary IR serialization/deserialization.
+    void toBinary(BinaryIRWriter &binary) const { BitRange::rangeToBinary(binary, lo, hi); }
+    static HalfOpenRange fromBinary(BinaryIRReader &binary) {
+        return HalfOpenRange(BitRange::rangeFromBinary(binary));
+    }
+
     /// Total ordering, first by lo, then by hi.
     bool operator<(const HalfOpenRange &other) const {
         if (lo != other.lo) return lo < other.lo;
@@ -663,6 +675,12 @@ struct ClosedRange {
         return ClosedRange(BitRange::rangeFromJSON(json));
     }
 
+    /// Binary IR serialization/deserialization.
+    void toBinary(BinaryIRWriter &binary) const { BitRange::rangeToBinary(binary, lo, hi); }
+    static ClosedRange fromBinary(BinaryIRReader &binary) {
+        return ClosedRange(BitRange::rangeFromBinary(binary));
+    }
+
     /// @see HalfOpenRange::operator<.
     bool operator<(const ClosedRange &other) const {
         if (lo != other.lo) return lo < other.lo;
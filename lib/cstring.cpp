@@ -16,7 +16,6 @@ limitations under the License.
 
 #include "cstring.h"
 
-#include "absl/container/node_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
 
@@ -28,16 +27,20 @@ limitations under the License.
 #endif /* HAVE_LIBGC */
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <functional>
 #include <iomanip>
 #include <ios>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <string_view>
-#include <unordered_set>
+#include <vector>
 
 #include "hash.h"
 
@@ -86,8 +89,8 @@ class table_entry {
         if (length < sizeof(const char *)) {
             // String with length less than size of pointer store directly
             // in pointer, that hint allows reduce stack fragmentation.
-            // We can make such optimization because std::unordered_set never
-            // moves objects in memory on new element insert
+            // We can make such optimization because cache entries are never
+            // moved in memory once they are inserted
             std::memcpy(m_inplace_string, string, length);
             m_inplace_string[length] = '\0';
             m_flags = table_entry_flags::inplace;
@@ -152,52 +155,115 @@ class table_entry {
     }
 };
 
-// We'd make Util::Hash to be transparent instead. However, this would enable
-// transparent hashing globally and in some cases in very undesired manner. So
-// for now aim for more fine-grained approach.
-struct TableEntryHash {
-    using is_transparent = void;
+// The cache is an open-addressing table of entry pointers, with a parallel
+// array of one byte tags taken from the hash, so a probe rarely touches other
+// entries. Lookups of interned strings do not take any lock: entries are
+// published by the release store of their tag and are never moved or removed,
+// and a full table is replaced by a larger copy while readers may still probe
+// the old one. Only inserting a new string takes the lock, after which the
+// lookup is repeated in the current table.
+constexpr size_t initial_slots = 1024;
+
+// Tags of used slots have the top bit set, empty slots have tag 0.
+uint8_t hash_tag(size_t hash) { return 0x80 | (hash >> (sizeof(size_t) * 8 - 7)); }
+
+struct cache_table {
+    size_t mask;
+    std::unique_ptr<std::atomic<uint8_t>[]> tags;
+    std::unique_ptr<std::atomic<const table_entry *>[]> entries;
+
+    explicit cache_table(size_t size)
+        : mask(size - 1),
+          tags(new std::atomic<uint8_t>[size]()),
+          entries(new std::atomic<const table_entry *>[size]()) {}
+};
 
-    // IMPORTANT: These two hashes MUST match in order for heterogenous
-    // lookup to work properly
-    size_t operator()(const table_entry &entry) const {
-        return Util::hash(entry.string(), entry.length());
-    }
+struct string_cache {
+    std::atomic<cache_table *> table = nullptr;
+    std::mutex lock;
+    size_t count = 0;  // Entries in the table, guarded by lock.
+    // Replaced tables, kept since readers may still probe them. Their total
+    // size is smaller than the size of the current table.
+    std::vector<cache_table *> retired;
+};
+
+string_cache &cache() {
+    static string_cache g_cache;
+    return g_cache;
+}
 
-    size_t operator()(std::string_view entry) const {
-        return Util::hash(entry.data(), entry.length());
+size_t hash_string(std::string_view s) { return Util::hash(s.data(), s.size()); }
+
+// Probes @table for @s, returns nullptr if it does not contain it. Tables are at
+// most half full, so every probe sequence ends at an empty slot.
+const table_entry *find_entry(const cache_table *table, std::string_view s, size_t hash) {
+    if (table == nullptr) return nullptr;
+    uint8_t tag = hash_tag(hash);
+    for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+        uint8_t slot_tag = table->tags[i].load(std::memory_order_acquire);
+        if (slot_tag == 0) return nullptr;
+        if (slot_tag != tag) continue;
+        const auto *entry = table->entries[i].load(std::memory_order_relaxed);
+        if (*entry == s) return entry;
     }
-};
+}
 
-auto &cache() {
-    // We need node_hash_set due to SSO: we return address of embedded string
-    // that should be stable
-    static absl::node_hash_set<table_entry, TableEntryHash, std::equal_to<>> g_cache;
+void place_entry(cache_table *table, const table_entry *entry, size_t hash) {
+    size_t i = hash & table->mask;
+    while (table->tags[i].load(std::memory_order_relaxed) != 0) i = (i + 1) & table->mask;
+    table->entries[i].store(entry, std::memory_order_relaxed);
+    table->tags[i].store(hash_tag(hash), std::memory_order_release);
+}
 
-    return g_cache;
+// Replaces the table by one twice as large. Requires the cache lock.
+cache_table *grow(string_cache &interned, cache_table *table) {
+    auto *larger = new cache_table(table ? 2 * (table->mask + 1) : initial_slots);
+    if (table != nullptr) {
+        for (size_t i = 0; i <= table->mask; ++i) {
+            if (table->tags[i].load(std::memory_order_relaxed) == 0) continue;
+            const auto *entry = table->entries[i].load(std::memory_order_relaxed);
+            place_entry(larger, entry, hash_string({entry->string(), entry->length()}));
+        }
+        interned.retired.push_back(table);
+    }
+    interned.table.store(larger, std::memory_order_release);
+    return larger;
+}
+
+const char *find_cached(std::string_view s) {
+    const auto *entry =
+        find_entry(cache().table.load(std::memory_order_acquire), s, hash_string(s));
+    return entry ? entry->string() : nullptr;
 }
 
 const char *save_to_cache(const char *string, std::size_t length, table_entry_flags flags) {
-    // Checks if string is already cached and if not, calls ctor to construct in
-    // place.  As a result, only a single lookup is performed regardless whether
-    // entry is in cache or not.
-    return cache()
-        .lazy_emplace(table_entry(string, length, table_entry_flags::no_need_copy),
-                      [string, length, flags](const auto &ctor) { ctor(string, length, flags); })
-        ->string();
+    std::string_view s(string, length);
+    size_t hash = hash_string(s);
+    auto &interned = cache();
+    // Fast path, the string is already interned.
+    if (const auto *entry = find_entry(interned.table.load(std::memory_order_acquire), s, hash))
+        return entry->string();
+
+    std::lock_guard<std::mutex> guard(interned.lock);
+    // The string may have been added by another thread, possibly into a new table.
+    auto *table = interned.table.load(std::memory_order_relaxed);
+    if (const auto *entry = find_entry(table, s, hash)) return entry->string();
+
+    if (table == nullptr || 2 * (interned.count + 1) > table->mask + 1)
+        table = grow(interned, table);
+    const auto *entry = new table_entry(string, length, flags);
+    place_entry(table, entry, hash);
+    ++interned.count;
+    return entry->string();
 }
 
 }  // namespace
 
-bool cstring::is_cached(std::string_view s) { return cache().contains(s); }
+bool cstring::is_cached(std::string_view s) { return find_cached(s) != nullptr; }
 
 cstring cstring::get_cached(std::string_view s) {
-    auto entry = cache().find(s);
-    if (entry == cache().end()) return nullptr;
-
     cstring res;
-    res.str = entry->string();
-
+    res.str = find_cached(s);
     return res;
 }
 
@@ -215,9 +281,17 @@ void cstring::construct_from_literal(const char *string, std::size_t length) {
 }
 
 size_t cstring::cache_size(size_t &count) {
+    auto &interned = cache();
+    std::lock_guard<std::mutex> guard(interned.lock);
     size_t rv = 0;
-    count = cache().size();
-    for (auto &s : cache()) rv += sizeof(s) + s.length();
+    count = interned.count;
+    if (auto *table = interned.table.load(std::memory_order_relaxed)) {
+        for (size_t i = 0; i <= table->mask; ++i) {
+            if (table->tags[i].load(std::memory_order_relaxed) == 0) continue;
+            const auto *entry = table->entries[i].load(std::memory_order_relaxed);
+            rv += sizeof(*entry) + entry->length();
+        }
+    }
     return rv;
 }
 
@@ -268,44 +342,48 @@ cstring cstring::indent(size_t amount) const {
     return cstring(absl::StrCat(spaces, absl::StrReplaceAll(string_view(), {{"\n", spc}})));
 }
 
-// See https://stackoverflow.com/a/33799784/4538702
 cstring cstring::escapeJson() const {
     std::ostringstream o;
-    for (size_t i = 0; i < size(); i++) {
-        char c = get(i);
+    escapeJson(o, string_view());
+    return cstring(o.str());
+}
+
+// See https://stackoverflow.com/a/33799784/4538702
+void cstring::escapeJson(std::ostream &out, std::string_view str) {
+    for (char c : str) {
         switch (c) {
             case '"':
-                o << "\\\"";
+                out << "\\\"";
                 break;
             case '\\':
-                o << "\\\\";
+                out << "\\\\";
                 break;
             case '\b':
-                o << "\\b";
+                out << "\\b";
                 break;
             case '\f':
-                o << "\\f";
+                out << "\\f";
                 break;
             case '\n':
-                o << "\\n";
+                out << "\\n";
                 break;
             case '\r':
-                o << "\\r";
+                out << "\\r";
                 break;
             case '\t':
-                o << "\\t";
+                out << "\\t";
                 break;
             default: {
                 if ('\x00' <= c && c <= '\x1f') {
-                    o << "\\u" << std::hex << std::setw(4) << std::setfill('0')
-                      << static_cast<int>(c);
+                    // Written by hand, so the flags of @p out are not changed.
+                    static const char digits[] = "0123456789abcdef";
+                    out << "\\u00" << digits[c >> 4] << digits[c & 0xf];
                 } else {
-                    o << c;
+                    out << c;
                 }
             }
         }
     }
-    return cstring(o.str());
 }
 
 cstring cstring::toUpper() const {
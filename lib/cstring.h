@@ -54,8 +54,10 @@ limitations under the License.
  *     std::string.
  *   - Interned strings can never be freed, so they'll stick around for the
  *     lifetime of the program.
- *   - The string interning cstring performs is currently not threadsafe, so you
- *     can't safely use cstrings off the main thread.
+ *   - Interning is threadsafe. Looking up an interned string takes no lock,
+ *     interning a new one takes the single lock of the cache. With the garbage
+ *     collector, threads creating cstrings have to be registered with it, like
+ *     threads doing any other allocation.
  *
  * Given these tradeoffs, the general rule of thumb to follow is that you should
  * try to convert strings to cstrings early and keep them in that form. That
@@ -175,6 +177,8 @@ class cstring {
     /// are properly escaped to make this into a json string (without
     /// the enclosing quotes).
     cstring escapeJson() const;
+    /// Writes @p str to @p out escaped like escapeJson().
+    static void escapeJson(std::ostream &out, std::string_view str);
 
     template <typename Iter>
     cstring(Iter begin, Iter end) {
@@ -18,6 +18,7 @@ limitations under the License.
 #define LIB_ERROR_REPORTER_H_
 
 #include <iostream>
+#include <mutex>
 #include <ostream>
 #include <set>
 #include <type_traits>
@@ -58,6 +59,9 @@ class ErrorReporter {
     /// Track errors or warnings that have already been issued for a particular source location
     std::set<std::pair<int, const Util::SourceInfo>> errorTracker;
 
+    /// Serializes diagnostics reported by concurrent threads, e.g. the workers of p4testgen.
+    static inline std::recursive_mutex diagnosticMutex;
+
     /// Output the message and flush the stream
     virtual void emit_message(const ErrorMessage &msg) {
         *outputstream << msg.toString();
@@ -113,6 +117,7 @@ class ErrorReporter {
     template <class T, typename = decltype(std::declval<T>()->getSourceInfo()), typename... Args>
     void diagnose(DiagnosticAction action, const int errorCode, const char *format,
                   const char *suffix, T node, Args &&...args) {
+        std::lock_guard<std::recursive_mutex> lock(diagnosticMutex);
         if (!node || error_reported(errorCode, node->getSourceInfo())) return;
 
         if (cstring name = get_error_name(errorCode))
@@ -138,6 +143,7 @@ class ErrorReporter {
     void diagnose(DiagnosticAction action, const char *diagnosticName, const char *format,
                   const char *suffix, Args &&...args) {
         if (action == DiagnosticAction::Ignore) return;
+        std::lock_guard<std::recursive_mutex> lock(diagnosticMutex);
 
         ErrorMessage::MessageType msgType = ErrorMessage::MessageType::None;
         if (action == DiagnosticAction::Info) {
@@ -35,6 +35,7 @@ limitations under the License.
 #endif /* HAVE_LIBGC */
 #include <sys/mman.h>
 
+#include <atomic>
 #include <cstddef>
 #include <cstring>
 #include <new>
@@ -59,14 +60,21 @@ static char *emergency_ptr;
 
 static alloc_trace_cb_t trace_cb;
 static bool tracing = false;
-#define TRACE_ALLOC(size)                                  \
-    if (trace_cb.fn && !tracing) {                         \
-        void *buffer[ALLOC_TRACE_DEPTH];                   \
-        tracing = true;                                    \
-        absl::GetStackTrace(buffer, ALLOC_TRACE_DEPTH, 1); \
-        trace_cb.fn(trace_cb.arg, buffer, size);           \
-        tracing = false;                                   \
+static std::atomic<bool> counting_allocs;
+static std::atomic<size_t> alloc_count, alloc_bytes;
+#define TRACE_ALLOC_SKIP(size, skip)                            \
+    if (counting_allocs.load(std::memory_order_relaxed)) {      \
+        alloc_count.fetch_add(1, std::memory_order_relaxed);    \
+        alloc_bytes.fetch_add(size, std::memory_order_relaxed); \
+    }                                                           \
+    if (trace_cb.fn && !tracing) {                              \
+        void *buffer[ALLOC_TRACE_DEPTH];                        \
+        tracing = true;                                         \
+        absl::GetStackTrace(buffer, ALLOC_TRACE_DEPTH, skip);   \
+        trace_cb.fn(trace_cb.arg, buffer, size);                \
+        tracing = false;                                        \
     }
+#define TRACE_ALLOC(size) TRACE_ALLOC_SKIP(size, 1)
 
 static void maybe_initialize_gc() {
     if (!done_init) {
@@ -321,6 +329,32 @@ void setup_gc_logging() {
 #endif /* HAVE_LIBGC */
 }
 
+void gc_trace_alloc(size_t size, int skip) {
+#if HAVE_LIBGC
+    TRACE_ALLOC_SKIP(size, skip + 1)
+#else
+    (void)size;
+    (void)skip;
+#endif
+}
+
+void gc_count_allocs(bool enable) {
+#if HAVE_LIBGC
+    counting_allocs.store(enable, std::memory_order_relaxed);
+#else
+    (void)enable;
+#endif
+}
+
+alloc_stats_t gc_alloc_stats() {
+#if HAVE_LIBGC
+    return {alloc_count.load(std::memory_order_relaxed),
+            alloc_bytes.load(std::memory_order_relaxed)};
+#else
+    return {0, 0};
+#endif
+}
+
 size_t gc_mem_inuse(size_t *max) {
 #if HAVE_LIBGC
     GC_word heapsize, heapfree;
@@ -31,4 +31,16 @@ struct alloc_trace_cb_t {
 alloc_trace_cb_t set_alloc_trace(alloc_trace_cb_t cb);
 alloc_trace_cb_t set_alloc_trace(void (*fn)(void *arg, void **pc, size_t sz), void *arg);
 
+// Totals of the allocations done through operator new while counting is enabled.
+// Allocations can only be counted when the garbage collector provides operator new.
+struct alloc_stats_t {
+    size_t count;
+    size_t bytes;
+};
+void gc_count_allocs(bool enable);
+alloc_stats_t gc_alloc_stats();
+// Counts and traces an allocation made without operator new, such as an object placed in an
+// Arena. @skip is the number of allocator frames to leave out of the traced backtrace.
+void gc_trace_alloc(size_t size, int skip);
+
 #endif /* LIB_GC_H_ */
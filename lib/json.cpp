@@ -210,4 +210,103 @@ JsonObject *JsonObject::emplace_non_null(cstring label, IJson *value) {
     return this;
 }
 
+void JsonWriter::newline() {
+    // Not IndentCtl::endl, which flushes the stream.
+    if (!compact) out << '\n' << indent_t::getindent(out);
+}
+
+void JsonWriter::string(std::string_view str) {
+    out << '"';
+    cstring::escapeJson(out, str);
+    out << '"';
+}
+
+void JsonWriter::beginValue(bool isValue) {
+    if (scopes.empty()) {
+        if (wroteTopLevel) throw std::logic_error("Json value after the top-level value");
+        wroteTopLevel = true;
+        return;
+    }
+    auto &scope = scopes.back();
+    if (scope.isObject) {
+        if (!hasKey) throw std::logic_error("Json object member without a key");
+        hasKey = false;
+        return;
+    }
+    if (scope.first) {
+        scope.isSmall = isValue;
+        if (!scope.isSmall) out << IndentCtl::indent;
+    } else {
+        out << ",";
+        if (scope.isSmall && !compact) out << " ";
+    }
+    if (!scope.isSmall) newline();
+    scope.first = false;
+}
+
+JsonWriter &JsonWriter::beginObject() {
+    beginValue(false);
+    out << "{" << IndentCtl::indent;
+    scopes.push_back({true});
+    return *this;
+}
+
+JsonWriter &JsonWriter::endObject() {
+    if (scopes.empty() || !scopes.back().isObject || hasKey)
+        throw std::logic_error("Unbalanced end of json object");
+    scopes.pop_back();
+    out << IndentCtl::unindent;
+    newline();
+    out << "}";
+    return *this;
+}
+
+JsonWriter &JsonWriter::beginArray() {
+    beginValue(false);
+    out << "[";
+    scopes.push_back({false});
+    return *this;
+}
+
+JsonWriter &JsonWriter::endArray() {
+    if (scopes.empty() || scopes.back().isObject)
+        throw std::logic_error("Unbalanced end of json array");
+    if (!scopes.back().isSmall && !scopes.back().first) {
+        out << IndentCtl::unindent;
+        newline();
+    }
+    scopes.pop_back();
+    out << "]";
+    return *this;
+}
+
+JsonWriter &JsonWriter::key(std::string_view label) {
+    if (label.empty()) throw std::logic_error("Empty label");
+    if (scopes.empty() || !scopes.back().isObject || hasKey)
+        throw std::logic_error(absl::StrCat("Json key ", label, " outside of an object"));
+    auto &scope = scopes.back();
+    if (!scope.first) out << ",";
+    scope.first = false;
+    newline();
+    string(label);
+    out << (compact ? ":" : " : ");
+    hasKey = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(const JsonValue &v) {
+    beginValue(true);
+    v.serialize(out);
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(const IJson *json) {
+    beginValue(json == nullptr || json->is<JsonValue>());
+    if (json == nullptr)
+        out << "null";
+    else
+        json->serialize(out);
+    return *this;
+}
+
 }  // namespace P4::Util
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include <iostream>
 #include <stdexcept>
+#include <string_view>
 #include <type_traits>
 #include <vector>
 
@@ -204,6 +205,89 @@ class JsonObject final : public IJson, public string_map<IJson *> {
     DECLARE_TYPEINFO(JsonObject, IJson);
 };
 
+/// Writes JSON to a stream as it is produced, in the format of IJson::serialize, so large
+/// outputs do not have to be built as JsonObject/JsonArray trees first.  Objects and arrays
+/// are opened and closed explicitly, and object members are written as key() followed by
+/// exactly one value or container:
+///
+///     JsonWriter json(out);
+///     json.beginObject();
+///     json.member("name", name);
+///     json.key("tables").beginArray();
+///     ...
+///     json.endArray();
+///     json.endObject();
+///
+/// IJson::serialize writes an array on one line if all its elements are values; the writer
+/// decides this by the first element of the array.  A compact writer puts everything on one
+/// line without spaces, e.g. for JSON-lines records.
+///
+/// Keys and string values are escaped with cstring::escapeJson.  JsonValue and IJson arguments
+/// are written like IJson::serialize does, so their strings have to be escaped already.
+class JsonWriter {
+    struct Scope {
+        bool isObject;
+        bool first = true;
+        /// An array whose elements are written on one line.
+        bool isSmall = false;
+    };
+
+    std::ostream &out;
+    bool compact;
+    std::vector<Scope> scopes;
+    /// Set by key() until the value of the member is written.
+    bool hasKey = false;
+    bool wroteTopLevel = false;
+
+    /// Writes the separators before a value; @p isValue is false for objects and arrays.
+    void beginValue(bool isValue);
+    void newline();
+    void string(std::string_view str);
+
+ public:
+    explicit JsonWriter(std::ostream &out, bool compact = false) : out(out), compact(compact) {}
+
+    JsonWriter &beginObject();
+    JsonWriter &endObject();
+    JsonWriter &beginArray();
+    JsonWriter &endArray();
+    /// Starts a member of the current object.
+    JsonWriter &key(std::string_view label);
+
+    JsonWriter &value(const JsonValue &v);
+    /// Writes a tree built with the JsonObject/JsonArray API, or null.
+    JsonWriter &value(const IJson *json);
+    template <class T>
+    auto value(T &&v) -> std::enable_if_t<!std::is_convertible_v<T, const IJson *> &&
+                                              !std::is_same_v<std::decay_t<T>, JsonValue>,
+                                          JsonWriter &> {
+        using V = std::decay_t<T>;
+        if constexpr (std::is_same_v<V, bool>) {
+            beginValue(true);
+            out << (v ? "true" : "false");
+        } else if constexpr (std::is_arithmetic_v<V> && !std::is_same_v<V, char>) {
+            // Formatted like JsonValue, without converting to big_int first.
+            beginValue(true);
+            out << v;
+        } else if constexpr (std::is_convertible_v<const V &, std::string_view>) {
+            beginValue(true);
+            string(v);
+        } else {
+            return value(JsonValue(std::forward<T>(v)));
+        }
+        return *this;
+    }
+
+    template <class T>
+    JsonWriter &member(std::string_view label, T &&v) {
+        key(label);
+        return value(std::forward<T>(v));
+    }
+
+    /// True once a complete top-level value has been written.
+    bool done() const { return wroteTopLevel && scopes.empty(); }
+};
+
 }  // namespace P4::Util
 
 #endif /* LIB_JSON_H_ */
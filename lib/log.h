@@ -42,7 +42,8 @@ extern int maximumLogLevel;
 
 // Used to restrict logging to a specific IR context.
 extern bool enableLoggingGlobally;
-extern bool enableLoggingInContext;  // if enableLoggingGlobally is true, this is ignored.
+// Set per thread while visiting IR nodes; ignored if enableLoggingGlobally is true.
+extern thread_local bool enableLoggingInContext;
 
 // Look up the log level of @file.
 int fileLogLevel(const char *file);
@@ -18,6 +18,18 @@
 #include <arpa/inet.h>
 
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+#include "lib/exceptions.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 /** \file
  * \author Antonin Bas (antonin@barefootnetworks.com) (the behavioral-model version)
@@ -27,152 +39,253 @@
  * https://github.com/p4lang/behavioral-model/blob/main/src/bm_sim/calculations.cpp
  * which was in turn adapted from
  * http://www.barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+ * The CRCs use the slice-by-8 algorithm, with tables generated at compile time.
  */
 
 namespace P4::NetHash {
 
-/// Reflects/reverse n-bit number bit-by-bit. Note that it also solves as a slicing cast in the main
-/// calculation loop, where it extracts and reflect lowest byte. Written as templated function
-/// inside non-teplated class to allow passing the entire thing into crcGeneric and them templating
-/// it with two different types inside.
-struct Reflect {
-    template <typename T>
-    static T op(T data) {
-        const int nBits = sizeof(T) * 8;
-        T reflection = 0;
-
-        // Reflect the data about the center bit.
-        for (int bit = 0; bit < nBits; ++bit) {
-            // If the LSB bit is set, set the reflection of it.
-            if (data & 0x01) {
-                reflection |= (T(1) << ((nBits - 1) - bit));
+namespace {
+
+/// Reflects/reverses the lowest @p width bits of @p value bit-by-bit.
+constexpr uint64_t reflect(uint64_t value, unsigned width) {
+    uint64_t reflection = 0;
+    for (unsigned bit = 0; bit < width; ++bit, value >>= 1)
+        reflection = (reflection << 1) | (value & 1);
+    return reflection;
+}
+
+constexpr uint64_t widthMask(unsigned width) {
+    return width >= 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+}
+
+/// Loads 8 bytes of the input, so that the first byte ends up in the lowest (@p littleEndian) or
+/// in the highest byte of the result.
+uint64_t load64(const uint8_t *buf, bool littleEndian) {
+    uint64_t word;
+    memcpy(&word, buf, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return littleEndian ? word : __builtin_bswap64(word);
+#else
+    return littleEndian ? __builtin_bswap64(word) : word;
+#endif
+}
+
+/// Lookup tables of a CRC for the slice-by-8 algorithm, for CRCs of up to sizeof(T) * 8 bits.
+/// The CRC register is kept in T: reflected CRCs keep it in the lowest bits and shift it right,
+/// the others keep it in the highest bits and shift it left. The tables do not depend on the
+/// initial value and the final xor, which are applied by start() and finish().
+template <typename T>
+struct CrcTables {
+    static constexpr unsigned BITS = sizeof(T) * 8;
+
+    unsigned width;
+    uint64_t poly;
+    bool reflected;
+
+    /// table[k][byte] is the register after processing @p byte followed by k zero bytes,
+    /// starting from a zero register.
+    std::array<std::array<T, 256>, 8> table;
+
+    constexpr CrcTables(unsigned width, uint64_t poly, bool reflected)
+        : width(width), poly(poly & widthMask(width)), reflected(reflected), table() {
+        T shifted = reflected ? T(reflect(this->poly, width)) : T(this->poly << (BITS - width));
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            T reg = reflected ? T(byte) : T(T(byte) << (BITS - 8));
+            for (int bit = 0; bit < 8; ++bit) {
+                if (reflected)
+                    reg = (reg & 1) ? T(reg >> 1) ^ shifted : T(reg >> 1);
+                else
+                    reg = (reg >> (BITS - 1)) ? T(reg << 1) ^ shifted : T(reg << 1);
+            }
+            table[0][byte] = reg;
+        }
+        for (unsigned k = 1; k < 8; ++k) {
+            for (unsigned byte = 0; byte < 256; ++byte) {
+                T prev = table[k - 1][byte];
+                table[k][byte] = reflected ? T(prev >> 8) ^ table[0][prev & 0xff]
+                                           : T(prev << 8) ^ table[0][prev >> (BITS - 8)];
+            }
+        }
+    }
+
+    /// @returns the register initialized to @p init.
+    T start(uint64_t init) const {
+        init &= widthMask(width);
+        return reflected ? T(reflect(init, width)) : T(init << (BITS - width));
+    }
+
+    /// @returns the CRC for the register @p reg.
+    uint64_t finish(T reg, uint64_t xorOut) const {
+        uint64_t result = reflected ? uint64_t(reg) : uint64_t(reg) >> (BITS - width);
+        return (result ^ xorOut) & widthMask(width);
+    }
+
+    /// Processes @p len bytes of @p buf, 8 bytes per step.
+    template <bool Reflected>
+    T update(T reg, const uint8_t *buf, size_t len) const {
+        for (; len >= 8; buf += 8, len -= 8) {
+            // The register is xor-ed to the first bytes, the table lookups then shift each byte
+            // through the remaining bytes of the step.
+            if (Reflected) {
+                uint64_t word = load64(buf, true) ^ reg;
+                reg = table[7][word & 0xff] ^ table[6][(word >> 8) & 0xff] ^
+                      table[5][(word >> 16) & 0xff] ^ table[4][(word >> 24) & 0xff] ^
+                      table[3][(word >> 32) & 0xff] ^ table[2][(word >> 40) & 0xff] ^
+                      table[1][(word >> 48) & 0xff] ^ table[0][word >> 56];
+            } else {
+                uint64_t word = load64(buf, false) ^ (uint64_t(reg) << (64 - BITS));
+                reg = table[7][word >> 56] ^ table[6][(word >> 48) & 0xff] ^
+                      table[5][(word >> 40) & 0xff] ^ table[4][(word >> 32) & 0xff] ^
+                      table[3][(word >> 24) & 0xff] ^ table[2][(word >> 16) & 0xff] ^
+                      table[1][(word >> 8) & 0xff] ^ table[0][word & 0xff];
             }
-            data = (data >> 1);
         }
+        for (; len > 0; ++buf, --len) {
+            if (Reflected)
+                reg = table[0][(reg ^ *buf) & 0xff] ^ T(reg >> 8);
+            else
+                reg = table[0][(reg >> (BITS - 8)) ^ *buf] ^ T(reg << 8);
+        }
+        return reg;
+    }
 
-        return reflection;
+    T update(T reg, const uint8_t *buf, size_t len) const {
+        return reflected ? update<true>(reg, buf, len) : update<false>(reg, buf, len);
     }
-};
 
-/// A class with the same signature as reflect, but just returning the data.
-struct Identity {
-    template <typename T>
-    static T op(T data) {
-        return data;
+    uint64_t compute(const uint8_t *buf, size_t len, uint64_t init, uint64_t xorOut) const {
+        return finish(update(start(init), buf, len), xorOut);
     }
 };
 
-template <typename T, T remainderInit, T final_xor_value, auto table, typename MaybeReflect>
-T crcGeneric(const uint8_t *buf, size_t len) {
-    T remainder = remainderInit;
-    for (unsigned int byte = 0; byte < len; byte++) {
-        auto data =
-            MaybeReflect::template op<uint8_t>(buf[byte]) ^ (remainder >> (sizeof(T) * 8 - 8));
-        remainder = table[data] ^ (remainder << 8);
-    }
-    return MaybeReflect::template op<T>(remainder) ^ final_xor_value;
-}
-
-static const uint16_t table_crc16[256] = {
-    0x0000, 0x8005, 0x800F, 0x000A, 0x801B, 0x001E, 0x0014, 0x8011, 0x8033, 0x0036, 0x003C, 0x8039,
-    0x0028, 0x802D, 0x8027, 0x0022, 0x8063, 0x0066, 0x006C, 0x8069, 0x0078, 0x807D, 0x8077, 0x0072,
-    0x0050, 0x8055, 0x805F, 0x005A, 0x804B, 0x004E, 0x0044, 0x8041, 0x80C3, 0x00C6, 0x00CC, 0x80C9,
-    0x00D8, 0x80DD, 0x80D7, 0x00D2, 0x00F0, 0x80F5, 0x80FF, 0x00FA, 0x80EB, 0x00EE, 0x00E4, 0x80E1,
-    0x00A0, 0x80A5, 0x80AF, 0x00AA, 0x80BB, 0x00BE, 0x00B4, 0x80B1, 0x8093, 0x0096, 0x009C, 0x8099,
-    0x0088, 0x808D, 0x8087, 0x0082, 0x8183, 0x0186, 0x018C, 0x8189, 0x0198, 0x819D, 0x8197, 0x0192,
-    0x01B0, 0x81B5, 0x81BF, 0x01BA, 0x81AB, 0x01AE, 0x01A4, 0x81A1, 0x01E0, 0x81E5, 0x81EF, 0x01EA,
-    0x81FB, 0x01FE, 0x01F4, 0x81F1, 0x81D3, 0x01D6, 0x01DC, 0x81D9, 0x01C8, 0x81CD, 0x81C7, 0x01C2,
-    0x0140, 0x8145, 0x814F, 0x014A, 0x815B, 0x015E, 0x0154, 0x8151, 0x8173, 0x0176, 0x017C, 0x8179,
-    0x0168, 0x816D, 0x8167, 0x0162, 0x8123, 0x0126, 0x012C, 0x8129, 0x0138, 0x813D, 0x8137, 0x0132,
-    0x0110, 0x8115, 0x811F, 0x011A, 0x810B, 0x010E, 0x0104, 0x8101, 0x8303, 0x0306, 0x030C, 0x8309,
-    0x0318, 0x831D, 0x8317, 0x0312, 0x0330, 0x8335, 0x833F, 0x033A, 0x832B, 0x032E, 0x0324, 0x8321,
-    0x0360, 0x8365, 0x836F, 0x036A, 0x837B, 0x037E, 0x0374, 0x8371, 0x8353, 0x0356, 0x035C, 0x8359,
-    0x0348, 0x834D, 0x8347, 0x0342, 0x03C0, 0x83C5, 0x83CF, 0x03CA, 0x83DB, 0x03DE, 0x03D4, 0x83D1,
-    0x83F3, 0x03F6, 0x03FC, 0x83F9, 0x03E8, 0x83ED, 0x83E7, 0x03E2, 0x83A3, 0x03A6, 0x03AC, 0x83A9,
-    0x03B8, 0x83BD, 0x83B7, 0x03B2, 0x0390, 0x8395, 0x839F, 0x039A, 0x838B, 0x038E, 0x0384, 0x8381,
-    0x0280, 0x8285, 0x828F, 0x028A, 0x829B, 0x029E, 0x0294, 0x8291, 0x82B3, 0x02B6, 0x02BC, 0x82B9,
-    0x02A8, 0x82AD, 0x82A7, 0x02A2, 0x82E3, 0x02E6, 0x02EC, 0x82E9, 0x02F8, 0x82FD, 0x82F7, 0x02F2,
-    0x02D0, 0x82D5, 0x82DF, 0x02DA, 0x82CB, 0x02CE, 0x02C4, 0x82C1, 0x8243, 0x0246, 0x024C, 0x8249,
-    0x0258, 0x825D, 0x8257, 0x0252, 0x0270, 0x8275, 0x827F, 0x027A, 0x826B, 0x026E, 0x0264, 0x8261,
-    0x0220, 0x8225, 0x822F, 0x022A, 0x823B, 0x023E, 0x0234, 0x8231, 0x8213, 0x0216, 0x021C, 0x8219,
-    0x0208, 0x820D, 0x8207, 0x0202};
-
-static const uint16_t table_crcCCITT[256] = {
-    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7, 0x8108, 0x9129, 0xA14A, 0xB16B,
-    0xC18C, 0xD1AD, 0xE1CE, 0xF1EF, 0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
-    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE, 0x2462, 0x3443, 0x0420, 0x1401,
-    0x64E6, 0x74C7, 0x44A4, 0x5485, 0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
-    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4, 0xB75B, 0xA77A, 0x9719, 0x8738,
-    0xF7DF, 0xE7FE, 0xD79D, 0xC7BC, 0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
-    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B, 0x5AF5, 0x4AD4, 0x7AB7, 0x6A96,
-    0x1A71, 0x0A50, 0x3A33, 0x2A12, 0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
-    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41, 0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD,
-    0xAD2A, 0xBD0B, 0x8D68, 0x9D49, 0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
-    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78, 0x9188, 0x81A9, 0xB1CA, 0xA1EB,
-    0xD10C, 0xC12D, 0xF14E, 0xE16F, 0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
-    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E, 0x02B1, 0x1290, 0x22F3, 0x32D2,
-    0x4235, 0x5214, 0x6277, 0x7256, 0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
-    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405, 0xA7DB, 0xB7FA, 0x8799, 0x97B8,
-    0xE75F, 0xF77E, 0xC71D, 0xD73C, 0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
-    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB, 0x5844, 0x4865, 0x7806, 0x6827,
-    0x18C0, 0x08E1, 0x3882, 0x28A3, 0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
-    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92, 0xFD2E, 0xED0F, 0xDD6C, 0xCD4D,
-    0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9, 0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
-    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8, 0x6E17, 0x7E36, 0x4E55, 0x5E74,
-    0x2E93, 0x3EB2, 0x0ED1, 0x1EF0};
-
-static const uint32_t table_crc32[256] = {
-    0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9, 0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
-    0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61, 0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD,
-    0x4C11DB70, 0x48D0C6C7, 0x4593E01E, 0x4152FDA9, 0x5F15ADAC, 0x5BD4B01B, 0x569796C2, 0x52568B75,
-    0x6A1936C8, 0x6ED82B7F, 0x639B0DA6, 0x675A1011, 0x791D4014, 0x7DDC5DA3, 0x709F7B7A, 0x745E66CD,
-    0x9823B6E0, 0x9CE2AB57, 0x91A18D8E, 0x95609039, 0x8B27C03C, 0x8FE6DD8B, 0x82A5FB52, 0x8664E6E5,
-    0xBE2B5B58, 0xBAEA46EF, 0xB7A96036, 0xB3687D81, 0xAD2F2D84, 0xA9EE3033, 0xA4AD16EA, 0xA06C0B5D,
-    0xD4326D90, 0xD0F37027, 0xDDB056FE, 0xD9714B49, 0xC7361B4C, 0xC3F706FB, 0xCEB42022, 0xCA753D95,
-    0xF23A8028, 0xF6FB9D9F, 0xFBB8BB46, 0xFF79A6F1, 0xE13EF6F4, 0xE5FFEB43, 0xE8BCCD9A, 0xEC7DD02D,
-    0x34867077, 0x30476DC0, 0x3D044B19, 0x39C556AE, 0x278206AB, 0x23431B1C, 0x2E003DC5, 0x2AC12072,
-    0x128E9DCF, 0x164F8078, 0x1B0CA6A1, 0x1FCDBB16, 0x018AEB13, 0x054BF6A4, 0x0808D07D, 0x0CC9CDCA,
-    0x7897AB07, 0x7C56B6B0, 0x71159069, 0x75D48DDE, 0x6B93DDDB, 0x6F52C06C, 0x6211E6B5, 0x66D0FB02,
-    0x5E9F46BF, 0x5A5E5B08, 0x571D7DD1, 0x53DC6066, 0x4D9B3063, 0x495A2DD4, 0x44190B0D, 0x40D816BA,
-    0xACA5C697, 0xA864DB20, 0xA527FDF9, 0xA1E6E04E, 0xBFA1B04B, 0xBB60ADFC, 0xB6238B25, 0xB2E29692,
-    0x8AAD2B2F, 0x8E6C3698, 0x832F1041, 0x87EE0DF6, 0x99A95DF3, 0x9D684044, 0x902B669D, 0x94EA7B2A,
-    0xE0B41DE7, 0xE4750050, 0xE9362689, 0xEDF73B3E, 0xF3B06B3B, 0xF771768C, 0xFA325055, 0xFEF34DE2,
-    0xC6BCF05F, 0xC27DEDE8, 0xCF3ECB31, 0xCBFFD686, 0xD5B88683, 0xD1799B34, 0xDC3ABDED, 0xD8FBA05A,
-    0x690CE0EE, 0x6DCDFD59, 0x608EDB80, 0x644FC637, 0x7A089632, 0x7EC98B85, 0x738AAD5C, 0x774BB0EB,
-    0x4F040D56, 0x4BC510E1, 0x46863638, 0x42472B8F, 0x5C007B8A, 0x58C1663D, 0x558240E4, 0x51435D53,
-    0x251D3B9E, 0x21DC2629, 0x2C9F00F0, 0x285E1D47, 0x36194D42, 0x32D850F5, 0x3F9B762C, 0x3B5A6B9B,
-    0x0315D626, 0x07D4CB91, 0x0A97ED48, 0x0E56F0FF, 0x1011A0FA, 0x14D0BD4D, 0x19939B94, 0x1D528623,
-    0xF12F560E, 0xF5EE4BB9, 0xF8AD6D60, 0xFC6C70D7, 0xE22B20D2, 0xE6EA3D65, 0xEBA91BBC, 0xEF68060B,
-    0xD727BBB6, 0xD3E6A601, 0xDEA580D8, 0xDA649D6F, 0xC423CD6A, 0xC0E2D0DD, 0xCDA1F604, 0xC960EBB3,
-    0xBD3E8D7E, 0xB9FF90C9, 0xB4BCB610, 0xB07DABA7, 0xAE3AFBA2, 0xAAFBE615, 0xA7B8C0CC, 0xA379DD7B,
-    0x9B3660C6, 0x9FF77D71, 0x92B45BA8, 0x9675461F, 0x8832161A, 0x8CF30BAD, 0x81B02D74, 0x857130C3,
-    0x5D8A9099, 0x594B8D2E, 0x5408ABF7, 0x50C9B640, 0x4E8EE645, 0x4A4FFBF2, 0x470CDD2B, 0x43CDC09C,
-    0x7B827D21, 0x7F436096, 0x7200464F, 0x76C15BF8, 0x68860BFD, 0x6C47164A, 0x61043093, 0x65C52D24,
-    0x119B4BE9, 0x155A565E, 0x18197087, 0x1CD86D30, 0x029F3D35, 0x065E2082, 0x0B1D065B, 0x0FDC1BEC,
-    0x3793A651, 0x3352BBE6, 0x3E119D3F, 0x3AD08088, 0x2497D08D, 0x2056CD3A, 0x2D15EBE3, 0x29D4F654,
-    0xC5A92679, 0xC1683BCE, 0xCC2B1D17, 0xC8EA00A0, 0xD6AD50A5, 0xD26C4D12, 0xDF2F6BCB, 0xDBEE767C,
-    0xE3A1CBC1, 0xE760D676, 0xEA23F0AF, 0xEEE2ED18, 0xF0A5BD1D, 0xF464A0AA, 0xF9278673, 0xFDE69BC4,
-    0x89B8FD09, 0x8D79E0BE, 0x803AC667, 0x84FBDBD0, 0x9ABC8BD5, 0x9E7D9662, 0x933EB0BB, 0x97FFAD0C,
-    0xAFB010B1, 0xAB710D06, 0xA6322BDF, 0xA2F33668, 0xBCB4666D, 0xB8757BDA, 0xB5365D03, 0xB1F740B4};
-
-uint16_t crc16(const uint8_t *buf, size_t len) {
-    return crcGeneric<uint16_t, 0, 0, table_crc16, Reflect>(buf, len);
+constexpr uint64_t POLY_CRC16 = 0x8005;
+constexpr uint64_t POLY_CCITT = 0x1021;
+constexpr uint64_t POLY_CRC32 = 0x04C11DB7;
+
+constexpr CrcTables<uint16_t> TABLES_CRC16(16, POLY_CRC16, true);
+constexpr CrcTables<uint16_t> TABLES_CRC16_ANSI(16, POLY_CRC16, false);
+constexpr CrcTables<uint16_t> TABLES_CCITT(16, POLY_CCITT, false);
+constexpr CrcTables<uint32_t> TABLES_CRC32(32, POLY_CRC32, true);
+constexpr CrcTables<uint32_t> TABLES_CRC32_FCS(32, POLY_CRC32, false);
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define NETHASH_CLMUL 1
+
+#define NETHASH_CLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+
+NETHASH_CLMUL_TARGET inline __m128i load(const uint8_t *buf) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf));
 }
 
-uint16_t crc16ANSI(const uint8_t *buf, size_t len) {
-    return crcGeneric<uint16_t, 0, 0, table_crc16, Identity>(buf, len);
+/// Folds the 128 bits of @p x forward by the distance given by the constants @p k onto @p next.
+NETHASH_CLMUL_TARGET inline __m128i fold(__m128i x, __m128i k, __m128i next) {
+    return _mm_xor_si128(
+        _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11)), next);
 }
 
-uint32_t crc32(const uint8_t *buf, size_t len) {
-    return crcGeneric<uint32_t, 0xffffffff, 0xffffffff, table_crc32, Reflect>(buf, len);
+/// Folds the reflected CRC-32 register @p reg over a multiple of 16 bytes of @p buf (at least
+/// 64) with carry-less multiplication, as described in "Fast CRC Computation for Generic
+/// Polynomials Using PCLMULQDQ Instruction" (Intel, 2009). The constants are x^(32 * n) mod P
+/// for the fold distances of 512, 128 and 64 bits, followed by the Barrett reduction constants,
+/// all bit-reflected.
+NETHASH_CLMUL_TARGET uint32_t crc32Clmul(uint32_t reg, const uint8_t *buf, size_t len) {
+    const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+    const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    const __m128i k5 = _mm_set_epi64x(0, 0x0163cd6124);
+    const __m128i barrett = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+    const __m128i low32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    __m128i x1 = _mm_xor_si128(load(buf), _mm_cvtsi32_si128(static_cast<int>(reg)));
+    __m128i x2 = load(buf + 16);
+    __m128i x3 = load(buf + 32);
+    __m128i x4 = load(buf + 48);
+    for (buf += 64, len -= 64; len >= 64; buf += 64, len -= 64) {
+        x1 = fold(x1, k1k2, load(buf));
+        x2 = fold(x2, k1k2, load(buf + 16));
+        x3 = fold(x3, k1k2, load(buf + 32));
+        x4 = fold(x4, k1k2, load(buf + 48));
+    }
+    x1 = fold(x1, k3k4, x2);
+    x1 = fold(x1, k3k4, x3);
+    x1 = fold(x1, k3k4, x4);
+    for (; len >= 16; buf += 16, len -= 16) x1 = fold(x1, k3k4, load(buf));
+
+    // Fold 128 bits to 64 bits, and the Barrett reduction to 32 bits.
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), _mm_clmulepi64_si128(x1, k3k4, 0x10));
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 4),
+                       _mm_clmulepi64_si128(_mm_and_si128(x1, low32), k5, 0x00));
+    __m128i reduced = _mm_clmulepi64_si128(_mm_and_si128(x1, low32), barrett, 0x10);
+    reduced = _mm_clmulepi64_si128(_mm_and_si128(reduced, low32), barrett, 0x00);
+    return static_cast<uint32_t>(_mm_extract_epi32(_mm_xor_si128(x1, reduced), 1));
 }
 
+bool hasClmul() {
+    static const bool supported =
+        __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+    return supported;
+}
+#endif
+
+/// Updates the register of a reflected CRC-32 with polynomial POLY_CRC32, using carry-less
+/// multiplication for the bulk of longer inputs if the CPU supports it.
+uint32_t crc32Update(uint32_t reg, const uint8_t *buf, size_t len) {
+#ifdef NETHASH_CLMUL
+    if (len >= 64 && hasClmul()) {
+        size_t bulk = len & ~size_t(15);
+        reg = crc32Clmul(reg, buf, bulk);
+        buf += bulk;
+        len -= bulk;
+    }
+#endif
+    return TABLES_CRC32.update<true>(reg, buf, len);
+}
+
+/// @returns the tables for a custom CRC, building them on first use.
+template <typename T>
+const CrcTables<T> &customTables(unsigned width, uint64_t poly, bool reflected) {
+    // Most users compute one CRC many times, so the last tables are kept for the thread.
+    thread_local const CrcTables<T> *last = nullptr;
+    poly &= widthMask(width);
+    if (last && last->width == width && last->poly == poly && last->reflected == reflected)
+        return *last;
+
+    static std::mutex mutex;
+    static std::map<std::tuple<unsigned, uint64_t, bool>, std::unique_ptr<CrcTables<T>>> cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &tables = cache[{width, poly, reflected}];
+    if (!tables) tables = std::make_unique<CrcTables<T>>(width, poly, reflected);
+    last = tables.get();
+    return *last;
+}
+
+}  // namespace
+
+uint16_t crc16(const uint8_t *buf, size_t len) { return TABLES_CRC16.compute(buf, len, 0, 0); }
+
+uint16_t crc16ANSI(const uint8_t *buf, size_t len) {
+    return TABLES_CRC16_ANSI.compute(buf, len, 0, 0);
+}
+
+uint32_t crc32(const uint8_t *buf, size_t len) { return ~crc32Update(0xffffffff, buf, len); }
+
 uint32_t crc32FCS(const uint8_t *buf, size_t len) {
-    return crcGeneric<uint32_t, 0xffffffff, 0xffffffff, table_crc32, Identity>(buf, len);
+    return TABLES_CRC32_FCS.compute(buf, len, 0xffffffff, 0xffffffff);
 }
 
 uint16_t crcCCITT(const uint8_t *buf, size_t len) {
-    return crcGeneric<uint16_t, 0xffff, 0, table_crcCCITT, Identity>(buf, len);
+    return TABLES_CCITT.compute(buf, len, 0xffff, 0);
+}
+
+uint64_t crcCustom(const uint8_t *buf, size_t len, unsigned width, uint64_t poly, uint64_t init,
+                   uint64_t xorOut, bool reflect) {
+    BUG_CHECK(width >= 1 && width <= 64, "CRC width %1% is not between 1 and 64", width);
+    if (reflect && width == 32 && (poly & widthMask(32)) == POLY_CRC32) {
+        return TABLES_CRC32.finish(crc32Update(TABLES_CRC32.start(init), buf, len), xorOut);
+    }
+    if (width <= 32) {
+        return customTables<uint32_t>(width, poly, reflect).compute(buf, len, init, xorOut);
+    }
+    return customTables<uint64_t>(width, poly, reflect).compute(buf, len, init, xorOut);
 }
 
 uint16_t csum16(const uint8_t *buf, size_t len) {
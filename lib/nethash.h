@@ -26,6 +26,14 @@ uint32_t crc32(const uint8_t *buf, size_t len);
 /// and xor_out = ~0).
 uint32_t crc32FCS(const uint8_t *buf, size_t len);
 
+/// CRC with arbitrary parameters, as given by the CRC catalogue
+/// (https://reveng.sourceforge.net/crc-catalogue/): a @p width bit CRC (1 to 64 bits) with
+/// polynomial @p poly (without the leading bit), register initialized to @p init, and @p xorOut
+/// xor-ed to the result. If @p reflect is set, the bits of each input byte and of the result are
+/// reflected. The lookup tables are built on first use of a polynomial and cached.
+uint64_t crcCustom(const uint8_t *buf, size_t len, unsigned width, uint64_t poly, uint64_t init,
+                   uint64_t xorOut, bool reflect);
+
 /// 16-bit ones' complement checksum (used in IP, TCP, UDP, ...).
 uint16_t csum16(const uint8_t *buf, size_t len);
 
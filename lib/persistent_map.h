@@ -0,0 +1,256 @@
+#ifndef LIB_PERSISTENT_MAP_H_
+#define LIB_PERSISTENT_MAP_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace P4 {
+
+/// An ordered map whose copies share their structure. The map is an AVL tree of immutable
+/// nodes, so copying a map is O(1) and an update of a copy only replaces the O(log n) nodes
+/// on the path to the updated key; all other nodes stay shared with the other copies.
+/// Nodes which are only referenced by a single map are updated in place, so a sequence of
+/// assignments to the same keys of a map which is not shared does not allocate.
+///
+/// Iteration is in key order, as for std::map and flat_map. There are no mutable
+/// iterators, values are changed with insert_or_assign.
+template <typename K, typename V, typename Compare = std::less<>>
+class persistent_map {
+ public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using key_compare = Compare;
+    using size_type = std::size_t;
+    using reference = const value_type &;
+    using const_reference = const value_type &;
+
+ private:
+    struct Node;
+    using NodePtr = std::shared_ptr<Node>;
+
+    struct Node {
+        value_type value;
+        NodePtr left, right;
+        int height;
+
+        Node(value_type value, NodePtr left, NodePtr right, int height)
+            : value(std::move(value)),
+              left(std::move(left)),
+              right(std::move(right)),
+              height(height) {}
+    };
+
+    NodePtr root;
+    size_type elements = 0;
+    Compare compare;
+
+    static int height(const NodePtr &node) { return node ? node->height : 0; }
+
+    static NodePtr make(value_type value, NodePtr left, NodePtr right) {
+        int h = 1 + std::max(height(left), height(right));
+        return std::make_shared<Node>(std::move(value), std::move(left), std::move(right), h);
+    }
+
+    /// Makes a node from @value and two subtrees whose heights differ by at most two.
+    static NodePtr balance(value_type value, NodePtr left, NodePtr right) {
+        int hl = height(left), hr = height(right);
+        if (hl > hr + 1) {
+            if (height(left->left) >= height(left->right))
+                return make(left->value, left->left,
+                            make(std::move(value), left->right, std::move(right)));
+            return make(left->right->value, make(left->value, left->left, left->right->left),
+                        make(std::move(value), left->right->right, std::move(right)));
+        }
+        if (hr > hl + 1) {
+            if (height(right->right) >= height(right->left))
+                return make(right->value, make(std::move(value), std::move(left), right->left),
+                            right->right);
+            return make(right->left->value,
+                        make(std::move(value), std::move(left), right->left->left),
+                        make(right->value, right->left->right, right->right));
+        }
+        return make(std::move(value), std::move(left), std::move(right));
+    }
+
+    /// Returns a copy of @node's tree with @key mapped to @value.
+    NodePtr assign(const NodePtr &node, const K &key, const V &value, bool &added) const {
+        if (!node) {
+            added = true;
+            return make(value_type(key, value), nullptr, nullptr);
+        }
+        if (compare(key, node->value.first))
+            return balance(node->value, assign(node->left, key, value, added), node->right);
+        if (compare(node->value.first, key))
+            return balance(node->value, node->left, assign(node->right, key, value, added));
+        return std::make_shared<Node>(value_type(node->value.first, value), node->left,
+                                      node->right, node->height);
+    }
+
+    static NodePtr eraseMin(const NodePtr &node) {
+        if (!node->left) return node->right;
+        return balance(node->value, eraseMin(node->left), node->right);
+    }
+
+    /// Returns a copy of @node's tree without @key.
+    NodePtr erase(const NodePtr &node, const K &key, bool &removed) const {
+        if (!node) return nullptr;
+        if (compare(key, node->value.first)) {
+            auto left = erase(node->left, key, removed);
+            return removed ? balance(node->value, std::move(left), node->right) : node;
+        }
+        if (compare(node->value.first, key)) {
+            auto right = erase(node->right, key, removed);
+            return removed ? balance(node->value, node->left, std::move(right)) : node;
+        }
+        removed = true;
+        if (!node->left) return node->right;
+        if (!node->right) return node->left;
+        const Node *min = node->right.get();
+        while (min->left) min = min->left.get();
+        return balance(min->value, node->left, eraseMin(node->right));
+    }
+
+ public:
+    /// Iterates over the map in key order. Iterators remain valid as long as the map they
+    /// were obtained from is not modified.
+    class const_iterator {
+        friend class persistent_map;
+        // The current node, preceded by its ancestors whose value comes after it.
+        std::vector<const Node *> path;
+
+        void pushLeftSpine(const Node *node) {
+            for (; node; node = node->left.get()) path.push_back(node);
+        }
+
+     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = persistent_map::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type *;
+        using reference = const value_type &;
+
+        const_iterator() = default;
+        reference operator*() const { return path.back()->value; }
+        pointer operator->() const { return &path.back()->value; }
+        const_iterator &operator++() {
+            const Node *node = path.back();
+            path.pop_back();
+            pushLeftSpine(node->right.get());
+            return *this;
+        }
+        const_iterator operator++(int) {
+            auto rv = *this;
+            ++*this;
+            return rv;
+        }
+        bool operator==(const const_iterator &other) const {
+            if (path.empty() || other.path.empty()) return path.empty() == other.path.empty();
+            return path.back() == other.path.back();
+        }
+        bool operator!=(const const_iterator &other) const { return !(*this == other); }
+    };
+    using iterator = const_iterator;
+
+    persistent_map() = default;
+    persistent_map(std::initializer_list<value_type> il) {
+        for (const auto &value : il) insert_or_assign(value.first, value.second);
+    }
+
+    const_iterator begin() const {
+        const_iterator rv;
+        rv.pushLeftSpine(root.get());
+        return rv;
+    }
+    const_iterator end() const { return {}; }
+
+    bool empty() const { return elements == 0; }
+    size_type size() const { return elements; }
+    void clear() {
+        root = nullptr;
+        elements = 0;
+    }
+
+    const_iterator find(const K &key) const {
+        const_iterator rv;
+        for (const Node *node = root.get(); node;) {
+            if (compare(key, node->value.first)) {
+                rv.path.push_back(node);
+                node = node->left.get();
+            } else if (compare(node->value.first, key)) {
+                node = node->right.get();
+            } else {
+                rv.path.push_back(node);
+                return rv;
+            }
+        }
+        return end();
+    }
+    size_type count(const K &key) const { return lookup(key) ? 1 : 0; }
+
+    /// Returns the value of @key, or null if there is none.
+    const V *lookup(const K &key) const {
+        for (const Node *node = root.get(); node;) {
+            if (compare(key, node->value.first))
+                node = node->left.get();
+            else if (compare(node->value.first, key))
+                node = node->right.get();
+            else
+                return &node->value.second;
+        }
+        return nullptr;
+    }
+
+    const V &at(const K &key) const {
+        if (const V *value = lookup(key)) return *value;
+        throw std::out_of_range("persistent_map::at");
+    }
+
+    /// Maps @key to @value. Returns true if @key was not in the map before.
+    bool insert_or_assign(const K &key, const V &value) {
+        // Fast path: the key exists and the whole path to it is only owned by this map.
+        Node *node = root.use_count() == 1 ? root.get() : nullptr;
+        while (node) {
+            NodePtr *next;
+            if (compare(key, node->value.first)) {
+                next = &node->left;
+            } else if (compare(node->value.first, key)) {
+                next = &node->right;
+            } else {
+                // Copies may have been dropped by other threads, see their writes before ours.
+                std::atomic_thread_fence(std::memory_order_acquire);
+                node->value.second = value;
+                return false;
+            }
+            node = next->use_count() == 1 ? next->get() : nullptr;
+        }
+        bool added = false;
+        root = assign(root, key, value, added);
+        if (added) elements++;
+        return added;
+    }
+
+    /// Removes @key from the map. Returns the number of removed elements.
+    size_type erase(const K &key) {
+        bool removed = false;
+        root = erase(root, key, removed);
+        if (!removed) return 0;
+        elements--;
+        return 1;
+    }
+
+    /// Returns true if both maps share the same tree, and thus have the same contents.
+    bool shares(const persistent_map &other) const { return root == other.root; }
+};
+
+}  // namespace P4
+
+#endif /* LIB_PERSISTENT_MAP_H_ */
@@ -0,0 +1,61 @@
+#ifndef LIB_PERSISTENT_STACK_H_
+#define LIB_PERSISTENT_STACK_H_
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace P4 {
+
+/// A stack whose copies share their structure, with the interface of std::stack. The
+/// stack is a singly linked list of immutable nodes, so copying a stack and all operations
+/// on it are O(1). Popping a stack does not affect its copies.
+template <typename T>
+class persistent_stack {
+ public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using reference = const T &;
+    using const_reference = const T &;
+
+ private:
+    struct Node {
+        T value;
+        std::shared_ptr<const Node> next;
+
+        Node(T value, std::shared_ptr<const Node> next)
+            : value(std::move(value)), next(std::move(next)) {}
+    };
+
+    std::shared_ptr<const Node> head;
+    size_type elements = 0;
+
+ public:
+    bool empty() const { return elements == 0; }
+    size_type size() const { return elements; }
+
+    const T &top() const {
+        if (!head) throw std::out_of_range("persistent_stack::top");
+        return head->value;
+    }
+
+    void push(const T &value) {
+        head = std::make_shared<const Node>(value, std::move(head));
+        elements++;
+    }
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        push(T(std::forward<Args>(args)...));
+    }
+
+    void pop() {
+        if (!head) throw std::out_of_range("persistent_stack::pop");
+        head = head->next;
+        elements--;
+    }
+};
+
+}  // namespace P4
+
+#endif /* LIB_PERSISTENT_STACK_H_ */
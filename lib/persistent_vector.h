@@ -0,0 +1,195 @@
+#ifndef LIB_PERSISTENT_VECTOR_H_
+#define LIB_PERSISTENT_VECTOR_H_
+
+#include <atomic>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace P4 {
+
+/// A vector whose copies share their structure. Elements are stored in the leaves of a
+/// trie with 32 children per node, so copying a vector is O(1), and push_back and pop_back
+/// on a copy only replace the O(log32 n) nodes on the path to the last element. Elements
+/// are read-only, the vector only grows and shrinks at the end. Nodes which are only
+/// referenced by a single vector are updated in place.
+template <typename T>
+class persistent_vector {
+ public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using reference = const T &;
+    using const_reference = const T &;
+
+ private:
+    static constexpr unsigned bits = 5;
+    static constexpr size_type branching = size_type(1) << bits;
+    static constexpr size_type mask = branching - 1;
+
+    struct Node;
+    using NodePtr = std::shared_ptr<Node>;
+
+    struct Node {
+        std::vector<NodePtr> children;  // Of inner nodes.
+        std::vector<T> values;          // Of leaves.
+    };
+
+    NodePtr root;
+    size_type elements = 0;
+    // Index bits consumed by the levels above the leaves.
+    unsigned shift = 0;
+
+    /// Returns @node if it can be modified in place, otherwise a copy of it.
+    static NodePtr own(const NodePtr &node) {
+        if (!node) return std::make_shared<Node>();
+        if (node.use_count() == 1) {
+            // Copies may have been dropped by other threads, see their writes before ours.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return node;
+        }
+        return std::make_shared<Node>(*node);
+    }
+
+    static NodePtr push(const NodePtr &node, unsigned level, size_type index, const T &value) {
+        auto rv = own(node);
+        if (level == 0) {
+            rv->values.push_back(value);
+            return rv;
+        }
+        size_type child = (index >> level) & mask;
+        if (child < rv->children.size())
+            rv->children[child] = push(rv->children[child], level - bits, index, value);
+        else
+            rv->children.push_back(push(nullptr, level - bits, index, value));
+        return rv;
+    }
+
+    /// Removes the element at @index, the last one, and returns null if @node becomes empty.
+    static NodePtr pop(const NodePtr &node, unsigned level, size_type index) {
+        if (level == 0) {
+            if (node->values.size() == 1) return nullptr;
+            auto rv = own(node);
+            rv->values.pop_back();
+            return rv;
+        }
+        // Children of a shared node are shared as well, so it is copied before descending.
+        auto rv = own(node);
+        size_type child = (index >> level) & mask;
+        auto newChild = pop(rv->children[child], level - bits, index);
+        if (!newChild && child == 0) return nullptr;
+        if (newChild)
+            rv->children[child] = std::move(newChild);
+        else
+            rv->children.pop_back();
+        return rv;
+    }
+
+    const Node *leafFor(size_type index) const {
+        const Node *node = root.get();
+        for (unsigned level = shift; level > 0; level -= bits)
+            node = node->children[(index >> level) & mask].get();
+        return node;
+    }
+
+ public:
+    /// Iterates over the elements in order. Iterators remain valid as long as the vector
+    /// they were obtained from is not modified.
+    class const_iterator {
+        friend class persistent_vector;
+        const persistent_vector *vector = nullptr;
+        size_type index = 0;
+        const Node *leaf = nullptr;
+
+        const_iterator(const persistent_vector *vector, size_type index)
+            : vector(vector), index(index) {
+            if (index < vector->size()) leaf = vector->leafFor(index);
+        }
+
+     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T *;
+        using reference = const T &;
+
+        const_iterator() = default;
+        reference operator*() const { return leaf->values[index & mask]; }
+        pointer operator->() const { return &leaf->values[index & mask]; }
+        const_iterator &operator++() {
+            if ((++index & mask) == 0)
+                leaf = index < vector->size() ? vector->leafFor(index) : nullptr;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            auto rv = *this;
+            ++*this;
+            return rv;
+        }
+        bool operator==(const const_iterator &other) const { return index == other.index; }
+        bool operator!=(const const_iterator &other) const { return index != other.index; }
+    };
+    using iterator = const_iterator;
+
+    persistent_vector() = default;
+    persistent_vector(std::initializer_list<T> il) {
+        for (const auto &value : il) push_back(value);
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, elements); }
+
+    bool empty() const { return elements == 0; }
+    size_type size() const { return elements; }
+    void clear() {
+        root = nullptr;
+        elements = 0;
+        shift = 0;
+    }
+
+    const T &operator[](size_type index) const { return leafFor(index)->values[index & mask]; }
+    const T &at(size_type index) const {
+        if (index >= elements) throw std::out_of_range("persistent_vector::at");
+        return (*this)[index];
+    }
+    const T &front() const { return (*this)[0]; }
+    const T &back() const { return (*this)[elements - 1]; }
+
+    void push_back(const T &value) {
+        if (root && elements == (branching << shift)) {
+            // The trie is full, add a level above it.
+            auto newRoot = std::make_shared<Node>();
+            newRoot->children.push_back(std::move(root));
+            root = std::move(newRoot);
+            shift += bits;
+        }
+        root = push(root, shift, elements, value);
+        elements++;
+    }
+    template <typename... Args>
+    void emplace_back(Args &&...args) {
+        push_back(T(std::forward<Args>(args)...));
+    }
+
+    void pop_back() {
+        if (elements == 0) throw std::out_of_range("persistent_vector::pop_back");
+        root = pop(root, shift, --elements);
+        if (!root) {
+            shift = 0;
+        } else if (shift > 0 && root->children.size() == 1) {
+            // Remove a level which only has a single child.
+            root = root->children.front();
+            shift -= bits;
+        }
+    }
+
+    /// Copies the elements into a std::vector.
+    std::vector<T> toVector() const { return std::vector<T>(begin(), end()); }
+};
+
+}  // namespace P4
+
+#endif /* LIB_PERSISTENT_VECTOR_H_ */
@@ -69,8 +69,10 @@ std::ostream &operator<<(std::ostream &os, const SourceInfo &info) {
 //////////////////////////////////////////////////////////////////////////////////////////
 
 InputSources::InputSources() : sealed(false) {
+    lineIndex.push_back({0, 0});  // line 0 is invalid, mapLine replaces it
     mapLine("", 1);  // the first line read will be line 1 of stdin
     contents.push_back("");
+    indexNextLine();
 }
 
 void InputSources::addComment(SourceInfo srcInfo, bool singleLine, cstring body) {
@@ -115,6 +117,22 @@ void InputSources::appendNewline(std::string_view newline) {
     if (sealed) BUG("Appending to sealed InputSources");
     contents.back() += newline;
     contents.push_back("");  // start a new line
+    indexNextLine();
+}
+
+void InputSources::indexNextLine() {
+    // For a source file such as
+    // ----------
+    // # 1 "x.p4"
+    // parser start { }
+    // ----------
+    // The first line indicates that line 2 is the first line in x.p4
+    // line=2, mapping.line=1, mapping.sourceLine=1
+    // So we have to subtract one to get the real line number.
+    const auto &mapping = lineMappings.back();
+    unsigned line = lineIndex.size();
+    const auto nominalLine = line - mapping.line + mapping.sourceLine;
+    lineIndex.push_back({mapping.fileId, nominalLine > 0 ? nominalLine - 1 : 0});
 }
 
 void InputSources::appendText(const char *text) {
@@ -162,28 +180,34 @@ std::string_view InputSources::getLine(unsigned lineNumber) const {
 void InputSources::mapLine(std::string_view file, unsigned originalSourceLineNo) {
     if (sealed) BUG("Changing mapping to sealed InputSources");
     unsigned lineno = getCurrentLineNumber();
-    line_file_map.emplace(lineno, SourceFileLine(file, originalSourceLineNo));
+    // Only the first mapping of a line counts.
+    if (!lineMappings.empty() && lineMappings.back().line == lineno) return;
+    cstring name(file);
+    auto [it, inserted] = fileIds.emplace(name, fileNames.size());
+    if (inserted) fileNames.push_back(name);
+    lineMappings.push_back({lineno, it->second, originalSourceLineNo});
+    // The current line is already indexed, with the previous mapping.
+    lineIndex.pop_back();
+    indexNextLine();
+}
+
+SourceLineIndex InputSources::getLineIndex(unsigned line) const {
+    if (line < lineIndex.size()) return lineIndex[line];
+    // Lines past the end of the input keep counting from the last mapping.
+    const auto &mapping = lineMappings.back();
+    const auto nominalLine = line - mapping.line + mapping.sourceLine;
+    return {mapping.fileId, nominalLine > 0 ? nominalLine - 1 : 0};
+}
+
+cstring InputSources::getFileName(unsigned fileId) const {
+    BUG_CHECK(fileId < fileNames.size(), "No source file with id %1%", fileId);
+    return fileNames[fileId];
 }
 
 SourceFileLine InputSources::getSourceLine(unsigned line) const {
-    auto it = line_file_map.upper_bound(line);
-    if (it == line_file_map.begin())
-        // There must be always something mapped to line 0
-        BUG("No source information for line %1%", line);
-    LOG3(line << " mapped to " << it->first << "," << it->second.toString());
-    --it;
-    LOG3(line << " corrected to " << it->first << "," << it->second.toString());
-    // For a source file such as
-    // ----------
-    // # 1 "x.p4"
-    // parser start { }
-    // ----------
-    // The first line indicates that line 2 is the first line in x.p4
-    // line=2, it->first=1, it->second.sourceLine=1
-    // So we have to subtract one to get the real line number.
-    const auto nominalLine = line - it->first + it->second.sourceLine;
-    const auto realLine = nominalLine > 0 ? nominalLine - 1 : 0;
-    return SourceFileLine(it->second.fileName, realLine);
+    auto index = getLineIndex(line);
+    LOG3(line << " mapped to " << fileNames[index.fileId] << "(" << index.sourceLine << ")");
+    return SourceFileLine(fileNames[index.fileId].string_view(), index.sourceLine);
 }
 
 unsigned InputSources::getCurrentLineNumber() const { return contents.size(); }
@@ -307,8 +331,11 @@ cstring InputSources::toDebugString() const {
     std::stringstream builder;
     for (const auto &line : contents) builder << line;
     builder << "---------------" << std::endl;
-    for (const auto &lf : line_file_map)
-        builder << lf.first << ": " << lf.second.toString() << std::endl;
+    for (const auto &mapping : lineMappings)
+        builder << mapping.line << ": "
+                << SourceFileLine(fileNames[mapping.fileId].string_view(), mapping.sourceLine)
+                       .toString()
+                << std::endl;
     return {builder};
 }
 
@@ -354,6 +381,10 @@ cstring SourceInfo::getSourceFile() const {
     return sourceLine.fileName;
 }
 
+unsigned SourceInfo::getSourceFileId() const {
+    return sources->getLineIndex(start.getLineNumber()).fileId;
+}
+
 cstring SourceInfo::getLineNum() const {
     SourceFileLine sourceLine = sources->getSourceLine(start.getLineNumber());
     return Util::toString(sourceLine.sourceLine);
@@ -24,6 +24,7 @@ limitations under the License.
 #include <map>
 #include <sstream>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "absl/strings/str_format.h"
@@ -44,6 +45,7 @@ namespace P4::Util {
 using namespace P4::literals;
 
 struct SourceFileLine;
+struct SourceLineIndex;
 /**
 A character position within some InputSources: a pair of
 line/column positions.  Can only be interpreted in the context
@@ -198,8 +200,12 @@ class SourceInfo final {
     explicit operator bool() const { return isValid(); }
 
     cstring getSourceFile() const;
+    /// Id of the source file, see InputSources::getFileName; cheaper than getSourceFile.
+    unsigned getSourceFileId() const;
     cstring getLineNum() const;
 
+    const InputSources *getInputSources() const { return sources; }
+
     const SourcePosition &getStart() const { return this->start; }
 
     const SourcePosition &getEnd() const { return this->end; }
@@ -255,6 +261,12 @@ struct SourceFileLine {
     cstring toString() const;
 };
 
+/** A line in a source file, with the file given by its id in the InputSources */
+struct SourceLineIndex {
+    unsigned fileId;
+    unsigned sourceLine;
+};
+
 class Comment final : IHasDbPrint, IHasSourceInfo {
  private:
     SourceInfo srcInfo;
@@ -302,6 +314,13 @@ class InputSources final {
     std::string_view getLine(unsigned lineNumber) const;
     /// Original source line that produced the line with the specified number
     SourceFileLine getSourceLine(unsigned line) const;
+    /// Like getSourceLine, but returns the id of the file instead of its name.  This is an
+    /// array lookup, for passes which need the original position of many lines.
+    SourceLineIndex getLineIndex(unsigned line) const;
+    /// The file with the specified id; ids are assigned in the order of the mapLine calls
+    /// and 0 is stdin.
+    cstring getFileName(unsigned fileId) const;
+    unsigned fileCount() const { return fileNames.size(); }
 
     unsigned lineCount() const;
     SourcePosition getCurrentPosition() const;
@@ -338,11 +357,24 @@ class InputSources final {
     void appendToLastLine(std::string_view text);
     /// Append a newline and start a new line
     void appendNewline(std::string_view newline);
+    /// Append the original position of the next line to lineIndex
+    void indexNextLine();
+
+    struct LineMapping {
+        unsigned line;
+        unsigned fileId;
+        unsigned sourceLine;
+    };
 
     /// Input program that is being currently compiled; there can be only one.
     bool sealed;
 
-    std::map<unsigned, SourceFileLine> line_file_map;
+    /// The mapLine calls, ordered by line; there is at most one mapping per line.
+    std::vector<LineMapping> lineMappings;
+    /// The original position of every line, indexed by line number.
+    std::vector<SourceLineIndex> lineIndex;
+    std::vector<cstring> fileNames;
+    std::unordered_map<cstring, unsigned> fileIds;
 
     /// Each line also stores the end-of-line character(s)
     std::vector<std::string> contents;
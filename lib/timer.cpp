@@ -4,6 +4,7 @@
 #include <chrono>  // NOLINT linter forbids using chrono, but we don't have alternatives
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <utility>
 
@@ -41,31 +42,29 @@ struct CounterEntry {
     explicit CounterEntry(const char *n) : name(n) {}
 };
 
+/// The most inner currently active counter of this thread, null for the topmost counter.
+/// Counters are owned by the tree below the root, so the collector does not need to scan this.
+thread_local CounterEntry *currentCounter = nullptr;
+
 struct RootCounter {
     /// The topmost counter.
     CounterEntry counter;
-    /// The most inner currently active counter.
-    CounterEntry *current;
     Clock::time_point start;
+    /// Protects the counter tree. Timers of all threads are added to the same tree, a counter
+    /// used by several threads at once accumulates the time spent in each of them.
+    std::mutex mutex;
 
     static RootCounter &get() {
-        // TODO: not threadsafe currently. Instance of RootCounter could be thread_local:
-        //
-        // thread_local RootCounter root;
-        //
-        // however libgc cannot scan thread local data, which can lead to premature object
-        // garbage collection.
         static RootCounter ROOT;
-        ROOT.counter.duration = Clock::now() - ROOT.start;
         return ROOT;
     }
 
-    CounterEntry *getCurrent() const { return current; }
+    CounterEntry *getCurrent() { return currentCounter ? currentCounter : &counter; }
 
-    void setCurrent(CounterEntry *c) { current = c; }
+    void setCurrent(CounterEntry *c) { currentCounter = c; }
 
  private:
-    RootCounter() : counter(""), current(&counter) { start = Clock::now(); }
+    RootCounter() : counter("") { start = Clock::now(); }
 };
 
 }  // namespace
@@ -86,8 +85,11 @@ struct ScopedTimerCtx {
     CounterEntry *self = nullptr;
     Clock::time_point startTime;
 
-    explicit ScopedTimerCtx(const char *timerName)
-        : parent(RootCounter::get().getCurrent()), self(parent->openSubcounter(timerName)) {
+    explicit ScopedTimerCtx(const char *timerName) : parent(RootCounter::get().getCurrent()) {
+        {
+            std::lock_guard<std::mutex> lock(RootCounter::get().mutex);
+            self = parent->openSubcounter(timerName);
+        }
         startTime = Clock::now();
         // Push new active counter - the current active counter becomes the parent of this
         // counter, and this counter becomes the current active counter.
@@ -96,7 +98,10 @@ struct ScopedTimerCtx {
     ~ScopedTimerCtx() {
         // Close the current timer invocation, measure time and add it to the counter.
         auto duration = Clock::now() - startTime;
-        self->add(duration);
+        {
+            std::lock_guard<std::mutex> lock(RootCounter::get().mutex);
+            self->add(duration);
+        }
         // Restore previous counter as current.
         RootCounter::get().setCurrent(parent);
     }
@@ -142,7 +147,10 @@ static void formatCounters(std::vector<TimerEntry> &out, CounterEntry &current,
 std::vector<TimerEntry> getTimers() {
     std::vector<TimerEntry> ret;
     std::string namePrefix;
-    formatCounters(ret, RootCounter::get().counter, namePrefix, 0);
+    auto &root = RootCounter::get();
+    std::lock_guard<std::mutex> lock(root.mutex);
+    root.counter.duration = Clock::now() - root.start;
+    formatCounters(ret, root.counter, namePrefix, 0);
     return ret;
 }
 
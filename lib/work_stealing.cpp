@@ -0,0 +1,167 @@
+#include "lib/work_stealing.h"
+
+#include <config.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if HAVE_LIBGC
+#include <gc/gc.h>
+#endif
+
+namespace P4::Util {
+
+namespace {
+
+/// Tasks owned by one worker. The owner pops from the front, thieves from the back, so
+/// they only contend for the last task of the queue.
+struct TaskQueue {
+    std::mutex lock;
+    std::deque<size_t> tasks;
+
+    void push(size_t task) {
+        std::lock_guard<std::mutex> guard(lock);
+        tasks.push_front(task);
+    }
+
+    bool pop(size_t &task) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (tasks.empty()) return false;
+        task = tasks.front();
+        tasks.pop_front();
+        return true;
+    }
+
+    bool steal(size_t &task) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (tasks.empty()) return false;
+        task = tasks.back();
+        tasks.pop_back();
+        return true;
+    }
+};
+
+#if HAVE_LIBGC
+struct GCThread {
+    GCThread() {
+        GC_stack_base sb;
+        GC_get_stack_base(&sb);
+        GC_register_my_thread(&sb);
+    }
+    ~GCThread() { GC_unregister_my_thread(); }
+};
+#endif
+
+/// Runs the tasks on @workers workers.
+void runWorkers(size_t tasks, unsigned workers,
+                const std::function<void(size_t, unsigned, const SpawnTask &)> &run) {
+    if (workers <= 1) {
+        std::deque<size_t> queue;
+        for (size_t task = 0; task < tasks; ++task) queue.push_back(task);
+        size_t nextTask = tasks;
+        SpawnTask spawn = [&]() {
+            queue.push_front(nextTask);
+            return nextTask++;
+        };
+        while (!queue.empty()) {
+            size_t task = queue.front();
+            queue.pop_front();
+            run(task, 0, spawn);
+        }
+        return;
+    }
+
+#if HAVE_LIBGC
+    static std::once_flag threadsAllowed;
+    std::call_once(threadsAllowed, GC_allow_register_threads);
+#endif
+
+    // The first failure in task order is rethrown.
+    std::mutex errorLock;
+    size_t errorTask = SIZE_MAX;
+    std::exception_ptr error;
+    auto runTask = [&](size_t task, unsigned worker, const SpawnTask &spawn) {
+        try {
+            run(task, worker, spawn);
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(errorLock);
+            if (task < errorTask) {
+                errorTask = task;
+                error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    queues.reserve(workers);
+    for (unsigned w = 0; w < workers; ++w) {
+        auto queue = std::make_unique<TaskQueue>();
+        for (size_t task = tasks * w / workers; task < tasks * (w + 1) / workers; ++task)
+            queue->tasks.push_back(task);
+        queues.push_back(std::move(queue));
+    }
+
+    // Tasks which are queued or running. A task is counted before the task which added it
+    // finishes, so a worker which sees no unfinished tasks is done.
+    std::atomic<size_t> unfinished = tasks;
+    std::atomic<size_t> nextTask = tasks;
+    auto work = [&](unsigned worker) {
+        SpawnTask spawn = [&, worker]() {
+            size_t task = nextTask++;
+            ++unfinished;
+            queues[worker]->push(task);
+            return task;
+        };
+        while (unfinished > 0) {
+            size_t task;
+            bool found = queues[worker]->pop(task);
+            for (unsigned i = 1; !found && i < workers; ++i)
+                found = queues[(worker + i) % workers]->steal(task);
+            if (!found) {
+                // The remaining tasks are running, and may add more.
+                std::this_thread::yield();
+                continue;
+            }
+            runTask(task, worker, spawn);
+            --unfinished;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (unsigned w = 1; w < workers; ++w) {
+        pool.emplace_back([&work, w]() {
+#if HAVE_LIBGC
+            GCThread registered;
+#endif
+            work(w);
+        });
+    }
+    work(0);
+    for (auto &thread : pool) thread.join();
+
+    if (error) std::rethrow_exception(error);
+}
+
+}  // namespace
+
+void runWorkStealing(size_t tasks, unsigned threads,
+                     const std::function<void(size_t task, unsigned worker)> &run) {
+    runWorkers(tasks, std::min<size_t>(threads, tasks),
+               [&](size_t task, unsigned worker, const SpawnTask &) { run(task, worker); });
+}
+
+void runWorkStealing(size_t tasks, unsigned threads,
+                     const std::function<void(size_t task, unsigned worker,
+                                              const SpawnTask &spawn)> &run) {
+    runWorkers(tasks, threads, run);
+}
+
+}  // namespace P4::Util
@@ -0,0 +1,36 @@
+#ifndef LIB_WORK_STEALING_H_
+#define LIB_WORK_STEALING_H_
+
+#include <cstddef>
+#include <functional>
+
+namespace P4::Util {
+
+/// Runs @run for every task in [0, @tasks) on up to @threads workers. Every worker starts
+/// with a contiguous range of the tasks and takes them from the front; a worker which has
+/// run out of tasks steals from the back of the range of another worker. The calling
+/// thread is worker 0, @run receives the task and the index of the worker running it.
+///
+/// Additional threads are registered with the garbage collector, so tasks may allocate.
+/// If tasks throw, the exception of the first such task (in task order) is rethrown once
+/// all the tasks have finished. With a single worker the tasks run in order on the
+/// calling thread.
+void runWorkStealing(size_t tasks, unsigned threads,
+                     const std::function<void(size_t task, unsigned worker)> &run);
+
+/// Adds a task to a run of runWorkStealing and returns its index.
+using SpawnTask = std::function<size_t()>;
+
+/// Like the above, but @run may add tasks while it runs, by calling the SpawnTask it
+/// receives. A new task goes to the front of the queue of the worker which added it, so
+/// that worker runs it next unless an idle worker steals it first. Tasks are numbered in
+/// the order they are added, after the initial ones. All @threads workers are started
+/// even if there are fewer initial tasks, and the run ends once every task, including the
+/// ones added, has finished.
+void runWorkStealing(size_t tasks, unsigned threads,
+                     const std::function<void(size_t task, unsigned worker,
+                                              const SpawnTask &spawn)> &run);
+
+}  // namespace P4::Util
+
+#endif /* LIB_WORK_STEALING_H_ */
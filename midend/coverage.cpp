@@ -1,11 +1,114 @@
 #include "midend/coverage.h"
 
+#include <mutex>
 #include <ostream>
 
 #include "lib/log.h"
 
 namespace P4::Coverage {
 
+std::optional<size_t> CoverageIndex::find(const IR::Node *node) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = indices.find(node);
+    if (it == indices.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+size_t CoverageIndex::add(const IR::Node *node, bool report) {
+    if (!report) {
+        if (auto index = find(node)) {
+            return *index;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto [it, inserted] = indices.emplace(node, nodes.size());
+    if (inserted) {
+        nodes.push_back(node);
+    } else if (report) {
+        nodes[it->second] = node;
+    }
+    return it->second;
+}
+
+const IR::Node *CoverageIndex::at(size_t index) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return nodes.at(index);
+}
+
+const IR::Node *CoverageSet::const_iterator::operator*() const { return index->at(*bit); }
+
+bitvec CoverageSet::translate(const CoverageSet &other, bool add) const {
+    bitvec result;
+    for (const auto *node : other) {
+        if (add) {
+            result.setbit(index->add(node, false));
+        } else if (auto i = index ? index->find(node) : std::nullopt) {
+            result.setbit(*i);
+        }
+    }
+    return result;
+}
+
+bool CoverageSet::insert(const IR::Node *node) {
+    if (!index) {
+        index = std::make_shared<CoverageIndex>();
+    }
+    auto i = index->add(node, false);
+    if (bits.getbit(i)) {
+        return false;
+    }
+    bits.setbit(i);
+    return true;
+}
+
+void CoverageSet::insertCoverable(const IR::Node *node) {
+    if (!index) {
+        index = std::make_shared<CoverageIndex>();
+    }
+    bits.setbit(index->add(node, true));
+}
+
+bool CoverageSet::merge(const CoverageSet &other) {
+    if (other.empty()) {
+        return false;
+    }
+    if (!index) {
+        index = other.index;
+        bits = other.bits;
+        return true;
+    }
+    if (index == other.index) {
+        return bits |= other.bits;
+    }
+    return bits |= translate(other, true);
+}
+
+CoverageSet &CoverageSet::operator-=(const CoverageSet &other) {
+    if (index == other.index) {
+        bits -= other.bits;
+    } else if (!empty() && !other.empty()) {
+        bits -= translate(other, false);
+    }
+    return *this;
+}
+
+bool CoverageSet::contains(const CoverageSet &other) const {
+    if (index == other.index || other.empty()) {
+        return bits.contains(other.bits);
+    }
+    auto translated = translate(other, false);
+    return static_cast<size_t>(translated.popcount()) == other.size() && bits.contains(translated);
+}
+
+size_t CoverageSet::count(const IR::Node *node) const {
+    auto i = index ? index->find(node) : std::nullopt;
+    return i.has_value() && bits.getbit(*i) ? 1 : 0;
+}
+
+std::ostream &operator<<(std::ostream &out, const CoverageSet &set) { return out << set.getBits(); }
+
 bool SourceIdCmp::operator()(const IR::Node *s1, const IR::Node *s2) const {
     // We use source information as comparison operator since we want to trace coverage back to the
     // original program.
@@ -14,12 +117,25 @@ bool SourceIdCmp::operator()(const IR::Node *s1, const IR::Node *s2) const {
     return s1->srcInfo < s2->srcInfo;
 }
 
-CollectNodes::CollectNodes(CoverageOptions coverageOptions) : coverageOptions(coverageOptions) {}
+CollectNodes::CollectNodes(CoverageOptions coverageOptions, unsigned threads)
+    : ParallelInspector(threads),
+      index(std::make_shared<CoverageIndex>()),
+      coverableNodes(index),
+      coverageOptions(coverageOptions) {}
+
+ParallelInspector *CollectNodes::cloneWorker() const {
+    return new CollectNodes(coverageOptions, getThreads());
+}
+
+void CollectNodes::reduce(const ParallelInspector &worker) {
+    const auto &nodes = dynamic_cast<const CollectNodes &>(worker).collectedNodes;
+    collectedNodes.insert(nodes.begin(), nodes.end());
+}
 
 bool CollectNodes::preorder(const IR::BaseAssignmentStatement *stmt) {
     // Only track statements, which have a valid source position in the P4 program.
     if (coverageOptions.coverStatements && stmt->getSourceInfo().isValid()) {
-        coverableNodes.insert(stmt);
+        collectedNodes.insert(stmt);
     }
     return true;
 }
@@ -27,7 +143,7 @@ bool CollectNodes::preorder(const IR::BaseAssignmentStatement *stmt) {
 bool CollectNodes::preorder(const IR::Entry *entry) {
     // Only track entries, which have a valid source position in the P4 program.
     if (coverageOptions.coverTableEntries && entry->getSourceInfo().isValid()) {
-        coverableNodes.insert(entry);
+        collectedNodes.insert(entry);
     }
     return true;
 }
@@ -35,7 +151,7 @@ bool CollectNodes::preorder(const IR::Entry *entry) {
 bool CollectNodes::preorder(const IR::MethodCallStatement *stmt) {
     // Only track statements, which have a valid source position in the P4 program.
     if (coverageOptions.coverStatements && stmt->getSourceInfo().isValid()) {
-        coverableNodes.insert(stmt);
+        collectedNodes.insert(stmt);
     }
     return true;
 }
@@ -43,7 +159,7 @@ bool CollectNodes::preorder(const IR::MethodCallStatement *stmt) {
 bool CollectNodes::preorder(const IR::ExitStatement *stmt) {
     // Only track statements, which have a valid source position in the P4 program.
     if (coverageOptions.coverStatements && stmt->getSourceInfo().isValid()) {
-        coverableNodes.insert(stmt);
+        collectedNodes.insert(stmt);
     }
     return true;
 }
@@ -51,7 +167,7 @@ bool CollectNodes::preorder(const IR::ExitStatement *stmt) {
 bool CollectNodes::preorder(const IR::P4Action *act) {
     // Only track actions, which have a valid source position in the P4 program.
     if (coverageOptions.coverActions && act->getSourceInfo().isValid()) {
-        coverableNodes.insert(act);
+        collectedNodes.insert(act);
     }
     return true;
 }
@@ -78,16 +194,25 @@ void printCoverageReport(const CoverageSet &all, const CoverageSet &visited) {
 }
 
 void logCoverage(const CoverageSet &all, const CoverageSet &visited, const CoverageSet &new_) {
-    for (const auto *node : new_) {
-        if (visited.count(node) == 0) {
-            // Search for the original statement - `node` might have been transformed.
-            const auto *originalNode = *all.find(node);
-            LOG_FEATURE("coverage", 4,
-                        "============ Covered new node " << originalNode << "============");
+    // Sets report the original node of each source info, nodes might have been transformed.
+    auto covered = new_;
+    covered -= visited;
+    for (const auto *node : covered) {
+        if (all.count(node) != 0) {
+            LOG_FEATURE("coverage", 4, "============ Covered new node " << node << "============");
         }
     }
 }
 
-const CoverageSet &CollectNodes::getCoverableNodes() { return coverableNodes; }
+const CoverageSet &CollectNodes::getCoverableNodes() {
+    // Index the nodes in source order, so that the coverable nodes of a program are dense.
+    if (!indexed) {
+        for (const auto *node : collectedNodes) {
+            coverableNodes.insertCoverable(node);
+        }
+        indexed = true;
+    }
+    return coverableNodes;
+}
 
 }  // namespace P4::Coverage
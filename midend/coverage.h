@@ -1,11 +1,19 @@
 #ifndef MIDEND_COVERAGE_H_
 #define MIDEND_COVERAGE_H_
 
+#include <cstddef>
+#include <iosfwd>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <optional>
 #include <set>
+#include <shared_mutex>
 #include <vector>
 
 #include "ir/ir.h"
-#include "ir/visitor.h"
+#include "ir/parallel_inspector.h"
+#include "lib/bitvec.h"
 #include "lib/source_file.h"
 
 /// This file is a collection of utilities for coverage tracking in P4 programs.
@@ -34,15 +42,141 @@ struct CoverageOptions {
     bool onlyCoveringTests = false;
 };
 
-/// Set of nodes used for coverage purposes. Compares nodes based on their
-/// clone_id to take node modifications into account.
-using CoverageSet = std::set<const IR::Node *, SourceIdCmp>;
+/// Assigns dense indices to the source infos of the nodes of a program. An index is owned by
+/// the CollectNodes instance of its program and by the sets which use it, and may be shared by
+/// multiple threads.
+class CoverageIndex {
+    mutable std::shared_mutex mutex;
+
+    /// The index of each source info, represented by one of its nodes.
+    std::map<const IR::Node *, size_t, SourceIdCmp> indices;
+
+    /// The node reported for each index.
+    std::vector<const IR::Node *> nodes;
+
+ public:
+    /// @returns the index of the source info of @param node, if it has one.
+    [[nodiscard]] std::optional<size_t> find(const IR::Node *node) const;
+
+    /// @returns the index of the source info of @param node, which is assigned the next index
+    /// if it has none. If @param report is true, @param node is reported for its index.
+    size_t add(const IR::Node *node, bool report);
+
+    /// @returns the node reported for @param index.
+    [[nodiscard]] const IR::Node *at(size_t index) const;
+};
+
+/// Set of nodes used for coverage purposes. Nodes are identified by their source info to
+/// take node modifications into account. A set is a bitvec over the indices of a CoverageIndex,
+/// so unions, differences and sizes of sets sharing an index are computed a word at a time.
+/// CollectNodes indexes the coverable nodes of a program in source order, before any other
+/// node, so their sets are dense and iterate in source order. A set created without an index
+/// adopts the index of the first set merged into it, or creates its own on the first insert.
+/// Sets with different indices are combined node by node.
+class CoverageSet {
+    std::shared_ptr<CoverageIndex> index;
+    bitvec bits;
+
+    /// @returns the bits of @param other in the index of this set. Nodes which this index
+    /// does not know are dropped if @param add is false.
+    bitvec translate(const CoverageSet &other, bool add) const;
+
+ public:
+    /// Iterates over the nodes of a set in the order of their index. The node of an index is
+    /// the coverable node most recently collected for its source info, if any.
+    class const_iterator {
+        friend class CoverageSet;
+        const CoverageIndex *index;
+        bitvec::const_bitref bit;
+
+        const_iterator(const CoverageIndex *index, bitvec::const_bitref bit)
+            : index(index), bit(bit) {}
+
+     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = const IR::Node *;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type *;
+        using reference = value_type;
+
+        const IR::Node *operator*() const;
+        const_iterator &operator++() {
+            ++bit;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            auto rv = *this;
+            ++bit;
+            return rv;
+        }
+        bool operator==(const const_iterator &other) const { return bit == other.bit; }
+        bool operator!=(const const_iterator &other) const { return bit != other.bit; }
+    };
+    using iterator = const_iterator;
+
+    CoverageSet() = default;
+    /// Creates an empty set over @param index.
+    explicit CoverageSet(std::shared_ptr<CoverageIndex> index) : index(std::move(index)) {}
+
+    /// Adds @param node. @returns true if no node with the same source info was in the set.
+    bool insert(const IR::Node *node);
+    template <typename Iterator>
+    void insert(Iterator first, Iterator last) {
+        for (; first != last; ++first) insert(*first);
+    }
+
+    /// Adds all nodes of @param other. @returns true if the set has changed.
+    bool merge(const CoverageSet &other);
+
+    /// Removes all nodes of @param other.
+    CoverageSet &operator-=(const CoverageSet &other);
+
+    /// @returns 1 if a node with the source info of @param node is in the set, 0 otherwise.
+    [[nodiscard]] size_t count(const IR::Node *node) const;
+
+    /// @returns true if all nodes of @param other are in the set.
+    [[nodiscard]] bool contains(const CoverageSet &other) const;
+
+    [[nodiscard]] size_t size() const { return bits.popcount(); }
+    [[nodiscard]] bool empty() const { return bits.empty(); }
+    void clear() { bits.clear(); }
+
+    const_iterator begin() const { return const_iterator(index.get(), bits.begin()); }
+    const_iterator end() const { return const_iterator(index.get(), bits.end()); }
+
+    /// @returns the indices of the nodes in the set.
+    [[nodiscard]] const bitvec &getBits() const { return bits; }
+
+    /// @returns the index of the set, which may be null for an empty set.
+    [[nodiscard]] const std::shared_ptr<CoverageIndex> &getIndex() const { return index; }
+
+    bool operator==(const CoverageSet &other) const {
+        return size() == other.size() && contains(other);
+    }
+    bool operator!=(const CoverageSet &other) const { return !(*this == other); }
+
+    /// Makes @param node the node reported for its index, and adds it. Used by CollectNodes so
+    /// that reports show the nodes of the program which is being covered.
+    void insertCoverable(const IR::Node *node);
+};
+
+/// Prints the indices of the nodes in @param set as a hexadecimal bitmap.
+std::ostream &operator<<(std::ostream &out, const CoverageSet &set);
 
 /// CollectNodes iterates across selected nodes in the P4 program and collects them in a
 /// "CoverageSet". The nodes to collect are specified as options to the collector.
-class CollectNodes : public Inspector {
-    /// The set of nodes in the program that could potentially be covered.
+/// Controls, parsers and functions are scanned on @threads threads.
+class CollectNodes : public ParallelInspector {
+    /// The nodes in the program that could potentially be covered, in source order.
+    std::set<const IR::Node *, SourceIdCmp> collectedNodes;
+
+    /// The index of the program, shared by the sets which are built from @ref coverableNodes.
+    std::shared_ptr<CoverageIndex> index;
+
+    /// The set of nodes in the program that could potentially be covered. Built from
+    /// @ref collectedNodes when it is first requested.
     CoverageSet coverableNodes;
+    bool indexed = false;
 
     /// Specifies, which IR nodes to track with this particular visitor.
     CoverageOptions coverageOptions;
@@ -58,8 +192,11 @@ class CollectNodes : public Inspector {
     /// Actions coverage.
     bool preorder(const IR::P4Action *act) override;
 
+    ParallelInspector *cloneWorker() const override;
+    void reduce(const ParallelInspector &worker) override;
+
  public:
-    explicit CollectNodes(CoverageOptions coverageOptions);
+    explicit CollectNodes(CoverageOptions coverageOptions, unsigned threads = 1);
 
     /// @return the set of coverable nodes in the program.
     const CoverageSet &getCoverableNodes();
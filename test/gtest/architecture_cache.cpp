@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "frontends/common/options.h"
+#include "frontends/common/parseInput.h"
+#include "frontends/p4/toP4/toP4.h"
+#include "test/gtest/env.h"
+#include "test/gtest/helpers.h"
+
+namespace P4::Test {
+
+namespace fs = std::filesystem;
+
+class ArchitectureCacheTest : public P4CTest {
+ protected:
+    fs::path directory;
+
+    void SetUp() override {
+        directory = fs::temp_directory_path() / ("p4c-arch-cache-" + std::to_string(getpid()));
+        fs::remove_all(directory);
+        fs::create_directories(directory / "include");
+        setenv("P4C_16_INCLUDE_PATH", (std::string(buildPath) + "p4include").c_str(), 1);
+    }
+
+    void TearDown() override { fs::remove_all(directory); }
+
+    void write(const fs::path &path, const std::string &contents) {
+        std::ofstream out(path);
+        out << contents;
+    }
+
+    /// @returns the number of entries in the cache.
+    size_t entries() {
+        size_t count = 0;
+        for (const auto &file : fs::directory_iterator(directory))
+            count += file.path().extension() == ".p4c" ? 1 : 0;
+        return count;
+    }
+
+    /// Parses @p file, using the cache directory if @p cached is set or @p shared if given,
+    /// and prints the program together with the source positions of its declarations.
+    std::string parse(const fs::path &file, bool cached,
+                      const ArchitectureCache *shared = nullptr,
+                      const IR::P4Program **result = nullptr) {
+        AutoCompileContext context(new GTestContext(GTestContext::get()));
+        auto &options = GTestContext::get().options();
+        options.langVersion = CompilerOptions::FrontendVersion::P4_16;
+        options.file = file;
+        options.preprocessor_options = cstring("-I" + (directory / "include").string());
+        options.archCacheDir = cached ? directory : fs::path();
+        const auto *program = parseP4File(options, shared);
+        if (program == nullptr || ::P4::errorCount() > 0) return {};
+        if (result != nullptr) *result = program;
+        std::stringstream out;
+        program->apply(ToP4(&out, false));
+        for (const auto *object : program->objects)
+            out << object->srcInfo.toPositionString() << "\n";
+        return out.str();
+    }
+};
+
+TEST_F(ArchitectureCacheTest, ReusesStandardIncludes) {
+    auto file = directory / "program.p4";
+    write(file, R"(#define V1MODEL_VERSION 20200408
+#include <core.p4>
+#include <v1model.p4>
+
+error { Custom }
+const bit<32> version = V1MODEL_VERSION;
+const bit<32> line = __LINE__;
+header h_t { bit<8> f; }
+control c(inout h_t h) { apply { h.f = 1; } }
+)");
+    auto expected = parse(file, false);
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(entries(), 0U);
+
+    EXPECT_EQ(parse(file, true), expected);
+    EXPECT_EQ(entries(), 1U);
+    EXPECT_EQ(parse(file, true), expected);
+    EXPECT_EQ(entries(), 1U);
+}
+
+TEST_F(ArchitectureCacheTest, ChangedIncludeIsParsedAgain) {
+    auto file = directory / "program.p4";
+    auto include = directory / "include" / "arch.p4";
+    write(file, "#include <core.p4>\n#include <arch.p4>\n\nconst T value = 1;\n");
+    write(include, "typedef bit<8> T;\n");
+    auto expected = parse(file, false);
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(parse(file, true), expected);
+
+    write(include, "typedef bit<16> T;\n");
+    auto changed = parse(file, false);
+    EXPECT_NE(changed, expected);
+    EXPECT_EQ(parse(file, true), changed);
+    EXPECT_EQ(entries(), 1U);
+}
+
+TEST_F(ArchitectureCacheTest, SharedCacheParsesIncludesOnce) {
+    auto first = directory / "first.p4";
+    auto second = directory / "second.p4";
+    write(first, "#include <core.p4>\n\nconst bit<8> first = 1;\n");
+    write(second, "#include <core.p4>\n\nconst bit<8> second = 2;\n");
+    auto expectedFirst = parse(first, false);
+    auto expectedSecond = parse(second, false);
+    ASSERT_FALSE(expectedFirst.empty());
+    ASSERT_FALSE(expectedSecond.empty());
+
+    // Without a cache directory, the declarations of core.p4 are parsed by the first
+    // program and shared with the second.
+    ArchitectureCache shared({}, true);
+    const IR::P4Program *firstProgram = nullptr;
+    const IR::P4Program *secondProgram = nullptr;
+    EXPECT_EQ(parse(first, false, &shared, &firstProgram), expectedFirst);
+    EXPECT_EQ(parse(second, false, &shared, &secondProgram), expectedSecond);
+    ASSERT_NE(firstProgram, nullptr);
+    ASSERT_NE(secondProgram, nullptr);
+    ASSERT_EQ(firstProgram->objects.size(), secondProgram->objects.size());
+    size_t sharedObjects = 0;
+    for (size_t i = 0; i < firstProgram->objects.size(); ++i)
+        sharedObjects += firstProgram->objects[i] == secondProgram->objects[i] ? 1 : 0;
+    // Everything except the error declaration, which programs may extend, and the constant.
+    EXPECT_EQ(sharedObjects, firstProgram->objects.size() - 2);
+    EXPECT_EQ(entries(), 0U);
+}
+
+TEST_F(ArchitectureCacheTest, CorruptedEntryIsParsedAgain) {
+    auto file = directory / "program.p4";
+    write(file, "#include <core.p4>\n\nconst bit<8> value = 1;\n");
+    auto expected = parse(file, false);
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(parse(file, true), expected);
+    ASSERT_EQ(entries(), 1U);
+
+    // Replace the size of the first section by one far beyond the end of the entry.
+    for (const auto &entry : fs::directory_iterator(directory)) {
+        if (entry.path().extension() != ".p4c") continue;
+        std::ifstream in(entry.path(), std::ios::binary);
+        std::string header, size;
+        std::getline(in, header);
+        std::getline(in, size);
+        std::stringstream rest;
+        rest << in.rdbuf();
+        in.close();
+        write(entry.path(), header + "\n1000000000000\n" + rest.str());
+    }
+    EXPECT_EQ(parse(file, true), expected);
+}
+
+TEST_F(ArchitectureCacheTest, IgnoresProgramsWithoutStandardIncludes) {
+    auto file = directory / "program.p4";
+    write(file, "const bit<8> value = 1;\n");
+    auto expected = parse(file, false);
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(parse(file, true), expected);
+    EXPECT_EQ(entries(), 0U);
+}
+
+}  // namespace P4::Test
@@ -0,0 +1,112 @@
+#include "lib/arena.h"
+
+#include <config.h>
+#include <gtest/gtest.h>
+
+#if HAVE_LIBGC
+#include <gc/gc.h>
+#endif
+
+#include "ir/ir.h"
+#include "ir/pass_manager.h"
+
+namespace P4::Test {
+
+TEST(Arena, ScopeSetsCurrentArena) {
+    Arena outer, inner;
+    EXPECT_EQ(Arena::current(), nullptr);
+    {
+        Arena::Scope outerScope(&outer);
+        EXPECT_EQ(Arena::current(), &outer);
+        {
+            Arena::Scope innerScope(&inner);
+            EXPECT_EQ(Arena::current(), &inner);
+            // A null arena keeps the current one.
+            Arena::Scope nullScope(nullptr);
+            EXPECT_EQ(Arena::current(), &inner);
+        }
+        EXPECT_EQ(Arena::current(), &outer);
+    }
+    EXPECT_EQ(Arena::current(), nullptr);
+}
+
+#if HAVE_LIBGC
+
+TEST(Arena, NodesArePlacedInTheCurrentArena) {
+    Arena arena;
+    const IR::Constant *outside = new IR::Constant(1);
+    const IR::Constant *first, *second;
+    {
+        Arena::Scope scope(&arena);
+        first = new IR::Constant(2);
+        second = first->clone();
+    }
+    EXPECT_FALSE(Arena::isArenaAllocated(outside));
+    EXPECT_TRUE(Arena::isArenaAllocated(first));
+    EXPECT_TRUE(Arena::isArenaAllocated(second));
+    EXPECT_EQ(GC_base(const_cast<IR::Constant *>(first)),
+              GC_base(const_cast<IR::Constant *>(second)));
+    EXPECT_EQ(first->asUnsigned(), 2u);
+    EXPECT_EQ(second->asUnsigned(), 2u);
+
+    const auto &stats = arena.getStats();
+    EXPECT_EQ(stats.allocations, 2u);
+    EXPECT_EQ(stats.chunks, 1u);
+    EXPECT_GE(stats.bytes, 2 * sizeof(IR::Constant));
+
+    // Deleting a node in an arena leaves its chunk alone.
+    delete second;
+    EXPECT_EQ(first->asUnsigned(), 2u);
+}
+
+TEST(Arena, RegionsDoNotShareChunks) {
+    Arena arena;
+    Arena::Scope scope(&arena);
+    auto *before = new IR::Constant(1);
+    arena.newRegion();
+    auto *after = new IR::Constant(2);
+    EXPECT_NE(GC_base(before), GC_base(after));
+    EXPECT_EQ(arena.getStats().chunks, 2u);
+}
+
+TEST(Arena, PassManagerStartsRegionPerPass) {
+    Arena arena;
+    auto *program = new IR::Vector<IR::Node>();
+    auto addConstant = [](const IR::Node *node) -> const IR::Node * {
+        auto *vector = node->to<IR::Vector<IR::Node>>()->clone();
+        vector->push_back(new IR::Constant(static_cast<int>(vector->size())));
+        return vector;
+    };
+    PassManager passes({addConstant, addConstant, addConstant});
+    passes.setNodeArena(&arena, true);
+    const auto *result = program->apply(passes)->to<IR::Vector<IR::Node>>();
+
+    ASSERT_EQ(result->size(), 3u);
+    EXPECT_FALSE(Arena::isArenaAllocated(program));
+    for (const auto *node : *result) EXPECT_TRUE(Arena::isArenaAllocated(node));
+    // Every pass allocated a vector and a constant in a region of its own.
+    EXPECT_EQ(arena.getStats().allocations, 6u);
+    EXPECT_EQ(arena.getStats().chunks, 3u);
+    EXPECT_EQ(Arena::current(), nullptr);
+}
+
+TEST(Arena, UnreachableChunksAreReclaimed) {
+    auto before = Arena::totals();
+    {
+        Arena arena(4096);
+        Arena::Scope scope(&arena);
+        for (int i = 0; i < 10000; ++i) new IR::Constant(i);
+        EXPECT_GT(arena.getStats().chunks, 100u);
+    }
+    // Finalized chunks are freed by the collection after the one which found them.
+    GC_gcollect();
+    GC_invoke_finalizers();
+    GC_gcollect();
+    auto after = Arena::totals();
+    EXPECT_GT(after.reclaimedChunks, before.reclaimedChunks);
+    EXPECT_GT(after.reclaimedBytes, before.reclaimedBytes);
+}
+
+#endif  // HAVE_LIBGC
+
+}  // namespace P4::Test
@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "frontends/p4/toP4/toP4.h"
+#include "ir/binary_ir_reader.h"
+#include "ir/binary_ir_writer.h"
+#include "ir/ir.h"
+#include "ir/json_generator.h"
+#include "lib/error.h"
+#include "lib/json.h"
+#include "test/gtest/env.h"
+#include "test/gtest/helpers.h"
+
+namespace P4::Test {
+
+namespace fs = std::filesystem;
+
+class BinaryIRTest : public P4CTest {
+ protected:
+    fs::path file;
+
+    void SetUp() override {
+        file = fs::temp_directory_path() / ("p4c-binary-ir-" + std::to_string(getpid()) + ".bir");
+    }
+
+    void TearDown() override { fs::remove(file); }
+
+    void write(const IR::Node *root, bool sourceInfo = false) {
+        std::ofstream out(file, std::ios::binary);
+        ASSERT_TRUE(BinaryIRWriter(sourceInfo).write(out, root));
+    }
+
+    static std::string toJSON(const IR::Node *node) {
+        std::stringstream out;
+        JSONGenerator(out).emit(node);
+        return out.str();
+    }
+
+    static std::string toP4(const IR::Node *node) {
+        std::stringstream out;
+        node->apply(ToP4(&out, false));
+        return out.str();
+    }
+
+    /// @returns the source info of every node of @p root, including the nodes inline in other
+    /// nodes, in the order they are visited. Parsed and loaded source infos print the same.
+    static std::vector<std::string> sourceInfos(const IR::Node *root) {
+        std::vector<std::string> result;
+        forAllMatching<IR::Node>(root, [&result](const IR::Node *node) {
+            const auto *json = node->sourceInfoJsonObj();
+            result.push_back(json ? json->toString().string() : std::string());
+        });
+        return result;
+    }
+
+    static const IR::P4Program *program() {
+        auto test = FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, R"(
+            header H { bit<8> f; bit<32> g; }
+            struct Headers { H h; }
+            struct Metadata { }
+            parser p(packet_in pkt, out Headers hdr, inout Metadata meta,
+                     inout standard_metadata_t sm) {
+                state start { pkt.extract(hdr.h); transition accept; }
+            }
+            control ingress(inout Headers hdr, inout Metadata meta,
+                            inout standard_metadata_t sm) {
+                action set(bit<32> v) { hdr.h.g = v + 32w0xdeadbeef; }
+                table t { key = { hdr.h.f : exact; } actions = { set; NoAction; } }
+                apply { t.apply(); }
+            }
+            control egress(inout Headers hdr, inout Metadata meta,
+                           inout standard_metadata_t sm) { apply { } }
+            control vc(inout Headers hdr, inout Metadata meta) { apply { } }
+            control uc(inout Headers hdr, inout Metadata meta) { apply { } }
+            control deparser(packet_out pkt, in Headers hdr) { apply { pkt.emit(hdr.h); } }
+            V1Switch(p(), vc(), ingress(), egress(), uc(), deparser()) main;
+        )"));
+        return test ? test->program : nullptr;
+    }
+};
+
+TEST_F(BinaryIRTest, RoundTrip) {
+    const auto *original = program();
+    ASSERT_TRUE(original);
+    write(original);
+
+    BinaryIRReader reader;
+    ASSERT_TRUE(reader.open(file.string()));
+    const auto *loaded = reader.root();
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(reader.createdNodes(), reader.nodeCount());
+    EXPECT_TRUE(loaded->equiv(*original));
+    EXPECT_EQ(toJSON(loaded), toJSON(original));
+    EXPECT_EQ(::P4::errorCount(), 0u);
+}
+
+TEST_F(BinaryIRTest, SourceInfo) {
+    const auto *original = program();
+    ASSERT_TRUE(original);
+    write(original, true);
+
+    BinaryIRReader reader;
+    ASSERT_TRUE(reader.open(file.string()));
+    const auto *loaded = reader.root();
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(sourceInfos(loaded), sourceInfos(original));
+}
+
+/// Round-trips a sample program of the repository through a binary IR file.
+TEST_F(BinaryIRTest, V1ModelSample) {
+    std::ifstream in(fs::path(sourcePath) / "testdata/p4_16_samples/basic_routing-bmv2.p4");
+    ASSERT_TRUE(in);
+    // The standard includes are added by P4_SOURCE.
+    std::string source;
+    for (std::string line; std::getline(in, line);) {
+        if (line.rfind("#include", 0) != 0) source += line + "\n";
+    }
+    auto test = FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, source.c_str()));
+    ASSERT_TRUE(test);
+    const auto *original = test->program;
+    write(original, true);
+
+    BinaryIRReader reader;
+    ASSERT_TRUE(reader.open(file.string()));
+    const auto *loaded = reader.root();
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(reader.createdNodes(), reader.nodeCount());
+    EXPECT_TRUE(loaded->equiv(*original));
+    EXPECT_EQ(toP4(loaded), toP4(original));
+    EXPECT_EQ(sourceInfos(loaded), sourceInfos(original));
+    EXPECT_EQ(::P4::errorCount(), 0u);
+}
+
+TEST_F(BinaryIRTest, SharedNodes) {
+    const auto *c = new IR::Constant(2);
+    const auto *add = new IR::Add(c, c);
+    write(add);
+
+    BinaryIRReader reader;
+    ASSERT_TRUE(reader.open(file.string()));
+    const auto *loaded = reader.root()->to<IR::Add>();
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(loaded->left, loaded->right);
+    EXPECT_EQ(loaded->left->to<IR::Constant>()->value, 2);
+}
+
+TEST_F(BinaryIRTest, Lazy) {
+    const auto *original = program();
+    ASSERT_TRUE(original);
+    write(original);
+
+    BinaryIRReader reader;
+    ASSERT_TRUE(reader.open(file.string()));
+    size_t index = 0;
+    while (index < reader.nodeCount() && reader.nodeType(index) != "P4Control") ++index;
+    ASSERT_LT(index, reader.nodeCount());
+    EXPECT_EQ(reader.createdNodes(), 0u);
+    const auto *control = reader.node(index)->to<IR::P4Control>();
+    ASSERT_TRUE(control);
+    EXPECT_GT(reader.createdNodes(), 0u);
+    EXPECT_LT(reader.createdNodes(), reader.nodeCount());
+    EXPECT_EQ(reader.node(index), control);
+}
+
+TEST_F(BinaryIRTest, NotBinaryIR) {
+    {
+        std::ofstream out(file);
+        out << std::string(256, 'x');
+    }
+    BinaryIRReader reader;
+    EXPECT_FALSE(reader.open(file.string()));
+    EXPECT_EQ(::P4::errorCount(), 1u);
+}
+
+TEST_F(BinaryIRTest, Corrupted) {
+    const auto *original = program();
+    ASSERT_TRUE(original);
+    write(original);
+
+    // Overwrite the records, the header and the tables stay valid.
+    BinaryIRHeader header;
+    {
+        std::ifstream in(file, std::ios::binary);
+        in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    }
+    {
+        std::fstream out(file, std::ios::binary | std::ios::in | std::ios::out);
+        out.seekp(header.recordsOffset);
+        out << std::string(header.recordsSize, '\xff');
+    }
+    BinaryIRReader reader;
+    ASSERT_TRUE(reader.open(file.string()));
+    EXPECT_EQ(reader.root(), nullptr);
+    EXPECT_EQ(reader.root(), nullptr);
+    EXPECT_EQ(::P4::errorCount(), 1u);
+}
+
+}  // namespace P4::Test
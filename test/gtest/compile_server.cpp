@@ -0,0 +1,185 @@
+#include "frontends/common/compileServer.h"
+
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frontends/common/options.h"
+#include "frontends/common/parseInput.h"
+#include "frontends/p4/frontend.h"
+#include "test/gtest/env.h"
+#include "test/gtest/helpers.h"
+
+namespace P4::Test {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// Runs the front end on a command line, the program is written with --pp.
+int compileFrontEnd(int argc, char *const argv[]) {
+    AutoCompileContext context(new P4CContextWithOptions<CompilerOptions>());
+    auto &options = P4CContextWithOptions<CompilerOptions>::get().options();
+    options.langVersion = CompilerOptions::FrontendVersion::P4_16;
+    if (options.process(argc, argv) == nullptr || ::P4::errorCount() > 0) return 1;
+    options.setInputFile();
+    const auto *program = parseP4File(options);
+    if (program != nullptr && ::P4::errorCount() == 0) FrontEnd().run(options, program);
+    return ::P4::errorCount() > 0;
+}
+
+}  // namespace
+
+class CompileServerTest : public P4CTest {
+ protected:
+    fs::path directory;
+    fs::path socketPath;
+    pid_t server = -1;
+
+    void SetUp() override {
+        directory = fs::temp_directory_path() / ("p4c-compile-server-" + std::to_string(getpid()));
+        fs::remove_all(directory);
+        fs::create_directories(directory / "include");
+        socketPath = directory / "server.sock";
+    }
+
+    void TearDown() override {
+        if (server > 0) {
+            kill(server, SIGTERM);
+            waitpid(server, nullptr, 0);
+        }
+        fs::remove_all(directory);
+    }
+
+    void write(const fs::path &path, const std::string &contents) {
+        std::ofstream out(path);
+        out << contents;
+    }
+
+    std::string read(const fs::path &path) {
+        std::ifstream in(path);
+        std::stringstream contents;
+        contents << in.rdbuf();
+        return contents.str();
+    }
+
+    /// Starts a server in a child process, with the environment of this process.
+    void startServer() {
+        std::cout.flush();
+        std::cerr.flush();
+        server = fork();
+        ASSERT_GE(server, 0);
+        if (server == 0) {
+            CompileServer(socketPath, compileFrontEnd, "p4test").run();
+            _exit(1);
+        }
+    }
+
+    /// Sends a request like the p4c driver, returns the exit status of the compilation.
+    int request(const fs::path &workingDirectory, const std::vector<std::string> &environment,
+                const std::vector<std::string> &arguments) {
+        std::string payload = workingDirectory.string() + '\0';
+        for (const auto &string : environment) payload += string + '\0';
+        for (const auto &string : arguments) payload += string + '\0';
+        CompileRequestHeader header{};
+        std::memcpy(header.magic, CompileRequestHeader::expectedMagic, sizeof(header.magic));
+        header.version = CompileRequestHeader::currentVersion;
+        header.size = payload.size();
+        header.environmentCount = environment.size();
+
+        int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+        // The server may still be starting.
+        bool connected = false;
+        for (int attempt = 0; attempt < 100 && !connected; ++attempt) {
+            connected = connect(connection, reinterpret_cast<sockaddr *>(&address),
+                                sizeof(address)) == 0;
+            if (!connected) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        EXPECT_TRUE(connected);
+
+        std::cout.flush();
+        std::cerr.flush();
+        int streams[] = {0, 1, 2};
+        iovec data{&header, sizeof(header)};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(streams))] = {};
+        msghdr message{};
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        auto *cmsg = CMSG_FIRSTHDR(&message);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(streams));
+        std::memcpy(CMSG_DATA(cmsg), streams, sizeof(streams));
+        EXPECT_EQ(sendmsg(connection, &message, 0), ssize_t(sizeof(header)));
+        EXPECT_EQ(::write(connection, payload.data(), payload.size()), ssize_t(payload.size()));
+
+        int32_t status = -1;
+        EXPECT_EQ(::read(connection, &status, sizeof(status)), ssize_t(sizeof(status)));
+        ::close(connection);
+        return status;
+    }
+};
+
+TEST_F(CompileServerTest, MatchesDirectCompilation) {
+    // extra.p4 is only found through P4C_16_INCLUDE_PATH, which the server does not have.
+    unsetenv("P4C_16_INCLUDE_PATH");
+    startServer();
+
+    auto include = directory / "include";
+    fs::copy_file(fs::path(sourcePath) / "p4include" / "core.p4", include / "core.p4");
+    write(include / "extra.p4", "const bit<8> EXTRA = 3;\n");
+    write(directory / "program.p4", R"(#include <core.p4>
+#include "extra.p4"
+
+control c(inout bit<8> x) {
+    apply { x = x + EXTRA; }
+}
+control proto(inout bit<8> x);
+package top(proto p);
+top(c()) main;
+)");
+
+    std::vector<std::string> environment;
+    for (char **entry = environ; *entry != nullptr; ++entry) environment.push_back(*entry);
+    // Without P4C_16_INCLUDE_PATH, the include is missing.
+    EXPECT_NE(request(directory, environment, {"p4test", "--pp", "missing.p4", "program.p4"}), 0);
+
+    environment.push_back("P4C_16_INCLUDE_PATH=" + include.string());
+    // Relative paths are resolved in the working directory of the request.
+    EXPECT_EQ(request(directory, environment, {"p4test", "--pp", "served1.p4", "program.p4"}), 0);
+    EXPECT_EQ(request(directory, environment, {"p4test", "--pp", "served2.p4", "program.p4"}), 0);
+    // Requests for another compiler are rejected.
+    EXPECT_EQ(request(directory, environment, {"p4c-ebpf", "program.p4"}), 1);
+
+    setenv("P4C_16_INCLUDE_PATH", include.c_str(), 1);
+    auto direct = (directory / "direct.p4").string();
+    auto program = (directory / "program.p4").string();
+    std::vector<const char *> argv = {"p4test", "--pp", direct.c_str(), program.c_str()};
+    EXPECT_EQ(compileFrontEnd(argv.size(), const_cast<char *const *>(argv.data())), 0);
+    unsetenv("P4C_16_INCLUDE_PATH");
+
+    auto expected = read(direct);
+    EXPECT_NE(expected.find("const bit<8> EXTRA = 3;"), std::string::npos);
+    EXPECT_EQ(read(directory / "served1.p4"), expected);
+    EXPECT_EQ(read(directory / "served2.p4"), expected);
+}
+
+}  // namespace P4::Test
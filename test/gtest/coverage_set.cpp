@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "ir/ir.h"
+#include "lib/source_file.h"
+#include "midend/coverage.h"
+
+namespace P4::Test {
+
+using Coverage::CoverageSet;
+
+class CoverageSetTest : public ::testing::Test {
+ protected:
+    Util::InputSources sources;
+
+    /// @returns an exit statement on @param line.
+    const IR::Statement *statementOnLine(unsigned line) {
+        return new IR::ExitStatement(Util::SourceInfo(&sources, Util::SourcePosition(line, 1),
+                                                      Util::SourcePosition(line, 5)));
+    }
+};
+
+TEST_F(CoverageSetTest, CollectsNodesInSourceOrder) {
+    const auto *third = statementOnLine(3);
+    const auto *first = statementOnLine(1);
+    const auto *second = statementOnLine(2);
+    auto *block = new IR::BlockStatement({third, first, second});
+
+    Coverage::CoverageOptions options;
+    options.coverStatements = true;
+    Coverage::CollectNodes collector(options);
+    block->apply(collector);
+    const auto &all = collector.getCoverableNodes();
+
+    EXPECT_EQ(all.size(), 3U);
+    std::vector<const IR::Node *> nodes(all.begin(), all.end());
+    EXPECT_EQ(nodes, (std::vector<const IR::Node *>{first, second, third}));
+}
+
+TEST_F(CoverageSetTest, IdentifiesNodesBySourceInfo) {
+    const auto *first = statementOnLine(1);
+    const auto *second = statementOnLine(2);
+    CoverageSet visited;
+    EXPECT_TRUE(visited.empty());
+    EXPECT_TRUE(visited.insert(first));
+    // A transformed node is the same node for coverage.
+    EXPECT_FALSE(visited.insert(first->clone()));
+    EXPECT_EQ(visited.count(first->clone()), 1U);
+    EXPECT_EQ(visited.count(second), 0U);
+    EXPECT_EQ(visited.size(), 1U);
+}
+
+TEST_F(CoverageSetTest, CombinesSets) {
+    std::vector<const IR::Statement *> statements;
+    for (unsigned line = 1; line <= 200; ++line) statements.push_back(statementOnLine(line));
+
+    CoverageSet even, all;
+    for (unsigned i = 0; i < statements.size(); ++i) {
+        all.insert(statements[i]);
+        if (i % 2 == 0) even.insert(statements[i]);
+    }
+    EXPECT_TRUE(all.contains(even));
+    EXPECT_FALSE(even.contains(all));
+
+    CoverageSet merged = even;
+    EXPECT_FALSE(merged.merge(even));
+    EXPECT_TRUE(merged.merge(all));
+    EXPECT_EQ(merged, all);
+
+    merged -= even;
+    EXPECT_EQ(merged.size(), 100U);
+    EXPECT_EQ(merged.count(statements[0]), 0U);
+    EXPECT_EQ(merged.count(statements[1]), 1U);
+}
+
+TEST_F(CoverageSetTest, IndexesEachProgramSeparately) {
+    const auto *first = statementOnLine(1);
+    const auto *second = statementOnLine(2);
+    Coverage::CoverageOptions options;
+    options.coverStatements = true;
+    Coverage::CollectNodes firstCollector(options), secondCollector(options);
+    IR::BlockStatement({first, second}).apply(firstCollector);
+    IR::BlockStatement({second}).apply(secondCollector);
+    const auto &firstProgram = firstCollector.getCoverableNodes();
+    const auto &secondProgram = secondCollector.getCoverableNodes();
+    EXPECT_NE(firstProgram.getIndex(), secondProgram.getIndex());
+    EXPECT_EQ(*secondProgram.begin(), second);
+
+    // An empty set adopts the index of the program merged into it.
+    CoverageSet visited;
+    visited.merge(secondProgram);
+    EXPECT_EQ(visited.getIndex(), secondProgram.getIndex());
+    // Sets of different programs are combined by source info.
+    EXPECT_TRUE(firstProgram.contains(visited));
+    EXPECT_FALSE(visited.contains(firstProgram));
+    EXPECT_TRUE(visited.merge(firstProgram));
+    EXPECT_EQ(visited, firstProgram);
+    visited -= secondProgram;
+    EXPECT_EQ(visited.size(), 1U);
+    EXPECT_EQ(visited.count(first), 1U);
+}
+
+}  // namespace P4::Test
@@ -16,8 +16,19 @@ limitations under the License.
 
 #include "lib/cstring.h"
 
+#include <config.h>
 #include <gtest/gtest.h>
 
+#if HAVE_LIBGC
+#include <gc/gc.h>
+#endif
+
+#include <chrono>  // NOLINT linter forbids using chrono, but we don't have alternatives
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace P4::Test {
 
 using namespace P4::literals;
@@ -158,4 +169,80 @@ TEST(cstring, get_cached) {
     EXPECT_FALSE(cstring::get_cached("test").isNullOrEmpty());
 }
 
+namespace {
+
+/// Runs @fn(thread index) on @threads threads, registered with the garbage collector.
+template <typename Fn>
+void runThreads(unsigned threads, Fn fn) {
+#if HAVE_LIBGC
+    GC_allow_register_threads();
+#endif
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&fn, t]() {
+#if HAVE_LIBGC
+            GC_stack_base sb;
+            GC_get_stack_base(&sb);
+            GC_register_my_thread(&sb);
+#endif
+            fn(t);
+#if HAVE_LIBGC
+            GC_unregister_my_thread();
+#endif
+        });
+    }
+    for (auto &worker : workers) worker.join();
+}
+
+std::vector<std::string> internNames(const char *prefix, size_t count) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; ++i) names.push_back(prefix + std::to_string(i * 7919));
+    return names;
+}
+
+}  // namespace
+
+TEST(cstring, concurrentIntern) {
+    constexpr unsigned threads = 4;
+    auto names = internNames("concurrent_intern_", 1 << 14);
+    std::vector<std::vector<const char *>> interned(threads,
+                                                    std::vector<const char *>(names.size()));
+
+    // Every thread interns all names in a different order (odd strides are permutations
+    // of the power of two names), so the threads race to add new strings.
+    runThreads(threads, [&](unsigned t) {
+        for (size_t i = 0; i < names.size(); ++i) {
+            size_t index = (i * (2 * t + 1)) % names.size();
+            interned[t][index] = cstring(names[index]).c_str();
+        }
+    });
+
+    for (size_t i = 0; i < names.size(); ++i) {
+        EXPECT_EQ(interned[0][i], names[i]);
+        for (unsigned t = 1; t < threads; ++t) EXPECT_EQ(interned[t][i], interned[0][i]);
+        EXPECT_EQ(cstring::get_cached(names[i]).c_str(), interned[0][i]);
+    }
+}
+
+// Reports the cost of interning already interned strings, which does not lock.
+// Disabled by default, run it with --gtest_also_run_disabled_tests.
+TEST(cstring, DISABLED_internBenchmark) {
+    auto names = internNames("intern_benchmark_", 20000);
+    for (const auto &name : names) cstring interned(name);
+
+    for (unsigned threads : {1u, 2u, 4u}) {
+        constexpr size_t rounds = 20;
+        auto start = std::chrono::steady_clock::now();
+        runThreads(threads, [&](unsigned t) {
+            for (size_t r = 0; r < rounds; ++r) {
+                for (size_t i = 0; i < names.size(); ++i)
+                    cstring interned(names[(i * 31 + t) % names.size()]);
+            }
+        });
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "interning with " << threads << " threads: "
+                  << elapsed.count() / (threads * rounds * names.size()) << " ns per string\n";
+    }
+}
+
 }  // namespace P4::Test
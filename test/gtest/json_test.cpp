@@ -85,4 +85,70 @@ TEST(Util, Json) {
               obj->toString());
 }
 
+TEST(Util, JsonWriter) {
+    auto *inner = new JsonArray();
+    inner->append(true);
+    auto *list = new JsonArray();
+    list->append(inner);
+    list->append(new JsonObject());
+    auto *numbers = new JsonArray();
+    numbers->append(1);
+    numbers->append(2);
+    auto *obj = new JsonObject();
+    obj->emplace("x", "x");
+    obj->emplace("y", list);
+    obj->emplace("z", new JsonArray());
+    obj->emplace("w", numbers);
+    obj->emplace("v", JsonValue::null);
+
+    std::stringstream out;
+    JsonWriter json(out);
+    json.beginObject();
+    json.member("x", "x");
+    json.key("y").beginArray();
+    json.beginArray().value(true).endArray();
+    json.beginObject().endObject();
+    json.endArray();
+    json.key("z").beginArray().endArray();
+    json.key("w").beginArray().value(1).value(2).endArray();
+    json.member("v", nullptr);
+    EXPECT_FALSE(json.done());
+    json.endObject();
+    EXPECT_TRUE(json.done());
+    EXPECT_EQ(obj->toString(), out.str());
+
+    std::stringstream nested;
+    JsonWriter(nested).beginArray().value(numbers).value(obj).endArray();
+    auto *array = new JsonArray();
+    array->append(numbers);
+    array->append(obj);
+    EXPECT_EQ(array->toString(), nested.str());
+
+    std::stringstream invalid;
+    JsonWriter writer(invalid);
+    writer.beginObject();
+    EXPECT_THROW(writer.value(1), std::logic_error);
+    EXPECT_THROW(writer.endArray(), std::logic_error);
+}
+
+TEST(Util, JsonWriterEscapesStrings) {
+    std::stringstream out;
+    JsonWriter json(out);
+    json.beginObject().member("a\"b", "c\\d\n\x01").member("n", 10).endObject();
+    EXPECT_EQ("{\n  \"a\\\"b\" : \"c\\\\d\\n\\u0001\",\n  \"n\" : 10\n}", out.str());
+    // The flags of the stream are left alone.
+    EXPECT_EQ(out.flags() & std::ios::basefield, std::ios::dec);
+}
+
+TEST(Util, JsonWriterCompact) {
+    std::stringstream out;
+    JsonWriter json(out, true);
+    json.beginObject();
+    json.key("x").beginArray().value(1).value(2.5).endArray();
+    json.key("y").beginArray().beginObject().member("z", true).endObject().endArray();
+    json.key("e").beginObject().endObject();
+    json.endObject();
+    EXPECT_EQ(R"({"x":[1,2.5],"y":[{"z":true}],"e":{}})", out.str());
+}
+
 }  // namespace P4::Util
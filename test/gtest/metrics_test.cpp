@@ -9,14 +9,21 @@ testdata/p4_16_samples_outputs.
 #include <gtest/gtest.h>
 
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
 
+#include "absl/strings/str_format.h"
 #include "frontends/common/options.h"
 #include "frontends/common/parseInput.h"
+#include "frontends/p4/createBuiltins.h"
 #include "frontends/p4/frontend.h"
+#include "frontends/p4/metrics/metricsBatch.h"
+#include "frontends/p4/metrics/metricsBinary.h"
+#include "frontends/p4/metrics/metricsPassManager.h"
 #include "test/gtest/env.h"
 #include "test/gtest/helpers.h"
 
@@ -32,11 +39,16 @@ class MetricPassesTest : public P4CTest {
     fs::path metricsOutputPath;
     fs::path txtMetricsOutputPath;
     fs::path jsonMetricsOutputPath;
+    const IR::P4Program *frontendResult = nullptr;
 
-    void SetUpFrontend(bool allMetrics) {
+    static CompilerOptions &compilerOptions() {
         P4CContext &contextRef = P4CContext::get();
         auto *ctx = dynamic_cast<P4CContextWithOptions<CompilerOptions> *>(&contextRef);
-        auto &opts = ctx->options();
+        return ctx->options();
+    }
+
+    void SetUpFrontend(bool allMetrics) {
+        auto &opts = compilerOptions();
         opts.langVersion = CompilerOptions::FrontendVersion::P4_16;
         opts.file = inputFile;
         const char *originalEnv = getenv("P4C_16_INCLUDE_PATH");
@@ -64,6 +76,7 @@ class MetricPassesTest : public P4CTest {
         FrontEnd frontend;
         const IR::P4Program *result = frontend.run(opts, program, &std::cerr);
         ASSERT_NE(result, nullptr) << "Frontend pipeline failed for " << inputFile;
+        frontendResult = result;
 
         metricsOutputPath =
             "../testdata/p4_16_samples/metrics/" + fs::path(inputFile).stem().string();
@@ -77,6 +90,14 @@ class MetricPassesTest : public P4CTest {
             setenv("P4C_16_INCLUDE_PATH", originalEnv, 1);
     }
 
+    /// Runs the frontend on metrics_test_8.p4, which covers every metric and is
+    /// shared by the tests of the metrics infrastructure.
+    void SetUpSharedProgram(bool allMetrics) {
+        inputFile = "../testdata/p4_16_samples/metrics/metrics_test_8.p4";
+        SetUpFrontend(allMetrics);
+        ASSERT_NE(frontendResult, nullptr);
+    }
+
     std::string readFileContent(const fs::path &path) {
         std::ifstream in(path);
         if (!in.is_open()) {
@@ -149,4 +170,475 @@ TEST_F(MetricPassesTest, MetricsTest10) {
     EXPECT_EQ(metrics.inlinedActions, 0u);
 }
 
+TEST_F(MetricPassesTest, MetricsEngineMatchesStandalonePasses) {
+    ASSERT_NO_FATAL_FAILURE(SetUpSharedProgram(true));
+
+    // Values of metrics_test_8_metrics.json, written by the passes before they were
+    // hosted by the MetricsEngine. Both the shared traversal and the collectors
+    // applied one by one must reproduce them.
+    auto expectBaselineValues = [](const Metrics &metrics, const char *mode) {
+        SCOPED_TRACE(mode);
+        EXPECT_EQ(metrics.linesOfCode, 150u);
+        const P4::ordered_map<cstring, unsigned> complexity = {
+            {"MyParser"_cs, 5},  {"MyVerifyChecksum"_cs, 1},  {"MyIngress"_cs, 7},
+            {"MyEgress"_cs, 4},  {"MyComputeChecksum"_cs, 1}, {"MyDeparser"_cs, 1}};
+        EXPECT_EQ(metrics.cyclomaticComplexity, complexity);
+        EXPECT_EQ(metrics.halsteadMetrics.uniqueOperators, 26u);
+        EXPECT_EQ(metrics.halsteadMetrics.uniqueOperands, 56u);
+        EXPECT_EQ(metrics.halsteadMetrics.totalOperators, 116u);
+        EXPECT_EQ(metrics.halsteadMetrics.totalOperands, 124u);
+        const P4::ordered_map<cstring, unsigned> depth = {
+            {"MyParser"_cs, 2},  {"MyVerifyChecksum"_cs, 1},  {"MyIngress"_cs, 1},
+            {"MyEgress"_cs, 1},  {"MyComputeChecksum"_cs, 1}, {"MyDeparser"_cs, 1}};
+        EXPECT_EQ(metrics.nestingDepth.blockNestingDepth, depth);
+        const P4::ordered_map<cstring, unsigned> states = {{"start"_cs, 3},
+                                                           {"parse_ipv4"_cs, 3},
+                                                           {"parse_tcp"_cs, 1},
+                                                           {"accept"_cs, 1},
+                                                           {"reject"_cs, 1}};
+        EXPECT_EQ(metrics.parserMetrics.StateComplexity, states);
+        EXPECT_EQ(metrics.externMetrics.externFunctions, 24u);
+        EXPECT_EQ(metrics.externMetrics.externFunctionUses, 10u);
+    };
+
+    expectBaselineValues(P4CContext::get().options().metrics, "engine");
+
+    Metrics standalone;
+    frontendResult->apply(LinesOfCodeMetricPass(standalone, inputFile));
+    frontendResult->apply(CyclomaticComplexityPass(standalone));
+    frontendResult->apply(HalsteadMetricsPass(standalone));
+    frontendResult->apply(NestingDepthMetricPass(standalone));
+    frontendResult->apply(ParserMetricsPass(standalone));
+    frontendResult->apply(ExternalObjectsMetricPass(standalone));
+    expectBaselineValues(standalone, "standalone");
+}
+
+TEST_F(MetricPassesTest, MetricsFormatSelectsOutputFiles) {
+    ASSERT_NO_FATAL_FAILURE(SetUpSharedProgram(true));
+
+    // Both files were written by the frontend, the expected content must stay the same.
+    std::string expectedText = readFileContent(txtMetricsOutputPath);
+    std::string expectedJson = readFileContent(jsonMetricsOutputPath);
+    EXPECT_NE(expectedText.find("Lines of Code: 150"), std::string::npos);
+    EXPECT_NE(expectedJson.find("\"lines_of_code\" : 150"), std::string::npos);
+    fs::remove(txtMetricsOutputPath);
+    fs::remove(jsonMetricsOutputPath);
+
+    Metrics &metrics = P4CContext::get().options().metrics;
+    const auto &selected = compilerOptions().selectedMetrics;
+    frontendResult->apply(ExportMetricsPass(inputFile, selected, metrics, "txt"_cs));
+    EXPECT_EQ(readFileContent(txtMetricsOutputPath), expectedText);
+    EXPECT_FALSE(fs::exists(jsonMetricsOutputPath));
+
+    fs::remove(txtMetricsOutputPath);
+    frontendResult->apply(ExportMetricsPass(inputFile, selected, metrics, "json"_cs));
+    EXPECT_EQ(readFileContent(jsonMetricsOutputPath), expectedJson);
+    EXPECT_FALSE(fs::exists(txtMetricsOutputPath));
+}
+
+TEST_F(MetricPassesTest, LabeledSnapshotsAfterSelectedPasses) {
+    ASSERT_NO_FATAL_FAILURE(SetUpSharedProgram(false));
+
+    auto &opts = compilerOptions();
+    opts.metricsFormat = "json"_cs;
+    opts.metricsAfterPasses = {"Simplify"_cs};
+    MetricsPassManager metricsPassManager(opts, nullptr, opts.metrics);
+
+    auto snapshotPath = [&](cstring label) {
+        fs::path path = metricsOutputPath;
+        path += absl::StrFormat("_metrics-%04u-%s.json", opts.metricsSnapshotCount,
+                                label.c_str());
+        return path;
+    };
+
+    // Passes which do not match --metrics-after are ignored by the hook.
+    unsigned count = opts.metricsSnapshotCount;
+    auto hook = metricsPassManager.getSnapshotHook();
+    hook("MidEnd", 1, "P4::RemoveAllUnusedDeclarations", frontendResult);
+    EXPECT_EQ(opts.metricsSnapshotCount, count);
+    hook("MidEnd", 2, "P4::SimplifyControlFlow", frontendResult);
+    ASSERT_EQ(opts.metricsSnapshotCount, count + 1);
+
+    fs::path hookSnapshot = snapshotPath("P4::SimplifyControlFlow"_cs);
+    std::string content = readFileContent(hookSnapshot);
+    EXPECT_NE(content.find("\"snapshot\" : \"P4::SimplifyControlFlow\""), std::string::npos);
+    EXPECT_NE(content.find("\"MyIngress\" : 7"), std::string::npos);
+    fs::remove(hookSnapshot);
+
+    PassManager pm;
+    metricsPassManager.addSnapshot(pm, "backend"_cs);
+    frontendResult->apply(pm);
+    fs::path passSnapshot = snapshotPath("backend"_cs);
+    EXPECT_TRUE(fs::exists(passSnapshot));
+    fs::remove(passSnapshot);
+}
+
+TEST_F(MetricPassesTest, SnapshotHookOutlivesTheManager) {
+    ASSERT_NO_FATAL_FAILURE(SetUpSharedProgram(false));
+
+    auto &opts = compilerOptions();
+    opts.metricsFormat = "json"_cs;
+    opts.metricsAfterPasses = {"Simplify"_cs};
+    DebugHook hook;
+    {
+        MetricsPassManager metricsPassManager(opts, nullptr, opts.metrics);
+        hook = metricsPassManager.getSnapshotHook();
+    }
+
+    unsigned count = opts.metricsSnapshotCount;
+    hook("MidEnd", 1, "P4::SimplifyControlFlow", frontendResult);
+    ASSERT_EQ(opts.metricsSnapshotCount, count + 1);
+    fs::path snapshot = metricsOutputPath;
+    snapshot += absl::StrFormat("_metrics-%04u-P4::SimplifyControlFlow.json", count + 1);
+    EXPECT_TRUE(fs::exists(snapshot));
+    fs::remove(snapshot);
+
+    // A program which no longer type checks is skipped, without failing the compilation.
+    auto *untyped = new IR::P4Program(IR::Vector<IR::Node>(
+        {new IR::Declaration_Variable(IR::ID("x"), new IR::Type_Name(IR::ID("Undeclared")))}));
+    unsigned errors = ::P4::errorCount();
+    hook("MidEnd", 2, "P4::SimplifyControlFlow", untyped);
+    EXPECT_EQ(::P4::errorCount(), errors);
+    EXPECT_EQ(opts.metricsSnapshotCount, count + 1);
+}
+
+TEST_F(MetricPassesTest, CompileProfileRecordsEveryPass) {
+    ASSERT_NO_FATAL_FAILURE(SetUpSharedProgram(false));
+    fs::remove(txtMetricsOutputPath);
+    fs::remove(jsonMetricsOutputPath);
+
+    auto &opts = compilerOptions();
+    opts.metricsFormat = "json"_cs;
+    opts.selectedMetrics.insert("compile-profile"_cs);
+    opts.selectedMetrics.insert("compile-profile-nodes"_cs);
+    Metrics &metrics = opts.metrics;
+    metrics.compileProfile.clear();
+    MetricsPassManager metricsPassManager(opts, nullptr, metrics);
+
+    PassManager pm({[]() {},
+                    [](const IR::Node *) -> const IR::Node * {
+                        return new IR::P4Program(IR::Vector<IR::Node>());
+                    }});
+    pm.setName("ProfiledPasses");
+    pm.addDebugHook(metricsPassManager.getProfileHook(frontendResult));
+    const IR::Node *result = frontendResult->apply(pm);
+
+    size_t programNodes = CompileProfiler::countNodes(frontendResult);
+    ASSERT_EQ(metrics.compileProfile.size(), 2u);
+    const auto &unchanged = metrics.compileProfile[0];
+    EXPECT_EQ(unchanged.manager, "ProfiledPasses");
+    EXPECT_EQ(unchanged.seqNo, 0u);
+    EXPECT_EQ(unchanged.nodesBefore, programNodes);
+    EXPECT_EQ(unchanged.nodesAfter, programNodes);
+    const auto &replaced = metrics.compileProfile[1];
+    EXPECT_EQ(replaced.seqNo, 1u);
+    EXPECT_EQ(replaced.nodesBefore, programNodes);
+    EXPECT_EQ(replaced.nodesAfter, CompileProfiler::countNodes(result));
+    EXPECT_LT(replaced.nodesAfter, programNodes);
+    EXPECT_GE(replaced.milliseconds, 0.0);
+
+    metricsPassManager.exportCompileProfile(result);
+    std::string content = readFileContent(jsonMetricsOutputPath);
+    EXPECT_NE(content.find("\"compile_profile\""), std::string::npos);
+    EXPECT_NE(content.find("\"manager\" : \"ProfiledPasses\""), std::string::npos);
+    EXPECT_NE(content.find("\"nodes_before\" : " + std::to_string(programNodes)),
+              std::string::npos);
+}
+
+TEST_F(MetricPassesTest, CompileProfileCountsNodesOnlyWhenRequested) {
+    ASSERT_NO_FATAL_FAILURE(SetUpSharedProgram(false));
+    fs::remove(jsonMetricsOutputPath);
+
+    auto &opts = compilerOptions();
+    opts.metricsFormat = "json"_cs;
+    opts.selectedMetrics.insert("compile-profile"_cs);
+    opts.selectedMetrics.erase("compile-profile-nodes"_cs);
+    Metrics &metrics = opts.metrics;
+    metrics.compileProfile.clear();
+    MetricsPassManager metricsPassManager(opts, nullptr, metrics);
+
+    PassManager pm({[]() {}});
+    pm.addDebugHook(metricsPassManager.getProfileHook(frontendResult));
+    frontendResult->apply(pm);
+
+    ASSERT_EQ(metrics.compileProfile.size(), 1u);
+    EXPECT_EQ(metrics.compileProfile[0].nodesBefore, 0u);
+    EXPECT_EQ(metrics.compileProfile[0].nodesAfter, 0u);
+    metricsPassManager.exportCompileProfile(frontendResult);
+    std::string content = readFileContent(jsonMetricsOutputPath);
+    EXPECT_NE(content.find("\"compile_profile\""), std::string::npos);
+    EXPECT_EQ(content.find("\"nodes_before\""), std::string::npos);
+}
+
+TEST_F(MetricPassesTest, MetricsBatchWritesOneRecordPerProgram) {
+    inputFile = "../testdata/p4_16_samples/metrics/metrics_test_1.p4";
+    SetUpFrontend(true);
+    std::vector<std::string> programs = {inputFile,
+                                         "../testdata/p4_16_samples/metrics/metrics_test_2.p4"};
+
+    auto &opts = compilerOptions();
+    fs::path output = fs::temp_directory_path() / "p4c_metrics_batch_test.jsonl";
+    opts.metricsBatchOutput = output;
+    std::vector<const char *> files;
+    for (const auto &program : programs) files.push_back(program.c_str());
+
+    std::string includeDir = std::string(buildPath) + "p4include";
+    setenv("P4C_16_INCLUDE_PATH", includeDir.c_str(), 1);
+    MetricsBatch batch(opts, files);
+    EXPECT_EQ(batch.size(), programs.size());
+    EXPECT_TRUE(batch.run());
+    unsetenv("P4C_16_INCLUDE_PATH");
+
+    // Every record holds the single-line form of the program's _metrics.json file.
+    std::ifstream records(output);
+    for (const auto &program : programs) {
+        std::string expected = readFileContent(
+            "../testdata/p4_16_samples_outputs/metrics/" + fs::path(program).stem().string() +
+            "_metrics.json");
+        std::string compact;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (expected[i] == '\n') {
+                while (i + 1 < expected.size() && expected[i + 1] == ' ') ++i;
+            } else if (expected.compare(i, 3, " : ") == 0) {
+                compact += ':';
+                i += 2;
+            } else {
+                compact += expected[i];
+            }
+        }
+        std::string record;
+        ASSERT_TRUE(std::getline(records, record));
+        EXPECT_EQ(record, "{\"program\":\"" + program + "\",\"metrics\":" + compact + "}");
+    }
+    fs::remove(output);
+}
+
+TEST_F(MetricPassesTest, ParallelBlockMetricsMatchSequential) {
+    ASSERT_NO_FATAL_FAILURE(SetUpSharedProgram(true));
+
+    // Results merged from worker threads must keep the order of the sequential run.
+    Metrics &sequential = P4CContext::get().options().metrics;
+    Metrics parallel;
+    MetricsEngine engine(4);
+    engine.addCollector(new CyclomaticComplexityPass(parallel));
+    engine.addCollector(new NestingDepthMetricPass(parallel));
+    frontendResult->apply(engine);
+
+    EXPECT_TRUE(parallel.cyclomaticComplexity == sequential.cyclomaticComplexity);
+    EXPECT_TRUE(parallel.nestingDepth.blockNestingDepth ==
+                sequential.nestingDepth.blockNestingDepth);
+    EXPECT_EQ(parallel.nestingDepth.avgNestingDepth, sequential.nestingDepth.avgNestingDepth);
+    EXPECT_EQ(parallel.nestingDepth.maxNestingDepth, sequential.nestingDepth.maxNestingDepth);
+}
+
+TEST_F(MetricPassesTest, MetricsCacheReusesValues) {
+    ASSERT_NO_FATAL_FAILURE(SetUpSharedProgram(true));
+
+    fs::path cacheDir = fs::temp_directory_path() / "p4c_metrics_cache_test";
+    fs::remove_all(cacheDir);
+
+    Metrics uncached;
+    frontendResult->apply(CyclomaticComplexityPass(uncached));
+    frontendResult->apply(NestingDepthMetricPass(uncached));
+
+    // The first run fills the cache, the second one takes all values from it.
+    size_t cachedEntries = 0;
+    for (int run = 0; run < 2; ++run) {
+        MetricsCache cache(cacheDir);
+        EXPECT_EQ(cache.size(), cachedEntries);
+        Metrics cached;
+        frontendResult->apply(CyclomaticComplexityPass(cached, &cache));
+        frontendResult->apply(NestingDepthMetricPass(cached, &cache));
+        cache.save();
+        if (run == 0) cachedEntries = cache.size();
+
+        // One entry for each of the six parsers and controls of the program.
+        EXPECT_EQ(cache.size(), 6u);
+        EXPECT_EQ(cached.cyclomaticComplexity.at("MyIngress"_cs), 7u);
+        EXPECT_EQ(cached.nestingDepth.blockNestingDepth.at("MyParser"_cs), 2u);
+        EXPECT_EQ(cached.cyclomaticComplexity, uncached.cyclomaticComplexity);
+        EXPECT_EQ(cached.nestingDepth.blockNestingDepth, uncached.nestingDepth.blockNestingDepth);
+        EXPECT_EQ(cached.nestingDepth.avgNestingDepth, uncached.nestingDepth.avgNestingDepth);
+        EXPECT_EQ(cached.nestingDepth.maxNestingDepth, uncached.nestingDepth.maxNestingDepth);
+    }
+    fs::remove_all(cacheDir);
+}
+
+TEST_F(MetricPassesTest, MetricsCacheMergesConcurrentSaves) {
+    ASSERT_NO_FATAL_FAILURE(SetUpSharedProgram(true));
+
+    fs::path cacheDir = fs::temp_directory_path() / "p4c_metrics_cache_merge_test";
+    fs::remove_all(cacheDir);
+
+    // Two compilations load the empty cache, and each saves different values.
+    MetricsCache first(cacheDir);
+    MetricsCache second(cacheDir);
+    Metrics firstMetrics;
+    Metrics secondMetrics;
+    frontendResult->apply(CyclomaticComplexityPass(firstMetrics, &first));
+    frontendResult->apply(NestingDepthMetricPass(secondMetrics, &second));
+    first.save();
+    second.save();
+
+    // The cache on disk holds the values of both.
+    MetricsCache merged(cacheDir);
+    EXPECT_EQ(merged.size(), first.size());
+    size_t blocks = 0;
+    for (const auto *object : frontendResult->objects) {
+        if (!object->is<IR::P4Control>() && !object->is<IR::P4Parser>()) continue;
+        const auto &entry = merged.getEntry(object);
+        EXPECT_TRUE(entry.cyclomaticComplexity.has_value());
+        EXPECT_TRUE(entry.nestingDepth.has_value());
+        ++blocks;
+    }
+    EXPECT_EQ(blocks, firstMetrics.cyclomaticComplexity.size());
+    fs::remove_all(cacheDir);
+}
+
+TEST_F(MetricPassesTest, MetricsSnapshotRoundTripAndDiff) {
+    ASSERT_NO_FATAL_FAILURE(SetUpSharedProgram(true));
+
+    Metrics &metrics = P4CContext::get().options().metrics;
+    metrics.compileProfile = {{"FrontEnd"_cs, "P4::TypeChecking"_cs, 3, 1.5, 10, 640, 200, 210}};
+    fs::path oldPath = fs::temp_directory_path() / "p4c_metrics_snapshot_old.bin";
+    fs::path newPath = fs::temp_directory_path() / "p4c_metrics_snapshot_new.bin";
+    ASSERT_TRUE(writeMetricsSnapshot(metrics, oldPath.string()));
+
+    MetricsSnapshot snapshot;
+    ASSERT_TRUE(snapshot.open(oldPath.string()));
+    Metrics loaded = snapshot.toMetrics();
+    EXPECT_EQ(loaded.linesOfCode, metrics.linesOfCode);
+    EXPECT_EQ(loaded.cyclomaticComplexity, metrics.cyclomaticComplexity);
+    EXPECT_EQ(loaded.nestingDepth.blockNestingDepth, metrics.nestingDepth.blockNestingDepth);
+    EXPECT_EQ(loaded.halsteadMetrics.effort, metrics.halsteadMetrics.effort);
+    EXPECT_EQ(loaded.headerMetrics.fieldSizeSum, metrics.headerMetrics.fieldSizeSum);
+    EXPECT_EQ(loaded.matchActionTableMetrics.keysNum, metrics.matchActionTableMetrics.keysNum);
+    EXPECT_EQ(loaded.matchActionTableMetrics.avgKeySize,
+              metrics.matchActionTableMetrics.avgKeySize);
+    EXPECT_EQ(loaded.parserMetrics.StateComplexity, metrics.parserMetrics.StateComplexity);
+    EXPECT_EQ(loaded.headerModificationMetrics.perPacket.size(),
+              metrics.headerModificationMetrics.perPacket.size());
+    EXPECT_EQ(loaded.headerModificationMetrics.total.totalSize,
+              metrics.headerModificationMetrics.total.totalSize);
+    EXPECT_EQ(loaded.unusedCodeInstances.states, metrics.unusedCodeInstances.states);
+    EXPECT_EQ(loaded.externMetrics.externFunctions, metrics.externMetrics.externFunctions);
+    ASSERT_EQ(loaded.compileProfile.size(), 1u);
+    EXPECT_EQ(loaded.compileProfile[0].manager, "FrontEnd");
+    EXPECT_EQ(loaded.compileProfile[0].pass, "P4::TypeChecking");
+    EXPECT_EQ(loaded.compileProfile[0].seqNo, 3u);
+    EXPECT_EQ(loaded.compileProfile[0].milliseconds, 1.5);
+    EXPECT_EQ(loaded.compileProfile[0].allocatedBytes, 640u);
+    EXPECT_EQ(loaded.compileProfile[0].nodesAfter, 210u);
+
+    // Only a grown block and a new table are reported, the grown block as a regression.
+    ASSERT_FALSE(loaded.cyclomaticComplexity.empty());
+    auto &block = *loaded.cyclomaticComplexity.begin();
+    block.second *= 2;
+    loaded.matchActionTableMetrics.keysNum["p4c_metrics_new_table"_cs] = 1;
+    ASSERT_TRUE(writeMetricsSnapshot(loaded, newPath.string()));
+
+    MetricsSnapshot changed;
+    ASSERT_TRUE(changed.open(newPath.string()));
+    EXPECT_TRUE(diffMetricsSnapshots(snapshot, snapshot, 10).empty());
+    auto changes = diffMetricsSnapshots(snapshot, changed, 10);
+    ASSERT_EQ(changes.size(), 2u);
+    EXPECT_EQ(changes[0].metric, "cyclomatic");
+    EXPECT_EQ(changes[0].name, block.first.string());
+    EXPECT_TRUE(changes[0].regression);
+    EXPECT_EQ(changes[1].metric, "table-keys");
+    EXPECT_TRUE(changes[1].added);
+    EXPECT_FALSE(changes[1].regression);
+    EXPECT_FALSE(diffMetricsSnapshots(snapshot, changed, 1000)[0].regression);
+
+    fs::remove(oldPath);
+    fs::remove(newPath);
+}
+
+TEST_F(MetricPassesTest, MetricsSnapshotRejectsCorruptedMaps) {
+    ASSERT_NO_FATAL_FAILURE(SetUpSharedProgram(true));
+    fs::path path = fs::temp_directory_path() / "p4c_metrics_snapshot_corrupted.bin";
+    ASSERT_TRUE(writeMetricsSnapshot(P4CContext::get().options().metrics, path.string()));
+    std::string valid = readFileContent(path);
+    MetricsSnapshotHeader header;
+    std::memcpy(&header, valid.data(), sizeof(header));
+    ASSERT_GT(header.mapCount, 0u);
+
+    // Rewrites the first map descriptor and checks that the snapshot is rejected.
+    auto expectRejected = [&](uint32_t columns, uint32_t entryCount) {
+        MetricsMapDescriptor map;
+        std::string data = valid;
+        std::memcpy(&map, data.data() + header.mapsOffset, sizeof(map));
+        map.columns = columns;
+        map.entryCount = entryCount;
+        std::memcpy(data.data() + header.mapsOffset, &map, sizeof(map));
+        {
+            std::ofstream out(path, std::ios::binary);
+            out << data;
+        }
+        MetricsSnapshot snapshot;
+        EXPECT_FALSE(snapshot.open(path.string())) << columns << " " << entryCount;
+    };
+    expectRejected(0, 1);
+    // 2^32 + 1 words per entry, which overflows the size of the entries in 64 bits.
+    expectRejected(UINT32_MAX, UINT32_MAX);
+    expectRejected(1, UINT32_MAX);
+    fs::remove(path);
+}
+
+TEST_F(MetricPassesTest, ParserAnalyzerExpandsJoinedPathsOnce) {
+    // Every stage branches into two states which join again, so the number of parser
+    // paths doubles with every stage, while the packet types only grow linearly.
+    constexpr size_t stages = 40;
+    std::stringstream source;
+    source << "extern packet_in { void extract<T>(out T hdr); }\n"
+           << "header h_t { bit<8> v; }\n"
+           << "struct headers_t {";
+    for (size_t i = 0; i < stages; ++i) source << " h_t h" << i << ";";
+    source << " }\n"
+           << "parser P(packet_in pkt, out headers_t hdr) {\n"
+           << "    state start { transition s0; }\n";
+    for (size_t i = 0; i < stages; ++i) {
+        std::string next = i + 1 < stages ? "s" + std::to_string(i + 1) : "accept";
+        source << "    state s" << i << " { pkt.extract(hdr.h" << i << "); transition select(hdr.h"
+               << i << ".v) { 0: l" << i << "; default: r" << i << "; } }\n"
+               << "    state l" << i << " { transition " << next << "; }\n"
+               << "    state r" << i << " { transition " << next << "; }\n";
+    }
+    source << "}\n";
+
+    const auto *program = parseP4String(source.str(), CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_NE(program, nullptr);
+    program = program->apply(CreateBuiltins());
+
+    ParserCallGraph graph("graph");
+    std::set<cstring> types;
+    program->apply(ParserAnalyzer(graph, types));
+    EXPECT_EQ(types.size(), stages);
+    EXPECT_EQ(types.count("h0-h1-h2"_cs), 1u);
+
+    // The path cap stops the enumeration, keeping the types found so far.
+    std::set<cstring> partial;
+    program->apply(ParserAnalyzer(graph, partial, 10));
+    EXPECT_GT(partial.size(), 0u);
+    EXPECT_LT(partial.size(), types.size());
+}
+
+TEST(ScopedNameIndexTest, MatchesRenamedNames) {
+    ScopedNameIndex index;
+    index.insert("MyIngress.tmp"_cs);
+    index.insert("MyIngress.if_7.x"_cs);
+    index.insert("MyEgress.tmp"_cs);
+    index.insert("MyIngress.tmp"_cs);
+
+    // Names renamed by UniqueNames still contain the original name.
+    index.match("MyIngress.tmp_0");
+    index.match("MyEgress.if_9.x");
+
+    EXPECT_TRUE(index.isMatched(0));
+    EXPECT_FALSE(index.isMatched(1));
+    EXPECT_FALSE(index.isMatched(2));
+    EXPECT_TRUE(index.isMatched(3));
+    EXPECT_EQ(index.countUnmatched(), 2u);
+}
+
 }  // namespace P4::Test
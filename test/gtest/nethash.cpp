@@ -2,8 +2,12 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>  // NOLINT linter forbids using chrono, but we don't have alternatives
 #include <initializer_list>
+#include <iostream>
+#include <random>
 #include <string_view>
+#include <vector>
 
 namespace P4::Test {
 
@@ -110,4 +114,130 @@ TEST(NetHash, identity) {
               0x4500'0073'0000'4000_u64);
 }
 
+/// The table-driven CRC computed a byte at a time, with reflection bit-by-bit, which the
+/// functions above were implemented with before they used slice-by-8.
+template <typename T>
+class LegacyCrc {
+    static constexpr int BITS = sizeof(T) * 8;
+    T table[256];
+    T init, xorOut;
+    bool reflected;
+
+    template <typename U>
+    static U reflect(U data) {
+        U reflection = 0;
+        for (size_t bit = 0; bit < sizeof(U) * 8; ++bit, data >>= 1) {
+            if (data & 1) reflection |= U(1) << (sizeof(U) * 8 - 1 - bit);
+        }
+        return reflection;
+    }
+
+ public:
+    LegacyCrc(T poly, T init, T xorOut, bool reflected)
+        : init(init), xorOut(xorOut), reflected(reflected) {
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            T reg = T(byte) << (BITS - 8);
+            for (int bit = 0; bit < 8; ++bit)
+                reg = (reg >> (BITS - 1)) ? T(reg << 1) ^ poly : T(reg << 1);
+            table[byte] = reg;
+        }
+    }
+
+    T operator()(const uint8_t *buf, size_t len) const {
+        T remainder = init;
+        for (size_t byte = 0; byte < len; ++byte) {
+            uint8_t data = reflected ? reflect<uint8_t>(buf[byte]) : buf[byte];
+            remainder = table[data ^ (remainder >> (BITS - 8))] ^ T(remainder << 8);
+        }
+        return (reflected ? reflect<T>(remainder) : remainder) ^ xorOut;
+    }
+};
+
+std::vector<uint8_t> randomBytes(size_t size) {
+    std::mt19937 gen(42);
+    std::vector<uint8_t> bytes(size);
+    for (auto &byte : bytes) byte = static_cast<uint8_t>(gen());
+    return bytes;
+}
+
+TEST(NetHash, crcMatchesLegacy) {
+    const LegacyCrc<uint16_t> legacyCrc16(0x8005, 0, 0, true);
+    const LegacyCrc<uint16_t> legacyCrc16ANSI(0x8005, 0, 0, false);
+    const LegacyCrc<uint16_t> legacyCrcCCITT(0x1021, 0xffff, 0, false);
+    const LegacyCrc<uint32_t> legacyCrc32(0x04C11DB7, 0xffffffff, 0xffffffff, true);
+    const LegacyCrc<uint32_t> legacyCrc32FCS(0x04C11DB7, 0xffffffff, 0xffffffff, false);
+    auto bytes = randomBytes(1024);
+    // All lengths up to some blocks of the vectorized CRC-32, at unaligned offsets.
+    for (size_t offset = 0; offset < 3; ++offset) {
+        for (size_t len = 0; len + offset <= 300; ++len) {
+            const uint8_t *buf = bytes.data() + offset;
+            ASSERT_EQ(crc16(buf, len), legacyCrc16(buf, len)) << len;
+            ASSERT_EQ(crc16ANSI(buf, len), legacyCrc16ANSI(buf, len)) << len;
+            ASSERT_EQ(crcCCITT(buf, len), legacyCrcCCITT(buf, len)) << len;
+            ASSERT_EQ(crc32(buf, len), legacyCrc32(buf, len)) << len;
+            ASSERT_EQ(crc32FCS(buf, len), legacyCrc32FCS(buf, len)) << len;
+        }
+    }
+    EXPECT_EQ(crc32(bytes.data(), bytes.size()), legacyCrc32(bytes.data(), bytes.size()));
+}
+
+TEST(NetHash, crcCustom) {
+    // The check values of the CRC catalogue, the CRCs of "123456789".
+    std::string_view check = "123456789";
+    auto crc = [&](unsigned width, uint64_t poly, uint64_t init, uint64_t xorOut, bool reflect) {
+        return Hex(crcCustom(reinterpret_cast<const uint8_t *>(check.data()), check.size(),
+                             width, poly, init, xorOut, reflect));
+    };
+    EXPECT_EQ(crc(3, 0x3, 0x7, 0, true), 0x6_u64);                             // CRC-3/ROHC
+    EXPECT_EQ(crc(5, 0x05, 0x1f, 0x1f, true), 0x19_u64);                       // CRC-5/USB
+    EXPECT_EQ(crc(7, 0x09, 0, 0, false), 0x75_u64);                            // CRC-7/MMC
+    EXPECT_EQ(crc(8, 0x07, 0, 0, false), 0xF4_u64);                            // CRC-8/SMBUS
+    EXPECT_EQ(crc(16, 0x8005, 0, 0, true), 0xBB3D_u64);                        // CRC-16/ARC
+    EXPECT_EQ(crc(16, 0x1021, 0xffff, 0xffff, true), 0x906E_u64);              // CRC-16/X-25
+    EXPECT_EQ(crc(24, 0x864CFB, 0xB704CE, 0, false), 0x21CF02_u64);            // CRC-24/OPENPGP
+    EXPECT_EQ(crc(32, 0x04C11DB7, ~0U, ~0U, true), 0xCBF43926_u64);            // CRC-32
+    EXPECT_EQ(crc(32, 0x04C11DB7, ~0U, 0, true), 0x340BC6D9_u64);              // CRC-32/JAMCRC
+    EXPECT_EQ(crc(32, 0x04C11DB7, ~0U, 0, false), 0x0376E6E7_u64);             // CRC-32/MPEG-2
+    EXPECT_EQ(crc(32, 0x1EDC6F41, ~0U, ~0U, true), 0xE3069283_u64);            // CRC-32C
+    EXPECT_EQ(crc(64, 0x42F0E1EBA9EA3693, 0, 0, false), 0x6C40DF5F0B497347_u64);  // CRC-64
+    EXPECT_EQ(crc(64, 0x42F0E1EBA9EA3693, ~0ULL, ~0ULL, true),
+              0x995DC9BBDF1939FA_u64);  // CRC-64/XZ
+
+    auto bytes = randomBytes(1000);
+    EXPECT_EQ(crcCustom(bytes.data(), bytes.size(), 32, 0x04C11DB7, ~0U, ~0U, true),
+              crc32(bytes.data(), bytes.size()));
+    EXPECT_EQ(crcCustom(bytes.data(), bytes.size(), 16, 0x1021, 0xffff, 0, false),
+              crcCCITT(bytes.data(), bytes.size()));
+}
+
+// Reports the throughput of the table-driven CRCs and of the bitwise implementations they
+// replace. Disabled by default, run it with --gtest_also_run_disabled_tests.
+TEST(NetHash, DISABLED_crcBenchmark) {
+    const LegacyCrc<uint16_t> legacyCrc16(0x8005, 0, 0, true);
+    const LegacyCrc<uint32_t> legacyCrc32(0x04C11DB7, 0xffffffff, 0xffffffff, true);
+    const LegacyCrc<uint32_t> legacyCrc32FCS(0x04C11DB7, 0xffffffff, 0xffffffff, false);
+    auto run = [](const char *name, size_t size, auto &&fn) {
+        auto bytes = randomBytes(size);
+        const size_t total = size_t(1) << 24;
+        volatile uint64_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t done = 0; done < total; done += size) sink = fn(bytes.data(), size);
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        static_cast<void>(sink);
+        std::cout << name << " on " << size << " byte inputs: " << total / elapsed.count()
+                  << " GB/s\n";
+    };
+    for (size_t size : {64, 1500}) {
+        run("legacy crc16", size, legacyCrc16);
+        run("crc16", size, crc16);
+        run("legacy crc32", size, legacyCrc32);
+        run("crc32", size, crc32);
+        run("legacy crc32FCS", size, legacyCrc32FCS);
+        run("crc32FCS", size, crc32FCS);
+        run("crcCustom CRC-32C", size, [](const uint8_t *buf, size_t len) {
+            return crcCustom(buf, len, 32, 0x1EDC6F41, ~0U, ~0U, true);
+        });
+    }
+}
+
 }  // namespace P4::Test
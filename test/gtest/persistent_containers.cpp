@@ -0,0 +1,148 @@
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "lib/persistent_map.h"
+#include "lib/persistent_stack.h"
+#include "lib/persistent_vector.h"
+
+using ::testing::ElementsAre;
+
+namespace P4::Test {
+
+TEST(PersistentMap, IteratesInKeyOrder) {
+    persistent_map<int, int> map;
+    for (int key : {5, 3, 8, 1, 4, 7, 9}) EXPECT_TRUE(map.insert_or_assign(key, key * 10));
+    EXPECT_FALSE(map.insert_or_assign(4, 41));
+    EXPECT_EQ(map.size(), 7u);
+    EXPECT_THAT(map, ElementsAre(std::make_pair(1, 10), std::make_pair(3, 30),
+                                 std::make_pair(4, 41), std::make_pair(5, 50),
+                                 std::make_pair(7, 70), std::make_pair(8, 80),
+                                 std::make_pair(9, 90)));
+    EXPECT_EQ(map.find(7)->second, 70);
+    EXPECT_EQ(map.find(6), map.end());
+    EXPECT_EQ(map.lookup(6), nullptr);
+    EXPECT_EQ(map.at(9), 90);
+    EXPECT_EQ(map.erase(5), 1u);
+    EXPECT_EQ(map.erase(5), 0u);
+    EXPECT_EQ(map.count(5), 0u);
+    EXPECT_EQ(map.size(), 6u);
+}
+
+TEST(PersistentMap, CopiesAreIndependent) {
+    persistent_map<int, int> original;
+    for (int i = 0; i < 100; ++i) original.insert_or_assign(i, i);
+    auto copy = original;
+    EXPECT_TRUE(copy.shares(original));
+    copy.insert_or_assign(10, -10);
+    copy.insert_or_assign(100, 100);
+    copy.erase(20);
+    EXPECT_FALSE(copy.shares(original));
+
+    EXPECT_EQ(original.size(), 100u);
+    EXPECT_EQ(original.at(10), 10);
+    EXPECT_EQ(original.count(100), 0u);
+    EXPECT_EQ(original.at(20), 20);
+    EXPECT_EQ(copy.size(), 100u);
+    EXPECT_EQ(copy.at(10), -10);
+    EXPECT_EQ(copy.at(100), 100);
+    EXPECT_EQ(copy.count(20), 0u);
+}
+
+TEST(PersistentMap, MatchesStdMap) {
+    std::mt19937 rng(1);
+    std::vector<persistent_map<int, int>> maps(4);
+    std::vector<std::map<int, int>> expected(4);
+    for (int step = 0; step < 20000; ++step) {
+        size_t i = rng() % maps.size();
+        int key = static_cast<int>(rng() % 300);
+        switch (rng() % 5) {
+            case 0: {
+                size_t j = rng() % maps.size();
+                maps[i] = maps[j];
+                expected[i] = expected[j];
+                break;
+            }
+            case 1:
+                EXPECT_EQ(maps[i].erase(key), expected[i].erase(key));
+                break;
+            default:
+                maps[i].insert_or_assign(key, step);
+                expected[i][key] = step;
+        }
+    }
+    for (size_t i = 0; i < maps.size(); ++i) {
+        std::map<int, int> contents(maps[i].begin(), maps[i].end());
+        EXPECT_EQ(contents, expected[i]);
+        EXPECT_EQ(maps[i].size(), expected[i].size());
+    }
+}
+
+TEST(PersistentVector, PushAndPop) {
+    persistent_vector<int> vector;
+    for (int i = 0; i < 5000; ++i) vector.push_back(i);
+    EXPECT_EQ(vector.size(), 5000u);
+    EXPECT_EQ(vector.front(), 0);
+    EXPECT_EQ(vector.back(), 4999);
+    EXPECT_EQ(vector[1234], 1234);
+    int next = 0;
+    for (int value : vector) EXPECT_EQ(value, next++);
+    EXPECT_EQ(next, 5000);
+
+    while (vector.size() > 10) vector.pop_back();
+    EXPECT_THAT(vector, ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+    while (!vector.empty()) vector.pop_back();
+    EXPECT_EQ(vector.begin(), vector.end());
+}
+
+TEST(PersistentVector, CopiesAreIndependent) {
+    std::mt19937 rng(2);
+    std::vector<persistent_vector<int>> vectors(4);
+    std::vector<std::vector<int>> expected(4);
+    for (int step = 0; step < 2000; ++step) {
+        size_t i = rng() % vectors.size();
+        switch (rng() % 4) {
+            case 0: {
+                size_t j = rng() % vectors.size();
+                vectors[i] = vectors[j];
+                expected[i] = expected[j];
+                break;
+            }
+            case 1:
+                for (int n = rng() % 40; n > 0 && !expected[i].empty(); --n) {
+                    vectors[i].pop_back();
+                    expected[i].pop_back();
+                }
+                break;
+            default:
+                for (int n = rng() % 100; n > 0; --n) {
+                    vectors[i].push_back(step);
+                    expected[i].push_back(step);
+                }
+        }
+    }
+    for (size_t i = 0; i < vectors.size(); ++i) EXPECT_EQ(vectors[i].toVector(), expected[i]);
+}
+
+TEST(PersistentStack, CopiesAreIndependent) {
+    persistent_stack<int> stack;
+    stack.push(1);
+    stack.push(2);
+    auto copy = stack;
+    copy.pop();
+    copy.push(3);
+    EXPECT_EQ(stack.size(), 2u);
+    EXPECT_EQ(stack.top(), 2);
+    EXPECT_EQ(copy.size(), 2u);
+    EXPECT_EQ(copy.top(), 3);
+    copy.pop();
+    EXPECT_EQ(copy.top(), 1);
+    copy.pop();
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(stack.top(), 2);
+}
+
+}  // namespace P4::Test
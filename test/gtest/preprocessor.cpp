@@ -0,0 +1,154 @@
+#include "frontends/common/preprocessor.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "frontends/common/options.h"
+#include "frontends/common/parseInput.h"
+#include "frontends/p4/toP4/toP4.h"
+#include "lib/error.h"
+#include "test/gtest/env.h"
+#include "test/gtest/helpers.h"
+
+namespace P4::Test {
+
+namespace fs = std::filesystem;
+
+class PreprocessorTest : public P4CTest {
+ protected:
+    fs::path directory;
+
+    void SetUp() override {
+        directory = fs::temp_directory_path() / ("p4c-preprocessor-" + std::to_string(getpid()));
+        fs::create_directories(directory);
+    }
+
+    void TearDown() override { fs::remove_all(directory); }
+
+    void write(const fs::path &path, const std::string &contents) {
+        std::ofstream out(path);
+        out << contents;
+    }
+
+    /// Preprocesses @p text and returns the output without line markers and blank lines.
+    std::string preprocess(const Preprocessor &preprocessor, const std::string &text) {
+        auto output = preprocessor.preprocess(text, directory / "test.p4");
+        if (!output) return "<error>";
+        std::stringstream in(*output);
+        std::string result;
+        for (std::string line; std::getline(in, line);) {
+            if (!line.empty() && line[0] != '#') result += line + "\n";
+        }
+        return result;
+    }
+
+    std::string preprocess(const std::string &text) { return preprocess(Preprocessor(), text); }
+
+    /// Parses @p file and prints it, using the preprocessor built into the compiler if
+    /// @p builtin is set.
+    std::string parse(const fs::path &file, bool builtin) {
+        AutoCompileContext context(new GTestContext(GTestContext::get()));
+        auto &options = GTestContext::get().options();
+        options.langVersion = CompilerOptions::FrontendVersion::P4_16;
+        options.file = file;
+        options.preprocessor_options = cstring("-DVALUE=3 -I" + directory.string());
+        options.builtinPreprocessor = builtin;
+        const auto *program = parseP4File(options);
+        if (program == nullptr || ::P4::errorCount() > 0) return {};
+        std::stringstream out;
+        program->apply(ToP4(&out, false));
+        for (const auto *object : program->objects)
+            out << object->srcInfo.toPositionString() << "\n";
+        return out.str();
+    }
+};
+
+TEST_F(PreprocessorTest, ObjectLikeMacros) {
+    EXPECT_EQ(preprocess("#define A 1 + 2\n#define B A * A\nx = B;\n"), "x = 1 + 2 * 1 + 2;\n");
+    EXPECT_EQ(preprocess("#define A B\n#define B A\nx = A; y = B;\n"), "x = A; y = B;\n");
+    EXPECT_EQ(preprocess("#define A 1\n#undef A\nx = A;\n"), "x = A;\n");
+    EXPECT_EQ(preprocess("#define A -\nx = -A;\n"), "x = - -;\n");
+}
+
+TEST_F(PreprocessorTest, FunctionLikeMacros) {
+    EXPECT_EQ(preprocess("#define F(a, b) ((a) * (b))\nx = F(1, (2, 3));\n"),
+              "x = ((1) * ((2, 3)));\n");
+    EXPECT_EQ(preprocess("#define F(a) a\nx = F;\n"), "x = F;\n");
+    EXPECT_EQ(preprocess("#define S(a) #a\n#define X(a) S(a)\n#define V 1\nx = S(V \"q\"); "
+                         "y = X(V);\n"),
+              "x = \"V \\\"q\\\"\"; y = \"1\";\n");
+    EXPECT_EQ(preprocess("#define C(a, b) a ## b\nx = C(8w, 1) C(, y);\n"), "x = 8w1 y;\n");
+    EXPECT_EQ(preprocess("#define L(f, ...) f(0, ## __VA_ARGS__)\nL(g); L(g, 1, 2);\n"),
+              "g(0); g(0, 1, 2);\n");
+    EXPECT_EQ(preprocess("#define f(x) x + f(x)\nf(f(2));\n"), "2 + f(2) + f(2 + f(2));\n");
+}
+
+TEST_F(PreprocessorTest, KeepsLineNumbers) {
+    auto output = Preprocessor().preprocess(
+        "#define F(a, b) a + b\nx = F(1,\n2);\ny = __LINE__;\n/* a\ncomment */\nz = 1;\n",
+        "test.p4");
+    ASSERT_TRUE(output.has_value());
+    EXPECT_EQ(*output, "# 1 \"test.p4\"\n\nx = 1 + 2;\n\ny = 4;\n/* a\ncomment */\nz = 1;\n");
+}
+
+TEST_F(PreprocessorTest, Conditionals) {
+    Preprocessor preprocessor;
+    preprocessor.define("V=2");
+    EXPECT_EQ(preprocess(preprocessor,
+                         "#if V > 1 && defined(V) && !defined W\na;\n#elif 1 / 0\nb;\n#endif\n"
+                         "#ifdef W\nc;\n#else\nd;\n#endif\n#if 0\n#error skipped\n#endif\n"),
+              "a;\nd;\n");
+    EXPECT_EQ(preprocess("#if 1\n"), "<error>");
+    EXPECT_EQ(preprocess("#error stop\n"), "<error>");
+}
+
+TEST_F(PreprocessorTest, UnsignedArithmetic) {
+    EXPECT_EQ(preprocess("#if -1 < 0u\nbad;\n#endif\n#if -1 > 0u\na;\n#endif\n"
+                         "#if 0xffffffffffffffff > 0\nb;\n#endif\n"
+                         "#if (-1 >> 63) == -1 && (-1u >> 63) == 1\nc;\n#endif\n"
+                         "#if -1 / 2u > 0 && (1 ? -1 : 0u) > 0\nd;\n#endif\n"
+                         "#if -1 / 2 == 0 && 1 << -1 == 0\ne;\n#endif\n"),
+              "a;\nb;\nc;\nd;\ne;\n");
+}
+
+TEST_F(PreprocessorTest, Includes) {
+    fs::create_directories(directory / "include");
+    write(directory / "include" / "guarded.p4",
+          "#ifndef G\n#define G\nconst bit<8> g = 1;\n#endif\n");
+    write(directory / "local.p4", "#pragma once\nconst bit<8> l = __INCLUDE_LEVEL__;\n");
+    Preprocessor preprocessor;
+    preprocessor.addIncludeDirectory(directory / "include");
+    EXPECT_EQ(preprocess(preprocessor,
+                         "#include <guarded.p4>\n#include <guarded.p4>\n#include \"local.p4\"\n"
+                         "#include \"local.p4\"\n"),
+              "const bit<8> g = 1;\nconst bit<8> l = 1;\n");
+    EXPECT_EQ(preprocess(preprocessor, "#include <missing.p4>\n"), "<error>");
+}
+
+TEST_F(PreprocessorTest, ParsesLikeExternalPreprocessor) {
+    setenv("P4C_16_INCLUDE_PATH", (std::string(buildPath) + "p4include").c_str(), 1);
+    write(directory / "constants.p4", "#define WIDTH(x) bit<(x)>\n");
+    auto file = directory / "program.p4";
+    write(file, R"(#include <core.p4>
+#define V1MODEL_VERSION 20200408
+#include <v1model.p4>
+#include "constants.p4"
+
+const WIDTH(8) value = VALUE;
+const bit<32> line = __LINE__;
+#if V1MODEL_VERSION >= 20200408
+header h_t { WIDTH(16) f; }
+#endif
+)");
+    auto expected = parse(file, false);
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(parse(file, true), expected);
+}
+
+}  // namespace P4::Test
@@ -76,6 +76,14 @@ TEST(UtilSourceFile, InputSources) {
     SourceFileLine original = sources.getSourceLine(3);
     EXPECT_EQ("fakesource.p4", original.fileName);
     EXPECT_EQ(5u, original.sourceLine);
+
+    SourceLineIndex index = sources.getLineIndex(3);
+    EXPECT_EQ(1u, index.fileId);
+    EXPECT_EQ(5u, index.sourceLine);
+    EXPECT_EQ("fakesource.p4", sources.getFileName(index.fileId));
+    EXPECT_EQ(0u, sources.getLineIndex(1).fileId);
+    EXPECT_EQ(1u, sources.getLineIndex(1).sourceLine);
+    EXPECT_EQ(2u, sources.fileCount());
 }
 
 TEST(UtilSourceFile, SourceInfo) {
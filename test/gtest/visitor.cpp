@@ -14,11 +14,16 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/common/resolveReferences/resolveReferences.h"
 #include "gtest/gtest.h"
 #include "helpers.h"
 #include "ir/ir.h"
+#include "ir/parallel_inspector.h"
 #include "midend_pass.h"
 
 namespace P4::Test {
@@ -160,4 +165,122 @@ TEST_F(P4CVisitor, MultiVisitModifierLoop) {
     ASSERT_TRUE(program != nullptr);
 }
 
+/// Records the context depth of every visited node.
+class CountVisits : public Inspector {
+ public:
+    std::vector<int> visits;
+    bool preorder(const IR::Node *) override {
+        visits.push_back(getContextDepth());
+        return true;
+    }
+};
+
+/// Replaces every constant with one shared node.
+class ShareConstants : public Transform {
+    const IR::Constant *shared = new IR::Constant(1);
+
+ public:
+    const IR::Node *postorder(IR::Constant *) override { return shared; }
+};
+
+/// Visits the declarations of the program twice, forgetting the first visit.
+class RevisitDeclarations : public Inspector {
+ public:
+    size_t visits = 0;
+    bool preorder(const IR::P4Program *program) override {
+        visit(program->objects, "objects");
+        revisit_visited();
+        visit(program->objects, "objects");
+        return false;
+    }
+    bool preorder(const IR::Node *) override {
+        ++visits;
+        return true;
+    }
+};
+
+TEST_F(P4CVisitor, DenseVisitStateMatchesMaps) {
+    auto *program =
+        P4::parseP4String(getMultiVisitLoopSource(), CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(program != nullptr);
+
+    CountVisits sparseCount;
+    program->apply(sparseCount);
+    RevisitDeclarations sparseRevisits;
+    program->apply(sparseRevisits);
+    auto *sparseResult = program->apply(ShareConstants());
+    program->apply(MultiVisitInspector());
+
+    Visitor::setDenseVisitState(true);
+    CountVisits denseCount;
+    program->apply(denseCount);
+    auto *denseResult = program->apply(ShareConstants());
+    program->apply(MultiVisitInspector());
+    program->apply(MultiVisitModifier());
+    // Traversals reuse the dense arrays of the previous ones.
+    CountVisits secondCount;
+    program->apply(secondCount);
+    RevisitDeclarations denseRevisits;
+    program->apply(denseRevisits);
+    Visitor::setDenseVisitState(false);
+
+    EXPECT_EQ(denseCount.visits, sparseCount.visits);
+    EXPECT_EQ(secondCount.visits, sparseCount.visits);
+    EXPECT_TRUE(denseResult->equiv(*sparseResult));
+    EXPECT_GT(sparseRevisits.visits, 0u);
+    EXPECT_EQ(denseRevisits.visits, sparseRevisits.visits);
+}
+
+/// Records every statement with the declaration and context depth it was found in.
+class CollectStatements : public ParallelInspector {
+    ParallelInspector *cloneWorker() const override {
+        return new CollectStatements(getThreads());
+    }
+    void reduce(const ParallelInspector &worker) override {
+        const auto &found = dynamic_cast<const CollectStatements &>(worker).statements;
+        statements.insert(statements.end(), found.begin(), found.end());
+    }
+
+ public:
+    std::vector<std::string> statements;
+
+    explicit CollectStatements(unsigned threads) : ParallelInspector(threads) {}
+
+    bool preorder(const IR::AssignmentStatement *statement) override {
+        const auto *declaration = findContext<IR::IDeclaration>();
+        EXPECT_NE(findContext<IR::P4Program>(), nullptr);
+        statements.push_back(
+            absl::StrCat(declaration ? declaration->getName().name.string_view() : "<none>", ":",
+                         statement->left->toString().string_view(), "@",
+                         getContextDepth()));
+        return true;
+    }
+};
+
+TEST_F(P4CVisitor, ParallelInspectorMatchesSequential) {
+    std::string source = P4_SOURCE(R"(
+        header h_t { bit<8> f; }
+        struct headers_t { h_t h; }
+        bit<8> twice(in bit<8> x) { bit<8> y = x; y = y + x; return y; }
+    )");
+    for (int i = 0; i < 6; ++i) {
+        absl::StrAppend(&source, "control c", i, "(inout headers_t hdr) {\n",
+                        "  action a() { hdr.h.f = ", i, "; }\n",
+                        "  apply { hdr.h.f = twice(hdr.h.f); a(); }\n}\n");
+        // Constants split the declarations into several parallel runs.
+        if (i % 3 == 2) absl::StrAppend(&source, "const bit<8> k", i, " = ", i, ";\n");
+    }
+    auto *program = P4::parseP4String(source, CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(program != nullptr);
+
+    CollectStatements sequential(1);
+    program->apply(sequential);
+    ASSERT_FALSE(sequential.statements.empty());
+    for (unsigned threads : {2, 4, 16}) {
+        CollectStatements parallel(threads);
+        program->apply(parallel);
+        EXPECT_EQ(parallel.statements, sequential.statements) << threads << " threads";
+    }
+}
+
 }  // namespace P4::Test
@@ -0,0 +1,64 @@
+#include "lib/work_stealing.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace P4::Test {
+
+TEST(WorkStealing, RunsEveryTaskOnce) {
+    for (unsigned threads : {1u, 4u}) {
+        std::vector<std::atomic<int>> runs(100);
+        Util::runWorkStealing(runs.size(), threads, [&](size_t task, unsigned worker) {
+            EXPECT_LT(worker, threads);
+            ++runs[task];
+        });
+        for (const auto &count : runs) EXPECT_EQ(count, 1);
+    }
+}
+
+/// Each task of a binary tree of depth 10 adds its two children.
+TEST(WorkStealing, RunsSpawnedTasks) {
+    for (unsigned threads : {1u, 4u}) {
+        std::mutex lock;
+        std::vector<unsigned> depth{0};
+        std::set<size_t> seen;
+        Util::runWorkStealing(1, threads, [&](size_t task, unsigned, const Util::SpawnTask &spawn) {
+            unsigned taskDepth;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                EXPECT_TRUE(seen.insert(task).second);
+                taskDepth = depth.at(task);
+            }
+            if (taskDepth == 10) return;
+            for (int child = 0; child < 2; ++child) {
+                // The depth is recorded before the child can run.
+                std::lock_guard<std::mutex> guard(lock);
+                size_t index = spawn();
+                ASSERT_EQ(index, depth.size());
+                depth.push_back(taskDepth + 1);
+            }
+        });
+        EXPECT_EQ(seen.size(), (size_t(1) << 11) - 1);
+    }
+}
+
+TEST(WorkStealing, RethrowsTheFirstFailure) {
+    std::atomic<int> runs = 0;
+    try {
+        Util::runWorkStealing(8, 4, [&](size_t task, unsigned) {
+            ++runs;
+            if (task == 3 || task == 5) throw std::runtime_error(std::to_string(task));
+        });
+        FAIL() << "no exception";
+    } catch (const std::runtime_error &e) {
+        EXPECT_STREQ(e.what(), "3");
+    }
+    EXPECT_EQ(runs, 8);
+}
+
+}  // namespace P4::Test
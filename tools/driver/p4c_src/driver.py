@@ -14,9 +14,12 @@
 import os
 import shlex
 import signal
+import socket
+import struct
 import subprocess
 import sys
 import traceback
+from array import array
 
 import p4c_src.util as util
 
@@ -51,6 +54,8 @@ class BackendDriver:
         self._source_basename = None
         self._verbose = False
         self._run_preprocessor_only = False
+        self._serve_socket = None
+        self._server_socket = None
 
     def __str__(self):
         return self._backend
@@ -120,6 +125,8 @@ class BackendDriver:
         self._source_filename = opts.source_file
         self._source_basename = os.path.splitext(os.path.basename(opts.source_file))[0]
         self._run_preprocessor_only = opts.run_preprocessor_only
+        self._serve_socket = opts.serveSocket
+        self._server_socket = opts.serverSocket
 
         # set preprocessor options
         if "preprocessor" in self._commands:
@@ -264,6 +271,22 @@ class BackendDriver:
 
         if opts.inputMetrics is not None:
             self.add_command_option("compiler", "--metrics={}".format(opts.inputMetrics))
+        if opts.metricsCacheDir is not None:
+            self.add_command_option("compiler", "--metrics-cache={}".format(opts.metricsCacheDir))
+        if opts.metricsJobs is not None:
+            self.add_command_option("compiler", "--metrics-jobs={}".format(opts.metricsJobs))
+        if opts.metricsFormat is not None:
+            self.add_command_option("compiler", "--metrics-format={}".format(opts.metricsFormat))
+        if opts.metricsParserPaths is not None:
+            self.add_command_option(
+                "compiler", "--metrics-parser-paths={}".format(opts.metricsParserPaths)
+            )
+        if opts.metricsAfterPasses is not None:
+            self.add_command_option(
+                "compiler", "--metrics-after={}".format(opts.metricsAfterPasses)
+            )
+        if opts.metricsSnapshot:
+            self.add_command_option("compiler", "--metrics-snapshot")
 
     def should_not_check_input(self, opts):
         """
@@ -338,6 +361,64 @@ class BackendDriver:
 
         return p.returncode
 
+    def runCmdOnServer(self, step, cmd):
+        """
+        Run a compiler command on the compilation server, which writes its
+        output directly to our standard streams, and return its exit status
+        """
+        if self._dry_run:
+            print("{} (on {}):\n{}".format(step, self._server_socket, " ".join(cmd)))
+            return 0
+
+        if self._verbose:
+            print("running {} on {}".format(" ".join(cmd), self._server_socket))
+        # The compilation runs in our directory and with our environment.
+        environment = [name + b"=" + value for name, value in os.environb.items()]
+        args = [os.fsencode(os.getcwd())] + environment
+        args += [os.fsencode(a) for a in shlex.split(" ".join(cmd))]
+        payload = b"".join(a + b"\0" for a in args)
+        header = struct.pack("=4sIII", b"P4CS", 2, len(payload), len(environment))
+        sys.stdout.flush()
+        sys.stderr.flush()
+        try:
+            with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as s:
+                s.connect(self._server_socket)
+                s.sendmsg(
+                    [header],
+                    [(socket.SOL_SOCKET, socket.SCM_RIGHTS, array("i", [0, 1, 2]))],
+                )
+                s.sendall(payload)
+                status = b""
+                while len(status) < 4:
+                    data = s.recv(4 - len(status))
+                    if not data:
+                        break
+                    status += data
+        except OSError as e:
+            print(
+                "error connecting to the compilation server {}: {}".format(self._server_socket, e),
+                file=sys.stderr,
+            )
+            return 1
+
+        if len(status) < 4:
+            print(
+                "the compilation server {} closed the connection".format(self._server_socket),
+                file=sys.stderr,
+            )
+            return 1
+        return struct.unpack("=i", status)[0]
+
+    def serve(self):
+        """
+        Start the compiler as a compilation server, replacing the driver
+        """
+        cmd = self._commands["compiler"]
+        if cmd[0].find("/") != 0 and (util.find_bin(cmd[0]) == None):
+            print("{}: command not found".format(cmd[0]), file=sys.stderr)
+            sys.exit(1)
+        return self.runCmd("compiler", [cmd[0], "--serve", "'{}'".format(self._serve_socket)])
+
     def preRun(self, cmd_name):
         """
         Preamble to a command to setup anything needed
@@ -371,6 +452,9 @@ class BackendDriver:
         Run the set of commands required by this driver
         """
 
+        if self._serve_socket is not None:
+            return self.serve()
+
         # set output directory
         if not os.path.exists(self._output_directory) and not self._run_preprocessor_only:
             os.makedirs(self._output_directory)
@@ -385,7 +469,10 @@ class BackendDriver:
                 print("{}: command not found".format(cmd[0]), file=sys.stderr)
                 sys.exit(1)
 
-            rc = self.runCmd(c, cmd)
+            if c == "compiler" and self._server_socket:
+                rc = self.runCmdOnServer(c, cmd)
+            else:
+                rc = self.runCmd(c, cmd)
 
             # run the cleanup whether the command succeeded or failed
             postrc = self.postRun(c)
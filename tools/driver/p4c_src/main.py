@@ -427,12 +427,72 @@ def main():
             "Select which code metrics will be collected (comma-separated list). "
             "Valid options: all, loc, cyclomatic, halstead, unused-code, nesting-depth,"
             "header-general, header-manipulation, header-modification, match-action,"
-            "parser, inlined, extern. "
+            "parser, inlined, extern, compile-profile (not included in all). "
             "Example: --metrics cyclomatic,halstead"
         ),
         action="store",
         default=None,
     )
+    parser.add_argument(
+        "--metrics-cache",
+        dest="metricsCacheDir",
+        help="Directory of the incremental code metrics cache.",
+        action="store",
+        default=None,
+    )
+    parser.add_argument(
+        "--metrics-jobs",
+        dest="metricsJobs",
+        help="Number of threads computing the per-block code metrics.",
+        action="store",
+        default=None,
+    )
+    parser.add_argument(
+        "--metrics-format",
+        dest="metricsFormat",
+        help="Select the files the code metrics are exported to.",
+        choices=["json", "txt", "both"],
+        action="store",
+        default=None,
+    )
+    parser.add_argument(
+        "--metrics-parser-paths",
+        dest="metricsParserPaths",
+        help="Maximum number of parser paths enumerated by the header packet metrics.",
+        action="store",
+        default=None,
+    )
+    parser.add_argument(
+        "--metrics-after",
+        dest="metricsAfterPasses",
+        help="Take labeled code metric snapshots after passes matching the given names.",
+        action="store",
+        default=None,
+    )
+    parser.add_argument(
+        "--metrics-snapshot",
+        dest="metricsSnapshot",
+        help="Also export the code metrics into a binary snapshot.",
+        action="store_true",
+        default=False,
+    )
+    parser.add_argument(
+        "--serve",
+        dest="serveSocket",
+        metavar="SOCKET",
+        help="Start the compiler as a compilation server listening on the Unix socket SOCKET.",
+        action="store",
+        default=None,
+    )
+    parser.add_argument(
+        "--server",
+        dest="serverSocket",
+        metavar="SOCKET",
+        help="Run the compilation on the compilation server listening on SOCKET "
+        "(default: $P4C_SERVER_SOCKET).",
+        action="store",
+        default=os.environ.get("P4C_SERVER_SOCKET"),
+    )
     parser.add_argument(
         "--Wdisable",
         action="append",
@@ -583,7 +643,9 @@ def main():
     ### In that case we set source to “dummy.p4” so sanity checking works.
     ### The backend can force this behavior for its own help options by
     ### overriding the “should_not_check_input” method.
-    checkInput = not (opts.help_pragmas or backend.should_not_check_input(opts))
+    checkInput = not (
+        opts.help_pragmas or opts.serveSocket or backend.should_not_check_input(opts)
+    )
 
     use_a_dummy_P4_pseudoPathname = False
     ### a note from Abe: do we really still need the dummy pathname?
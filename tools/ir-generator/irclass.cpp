@@ -142,6 +142,8 @@ void IrDefinitions::generate(std::ostream &t, std::ostream &out, std::ostream &i
         << std::endl;
 
     impl << "#include \"ir/ir-generated.h\"    // IWYU pragma: keep\n\n"
+         << "#include \"ir/binary_ir_reader.h\"  // IWYU pragma: keep\n"
+         << "#include \"ir/binary_ir_writer.h\"  // IWYU pragma: keep\n"
          << "#include \"ir/ir-inline.h\"       // IWYU pragma: keep\n"
          << "#include \"ir/json_generator.h\"  // IWYU pragma: keep\n"
          << "#include \"ir/json_loader.h\"     // IWYU pragma: keep\n"
@@ -169,9 +171,12 @@ void IrDefinitions::generate(std::ostream &t, std::ostream &out, std::ostream &i
         << std::endl
         << "class JSONLoader;\n"
         << "using NodeFactoryFn = IR::Node*(*)(JSONLoader&);\n"
+        << "class BinaryIRReader;\n"
+        << "using BinaryNodeFactoryFn = IR::Node*(*)(BinaryIRReader&);\n"
         << std::endl
         << "namespace IR {\n"
         << "extern std::map<cstring, NodeFactoryFn> unpacker_table;\n"
+        << "extern std::map<cstring, BinaryNodeFactoryFn> binary_unpacker_table;\n"
         << "using namespace P4::literals;\n"
         << "}\n";
 
@@ -191,6 +196,21 @@ void IrDefinitions::generate(std::ostream &t, std::ostream &out, std::ostream &i
     }
     impl << " };\n" << std::endl;
 
+    // Binary IR files name the types as node_type_name() does, including the namespace.
+    impl << "std::map<cstring, BinaryNodeFactoryFn> IR::binary_unpacker_table = {\n";
+    first = true;
+    for (auto cls : *getClasses()) {
+        if (cls->kind == NodeKind::Concrete) {
+            if (first)
+                first = false;
+            else
+                impl << ",\n";
+            impl << "{\"" << cls->containedIn << cls->name << "\"_cs, BinaryNodeFactoryFn(&IR::"
+                 << cls->containedIn << cls->name << "::fromBinary)}";
+        }
+    }
+    impl << " };\n" << std::endl;
+
     impl << "template class IR::Vector<IR::Node>;" << std::endl;
     out << "extern template class IR::Vector<IR::Node>;" << std::endl;
     impl << "template class IR::IndexedVector<IR::Node>;" << std::endl;
@@ -387,6 +387,53 @@ const ordered_map<cstring, IrMethod::info_t> IrMethod::Generate = {
           buf << "{ return new " << cl->name << "(json); }";
           return {buf};
       }}},
+    {"toBinary"_cs,
+     {&NamedType::Void(),
+      {new IrField(new ReferenceType(&NamedType::BinaryIRWriter()), "binary"_cs)},
+      CONST + IN_IMPL + OVERRIDE + INCL_NESTED,
+      [](IrClass *cl, Util::SourceInfo, cstring) -> cstring {
+          std::stringstream buf;
+          buf << "{" << std::endl;
+          if (auto parent = cl->getParent())
+              buf << cl->indent << parent->qualified_name(cl->containedIn)
+                  << "::toBinary(binary);" << std::endl;
+          for (auto f : *cl->getFields()) {
+              if (f->type && *f->type == NamedType::SourceInfo())
+                  continue;  // FIXME -- deal with SourcInfo
+              buf << cl->indent << "binary.emit(" << f->name << ");" << std::endl;
+          }
+          buf << "}";
+          return {buf};
+      }}},
+    // The constructor reading the fields in the order toBinary writes them.
+    {"binary_constructor"_cs,
+     {nullptr,
+      {new IrField(new ReferenceType(&NamedType::BinaryIRReader()), "binary"_cs)},
+      IN_IMPL + CONSTRUCTOR + INCL_NESTED,
+      [](IrClass *cl, Util::SourceInfo, cstring) -> cstring {
+          std::stringstream buf;
+          if (auto parent = cl->getParent())
+              buf << ": " << parent->qualified_name(cl->containedIn) << "(binary)";
+          buf << " {" << std::endl;
+          for (auto f : *cl->getFields()) {
+              if (f->type && *f->type == NamedType::SourceInfo())
+                  continue;  // FIXME -- deal with SourcInfo
+              buf << cl->indent << "binary.load(" << f->name << ");" << std::endl;
+          }
+          buf << "}";
+          return {buf};
+      }}},
+    {"fromBinary"_cs,
+     {nullptr,
+      {
+          new IrField(new ReferenceType(&NamedType::BinaryIRReader()), "binary"_cs),
+      },
+      FACTORY + IN_IMPL + CONCRETE_ONLY + INCL_NESTED,
+      [](IrClass *cl, Util::SourceInfo, cstring) -> cstring {
+          std::stringstream buf;
+          buf << "{ return new " << cl->name << "(binary); }";
+          return {buf};
+      }}},
     {"toString"_cs,
      {&NamedType::Cstring(),
       {},
@@ -465,7 +512,7 @@ void IrClass::generateMethods() {
         if (!IrMethod::Generate.count(m->name))
             throw Util::CompilationError("Unrecognized predefined method %1%", m->name);
         auto &info = IrMethod::Generate.at(m->name);
-        if (m->name) {
+        if (!(info.flags & CONSTRUCTOR)) {
             if (info.rtype) {
                 // This predefined method has an explicit return type.
                 m->rtype = info.rtype;
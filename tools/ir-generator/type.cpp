@@ -126,6 +126,16 @@ NamedType &NamedType::JSONObject() {
     return nt;
 }
 
+NamedType &NamedType::BinaryIRWriter() {
+    static NamedType nt("BinaryIRWriter"_cs);
+    return nt;
+}
+
+NamedType &NamedType::BinaryIRReader() {
+    static NamedType nt("BinaryIRReader"_cs);
+    return nt;
+}
+
 NamedType &NamedType::SourceInfo() {
     static NamedType nt(new LookupScope("Util"_cs), "SourceInfo"_cs);
     return nt;
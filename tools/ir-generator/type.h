@@ -111,6 +111,8 @@ class NamedType : public Type {
     static NamedType &JSONGenerator();
     static NamedType &JSONLoader();
     static NamedType &JSONObject();
+    static NamedType &BinaryIRWriter();
+    static NamedType &BinaryIRReader();
     static NamedType &SourceInfo();
 };
 